@@ -45,59 +45,59 @@ extern "C"
 
 #include "Conversion.h"
 
-void CropFrame(AL_TBuffer* pYUV, int iSizePix, uint32_t uCropLeft, uint32_t uCropRight, uint32_t uCropTop, uint32_t uCropBottom)
+/******************************************************************************/
+int GetVisiblePlanes(AL_TBuffer* pYUV, TPlaneView pPlanes[3])
 {
-  int iBeginVert, iEndVert, iBeginHrz, iEndHrz;
-  int iParse, iUV, iCbOffset, iCrOffset;
-
   AL_TSrcMetaData* pMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(pYUV, AL_META_TYPE_SOURCE);
+  uint8_t* pData = AL_Buffer_GetData(pYUV);
 
-  int iWidth = pMeta->tDim.iWidth;
-  int iHeight = pMeta->tDim.iHeight;
-  AL_EChromaMode eMode = AL_GetChromaMode(pMeta->tFourCC);
+  pPlanes[0].pData = pData + pMeta->tOffsetYC.iLuma + pMeta->tVisibleOffsetYC.iLuma;
+  pPlanes[0].iPitch = pMeta->tPitches.iLuma;
+  pPlanes[0].iWidth = pMeta->tVisibleDim.iWidth;
+  pPlanes[0].iHeight = pMeta->tVisibleDim.iHeight;
 
-  uint8_t* pOut = AL_Buffer_GetData(pYUV);
-  uint8_t* pIn = AL_Buffer_GetData(pYUV);
+  if(AL_GetChromaMode(pMeta->tFourCC) == CHROMA_MONO)
+    return 1;
 
-  /*warning: works in frame only in 4:2:0*/
-  iBeginVert = uCropTop;
-  iBeginHrz = uCropLeft;
-  iEndVert = iHeight - uCropBottom;
-  iEndHrz = iWidth - uCropRight;
+  int sx, sy;
+  AL_GetSubsampling(pMeta->tFourCC, &sx, &sy);
 
-  pMeta->tDim.iWidth = iEndHrz - iBeginHrz;
-  pMeta->tDim.iHeight = iEndVert - iBeginVert;
+  int const iChromaPlaneSize = pMeta->tPitches.iChroma * (pMeta->tDim.iHeight / sy);
 
-  /*luma samples*/
-  for(iParse = iBeginVert; iParse < iEndVert; ++iParse)
+  for(int iUV = 0; iUV < 2; ++iUV)
   {
-    memmove(pOut, &pIn[(iParse * iWidth + iBeginHrz) * iSizePix], (iEndHrz - iBeginHrz) * iSizePix);
-    pOut += (iEndHrz - iBeginHrz) * iSizePix;
+    TPlaneView& plane = pPlanes[1 + iUV];
+    plane.pData = pData + pMeta->tOffsetYC.iChroma + iUV * iChromaPlaneSize + pMeta->tVisibleOffsetYC.iChroma;
+    plane.iPitch = pMeta->tPitches.iChroma;
+    plane.iWidth = pMeta->tVisibleDim.iWidth / sx;
+    plane.iHeight = pMeta->tVisibleDim.iHeight / sy;
   }
 
-  /*chroma samples*/
-  if(eMode != CHROMA_MONO)
-  {
-    iCbOffset = iWidth * iHeight;
-    iWidth /= (eMode == CHROMA_4_4_4) ? 1 : 2;
-    iHeight /= (eMode == CHROMA_4_2_0) ? 2 : 1;
-    iCrOffset = iCbOffset + (iWidth * iHeight);
+  return 3;
+}
+
+/******************************************************************************/
+void WriteVisibleFrame(std::ofstream& File, AL_TBuffer* pYUV)
+{
+  AL_TSrcMetaData* pMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(pYUV, AL_META_TYPE_SOURCE);
+  int const iSizePix = AL_GetBitDepth(pMeta->tFourCC) > 8 ? 2 : 1;
 
-    iBeginVert /= (eMode == CHROMA_4_2_0) ? 2 : 1;
-    iEndVert /= (eMode == CHROMA_4_2_0) ? 2 : 1;
-    iBeginHrz /= (eMode == CHROMA_4_4_4) ? 1 : 2;
-    iEndHrz /= (eMode == CHROMA_4_4_4) ? 1 : 2;
+  TPlaneView pPlanes[3];
+  int const iNumPlanes = GetVisiblePlanes(pYUV, pPlanes);
 
-    for(iUV = 0; iUV < 2; ++iUV)
-    {
-      int iChromaOffset = (iUV ? iCrOffset : iCbOffset);
+  for(int iPlane = 0; iPlane < iNumPlanes; ++iPlane)
+  {
+    TPlaneView const& plane = pPlanes[iPlane];
+    int const iRowSize = plane.iWidth * iSizePix;
 
-      for(iParse = iBeginVert; iParse < iEndVert; ++iParse)
-      {
-        memmove(pOut, &pIn[(iParse * iWidth + iBeginHrz + iChromaOffset) * iSizePix], (iEndHrz - iBeginHrz) * iSizePix);
-        pOut += (iEndHrz - iBeginHrz) * iSizePix;
-      }
+    if(iRowSize == plane.iPitch)
+    {
+      File.write((char const*)plane.pData, iRowSize * plane.iHeight);
+      continue;
     }
+
+    for(int iRow = 0; iRow < plane.iHeight; ++iRow)
+      File.write((char const*)(plane.pData + iRow * plane.iPitch), iRowSize);
   }
 }
 
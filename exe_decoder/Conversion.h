@@ -38,6 +38,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <fstream>
 
 extern "C"
 {
@@ -45,13 +46,30 @@ extern "C"
 }
 
 /*************************************************************************//*!
-   \brief Crop YUV Frame Buffer
-   \param[out] pYUV        Pointer to the frame buffer (IYUV planar format) that receives the converted frame
-   \param[in]  iSizePix    Size of each samples in byte
-   \param[in]  uCropLeft   Delta limit of the rectangular region at the left of the picture
-   \param[in]  uCropRight  Delta limit of the rectangular region at the right of the picture
-   \param[in]  uCropTop    Delta limit of the rectangular region at the top   of the picture
-   \param[in]  uCropBottom Delta limit of the rectangular region at the bottom of the picture
+   \brief Displayed part of one plane of a planar frame buffer
 *****************************************************************************/
-void CropFrame(AL_TBuffer* pYUV, int iSizePix, uint32_t uCropLeft, uint32_t uCropRight, uint32_t uCropTop, uint32_t uCropBottom);
+struct TPlaneView
+{
+  uint8_t* pData; /* first displayed sample */
+  int iPitch; /* in bytes */
+  int iWidth; /* in samples */
+  int iHeight;
+};
+
+/*************************************************************************//*!
+   \brief Locates the displayed part of the planes of a frame buffer, following
+   the cropping window of its source metadata (see AL_SrcMetaData_SetCrop)
+   \param[in]  pYUV    Pointer to the frame buffer (I420, I422, I444 or Y800 planar format and their 16 bits variants).
+   The chroma planes follow each other, each one subsampled as its chroma mode requires (none for 4:4:4)
+   \param[out] pPlanes Receives the luma, cb and cr planes
+   \return Returns the number of planes: 1 for a monochrome frame, 3 otherwise
+*****************************************************************************/
+int GetVisiblePlanes(AL_TBuffer* pYUV, TPlaneView pPlanes[3]);
+
+/*************************************************************************//*!
+   \brief Writes the displayed part of a planar frame buffer, one plane after the other
+   \param[in] File Output file
+   \param[in] pYUV Pointer to the frame buffer
+*****************************************************************************/
+void WriteVisibleFrame(std::ofstream& File, AL_TBuffer* pYUV);
 
@@ -64,10 +64,23 @@ AL_TAllocator* createDmaAllocator(const char* deviceName)
 extern "C"
 {
 #include "lib_common/HardwareDriver.h"
+#include "lib_fpga/DriverRecord.h"
 AL_TIDecChannel* AL_DecChannelMcu_Create(AL_TDriver*);
 }
 
-static unique_ptr<CIpDevice> createMcuIpDevice()
+static shared_ptr<AL_TDriver> createDriver(string sRecordDriver)
+{
+  if(sRecordDriver.empty())
+    return shared_ptr<AL_TDriver>(AL_GetHardwareDriver(), [](AL_TDriver*) {});
+
+  auto pDriver = AL_RecordDriver_Create(AL_GetHardwareDriver(), sRecordDriver.c_str());
+
+  if(!pDriver)
+    throw runtime_error("Can't record the driver messages in " + sRecordDriver);
+  return shared_ptr<AL_TDriver>(pDriver, &AL_RecordDriver_Destroy);
+}
+
+static unique_ptr<CIpDevice> createMcuIpDevice(string sRecordDriver)
 {
   auto device = make_unique<CIpDevice>();
 
@@ -76,7 +89,8 @@ static unique_ptr<CIpDevice> createMcuIpDevice()
   if(!device->m_pAllocator)
     throw runtime_error("Can't open DMA allocator");
 
-  device->m_pDecChannel = AL_DecChannelMcu_Create(AL_GetHardwareDriver());
+  device->m_pDriver = createDriver(sRecordDriver);
+  device->m_pDecChannel = AL_DecChannelMcu_Create(device->m_pDriver.get());
 
   if(!device->m_pDecChannel)
     throw runtime_error("Failed to create MCU scheduler");
@@ -85,14 +99,14 @@ static unique_ptr<CIpDevice> createMcuIpDevice()
 }
 
 
-shared_ptr<CIpDevice> CreateIpDevice(int* iUseBoard, int iSchedulerType, function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl, bool trackDma, int uNumCore, int hangers)
+shared_ptr<CIpDevice> CreateIpDevice(int* iUseBoard, int iSchedulerType, function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl, bool trackDma, int uNumCore, int hangers, string sRecordDriver)
 {
   (void)iUseBoard, (void)wrapIpCtrl, (void)uNumCore, (void)trackDma, (void)hangers;
 
 
 
   if(iSchedulerType == SCHEDULER_TYPE_MCU)
-    return createMcuIpDevice();
+    return createMcuIpDevice(sRecordDriver);
 
   throw runtime_error("No support for this scheduling type");
 }
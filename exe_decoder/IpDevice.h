@@ -45,6 +45,7 @@
 typedef struct AL_t_Allocator AL_TAllocator;
 typedef struct AL_t_IDecChannel AL_TIDecChannel;
 typedef struct AL_t_IpCtrl AL_TIpCtrl;
+typedef struct AL_t_driver AL_TDriver;
 typedef struct AL_t_Timer AL_Timer;
 
 /*****************************************************************************/
@@ -52,8 +53,9 @@ struct CIpDevice
 {
   AL_TIDecChannel* m_pDecChannel = nullptr;
   std::shared_ptr<AL_TAllocator> m_pAllocator;
+  std::shared_ptr<AL_TDriver> m_pDriver;
   AL_Timer* m_pTimer;
 };
 
-std::shared_ptr<CIpDevice> CreateIpDevice(int* iUseBoard, int iSchedulerType, std::function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl, bool trackDma = false, int uNumCore = 0, int hangers = 0);
+std::shared_ptr<CIpDevice> CreateIpDevice(int* iUseBoard, int iSchedulerType, std::function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl, bool trackDma = false, int uNumCore = 0, int hangers = 0, std::string sRecordDriver = "");
 
@@ -0,0 +1,289 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+
+#include "StreamIndex.h"
+#include "lib_app/utils.h"
+
+using namespace std;
+
+static char const* const INDEX_MAGIC = "AL_NAL_INDEX";
+static int const INDEX_VERSION = 1;
+
+/******************************************************************************/
+struct NalInfo
+{
+  bool bIsParamSet;
+  bool bIsRap;
+  bool bIsFirstSlice;
+};
+
+static NalInfo GetNalInfo(AL_ECodec eCodec, uint8_t const* pNal)
+{
+  NalInfo info {};
+
+  if(eCodec == AL_CODEC_AVC)
+  {
+    int const iNut = pNal[0] & 0x1F;
+    bool const bIsVcl = iNut >= 1 && iNut <= AL_AVC_NUT_VCL_IDR;
+    info.bIsParamSet = iNut == AL_AVC_NUT_SPS || iNut == AL_AVC_NUT_PPS;
+    info.bIsRap = iNut == AL_AVC_NUT_VCL_IDR;
+    info.bIsFirstSlice = bIsVcl && (pNal[1] & 0x80); // first_mb_in_slice == 0
+  }
+  else
+  {
+    int const iNut = (pNal[0] >> 1) & 0x3F;
+    bool const bIsVcl = iNut < AL_HEVC_NUT_VPS;
+    info.bIsParamSet = iNut == AL_HEVC_NUT_VPS || iNut == AL_HEVC_NUT_SPS || iNut == AL_HEVC_NUT_PPS;
+    info.bIsRap = iNut >= AL_HEVC_NUT_BLA_W_LP && iNut <= AL_HEVC_NUT_CRA;
+    info.bIsFirstSlice = bIsVcl && (pNal[2] & 0x80); // first_slice_segment_in_pic_flag
+  }
+
+  return info;
+}
+
+/******************************************************************************/
+StreamIndex BuildStreamIndex(string const& sStream, AL_ECodec eCodec)
+{
+  ifstream file;
+  OpenInput(file, sStream);
+
+  StreamIndex index;
+
+  // start code + nal header + first byte of the slice header
+  size_t const zNalPrefix = 3 + ((eCodec == AL_CODEC_AVC) ? 1 : 2) + 1;
+  size_t const zChunkSize = 4 * 1024 * 1024;
+  vector<uint8_t> buf(zChunkSize + zNalPrefix);
+
+  uint64_t uBufPos = 0; // file offset of buf[0]
+  size_t zKept = 0; // bytes of the previous chunk kept at the beginning of buf
+  bool bInParamSet = false;
+  uint64_t uNalPos = 0;
+
+  auto CloseNal = [&](uint64_t uEnd)
+                  {
+                    if(bInParamSet)
+                      index.paramSets.push_back({ uNalPos, (uint32_t)(uEnd - uNalPos) });
+                    bInParamSet = false;
+                  };
+
+  while(true)
+  {
+    file.read((char*)buf.data() + zKept, zChunkSize);
+    size_t const zRead = (size_t)file.gcount();
+    size_t const zSize = zKept + zRead;
+    bool const bEnd = zRead == 0;
+
+    // start codes whose prefix may continue in the next chunk are left for it
+    size_t const zLimit = bEnd ? zSize : (zSize > zNalPrefix ? zSize - zNalPrefix : 0);
+    size_t const zSearchEnd = min(zLimit + 2, zSize); // the 0x01 of a start code before zLimit
+    size_t zSearch = 2;
+
+    while(zSearch < zSearchEnd)
+    {
+      auto pOne = (uint8_t const*)memchr(buf.data() + zSearch, 0x01, zSearchEnd - zSearch);
+
+      if(!pOne)
+        break;
+
+      size_t const zOne = pOne - buf.data();
+      zSearch = zOne + 1;
+
+      if(buf[zOne - 1] != 0x00 || buf[zOne - 2] != 0x00)
+        continue;
+
+      uint64_t const uPos = uBufPos + zOne - 2;
+      CloseNal(uPos);
+
+      if(zOne - 2 + zNalPrefix <= zSize)
+      {
+        NalInfo const info = GetNalInfo(eCodec, &buf[zOne + 1]);
+
+        if(info.bIsFirstSlice)
+        {
+          if(info.bIsRap)
+            index.raps.push_back({ uPos, index.iNumFrames, index.paramSets.size() });
+          ++index.iNumFrames;
+        }
+
+        bInParamSet = info.bIsParamSet;
+        uNalPos = uPos;
+      }
+
+      zSearch = zOne + 3;
+    }
+
+    if(bEnd)
+    {
+      CloseNal(uBufPos + zSize);
+      break;
+    }
+
+    zKept = zSize - zLimit;
+    memmove(buf.data(), buf.data() + zLimit, zKept);
+    uBufPos += zLimit;
+  }
+
+  return index;
+}
+
+/******************************************************************************/
+static uint64_t GetFileSize(string const& sFile)
+{
+  ifstream file(sFile, ios::binary | ios::ate);
+
+  if(!file)
+    return 0;
+
+  return (uint64_t)file.tellg();
+}
+
+static string GetCodecName(AL_ECodec eCodec)
+{
+  return (eCodec == AL_CODEC_AVC) ? "avc" : "hevc";
+}
+
+/******************************************************************************/
+static bool LoadStreamIndex(string const& sIndex, AL_ECodec eCodec, uint64_t uStreamSize, StreamIndex& index)
+{
+  ifstream file(sIndex);
+
+  if(!file)
+    return false;
+
+  string sMagic, sCodec;
+  int iVersion = 0;
+  uint64_t uSize = 0;
+  size_t zNumParamSets = 0, zNumRaps = 0;
+
+  file >> sMagic >> iVersion >> sCodec >> uSize >> index.iNumFrames >> zNumParamSets >> zNumRaps;
+
+  if(!file || sMagic != INDEX_MAGIC || iVersion != INDEX_VERSION || sCodec != GetCodecName(eCodec) || uSize != uStreamSize)
+    return false;
+
+  index.paramSets.resize(zNumParamSets);
+
+  for(auto& ps : index.paramSets)
+    file >> ps.uOffset >> ps.uSize;
+
+  index.raps.resize(zNumRaps);
+
+  for(auto& rap : index.raps)
+    file >> rap.uOffset >> rap.iFrame >> rap.zNumParamSets;
+
+  return (bool)file;
+}
+
+/******************************************************************************/
+static void SaveStreamIndex(string const& sIndex, AL_ECodec eCodec, uint64_t uStreamSize, StreamIndex const& index)
+{
+  ofstream file(sIndex);
+
+  if(!file)
+    return; // the index is rebuilt next time
+
+  file << INDEX_MAGIC << " " << INDEX_VERSION << " " << GetCodecName(eCodec) << " " << uStreamSize << " " << index.iNumFrames << " " << index.paramSets.size() << " " << index.raps.size() << "\n";
+
+  for(auto& ps : index.paramSets)
+    file << ps.uOffset << " " << ps.uSize << "\n";
+
+  for(auto& rap : index.raps)
+    file << rap.uOffset << " " << rap.iFrame << " " << rap.zNumParamSets << "\n";
+}
+
+/******************************************************************************/
+StreamIndex GetStreamIndex(string const& sStream, AL_ECodec eCodec)
+{
+  string const sIndex = sStream + ".idx";
+  uint64_t const uStreamSize = GetFileSize(sStream);
+  StreamIndex index;
+
+  if(LoadStreamIndex(sIndex, eCodec, uStreamSize, index))
+    return index;
+
+  index = BuildStreamIndex(sStream, eCodec);
+  SaveStreamIndex(sIndex, eCodec, uStreamSize, index);
+  return index;
+}
+
+/******************************************************************************/
+SeekPoint FindSeekPoint(StreamIndex const& index, string const& sStream, int iFrame)
+{
+  auto rap = upper_bound(index.raps.begin(), index.raps.end(), iFrame, [](int iFrame, StreamIndex::RandomAccessPoint const& rap)
+  {
+    return iFrame < rap.iFrame;
+  });
+
+  if(rap == index.raps.begin())
+    throw runtime_error("No random access point before frame " + to_string(iFrame));
+
+  --rap;
+
+  SeekPoint seek;
+  seek.uOffset = rap->uOffset;
+  seek.iFrame = rap->iFrame;
+
+  ifstream file;
+  OpenInput(file, sStream);
+
+  // parameter sets that are sent again override their previous occurrence:
+  // walk them backward to keep only the last one of each
+  set<vector<uint8_t>> seen;
+  vector<vector<uint8_t>> paramSets;
+
+  for(size_t i = rap->zNumParamSets; i > 0; --i)
+  {
+    auto const& ps = index.paramSets[i - 1];
+    vector<uint8_t> nal(ps.uSize);
+    file.seekg(ps.uOffset);
+    file.read((char*)nal.data(), nal.size());
+
+    if(seen.insert(nal).second)
+      paramSets.push_back(move(nal));
+  }
+
+  for(auto it = paramSets.rbegin(); it != paramSets.rend(); ++it)
+    seek.paramSets.insert(seek.paramSets.end(), it->begin(), it->end());
+
+  return seek;
+}
+
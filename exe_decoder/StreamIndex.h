@@ -0,0 +1,106 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include "lib_common/SliceConsts.h" // AL_ECodec
+}
+
+/*************************************************************************//*!
+   \brief Random access points and parameter sets of an annex B stream file
+*****************************************************************************/
+struct StreamIndex
+{
+  struct NalRange
+  {
+    uint64_t uOffset; /* of the start code */
+    uint32_t uSize; /* up to the next start code */
+  };
+
+  struct RandomAccessPoint
+  {
+    uint64_t uOffset; /* of the start code of the first slice */
+    int iFrame; /* in decoding order */
+    size_t zNumParamSets; /* number of parameter sets located before it */
+  };
+
+  std::vector<NalRange> paramSets; /* VPS, SPS and PPS in stream order */
+  std::vector<RandomAccessPoint> raps; /* IDR, CRA and BLA pictures in stream order */
+  int iNumFrames = 0;
+};
+
+/*************************************************************************//*!
+   \brief Where to start feeding the decoder to reach a frame
+*****************************************************************************/
+struct SeekPoint
+{
+  uint64_t uOffset; /* of the random access point in the stream file */
+  int iFrame; /* first frame decoded from there */
+  std::vector<uint8_t> paramSets; /* parameter sets to push before the random access point */
+};
+
+/*************************************************************************//*!
+   \brief Scans a stream file for its random access points and parameter sets
+   \param[in] sStream Annex B stream file
+   \param[in] eCodec  Codec of the stream
+*****************************************************************************/
+StreamIndex BuildStreamIndex(std::string const& sStream, AL_ECodec eCodec);
+
+/*************************************************************************//*!
+   \brief Loads the index of a stream file from its sidecar file
+   (<sStream>.idx), building and saving it when it is missing or outdated
+   \param[in] sStream Annex B stream file
+   \param[in] eCodec  Codec of the stream
+*****************************************************************************/
+StreamIndex GetStreamIndex(std::string const& sStream, AL_ECodec eCodec);
+
+/*************************************************************************//*!
+   \brief Finds the last random access point before a frame and gathers the
+   parameter sets the stream defined until there. When a parameter set was
+   sent several times, only its last occurrence is kept.
+   \param[in] index   Index of sStream
+   \param[in] sStream Annex B stream file
+   \param[in] iFrame  Frame to reach, in decoding order
+*****************************************************************************/
+SeekPoint FindSeekPoint(StreamIndex const& index, std::string const& sStream, int iFrame);
+
@@ -36,77 +36,179 @@
 ******************************************************************************/
 
 #include "crc.h"
+#include "Conversion.h"
+#include <algorithm>
 #include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
 
 using namespace std;
 
 #define POLYNOM_CRC 0x04c11db7
-static unsigned int crc32_table[1024];
-static bool bInitCRC;
 
-/******************************************************************************/
-static void init_crc32(int bitdepth)
+/*
+ * The certification crc of a plane shifts each sample, on iSampleBd bits, in
+ * the crc register, using a table computed for samples on iTableBd bits (the
+ * output bitdepth). The table lookup is linear as long as its index stays in
+ * the table (iSampleBd <= iTableBd): the crc of a block of N samples is then the
+ * crc register pushed N samples further, xored with the contribution of each
+ * sample pushed to the end of the block, which are both precomputed
+ * (slicing-by-8 on 8 bytes of samples).
+ */
+struct CrcTables
 {
-  for(int i = 0; i < (1 << bitdepth); i++)
+  CrcTables(int iTableBd, int iSampleBd, int iNumSlices) :
+    iSampleBd(iSampleBd),
+    iNumSlices(iNumSlices)
   {
-    unsigned int crc_precalc = i << (32 - bitdepth);
+    for(int i = 0; i < (1 << iTableBd); i++)
+    {
+      uint32_t crc_precalc = i << (32 - iTableBd);
+
+      for(int j = 0; j < iTableBd; j++)
+        crc_precalc = (crc_precalc & 0x80000000) ? (crc_precalc << 1) ^ POLYNOM_CRC : (crc_precalc << 1);
+
+      table[i] = crc_precalc;
+    }
+
+    bSliced = iSampleBd <= iTableBd;
+
+    if(!bSliced)
+      return;
+
+    int const iNumValues = 1 << iSampleBd;
+    sample.resize(iNumSlices * iNumValues);
+
+    for(int v = 0; v < iNumValues; ++v)
+    {
+      uint32_t crc = table[v];
 
-    for(int j = 0; j < bitdepth; j++)
-      crc_precalc = (crc_precalc & 0x80000000) ? (crc_precalc << 1) ^ POLYNOM_CRC : (crc_precalc << 1);
+      for(int k = 0; k < iNumSlices; ++k)
+      {
+        sample[k * iNumValues + v] = crc;
+        crc = Shift(crc, 0);
+      }
+    }
 
-    crc32_table[i] = crc_precalc;
+    for(int iByte = 0; iByte < 4; ++iByte)
+    {
+      for(int b = 0; b < 256; ++b)
+      {
+        uint32_t crc = b << (8 * iByte);
+
+        for(int k = 0; k < iNumSlices; ++k)
+          crc = Shift(crc, 0);
+
+        state[iByte][b] = crc;
+      }
+    }
   }
+
+  uint32_t Shift(uint32_t crc, int iPix) const
+  {
+    int const mask = (1 << iSampleBd) - 1;
+    return (crc << iSampleBd) ^ table[((crc >> (32 - iSampleBd)) ^ iPix) & mask];
+  }
+
+  int const iSampleBd;
+  int const iNumSlices;
+  bool bSliced;
+  uint32_t table[1024] {};
+  uint32_t state[4][256];
+  vector<uint32_t> sample; // sample[k][v]: crc of v, pushed k samples further
+};
+
+/******************************************************************************/
+static CrcTables const& GetTables(int iTableBd, int iSampleBd, int iNumSlices)
+{
+  static mutex lock;
+  static map<tuple<int, int, int>, unique_ptr<CrcTables>> tables;
+
+  lock_guard<mutex> guard(lock);
+  auto& pTables = tables[make_tuple(iTableBd, iSampleBd, iNumSlices)];
+
+  if(!pTables)
+    pTables.reset(new CrcTables(iTableBd, iSampleBd, iNumSlices));
+
+  return *pTables;
 }
 
 /******************************************************************************/
 template<typename T>
-void CRC32(int iBdIn, int iBdOut, uint32_t& crc, T* pBuffer)
+static uint32_t CRC32(int iBdIn, int iBdOut, TPlaneView const& tPlane)
 {
-  if(!bInitCRC)
+  int const iNumSlices = 8 / sizeof(T);
+  auto const& tables = GetTables(iBdIn, iBdOut, iNumSlices);
+  int const iShiftLeft = max(iBdOut - iBdIn, 0);
+  int const iShiftRight = max(iBdIn - iBdOut, 0);
+  int const mask = (1 << iBdOut) - 1;
+  uint32_t const* pSample[8];
+
+  if(tables.bSliced)
   {
-    init_crc32(iBdIn);
-    bInitCRC = true;
+    for(int k = 0; k < iNumSlices; ++k)
+      pSample[k] = &tables.sample[(iNumSlices - 1 - k) << iBdOut];
   }
 
-  int iPix;
+  uint32_t crc = 0xFFFFFFFF;
 
-  if(iBdIn < iBdOut)
-    iPix = *pBuffer << (iBdOut - iBdIn);
-  else
-    iPix = *pBuffer >> (iBdIn - iBdOut);
+  // rows are contiguous in the crc, whatever the pitch of the plane
+  for(int iRow = 0; iRow < tPlane.iHeight; ++iRow)
+  {
+    T const* pBuffer = (T const*)(tPlane.pData + iRow * tPlane.iPitch);
+    int const iNumPix = tPlane.iWidth;
+    int iPix = 0;
+
+    if(tables.bSliced)
+    {
+      for(; iPix + iNumSlices <= iNumPix; iPix += iNumSlices)
+      {
+        crc = tables.state[0][crc & 0xFF] ^ tables.state[1][(crc >> 8) & 0xFF] ^
+              tables.state[2][(crc >> 16) & 0xFF] ^ tables.state[3][crc >> 24];
+
+        for(int k = 0; k < iNumSlices; ++k)
+          crc ^= pSample[k][((pBuffer[iPix + k] << iShiftLeft) >> iShiftRight) & mask];
+      }
+    }
+
+    for(; iPix < iNumPix; ++iPix)
+      crc = tables.Shift(crc, (pBuffer[iPix] << iShiftLeft) >> iShiftRight);
+  }
 
-  int mask = (1 << iBdOut) - 1;
-  crc = (crc << iBdOut) ^ crc32_table[((crc >> (32 - iBdOut)) ^ iPix) & mask];
+  return crc;
 }
 
 /******************************************************************************/
-template<typename T>
-void Compute_CRC(int iBdInY, int iBdInC, int iBdOut, int iNumPix, int iNumPixC, AL_EChromaMode eMode, T* pBuf, ofstream& ofCrcFile)
+void Compute_CRC(int iBdInY, int iBdInC, int iBdOut, AL_TBuffer* pYUV, ofstream& ofCrcFile)
 {
   uint32_t crc_luma = 0xFFFFFFFF;
   uint32_t crc_cb = 0xFFFFFFFF;
   uint32_t crc_cr = 0xFFFFFFFF;
 
-  for(int iPix = 0; iPix < iNumPix; ++iPix)
-    CRC32(iBdOut, iBdInY, crc_luma, pBuf++);
+  TPlaneView pPlanes[3];
+  int const iNumPlanes = GetVisiblePlanes(pYUV, pPlanes);
+  auto PlaneCRC = (iBdOut > 8) ? CRC32<uint16_t> : CRC32<uint8_t>;
 
-  if(eMode != CHROMA_MONO)
-  {
-    for(int iPix = 0; iPix < iNumPixC; ++iPix)
-      CRC32(iBdOut, iBdInC, crc_cb, pBuf++);
+  // the planes are independent: the chroma ones are computed while the luma is
+  vector<thread> workers;
 
-    for(int iPix = 0; iPix < iNumPixC; ++iPix)
-      CRC32(iBdOut, iBdInC, crc_cr, pBuf++);
+  if(iNumPlanes > 1)
+  {
+    workers.emplace_back([&] { crc_cb = PlaneCRC(iBdOut, iBdInC, pPlanes[1]); });
+    workers.emplace_back([&] { crc_cr = PlaneCRC(iBdOut, iBdInC, pPlanes[2]); });
   }
 
+  crc_luma = PlaneCRC(iBdOut, iBdInY, pPlanes[0]);
+
+  for(auto& worker : workers)
+    worker.join();
+
   ofCrcFile << setfill('0') << setw(8) << crc_luma << " : ";
   ofCrcFile << setfill('0') << setw(8) << crc_cb << " : ";
   ofCrcFile << setfill('0') << setw(8) << crc_cr << endl;
 }
 
-template
-void Compute_CRC<uint8_t>(int iBdInY, int iBdInC, int iBdOut, int iNumPix, int iNumPixC, AL_EChromaMode eMode, uint8_t* pBuf, ofstream& ofCrcFile);
-
-template
-void Compute_CRC<uint16_t>(int iBdInY, int iBdInC, int iBdOut, int iNumPix, int iNumPixC, AL_EChromaMode eMode, uint16_t* pBuf, ofstream& ofCrcFile);
-
@@ -41,9 +41,16 @@
 
 extern "C"
 {
-#include "lib_common/SliceConsts.h" // EChromaMode
+#include "lib_common/BufferAPI.h"
 }
 
-template<typename T>
-void Compute_CRC(int iBdInY, int iBdInC, int iBdOut, int iNumPix, int iNumPixC, AL_EChromaMode eMode, T* pBuf, std::ofstream& ofCrcFile);
+/*************************************************************************//*!
+   \brief Appends the certification crc of the displayed part of a frame buffer
+   \param[in] iBdInY    Luma bitdepth of the decoded samples
+   \param[in] iBdInC    Chroma bitdepth of the decoded samples
+   \param[in] iBdOut    Bitdepth of the samples in the frame buffer (8 or 10)
+   \param[in] pYUV      Pointer to the frame buffer (see GetVisiblePlanes)
+   \param[in] ofCrcFile Output crc file
+*****************************************************************************/
+void Compute_CRC(int iBdInY, int iBdInC, int iBdOut, AL_TBuffer* pYUV, std::ofstream& ofCrcFile);
 
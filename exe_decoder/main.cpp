@@ -50,6 +50,8 @@
 #include <mutex>
 #include <queue>
 #include <map>
+#include <thread>
+#include <vector>
 extern "C"
 {
 #include "lib_common/BufferSrcMeta.h"
@@ -58,6 +60,8 @@ extern "C"
 #include "lib_common_dec/IpDecFourCC.h"
 #include "lib_common/StreamBuffer.h"
 #include "lib_common/Utils.h"
+#include "lib_perfs/PipelineStats.h"
+#include "lib_perfs/Tracer.h"
 }
 
 #include "lib_app/BufPool.h"
@@ -67,12 +71,14 @@ extern "C"
 #include "lib_app/utils.h"
 #include "lib_app/CommandLineParser.h"
 #include "lib_app/FileIOUtils.h"
+#include "lib_app/MemoryBudget.h"
 
 #include "Conversion.h"
 #include "al_resource.h"
 #include "IpDevice.h"
 #include "CodecUtils.h"
 #include "crc.h"
+#include "StreamIndex.h"
 
 using namespace std;
 
@@ -86,6 +92,7 @@ const char* ToString(AL_ERR eErrCode)
   case AL_ERR_REQUEST_MALFORMED: return "Channel not created: request was malformed";
   case AL_ERR_RESOLUTION_CHANGE: return "Resolution Change is not supported";
   case AL_ERR_NO_MEMORY: return "Memory shortage detected (dma, embedded memory or virtual memory shortage)";
+  case AL_ERR_STREAM_OVERFLOW: return "An access unit doesn't fit in the stream buffer (see --drop-on-overflow)";
   case AL_SUCCESS: return "Success";
   default: return "Unknown error";
   }
@@ -136,6 +143,7 @@ struct Config
   bool help = false;
 
   string sIn;
+  vector<string> extraInputs;
   string sOut;
   string sCrc;
 
@@ -155,6 +163,13 @@ struct Config
   int iLoop = 1;
   int iTimeoutInSeconds = -1;
   int iMaxFrames = INT_MAX;
+  string sRecordDriver = "";
+  string sLatencyStats = "";
+  string sTraceFile = "";
+  int iFeederThreads = -1;
+  int iSeekFrame = -1;
+  bool bProbeStream = false;
+  int iMemoryBudget = 0; // MB, 0 disables the check of the memory plan
 };
 
 /******************************************************************************/
@@ -280,6 +295,11 @@ static Config ParseCommandLine(int argc, char* argv[])
   opt.addFlag("--help,-h", &Config.help, "Shows this help");
   opt.addFlag("--version", &version, "Show version");
   opt.addString("-in,-i", &Config.sIn, "Input bitstream");
+  opt.addOption("--add-input", [&]()
+  {
+    Config.extraInputs.push_back(opt.popWord());
+  }, "Decode one more bitstream concurrently, the output files get a _<stream index> suffix");
+  opt.addInt("--feeder-threads", &Config.iFeederThreads, "Number of threads feeding the decoders (default: one per decoder with one input, one per core with several)");
   opt.addString("-out,-o", &Config.sOut, "Output YUV");
   opt.addInt("-nbuf", &Config.uInputBufferNum, "Specify the number of input feeder buffer");
   opt.addInt("-nsize", &Config.zInputBufferSize, "Specify the size (in bytes) of input feeder buffer");
@@ -291,6 +311,8 @@ static Config ParseCommandLine(int argc, char* argv[])
   opt.addString("-crc_ip", &Config.sCrc, "Output crc file");
   opt.addFlag("-wpp", &Config.tDecSettings.bParallelWPP, "Wavefront parallelization processing activation");
   opt.addFlag("-lowlat", &Config.tDecSettings.bLowLat, "Low latency decoding activation");
+  opt.addFlag("--length-prefixed", &Config.tDecSettings.bLengthPrefixed, "Input NALs are preceded by their size on 4 big endian bytes (MP4/MKV samples) instead of start codes");
+  opt.addFlag("--drop-on-overflow", &Config.tDecSettings.bDropOnStreamOverflow, "Drop the buffered stream instead of failing when an access unit doesn't fit in the stream buffer");
   opt.addInt("-ddrwidth", &Config.tDecSettings.uDDRWidth, "Width of DDR requests (16, 32, 64) (default: 32)");
   opt.addFlag("-nocache", &Config.tDecSettings.bDisableCache, "Inactivate the cache");
   opt.addOption("--fbc", [&]()
@@ -330,6 +352,19 @@ static Config ParseCommandLine(int argc, char* argv[])
               "Specify decoder latency (default: Frame Latency)",
               AL_AU_UNIT);
 
+  opt.addFlag("--batch-slices", &Config.tDecSettings.bBatchSlices,
+              "Slice latency: send the slices parsed together in one request (needs driver support)");
+
+  opt.addFlag("--key-frames-only", &Config.tDecSettings.eDropMode,
+              "Decode only the IDR (AVC) or IRAP (HEVC) pictures",
+              AL_DROP_NON_KEY_FRAMES);
+
+  opt.addOption("--max-temporal-id", [&]()
+  {
+    Config.tDecSettings.eDropMode = AL_DROP_HIGH_TEMPORAL_LAYERS;
+    Config.tDecSettings.uMaxTemporalId = opt.popInt();
+  }, "Decode only the pictures up to this temporal id (HEVC). With AVC, 0 drops the non reference pictures");
+
   opt.addFlag("-avc", &Config.tDecSettings.eCodec,
               "Specify the input bitstream codec (default: HEVC)",
               AL_CODEC_AVC);
@@ -346,12 +381,18 @@ static Config ParseCommandLine(int argc, char* argv[])
   opt.addInt("-loop", &Config.iLoop, "Number of Decoding loop (optional)");
 
   opt.addString("--log", &Config.logsFile, "A file where logged events will be dumped");
+  opt.addString("--latency-stats", &Config.sLatencyStats, "A file where the per stage latencies will be dumped at exit (.csv or .json)");
+  opt.addString("--trace", &Config.sTraceFile, "A file where the threads activity will be dumped at exit (Chrome trace-event json)");
+  opt.addString("--record-driver", &Config.sRecordDriver, "A file where the driver messages will be recorded, to be replayed by AL_DriverReplay.exe");
 
 
   string preAllocArgs = "";
   opt.addInt("--timeout", &Config.iTimeoutInSeconds, "Specify timeout in seconds");
+  opt.addInt("--seek-frame", &Config.iSeekFrame, "Start decoding at the random access point preceding this frame (decoding order), using the index of the input (<input>.idx, built on first use)");
   opt.addInt("--max-frames", &Config.iMaxFrames, "Abort after max number of decoded frames (approximative abort)");
   opt.addString("--prealloc-args", &preAllocArgs, "Specify the stream dimension: 1920x1080:unkwn:422:10:profile-idc:level");
+  opt.addFlag("--probe", &Config.bProbeStream, "Read the stream settings from the beginning of the input and preallocate the decoder buffers (ignored with --prealloc-args)");
+  opt.addInt("--memory-budget", &Config.iMemoryBudget, "Print the memory plan of the decoding channels and refuse to decode if they need more than this memory (MB), needs --prealloc-args or --probe");
 
   opt.parse(argc, argv);
 
@@ -578,6 +619,17 @@ static void FillInternalOffsets(AL_TSrcMetaData* pMeta, AL_EFbStorageMode eFBSto
   pMeta->tOffsetYC.iChroma = AL_GetAllocSize_DecReference(tDim, pMeta->tPitches.iLuma, CHROMA_MONO, eFBStorageMode);
 }
 
+static TFourCC GetPlanarFourCC(AL_EChromaMode eChromaMode, int iBdOut)
+{
+  switch(eChromaMode)
+  {
+  case CHROMA_MONO: return (iBdOut > 8) ? FOURCC(Y010) : FOURCC(Y800);
+  case CHROMA_4_2_2: return (iBdOut > 8) ? FOURCC(I2AL) : FOURCC(I422);
+  case CHROMA_4_4_4: return (iBdOut > 8) ? FOURCC(I4AL) : FOURCC(I444);
+  default: return (iBdOut > 8) ? FOURCC(I0AL) : FOURCC(I420);
+  }
+}
+
 static void ConvertFrameBuffer(AL_TBuffer& input, int iBdIn, AL_TBuffer& output, int iBdOut)
 {
   auto pRecMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(&input, AL_META_TYPE_SOURCE);
@@ -602,13 +654,14 @@ static void ConvertFrameBuffer(AL_TBuffer& input, int iBdIn, AL_TBuffer& output,
   }
 
   auto pYuvMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(&output, AL_META_TYPE_SOURCE);
+  pYuvMeta->tFourCC = GetPlanarFourCC(tPicFormat.eChromaMode, iBdOut);
   pYuvMeta->tDim.iWidth = pRecMeta->tDim.iWidth;
   pYuvMeta->tDim.iHeight = pRecMeta->tDim.iHeight;
   pYuvMeta->tPitches.iLuma = iSizePix * pRecMeta->tDim.iWidth;
   pYuvMeta->tPitches.iChroma = iSizePix * ((tPicFormat.eChromaMode == CHROMA_4_4_4) ? pRecMeta->tDim.iWidth : pRecMeta->tDim.iWidth >> 1);
-  /* unused */
   pYuvMeta->tOffsetYC.iLuma = 0;
-  pYuvMeta->tOffsetYC.iChroma = 0;
+  pYuvMeta->tOffsetYC.iChroma = pYuvMeta->tPitches.iLuma * pRecMeta->tDim.iHeight;
+  AL_SrcMetaData_SetCrop(pYuvMeta, 0, 0, 0, 0);
 
   auto AllegroConvert = GetConversionFunction(pRecMeta->tFourCC, iBdOut);
   AllegroConvert(&input, &output);
@@ -641,6 +694,7 @@ struct Display
   int iBitDepth = 8;
   unsigned int NumFrames = 0;
   unsigned int MaxFrames = UINT_MAX;
+  bool bShowStatus = true;
   mutex hMutex;
   int iNumFrameConceal = 0;
 };
@@ -697,7 +751,9 @@ static void sFrameDisplay(AL_TBuffer* pFrame, AL_TInfoDecode* pInfo, void* pUser
 
 void Display::Process(AL_TBuffer* pFrame, AL_TInfoDecode* pInfo)
 {
+  AL_Trace_Begin("app.display.lock", 0);
   unique_lock<mutex> lock(hMutex);
+  AL_Trace_End("app.display.lock");
 
   auto eErr = AL_Decoder_GetLastError(hDec);
 
@@ -731,10 +787,13 @@ void Display::Process(AL_TBuffer* pFrame, AL_TInfoDecode* pInfo)
 
   assert(AL_Buffer_GetData(pFrame));
 
+  AL_Trace_Begin("app.write_frame", NumFrames);
   ProcessFrame(*pFrame, *pInfo, iBitDepth);
+  AL_Trace_End("app.write_frame");
   AL_Decoder_PutDisplayPicture(hDec, pFrame);
 
-  DisplayFrameStatus(NumFrames);
+  if(bShowStatus)
+    DisplayFrameStatus(NumFrames);
   NumFrames++;
 
   if(NumFrames > MaxFrames)
@@ -755,7 +814,6 @@ void Display::ProcessFrame(AL_TBuffer& tRecBuf, AL_TInfoDecode info, int iBdOut)
 
 void Display::ProcessNotCompressedFrame(AL_TBuffer& tRecBuf, AL_TInfoDecode info, int iBdOut)
 {
-  auto pRecMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(&tRecBuf, AL_META_TYPE_SOURCE);
   auto pYuvMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(YuvBuffer, AL_META_TYPE_SOURCE);
 
   if(YuvFile.is_open() || CertCrcFile.is_open())
@@ -768,39 +826,17 @@ void Display::ProcessNotCompressedFrame(AL_TBuffer& tRecBuf, AL_TInfoDecode info
     if(iBdOut > 8)
       iBdOut = 10;
 
-    auto const iSizePix = (iBdOut + 7) >> 3;
-
     ConvertFrameBuffer(tRecBuf, iBdIn, *YuvBuffer, iBdOut);
 
+    // the display window is only described in the metadata, the samples stay in place
     if(info.tCrop.bCropping)
-      CropFrame(YuvBuffer, iSizePix, info.tCrop.uCropOffsetLeft, info.tCrop.uCropOffsetRight, info.tCrop.uCropOffsetTop, info.tCrop.uCropOffsetBottom);
+      AL_SrcMetaData_SetCrop(pYuvMeta, info.tCrop.uCropOffsetLeft, info.tCrop.uCropOffsetRight, info.tCrop.uCropOffsetTop, info.tCrop.uCropOffsetBottom);
 
     if(CertCrcFile.is_open())
-    {
-      // compute crc
-      int sx = 1, sy = 1;
-      AL_GetSubsampling(pRecMeta->tFourCC, &sx, &sy);
-      int const iNumPix = pYuvMeta->tDim.iHeight * pYuvMeta->tDim.iWidth;
-      int const iNumPixC = iNumPix / sx / sy;
-      auto eChromaMode = AL_GetChromaMode(pRecMeta->tFourCC);
-
-      if(iBdOut == 8)
-      {
-        uint8_t* pBuf = AL_Buffer_GetData(YuvBuffer);
-        Compute_CRC(info.uBitDepthY, info.uBitDepthC, iBdOut, iNumPix, iNumPixC, eChromaMode, pBuf, CertCrcFile);
-      }
-      else
-      {
-        uint16_t* pBuf = (uint16_t*)AL_Buffer_GetData(YuvBuffer);
-        Compute_CRC(info.uBitDepthY, info.uBitDepthC, iBdOut, iNumPix, iNumPixC, eChromaMode, pBuf, CertCrcFile);
-      }
-    }
+      Compute_CRC(info.uBitDepthY, info.uBitDepthC, iBdOut, YuvBuffer, CertCrcFile);
 
     if(YuvFile.is_open())
-    {
-      auto uSize = GetPictureSizeInSamples(pYuvMeta) * iSizePix;
-      YuvFile.write((const char*)AL_Buffer_GetData(YuvBuffer), uSize);
-    }
+      WriteVisibleFrame(YuvFile, YuvBuffer);
   }
 }
 
@@ -926,22 +962,58 @@ void ShowStatistics(double durationInSeconds, int iNumFrameConceal, int decodedF
 /******************************************************************************/
 struct AsyncFileInput
 {
-  AsyncFileInput(AL_HDecoder hDec_, string path, BufPool& bufPool_)
-    : hDec(hDec_), bufPool(bufPool_)
+  AsyncFileInput(AL_HDecoder hDec_, string path, BufPool& bufPool_, AL_EVENT hExitMain_, SeekPoint const* pSeek = nullptr)
+    : hDec(hDec_), bufPool(bufPool_), hExitMain(hExitMain_)
   {
     exit = false;
     OpenInput(ifFileStream, path);
+
+    // start on a random access point, after the parameter sets it uses
+    if(pSeek)
+    {
+      prefix = pSeek->paramSets;
+      ifFileStream.seekg(pSeek->uOffset);
+    }
+
     m_thread = thread(&AsyncFileInput::run, this);
   }
 
   ~AsyncFileInput()
+  {
+    exit = true;
+
+    if(m_thread.joinable())
+      m_thread.join();
+  }
+
+  /* stops the reader and rethrows, on the calling thread, the error that stopped it */
+  void Join()
   {
     exit = true;
     m_thread.join();
+
+    if(error)
+      rethrow_exception(error);
   }
 
 private:
   void run()
+  {
+    AL_Trace_NameThread("input");
+
+    try
+    {
+      ReadLoop();
+    }
+    catch(...)
+    {
+      // an exception escaping the thread would terminate the process: hand it to the consumer
+      error = current_exception();
+      Rtos_SetEvent(hExitMain);
+    }
+  }
+
+  void ReadLoop()
   {
     while(!exit)
     {
@@ -957,7 +1029,9 @@ private:
         continue;
       }
 
-      auto uAvailSize = ReadStream(ifFileStream, pBufStream.get());
+      AL_Trace_Begin("app.read_stream", 0);
+      auto uAvailSize = ReadInput(pBufStream.get());
+      AL_Trace_End("app.read_stream");
 
       if(!uAvailSize)
       {
@@ -966,30 +1040,96 @@ private:
         break;
       }
 
-      auto bRet = AL_Decoder_PushBuffer(hDec, pBufStream.get(), uAvailSize);
+      AL_Trace_Begin("app.push_buffer", uAvailSize);
+      auto eErr = PushBuffer(pBufStream.get(), uAvailSize);
+      AL_Trace_End("app.push_buffer");
 
-      if(!bRet)
-        throw runtime_error("Failed to push buffer");
+      if(eErr != AL_SUCCESS && eErr != AL_WARN_INPUT_FULL)
+        throw codec_error(eErr);
     }
   }
 
+  uint32_t ReadInput(AL_TBuffer* pBufStream)
+  {
+    if(zPrefixRead == prefix.size())
+      return ReadStream(ifFileStream, pBufStream);
+
+    auto const zSize = min(pBufStream->zSize, prefix.size() - zPrefixRead);
+    Rtos_Memcpy(AL_Buffer_GetData(pBufStream), prefix.data() + zPrefixRead, zSize);
+    zPrefixRead += zSize;
+    return (uint32_t)zSize;
+  }
+
+  /* the decoder input is full until it decodes some data: keep an eye on exit while waiting */
+  AL_ERR PushBuffer(AL_TBuffer* pBuf, size_t uSize)
+  {
+    AL_ERR eErr = AL_WARN_INPUT_FULL;
+
+    while(eErr == AL_WARN_INPUT_FULL && !exit)
+      eErr = AL_Decoder_TryPushBuffer(hDec, pBuf, uSize, 100);
+
+    return eErr;
+  }
+
   const AL_HDecoder hDec;
   ifstream ifFileStream;
+  vector<uint8_t> prefix; // pushed before the file content
+  size_t zPrefixRead = 0;
   BufPool& bufPool;
+  AL_EVENT const hExitMain;
+  exception_ptr error;
   atomic<bool> exit;
   thread m_thread;
 };
 
 /******************************************************************************/
-void SafeMain(int argc, char** argv)
+struct StreamStats
 {
-  auto const Config = ParseCommandLine(argc, argv);
+  int iDecodedFrames = 0;
+  int iNumFrameConceal = 0;
+  double fDuration = 0;
+  bool bTimeout = false;
+};
 
-  if(Config.help)
-    return;
+/* file.ext -> file_<iStream>.ext, unchanged when there is only one stream */
+static string StreamFileName(string const& sFile, int iStream)
+{
+  if(iStream < 0 || sFile.empty())
+    return sFile;
 
-  DisplayVersionInfo();
+  auto const zDot = sFile.find_last_of('.');
+  auto const zSlash = sFile.find_last_of("/\\");
+  auto const zSuffix = (zDot == string::npos || (zSlash != string::npos && zDot < zSlash)) ? sFile.size() : zDot;
+
+  return sFile.substr(0, zSuffix) + "_" + to_string(iStream) + sFile.substr(zSuffix);
+}
+
+/******************************************************************************/
+static AL_TStreamProbe ProbeStream(string const& sIn, AL_TDecSettings const& settings)
+{
+  static size_t const zProbeSize = 1024 * 1024;
+
+  ifstream ifs;
+  OpenInput(ifs, sIn);
 
+  vector<uint8_t> head(zProbeSize);
+  ifs.read((char*)head.data(), head.size());
+
+  AL_TStreamProbe tProbe;
+  auto const eErr = AL_Decoder_ProbeStream(&settings, head.data(), ifs.gcount(), &tProbe);
+
+  if(eErr != AL_SUCCESS)
+    throw codec_error(eErr);
+
+  auto const& tStream = tProbe.tStreamSettings;
+  Message(CC_DEFAULT, "Probed %dx%d, profile %d, level %d, %d bits: %d buffers of %d bytes\n", tStream.tDim.iWidth, tStream.tDim.iHeight, tStream.iProfileIdc, tStream.iLevel, tStream.iBitDepth, tProbe.iNumFrameBuffers, tProbe.iFrameBufferSize);
+
+  return tProbe;
+}
+
+/******************************************************************************/
+static StreamStats DecodeStream(Config const& Config, string const& sIn, int iStream, AL_HFeederPool hFeederPool)
+{
   // IP Device ------------------------------------------------------------
   auto iUseBoard = Config.iUseBoard;
 
@@ -1005,8 +1145,7 @@ void SafeMain(int argc, char** argv)
     break;
   }
 
-  auto pIpDevice = CreateIpDevice(&iUseBoard, Config.iSchedulerType, wrapIpCtrl, Config.trackDma, Config.tDecSettings.uNumCore, Config.hangers);
-
+  auto pIpDevice = CreateIpDevice(&iUseBoard, Config.iSchedulerType, wrapIpCtrl, Config.trackDma, Config.tDecSettings.uNumCore, Config.hangers, StreamFileName(Config.sRecordDriver, iStream));
 
   auto pAllocator = pIpDevice->m_pAllocator.get();
   auto pDecChannel = pIpDevice->m_pDecChannel;
@@ -1025,12 +1164,24 @@ void SafeMain(int argc, char** argv)
     AL_Buffer_Destroy(YuvBuffer);
   });
 
+  AL_TDecSettings Settings = Config.tDecSettings;
+  Settings.hFeederPool = hFeederPool;
+  auto zInputBufferSize = Config.zInputBufferSize;
+
+  if(Config.bProbeStream && invalidPreallocSettings(Settings.tStream))
+  {
+    Settings.tStream = ProbeStream(sIn, Settings).tStreamSettings;
+
+    if(zInputBufferSize == zDefaultInputBufferSize)
+      zInputBufferSize = AL_GetMaxNalSize(Settings.tStream.tDim, Settings.tStream.eChroma, Settings.tStream.iBitDepth);
+  }
+
   BufPool bufPool;
 
   {
     AL_TBufPoolConfig BufPoolConfig {};
 
-    BufPoolConfig.zBufSize = Config.zInputBufferSize;
+    BufPoolConfig.zBufSize = zInputBufferSize;
     BufPoolConfig.uNumBuf = Config.uInputBufferNum;
     BufPoolConfig.pMetaData = nullptr;
     BufPoolConfig.debugName = "stream";
@@ -1045,27 +1196,26 @@ void SafeMain(int argc, char** argv)
 
   if(Config.bEnableYUVOutput)
   {
-    OpenOutput(display.YuvFile, Config.sOut);
+    OpenOutput(display.YuvFile, StreamFileName(Config.sOut, iStream));
 
   }
 
   if(bCertCRC)
   {
-    OpenOutput(display.CertCrcFile, "crc_certif_res.hex", false);
+    OpenOutput(display.CertCrcFile, StreamFileName("crc_certif_res.hex", iStream), false);
     display.CertCrcFile << hex << uppercase;
   }
 
   if(!Config.sCrc.empty())
   {
-    OpenOutput(display.IpCrcFile, Config.sCrc, false);
+    OpenOutput(display.IpCrcFile, StreamFileName(Config.sCrc, iStream), false);
     display.IpCrcFile << hex << uppercase;
   }
 
   display.YuvBuffer = YuvBuffer;
   display.iBitDepth = Config.tDecSettings.iBitDepth;
   display.MaxFrames = Config.iMaxFrames;
-
-  AL_TDecSettings Settings = Config.tDecSettings;
+  display.bShowStatus = iStream < 0;
 
   ResChgParam ResolutionFoundParam;
   ResolutionFoundParam.pAllocator = pAllocator;
@@ -1102,13 +1252,25 @@ void SafeMain(int argc, char** argv)
 
   AL_Decoder_SetParam(hDec, Config.bConceal, iUseBoard ? true : false, Config.iNumTrace, Config.iNumberTrace);
 
-  if(!invalidPreallocSettings(Config.tDecSettings.tStream))
+  if(!invalidPreallocSettings(Settings.tStream))
   {
     if(!AL_Decoder_PreallocateBuffers(hDec))
       if(auto eErr = AL_Decoder_GetLastError(hDec))
         throw codec_error(eErr);
   }
 
+  unique_ptr<SeekPoint> pSeek;
+
+  if(Config.iSeekFrame >= 0)
+  {
+    if(Config.tDecSettings.bLengthPrefixed)
+      throw runtime_error("--seek-frame needs an annex B input");
+
+    auto const index = GetStreamIndex(sIn, Config.tDecSettings.eCodec);
+    pSeek.reset(new SeekPoint(FindSeekPoint(index, sIn, Config.iSeekFrame)));
+    Message(CC_DEFAULT, "Seeking to frame %d: decoding from frame %d (offset %llu)\n", Config.iSeekFrame, pSeek->iFrame, (unsigned long long)pSeek->uOffset);
+  }
+
   // Initial stream buffer filling
   auto const uBegin = GetPerfTime();
   bool timeoutOccured = false;
@@ -1118,7 +1280,7 @@ void SafeMain(int argc, char** argv)
     if(iLoop > 0)
       Message(CC_GREY, "  Looping\n");
 
-    AsyncFileInput producer(hDec, Config.sIn, bufPool);
+    AsyncFileInput producer(hDec, sIn, bufPool, display.hExitMain, pSeek.get());
 
     auto const maxWait = Config.iTimeoutInSeconds * 1000;
     auto const timeout = maxWait >= 0 ? maxWait : AL_WAIT_FOREVER;
@@ -1126,6 +1288,7 @@ void SafeMain(int argc, char** argv)
     if(!Rtos_WaitEvent(display.hExitMain, timeout))
       timeoutOccured = true;
     bufPool.Decommit();
+    producer.Join();
   }
 
   auto const uEnd = GetPerfTime();
@@ -1138,8 +1301,163 @@ void SafeMain(int argc, char** argv)
   if(!tDecodeParam.decodedFrames)
     throw runtime_error("No frame decoded");
 
-  auto const duration = (uEnd - uBegin) / 1000.0;
-  ShowStatistics(duration, display.iNumFrameConceal, tDecodeParam.decodedFrames, timeoutOccured);
+  StreamStats stats;
+  stats.iDecodedFrames = tDecodeParam.decodedFrames;
+  stats.iNumFrameConceal = display.iNumFrameConceal;
+  stats.fDuration = (uEnd - uBegin) / 1000.0;
+  stats.bTimeout = timeoutOccured;
+  return stats;
+}
+
+/******************************************************************************/
+static void CheckDecoderMemoryBudget(Config const& Config, vector<string> const& inputs)
+{
+  uint64_t uPeakSize = 0;
+
+  for(auto& sIn : inputs)
+  {
+    AL_TDecSettings Settings = Config.tDecSettings;
+
+    if(Config.bProbeStream && invalidPreallocSettings(Settings.tStream))
+      Settings.tStream = ProbeStream(sIn, Settings).tStreamSettings;
+
+    if(invalidPreallocSettings(Settings.tStream))
+      throw runtime_error("The memory budget needs the stream settings, use --prealloc-args or --probe");
+
+    AL_TMemoryPlan tPlan;
+
+    if(!AL_Decoder_GetMemoryPlan(&Settings, &tPlan))
+      throw runtime_error("Can't plan the memory of the channel");
+
+    auto const& tStream = Settings.tStream;
+    uint32_t const uSizeYuv = AL_GetAllocSize_Frame(tStream.tDim, tStream.eChroma, tStream.iBitDepth, Settings.bFrameBufferCompression, Settings.eFBStorageMode);
+    AL_MemoryPlan_Add(&tPlan, "held yuv", AL_MEM_APPLICATION, uSizeYuv, uDefaultNumBuffersHeldByNextComponent);
+
+    PrintMemoryPlan(tPlan);
+    uPeakSize += tPlan.uPeakSize;
+  }
+
+  CheckMemoryBudget(uPeakSize, Config.iMemoryBudget);
+}
+
+/******************************************************************************/
+static void DecodeStreams(Config const& Config, int iFeederThreads)
+{
+  vector<string> inputs { Config.sIn };
+  inputs.insert(inputs.end(), Config.extraInputs.begin(), Config.extraInputs.end());
+
+  int const iNumStreams = (int)inputs.size();
+  AL_HFeederPool hFeederPool = NULL;
+
+  if(Config.iMemoryBudget > 0)
+    CheckDecoderMemoryBudget(Config, inputs);
+
+  if(iFeederThreads > 0)
+  {
+    hFeederPool = AL_FeederPool_Create(iFeederThreads);
+
+    if(!hFeederPool)
+      throw runtime_error("Can't create the feeder pool");
+  }
+
+  auto scopePool = scopeExit([&]() {
+    AL_FeederPool_Destroy(hFeederPool);
+  });
+
+  if(iNumStreams == 1)
+  {
+    auto const stats = DecodeStream(Config, Config.sIn, -1, hFeederPool);
+    ShowStatistics(stats.fDuration, stats.iNumFrameConceal, stats.iDecodedFrames, stats.bTimeout);
+    return;
+  }
+
+  vector<StreamStats> stats(iNumStreams);
+  vector<exception_ptr> errors(iNumStreams);
+  vector<thread> streams;
+
+  auto const uBegin = GetPerfTime();
+
+  for(int i = 0; i < iNumStreams; ++i)
+  {
+    streams.emplace_back([&, i]()
+    {
+      try
+      {
+        stats[i] = DecodeStream(Config, inputs[i], i, hFeederPool);
+      }
+      catch(...)
+      {
+        errors[i] = current_exception();
+      }
+    });
+  }
+
+  for(auto& stream : streams)
+    stream.join();
+
+  auto const duration = (GetPerfTime() - uBegin) / 1000.0;
+  int iTotalFrames = 0;
+
+  Message(CC_DEFAULT, "\n");
+
+  for(int i = 0; i < iNumStreams; ++i)
+  {
+    if(errors[i])
+    {
+      Message(CC_RED, "Stream %d (%s): failed\n", i, inputs[i].c_str());
+      continue;
+    }
+
+    auto const& s = stats[i];
+    Message(CC_DEFAULT, "Stream %d (%s): %d frame(s) in %.4f s; %.4f Fps; %d conceal%s\n", i, inputs[i].c_str(), s.iDecodedFrames, s.fDuration, s.iDecodedFrames / s.fDuration, s.iNumFrameConceal, s.bTimeout ? "; TIMEOUT" : "");
+    iTotalFrames += s.iDecodedFrames;
+  }
+
+  Message(CC_DEFAULT, "All %d streams: %d frame(s) in %.4f s; Aggregate FrameRate ~ %.4f Fps\n", iNumStreams, iTotalFrames, duration, iTotalFrames / duration);
+
+  for(auto& error : errors)
+  {
+    if(error)
+      rethrow_exception(error);
+  }
+}
+
+/******************************************************************************/
+void SafeMain(int argc, char** argv)
+{
+  auto const Config = ParseCommandLine(argc, argv);
+
+  if(Config.help)
+    return;
+
+  DisplayVersionInfo();
+
+  if(!Config.sLatencyStats.empty())
+    AL_PipelineStats_Enable(true);
+
+  if(!Config.sTraceFile.empty() && !AL_Tracer_Start(AL_TRACER_DEFAULT_EVENTS_PER_THREAD))
+    throw runtime_error("Can't start the tracer");
+
+  int iFeederThreads = Config.iFeederThreads;
+
+  if(iFeederThreads < 0)
+  {
+    int const iNumStreams = 1 + (int)Config.extraInputs.size();
+    iFeederThreads = iNumStreams == 1 ? 0 : min(iNumStreams, max(1, (int)thread::hardware_concurrency()));
+  }
+
+  DecodeStreams(Config, iFeederThreads);
+
+  if(!Config.sLatencyStats.empty() && !AL_PipelineStats_Export(Config.sLatencyStats.c_str()))
+    throw runtime_error("Can't write the latency statistics in " + Config.sLatencyStats);
+
+  if(!Config.sTraceFile.empty())
+  {
+    AL_Tracer_Stop();
+
+    if(!AL_Tracer_Export(Config.sTraceFile.c_str()))
+      throw runtime_error("Can't write the trace in " + Config.sTraceFile);
+  }
 }
 
 /******************************************************************************/
@@ -4,6 +4,7 @@ EXE_DECODER_SRC:=\
   exe_decoder/IpDevice.cpp\
   exe_decoder/CodecUtils.cpp\
   exe_decoder/Conversion.cpp\
+  exe_decoder/StreamIndex.cpp\
   $(LIB_APP_SRC)\
 
 -include exe_decoder/site.mk
@@ -0,0 +1,89 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+extern "C"
+{
+#include "lib_common/IDriver.h"
+#include "lib_fpga/DriverRecord.h"
+}
+
+/* statuses reported by the libraries. A request is issued once the statuses
+ * the application had seen when it issued it are back */
+struct StatusCounter
+{
+  void Notify(bool bFrame);
+  bool WaitFor(int iNumStatus, std::chrono::milliseconds timeout);
+
+  std::mutex hMutex;
+  std::condition_variable hChanged;
+  int iNumStatus = 0;
+  int iNumFrames = 0;
+};
+
+/*
+ * Replays the recorded channels of one library through its driver facing
+ * layer (the decoder channel or the encoder scheduler) on the replay driver.
+ * The recorded requests are turned into library calls before the replay, so
+ * the conversion of the payloads isn't part of the figures.
+ */
+class CodecReplay
+{
+public:
+  virtual ~CodecReplay() = default;
+
+  /* the channel whose first request is tRequest is replayed by this library */
+  virtual bool Owns(AL_TDriverRecord const& tRequest) const = 0;
+
+  /* the call replaying tRequest. Empty when the library sends it on its own,
+   * like the start code wait of a search. Opening a channel is part of its
+   * first request */
+  virtual std::function<void()> Prepare(AL_TDriverRecord const& tRequest) = 0;
+
+  /* destroys the channels the recording left open */
+  virtual void Finish() = 0;
+};
+
+std::unique_ptr<CodecReplay> CreateDecoderReplay(AL_TDriver* pDriver, StatusCounter& counter);
+std::unique_ptr<CodecReplay> CreateEncoderReplay(AL_TDriver* pDriver, StatusCounter& counter);
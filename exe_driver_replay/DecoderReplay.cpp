@@ -0,0 +1,235 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <cstring>
+#include <map>
+#include <stdexcept>
+
+#include "CodecReplay.h"
+
+extern "C"
+{
+#include "lib_decode/I_DecChannel.h"
+#include "allegro_ioctl_mcu_dec.h"
+AL_TIDecChannel* AL_DecChannelMcu_Create(AL_TDriver*);
+}
+
+using namespace std;
+
+/* the decoder channel gives the firmware uncached addresses (see DecChannelMcu.c) */
+static uint32_t const DCacheOffset = 0x80000000;
+
+template<typename T>
+static T ReadRequest(AL_TDriverRecord const& tRequest)
+{
+  if(tRequest.uSize < sizeof(T) || !tRequest.pIn)
+    throw runtime_error("Truncated decoder request in the recording");
+
+  T msg;
+  memcpy(&msg, tRequest.pIn, sizeof(T));
+  return msg;
+}
+
+template<typename T>
+static T ReadParams(struct al5_params const& params)
+{
+  T t {};
+  memcpy(&t, params.opaque, min<size_t>(params.size, sizeof(T)));
+  return t;
+}
+
+static TMemDesc ToSliceParams(uint32_t uSliceParamV)
+{
+  TMemDesc tSliceParams {};
+  tSliceParams.uPhysicalAddr = uSliceParamV - DCacheOffset;
+  return tSliceParams;
+}
+
+static void OnEndFrameDecoding(void* pUserParam, AL_TDecPicStatus*)
+{
+  static_cast<StatusCounter*>(pUserParam)->Notify(true);
+}
+
+static void OnEndStartCode(void* pUserParam, AL_TScStatus*)
+{
+  static_cast<StatusCounter*>(pUserParam)->Notify(false);
+}
+
+/******************************************************************************/
+struct DecodeRequest
+{
+  AL_TDecPicParam tPictParam;
+  AL_TDecPicBufferAddrs tPictAddrs;
+  TMemDesc tSliceParams;
+  int iNumSlices;
+};
+
+class DecoderReplay : public CodecReplay
+{
+public:
+  DecoderReplay(AL_TDriver* pDriver, StatusCounter& counter) : pDriver(pDriver), counter(counter)
+  {
+    /* the start code searches of every decoder go through one channel object:
+     * a search opens its own channel and doesn't depend on the decoding one */
+    pScChannel = AL_DecChannelMcu_Create(pDriver);
+
+    if(!pScChannel)
+      throw runtime_error("Can't create the decoder channel");
+  }
+
+  ~DecoderReplay()
+  {
+    Finish();
+  }
+
+  bool Owns(AL_TDriverRecord const& tRequest) const override
+  {
+    return tRequest.uMessageId == AL_MCU_CONFIG_CHANNEL || tRequest.uMessageId == AL_MCU_SEARCH_START_CODE;
+  }
+
+  function<void()> Prepare(AL_TDriverRecord const& tRequest) override
+  {
+    switch(tRequest.uMessageId)
+    {
+    case AL_MCU_CONFIG_CHANNEL:
+    {
+      auto msg = ReadRequest<struct al5_channel_config>(tRequest);
+      auto pChannel = AL_DecChannelMcu_Create(pDriver);
+
+      if(!pChannel)
+        throw runtime_error("Can't create the decoder channel");
+      channels[tRequest.iChannel] = pChannel;
+
+      auto tChanParam = ReadParams<AL_TDecChanParam>(msg.param);
+      AL_CB_EndFrameDecoding callback = { &OnEndFrameDecoding, &counter };
+      return [=]() mutable
+             {
+               AL_IDecChannel_Configure(pChannel, &tChanParam, callback);
+             };
+    }
+    case AL_MCU_SEARCH_START_CODE:
+    {
+      auto msg = ReadRequest<struct al5_search_sc_msg>(tRequest);
+      auto tScParam = ReadParams<AL_TScParam>(msg.param);
+      auto tBufAddrs = ReadParams<AL_TScBufferAddrs>(msg.buffer_addrs);
+      AL_CB_EndStartCode callback = { &OnEndStartCode, &counter };
+      auto pChannel = pScChannel;
+      return [=]() mutable
+             {
+               AL_IDecChannel_SearchSC(pChannel, &tScParam, &tBufAddrs, callback);
+             };
+    }
+    case AL_MCU_DECODE_ONE_FRM:
+    case AL_MCU_DECODE_ONE_SLICE:
+    {
+      auto msg = ReadRequest<struct al5_decode_msg>(tRequest);
+      DecodeRequest req { ReadParams<AL_TDecPicParam>(msg.params), ReadParams<AL_TDecPicBufferAddrs>(msg.addresses), ToSliceParams(msg.slice_param_v), 1 };
+      auto pChannel = GetChannel(tRequest);
+
+      if(tRequest.uMessageId == AL_MCU_DECODE_ONE_FRM)
+        return [=]() mutable
+               {
+                 AL_IDecChannel_DecodeOneFrame(pChannel, &req.tPictParam, &req.tPictAddrs, &req.tSliceParams);
+               };
+      return [=]() mutable
+             {
+               AL_IDecChannel_DecodeOneSlice(pChannel, &req.tPictParam, &req.tPictAddrs, &req.tSliceParams);
+             };
+    }
+    case AL_MCU_DECODE_SLICE_BATCH:
+    {
+      auto msg = ReadRequest<struct al5_decode_batch_msg>(tRequest);
+      DecodeRequest req { ReadParams<AL_TDecPicParam>(msg.params), ReadParams<AL_TDecPicBufferAddrs>(msg.addresses), ToSliceParams(msg.slice_param_v), (int)msg.num_slices };
+      auto pChannel = GetChannel(tRequest);
+      return [=]() mutable
+             {
+               AL_IDecChannel_DecodeSliceBatch(pChannel, &req.tPictParam, &req.tPictAddrs, &req.tSliceParams, req.iNumSlices);
+             };
+    }
+    case AL_MCU_DESTROY_CHANNEL:
+    {
+      auto it = channels.find(tRequest.iChannel);
+
+      /* the destroy message of a search channel doesn't exist */
+      if(it == channels.end())
+        return nullptr;
+
+      auto pChannel = it->second;
+      channels.erase(it);
+      return [=]()
+             {
+               AL_IDecChannel_Destroy(pChannel);
+             };
+    }
+    default:
+      return nullptr;
+    }
+  }
+
+  void Finish() override
+  {
+    for(auto& channel : channels)
+      AL_IDecChannel_Destroy(channel.second);
+
+    channels.clear();
+
+    if(pScChannel)
+      AL_IDecChannel_Destroy(pScChannel);
+    pScChannel = nullptr;
+  }
+
+private:
+  AL_TIDecChannel* GetChannel(AL_TDriverRecord const& tRequest)
+  {
+    auto it = channels.find(tRequest.iChannel);
+
+    if(it == channels.end())
+      throw runtime_error("Decoding request on a channel that wasn't configured");
+
+    return it->second;
+  }
+
+  AL_TDriver* pDriver;
+  StatusCounter& counter;
+  AL_TIDecChannel* pScChannel;
+  map<int, AL_TIDecChannel*> channels; // by recorded channel, until their destroy request is prepared
+};
+
+unique_ptr<CodecReplay> CreateDecoderReplay(AL_TDriver* pDriver, StatusCounter& counter)
+{
+  return unique_ptr<CodecReplay>(new DecoderReplay(pDriver, counter));
+}
@@ -0,0 +1,375 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <cstring>
+#include <deque>
+#include <map>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "CodecReplay.h"
+
+extern "C"
+{
+#include "lib_encode/IScheduler.h"
+#include "lib_encode/SchedulerMcu.h"
+#include "lib_fpga/DmaAllocLinux.h"
+#include "allegro_ioctl_mcu_enc.h"
+}
+
+using namespace std;
+
+/* the scheduler gives the firmware uncached addresses (see DriverDataConversions.h) */
+static uint32_t const DCacheOffset = 0x80000000;
+
+/******************************************************************************/
+/* The dma buffers of the recording only exist as the file descriptors carried
+ * by the requests. The scheduler closes the descriptor of a reconstructed
+ * picture when it releases it, so an imported buffer gets a descriptor of its own */
+struct ReplayBuffer
+{
+  int fd;
+};
+
+static bool DestroyAllocator(AL_TAllocator*)
+{
+  return true;
+}
+
+static AL_HANDLE Alloc(AL_TAllocator*, size_t)
+{
+  return nullptr;
+}
+
+static AL_HANDLE AllocNamed(AL_TAllocator*, size_t, char const*)
+{
+  return nullptr;
+}
+
+static bool Free(AL_TAllocator*, AL_HANDLE hBuf)
+{
+  delete static_cast<ReplayBuffer*>(hBuf);
+  return true;
+}
+
+static AL_VADDR GetVirtualAddr(AL_TAllocator*, AL_HANDLE)
+{
+  return nullptr;
+}
+
+static AL_PADDR GetPhysicalAddr(AL_TAllocator*, AL_HANDLE)
+{
+  return 0;
+}
+
+static int GetFd(AL_TLinuxDmaAllocator*, AL_HANDLE hBuf)
+{
+  return static_cast<ReplayBuffer*>(hBuf)->fd;
+}
+
+static AL_HANDLE ImportFromFd(AL_TLinuxDmaAllocator*, int)
+{
+  int fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+
+  if(fd < 0)
+    return nullptr;
+
+  return new ReplayBuffer { fd };
+}
+
+static AL_DmaAllocLinuxVtable const ReplayAllocatorVtable =
+{
+  {
+    &DestroyAllocator,
+    &Alloc,
+    &Free,
+    &GetVirtualAddr,
+    &GetPhysicalAddr,
+    &AllocNamed,
+  },
+  &GetFd,
+  &ImportFromFd,
+};
+
+/******************************************************************************/
+template<typename T>
+static T ReadRequest(AL_TDriverRecord const& tRequest)
+{
+  if(tRequest.uSize < sizeof(T) || !tRequest.pIn)
+    throw runtime_error("Truncated encoder request in the recording");
+
+  T msg;
+  memcpy(&msg, tRequest.pIn, sizeof(T));
+  return msg;
+}
+
+/* reads the fields in the order setChannelParam and setEncodeMsg wrote them */
+static void ReadParams(struct al5_params const& params, uint32_t& uOffset, void* pData, uint32_t uSize)
+{
+  if(uOffset + uSize > params.size)
+    throw runtime_error("Truncated encoder request in the recording");
+
+  memcpy(pData, (uint8_t const*)params.opaque_params + uOffset, uSize);
+  uOffset += uSize;
+}
+
+static void OnEndEncoding(void* pUserParam, AL_TEncPicStatus* pPicStatus, AL_64U)
+{
+  static_cast<StatusCounter*>(pUserParam)->Notify(pPicStatus != nullptr);
+}
+
+/******************************************************************************/
+struct EncChannel
+{
+  AL_HANDLE hChannel = AL_INVALID_CHANNEL;
+  deque<TRecPic> recPics; // given by the scheduler, not released yet
+};
+
+struct EncodeRequest
+{
+  AL_TEncInfo tEncInfo;
+  AL_TEncRequestInfo tReqInfo;
+  AL_TEncPicBufAddrs tBufAddrs;
+  bool bEmpty;
+};
+
+class EncoderReplay : public CodecReplay
+{
+public:
+  EncoderReplay(AL_TDriver* pDriver, StatusCounter& counter) : counter(counter)
+  {
+    allocator.vtable = &ReplayAllocatorVtable;
+    pScheduler = AL_SchedulerMcu_Create(pDriver, (AL_TAllocator*)&allocator);
+
+    if(!pScheduler)
+      throw runtime_error("Can't create the encoder scheduler");
+  }
+
+  ~EncoderReplay()
+  {
+    Finish();
+  }
+
+  bool Owns(AL_TDriverRecord const& tRequest) const override
+  {
+    return tRequest.uMessageId == AL_MCU_CONFIG_CHANNEL;
+  }
+
+  function<void()> Prepare(AL_TDriverRecord const& tRequest) override
+  {
+    switch(tRequest.uMessageId)
+    {
+    case AL_MCU_CONFIG_CHANNEL:
+    {
+      auto msg = ReadRequest<struct al5_channel_config>(tRequest);
+      auto pChannel = make_shared<EncChannel>();
+      channels[tRequest.iChannel] = pChannel;
+
+      AL_TEncChanParam tChanParam {};
+      uint32_t uEp1VirtAddr = 0;
+      uint32_t uOffset = 0;
+      ReadParams(msg.param, uOffset, &tChanParam, sizeof(tChanParam));
+      ReadParams(msg.param, uOffset, &uEp1VirtAddr, sizeof(uEp1VirtAddr));
+
+      TMemDesc tEP1 {};
+      tEP1.uPhysicalAddr = uEp1VirtAddr - DCacheOffset;
+      bool const bEP1 = uEp1VirtAddr != 0;
+      AL_TISchedulerCallBacks CBs = { &OnEndEncoding, &counter };
+      auto pScheduler = this->pScheduler;
+
+      return [=]() mutable
+             {
+               AL_ISchedulerEnc_CreateChannel(&pChannel->hChannel, pScheduler, &tChanParam, bEP1 ? &tEP1 : nullptr, &CBs);
+             };
+    }
+    case AL_MCU_ENCODE_ONE_FRM:
+    {
+      auto msg = ReadRequest<struct al5_encode_msg>(tRequest);
+      EncodeRequest req {};
+      req.bEmpty = !msg.params.size || !msg.addresses.size;
+
+      if(!req.bEmpty)
+      {
+        uint32_t uOffset = 0;
+        ReadParams(msg.params, uOffset, &req.tEncInfo, sizeof(req.tEncInfo));
+        ReadParams(msg.params, uOffset, &req.tReqInfo.eReqOptions, sizeof(req.tReqInfo.eReqOptions));
+
+        if(req.tReqInfo.eReqOptions & AL_OPT_SCENE_CHANGE)
+          ReadParams(msg.params, uOffset, &req.tReqInfo.uSceneChangeDelay, sizeof(req.tReqInfo.uSceneChangeDelay));
+
+        if(req.tReqInfo.eReqOptions & AL_OPT_UPDATE_PARAMS)
+          ReadParams(msg.params, uOffset, &req.tReqInfo.smartParams, sizeof(req.tReqInfo.smartParams));
+
+        uOffset = 0;
+        ReadParams(msg.addresses, uOffset, &req.tBufAddrs, sizeof(req.tBufAddrs));
+      }
+
+      auto pChannel = GetChannel(tRequest);
+      auto pScheduler = this->pScheduler;
+      return [=]() mutable
+             {
+               if(pChannel->hChannel == AL_INVALID_CHANNEL)
+                 return;
+
+               if(req.bEmpty)
+                 AL_ISchedulerEnc_EncodeOneFrame(pScheduler, pChannel->hChannel, nullptr, nullptr, nullptr);
+               else
+                 AL_ISchedulerEnc_EncodeOneFrame(pScheduler, pChannel->hChannel, &req.tEncInfo, &req.tReqInfo, &req.tBufAddrs);
+             };
+    }
+    case AL_MCU_PUT_STREAM_BUFFER:
+    {
+      auto msg = ReadRequest<struct al5_buffer>(tRequest);
+      AL_TBuffer* pStream = AL_Buffer_Create((AL_TAllocator*)&allocator, new ReplayBuffer { (int)msg.handle }, msg.size, nullptr);
+
+      if(!pStream)
+        throw runtime_error("Can't create a stream buffer");
+      streams.push_back(pStream);
+
+      auto pChannel = GetChannel(tRequest);
+      auto pScheduler = this->pScheduler;
+      return [=]()
+             {
+               if(pChannel->hChannel != AL_INVALID_CHANNEL)
+                 AL_ISchedulerEnc_PutStreamBuffer(pScheduler, pChannel->hChannel, pStream, msg.stream_buffer_ptr, msg.offset);
+             };
+    }
+    case AL_MCU_GET_REC_PICTURE:
+    {
+      auto pChannel = GetChannel(tRequest);
+      auto pScheduler = this->pScheduler;
+      return [=]()
+             {
+               TRecPic tRecPic;
+
+               if(pChannel->hChannel != AL_INVALID_CHANNEL && AL_ISchedulerEnc_GetRecPicture(pScheduler, pChannel->hChannel, &tRecPic))
+                 pChannel->recPics.push_back(tRecPic);
+             };
+    }
+    case AL_MCU_RELEASE_REC_PICTURE:
+    {
+      auto pChannel = GetChannel(tRequest);
+      auto pScheduler = this->pScheduler;
+      return [=]()
+             {
+               if(pChannel->recPics.empty())
+                 return;
+
+               ReleaseRecPicture(pScheduler, *pChannel, pChannel->recPics.front());
+               pChannel->recPics.pop_front();
+             };
+    }
+    case AL_MCU_DESTROY_CHANNEL:
+    {
+      auto pChannel = GetChannel(tRequest);
+      auto pScheduler = this->pScheduler;
+      return [=]()
+             {
+               DestroyChannel(pScheduler, *pChannel);
+             };
+    }
+    default:
+      return nullptr;
+    }
+  }
+
+  void Finish() override
+  {
+    for(auto& channel : channels)
+      DestroyChannel(pScheduler, *channel.second);
+
+    channels.clear();
+
+    for(auto pStream : streams)
+      AL_Buffer_Destroy(pStream);
+
+    streams.clear();
+
+    if(pScheduler)
+      AL_ISchedulerEnc_Destroy(pScheduler);
+    pScheduler = nullptr;
+  }
+
+private:
+  static void ReleaseRecPicture(TScheduler* pScheduler, EncChannel& channel, TRecPic& tRecPic)
+  {
+    if(AL_ISchedulerEnc_ReleaseRecPicture(pScheduler, channel.hChannel, &tRecPic))
+      return;
+
+    /* the recording has no release left for it */
+    auto pBuffer = static_cast<ReplayBuffer*>(tRecPic.tBuf.tMD.hAllocBuf);
+    close(pBuffer->fd);
+    delete pBuffer;
+  }
+
+  static void DestroyChannel(TScheduler* pScheduler, EncChannel& channel)
+  {
+    if(channel.hChannel == AL_INVALID_CHANNEL)
+      return;
+
+    /* the application gives the reconstructed pictures back before destroying the channel */
+    for(auto& tRecPic : channel.recPics)
+      ReleaseRecPicture(pScheduler, channel, tRecPic);
+
+    channel.recPics.clear();
+    AL_ISchedulerEnc_DestroyChannel(pScheduler, channel.hChannel);
+    channel.hChannel = AL_INVALID_CHANNEL;
+  }
+
+  shared_ptr<EncChannel> GetChannel(AL_TDriverRecord const& tRequest)
+  {
+    auto it = channels.find(tRequest.iChannel);
+
+    if(it == channels.end())
+      throw runtime_error("Encoding request on a channel that wasn't configured");
+
+    return it->second;
+  }
+
+  StatusCounter& counter;
+  AL_TLinuxDmaAllocator allocator;
+  TScheduler* pScheduler;
+  map<int, shared_ptr<EncChannel>> channels; // by recorded channel
+  vector<AL_TBuffer*> streams;
+};
+
+unique_ptr<CodecReplay> CreateEncoderReplay(AL_TDriver* pDriver, StatusCounter& counter)
+{
+  return unique_ptr<CodecReplay>(new EncoderReplay(pDriver, counter));
+}
@@ -0,0 +1,371 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <sys/resource.h>
+
+#include "lib_app/CommandLineParser.h"
+#include "CodecReplay.h"
+
+extern "C"
+{
+#include "lib_common/IDriver.h"
+#include "lib_fpga/DriverRecord.h"
+#include "allegro_ioctl_mcu_dec.h"
+}
+
+using namespace std;
+
+/* The requests are replayed through the decoder channel and the encoder
+ * scheduler, on the replay driver: the figures cover the libraries' driver
+ * path, the driver and the event loop. What the device writes in DMA memory
+ * (stream sections, start code tables) isn't recorded, so the parts of the
+ * libraries above these layers can't run. */
+
+/* the encoder and the decoder share the code of their status message */
+static long unsigned int const WaitMessages[] =
+{
+  AL_MCU_WAIT_FOR_STATUS,
+  AL_MCU_WAIT_FOR_START_CODE,
+};
+
+struct Config
+{
+  bool help = false;
+  string sIn;
+  int iLatencyUs = -1;
+};
+
+/******************************************************************************/
+static void Usage(CommandLineParser const& opt, char* ExeName)
+{
+  cerr << "Usage: " << ExeName << " -i <recording> [options]" << endl;
+  cerr << "Replays a driver session recorded with --record-driver through the decoder channel and the encoder scheduler" << endl;
+  cerr << "and reports the host cost of the driver message path. The layers above them are not run" << endl;
+  cerr << "Options:" << endl;
+
+  for(auto& name : opt.displayOrder)
+  {
+    auto& o = opt.options.at(name);
+    cerr << "  " << o.desc << endl;
+  }
+
+  cerr << endl;
+}
+
+static Config ParseCommandLine(int argc, char* argv[])
+{
+  Config cfg;
+
+  auto opt = CommandLineParser();
+
+  opt.addFlag("--help,-h", &cfg.help, "Shows this help");
+  opt.addString("--input,-i", &cfg.sIn, "Recording to replay");
+  opt.addInt("--latency", &cfg.iLatencyUs, "Device latency in microseconds (default: the recorded one)");
+
+  opt.parse(argc, argv);
+
+  if(cfg.help)
+  {
+    Usage(opt, argv[0]);
+    return cfg;
+  }
+
+  if(cfg.sIn.empty())
+    throw runtime_error("No input file specified (use -h to get help)");
+
+  return cfg;
+}
+
+static bool IsWaitMessage(long unsigned int messageId)
+{
+  return find(begin(WaitMessages), end(WaitMessages), messageId) != end(WaitMessages);
+}
+
+/******************************************************************************/
+void StatusCounter::Notify(bool bFrame)
+{
+  unique_lock<mutex> lock(hMutex);
+  ++iNumStatus;
+
+  if(bFrame)
+    ++iNumFrames;
+  hChanged.notify_all();
+}
+
+bool StatusCounter::WaitFor(int iNumStatus, chrono::milliseconds timeout)
+{
+  unique_lock<mutex> lock(hMutex);
+  return hChanged.wait_for(lock, timeout, [&]() { return this->iNumStatus >= iNumStatus; });
+}
+
+/******************************************************************************/
+struct RecordedChannel
+{
+  AL_TDriverRecord const* pFirstRequest = nullptr;
+  CodecReplay* pCodec = nullptr; // null: no library sends these requests, they are posted as they are
+  int fd = -1;
+};
+
+struct Step
+{
+  int iNumSeen; // statuses the application had seen when it issued the request
+  function<void()> issue;
+};
+
+/* a request of a channel no library owns, posted with its recorded payload */
+static function<void()> PrepareRawRequest(AL_TDriver* pDriver, RecordedChannel* pChan, AL_TDriverRecord const* pRecord)
+{
+  switch(pRecord->eType)
+  {
+  case AL_DRIVER_RECORD_OPEN:
+    return [=]()
+           {
+             pChan->fd = AL_Driver_Open(pDriver, "");
+
+             if(pChan->fd < 0)
+               throw runtime_error("Can't open a replayed channel");
+           };
+  case AL_DRIVER_RECORD_CLOSE:
+    return [=]()
+           {
+             AL_Driver_Close(pDriver, pChan->fd);
+             pChan->fd = -1;
+           };
+  default:
+  {
+    auto payload = make_shared<vector<uint8_t>>(pRecord->pIn, pRecord->pIn + pRecord->uSize);
+    return [=]()
+           {
+             AL_Driver_PostMessage(pDriver, pChan->fd, pRecord->uMessageId, payload->empty() ? nullptr : payload->data());
+           };
+  }
+  }
+}
+
+/******************************************************************************/
+struct Measure
+{
+  chrono::steady_clock::time_point wall;
+  struct rusage usage;
+
+  static Measure now()
+  {
+    Measure m;
+    m.wall = chrono::steady_clock::now();
+    getrusage(RUSAGE_SELF, &m.usage);
+    return m;
+  }
+};
+
+static double ToMs(struct timeval const& a, struct timeval const& b)
+{
+  return (b.tv_sec - a.tv_sec) * 1000.0 + (b.tv_usec - a.tv_usec) / 1000.0;
+}
+
+static void ShowStatistics(Measure const& start, Measure const& stop, int iNumRequests, int iNumChannels, int iNumFrames)
+{
+  double const wallMs = chrono::duration<double, milli>(stop.wall - start.wall).count();
+  double const userMs = ToMs(start.usage.ru_utime, stop.usage.ru_utime);
+  double const sysMs = ToMs(start.usage.ru_stime, stop.usage.ru_stime);
+  long const voluntary = stop.usage.ru_nvcsw - start.usage.ru_nvcsw;
+  long const involuntary = stop.usage.ru_nivcsw - start.usage.ru_nivcsw;
+  int const frames = max(iNumFrames, 1);
+
+  printf("Replayed %d request(s) on %d channel(s), %d frame(s)\n", iNumRequests, iNumChannels, iNumFrames);
+  printf("Wall time      : %.3f ms (%.1f us/frame)\n", wallMs, wallMs * 1000.0 / frames);
+  printf("Host CPU time  : %.3f ms user + %.3f ms system (%.1f us/frame)\n", userMs, sysMs, (userMs + sysMs) * 1000.0 / frames);
+  printf("Thread wake-ups: %ld (%ld voluntary, %ld involuntary)\n", voluntary + involuntary, voluntary, involuntary);
+}
+
+/******************************************************************************/
+static void SafeMain(int argc, char** argv)
+{
+  auto cfg = ParseCommandLine(argc, argv);
+
+  if(cfg.help)
+    return;
+
+  AL_TDriverSession session;
+
+  if(!AL_DriverSession_Load(cfg.sIn.c_str(), &session))
+    throw runtime_error("Can't load recording " + cfg.sIn);
+
+  unique_ptr<AL_TDriverSession, decltype(&AL_DriverSession_Deinit)> sessionGuard(&session, &AL_DriverSession_Deinit);
+
+  vector<RecordedChannel> channels(session.iNumChannels);
+  vector<AL_TDriverRecord const*> requests;
+
+  for(int i = 0; i < session.iNumRecords; ++i)
+  {
+    auto pRecord = &session.pRecords[i];
+
+    if(pRecord->iChannel < 0)
+      continue;
+
+    if(pRecord->eType != AL_DRIVER_RECORD_MESSAGE || !IsWaitMessage(pRecord->uMessageId))
+      requests.push_back(pRecord);
+  }
+
+  stable_sort(requests.begin(), requests.end(), [](AL_TDriverRecord const* a, AL_TDriverRecord const* b) { return a->uStartUs < b->uStartUs; });
+
+  for(auto pRecord : requests)
+  {
+    auto& chan = channels.at(pRecord->iChannel);
+
+    if(pRecord->eType == AL_DRIVER_RECORD_MESSAGE && !chan.pFirstRequest)
+      chan.pFirstRequest = pRecord;
+  }
+
+  AL_TReplayConfig replayCfg;
+  replayCfg.iLatencyUs = cfg.iLatencyUs;
+  replayCfg.pWaitMessages = WaitMessages;
+  replayCfg.iNumWaitMessages = sizeof(WaitMessages) / sizeof(*WaitMessages);
+
+  unique_ptr<AL_TDriver, decltype(&AL_ReplayDriver_Destroy)> pDriver(AL_ReplayDriver_Create(&session, &replayCfg), &AL_ReplayDriver_Destroy);
+
+  if(!pDriver)
+    throw runtime_error("Can't create the replay driver");
+
+  StatusCounter counter;
+  vector<unique_ptr<CodecReplay>> codecs;
+  codecs.push_back(CreateDecoderReplay(pDriver.get(), counter));
+  codecs.push_back(CreateEncoderReplay(pDriver.get(), counter));
+
+  for(auto& chan : channels)
+  {
+    for(auto& codec : codecs)
+    {
+      if(chan.pFirstRequest && !chan.pCodec && codec->Owns(*chan.pFirstRequest))
+        chan.pCodec = codec.get();
+    }
+  }
+
+  /* only the statuses read by a library are counted */
+  vector<uint64_t> statusDates;
+
+  for(int i = 0; i < session.iNumRecords; ++i)
+  {
+    auto pRecord = &session.pRecords[i];
+
+    if(pRecord->iChannel < 0 || pRecord->eType != AL_DRIVER_RECORD_MESSAGE || !IsWaitMessage(pRecord->uMessageId))
+      continue;
+
+    if(pRecord->iStatus == DRIVER_SUCCESS && channels.at(pRecord->iChannel).pCodec)
+      statusDates.push_back(pRecord->uEndUs);
+  }
+
+  sort(statusDates.begin(), statusDates.end());
+
+  /* the libraries open a channel with its first request: it is issued when the channel
+   * was opened, so that the replay driver sees the channels opened in the recorded order */
+  vector<Step> steps;
+
+  for(auto pRecord : requests)
+  {
+    auto& chan = channels.at(pRecord->iChannel);
+    function<void()> issue;
+
+    if(!chan.pCodec)
+      issue = PrepareRawRequest(pDriver.get(), &chan, pRecord);
+    else if(pRecord->eType == AL_DRIVER_RECORD_OPEN)
+      issue = chan.pCodec->Prepare(*chan.pFirstRequest);
+    else if(pRecord->eType == AL_DRIVER_RECORD_MESSAGE && pRecord != chan.pFirstRequest)
+      issue = chan.pCodec->Prepare(*pRecord);
+
+    if(!issue)
+      continue;
+
+    int const iNumSeen = lower_bound(statusDates.begin(), statusDates.end(), pRecord->uStartUs) - statusDates.begin();
+    steps.push_back(Step { iNumSeen, issue });
+  }
+
+  auto const start = Measure::now();
+
+  for(auto& step : steps)
+  {
+    /* don't issue a request before the statuses the application had seen at this point */
+    if(!counter.WaitFor(step.iNumSeen, chrono::seconds(10)))
+      cerr << "Warning: issuing a request before the statuses it waited for" << endl;
+    step.issue();
+  }
+
+  int const iNumStatus = statusDates.size();
+
+  if(!counter.WaitFor(iNumStatus, chrono::seconds(10)))
+    cerr << "Warning: " << iNumStatus - counter.iNumStatus << " status(es) never came back" << endl;
+
+  auto const stop = Measure::now();
+
+  /* the recording may have been stopped before every channel was closed */
+  for(auto& codec : codecs)
+    codec->Finish();
+
+  for(auto& chan : channels)
+  {
+    if(chan.fd >= 0)
+      AL_Driver_Close(pDriver.get(), chan.fd);
+  }
+
+  codecs.clear();
+  pDriver.reset();
+
+  ShowStatistics(start, stop, steps.size(), session.iNumChannels, counter.iNumFrames);
+}
+
+/******************************************************************************/
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    SafeMain(argc, argv);
+    return 0;
+  }
+  catch(runtime_error const& error)
+  {
+    cerr << endl << "Exception caught: " << error.what() << endl;
+    return 1;
+  }
+}
+
+/******************************************************************************/
+
@@ -0,0 +1,18 @@
+EXE_DRIVER_REPLAY_SRC:=\
+  exe_driver_replay/DecoderReplay.cpp\
+  exe_driver_replay/EncoderReplay.cpp\
+  exe_driver_replay/main.cpp\
+
+EXE_DRIVER_REPLAY_OBJ:=$(EXE_DRIVER_REPLAY_SRC:%=$(BIN)/%.o)
+
+ifeq ($(findstring linux,$(TARGET)),linux)
+
+# the decoder and encoder libraries share their common modules
+EXE_DRIVER_REPLAY_LIB_SRC:=$(sort $(LIB_DECODER_SRC) $(LIB_ENCODER_SRC))
+
+$(BIN)/AL_DriverReplay.exe: $(EXE_DRIVER_REPLAY_OBJ) $(EXE_DRIVER_REPLAY_LIB_SRC:%=$(BIN)/%.o)
+
+TARGETS+=$(BIN)/AL_DriverReplay.exe
+
+endif
+
@@ -0,0 +1,343 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "AdaptiveQP.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+extern "C"
+{
+#include "lib_common/BufferSrcMeta.h"
+#include "lib_common/FourCC.h"
+}
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AQ_SIMD 1
+#endif
+
+// delta QP per log2 unit of the luma variance (a QP step per doubling of the variance)
+static float const fActivityStrength = 1.0f;
+// delta QP per log2 unit of the change with the previous source
+static float const fChangeStrength = 0.5f;
+static int const iMaxChangeDelta = 3;
+
+struct TBlockStats
+{
+  uint64_t uSum;
+  uint64_t uSumSq;
+  uint64_t uSad;
+};
+
+/****************************************************************************/
+template<typename T>
+static void RowStats_C(T const* pCur, T const* pPrev, int iStart, int iWidth, TBlockStats& tStats)
+{
+  for(int x = iStart; x < iWidth; ++x)
+  {
+    uint32_t const uCur = pCur[x];
+    tStats.uSum += uCur;
+    tStats.uSumSq += uCur * uCur;
+
+    if(pPrev)
+      tStats.uSad += (uint32_t)abs((int)uCur - (int)pPrev[x]);
+  }
+}
+
+#if AQ_SIMD
+/****************************************************************************/
+static inline uint32_t SumEpi32(__m128i v)
+{
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+  return (uint32_t)_mm_cvtsi128_si32(v);
+}
+
+/****************************************************************************/
+static inline uint32_t SumSad(__m128i v)
+{
+  return (uint32_t)(_mm_cvtsi128_si32(v) + _mm_cvtsi128_si32(_mm_srli_si128(v, 8)));
+}
+
+/* a row is at most 64 samples: the 32 bits accumulators can't overflow */
+/****************************************************************************/
+static void RowStats(uint8_t const* pCur, uint8_t const* pPrev, int iWidth, TBlockStats& tStats)
+{
+  __m128i const zero = _mm_setzero_si128();
+  __m128i vSum = zero;
+  __m128i vSumSq = zero;
+  __m128i vSad = zero;
+  int x = 0;
+
+  for(; x + 16 <= iWidth; x += 16)
+  {
+    __m128i const cur = _mm_loadu_si128((__m128i const*)(pCur + x));
+    __m128i const lo = _mm_unpacklo_epi8(cur, zero);
+    __m128i const hi = _mm_unpackhi_epi8(cur, zero);
+    vSum = _mm_add_epi32(vSum, _mm_sad_epu8(cur, zero));
+    vSumSq = _mm_add_epi32(vSumSq, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+
+    if(pPrev)
+      vSad = _mm_add_epi32(vSad, _mm_sad_epu8(cur, _mm_loadu_si128((__m128i const*)(pPrev + x))));
+  }
+
+  tStats.uSum += SumSad(vSum);
+  tStats.uSumSq += SumEpi32(vSumSq);
+  tStats.uSad += SumSad(vSad);
+  RowStats_C(pCur, pPrev, x, iWidth, tStats);
+}
+
+/****************************************************************************/
+static void RowStats(uint16_t const* pCur, uint16_t const* pPrev, int iWidth, TBlockStats& tStats)
+{
+  __m128i const one = _mm_set1_epi16(1);
+  __m128i vSum = _mm_setzero_si128();
+  __m128i vSumSq = _mm_setzero_si128();
+  __m128i vSad = _mm_setzero_si128();
+  int x = 0;
+
+  for(; x + 8 <= iWidth; x += 8)
+  {
+    __m128i const cur = _mm_loadu_si128((__m128i const*)(pCur + x));
+    vSum = _mm_add_epi32(vSum, _mm_madd_epi16(cur, one));
+    vSumSq = _mm_add_epi32(vSumSq, _mm_madd_epi16(cur, cur));
+
+    if(pPrev)
+    {
+      __m128i const prev = _mm_loadu_si128((__m128i const*)(pPrev + x));
+      __m128i const diff = _mm_or_si128(_mm_subs_epu16(cur, prev), _mm_subs_epu16(prev, cur));
+      vSad = _mm_add_epi32(vSad, _mm_madd_epi16(diff, one));
+    }
+  }
+
+  tStats.uSum += SumEpi32(vSum);
+  tStats.uSumSq += SumEpi32(vSumSq);
+  tStats.uSad += SumEpi32(vSad);
+  RowStats_C(pCur, pPrev, x, iWidth, tStats);
+}
+
+#else
+/****************************************************************************/
+template<typename T>
+static void RowStats(T const* pCur, T const* pPrev, int iWidth, TBlockStats& tStats)
+{
+  RowStats_C(pCur, pPrev, 0, iWidth, tStats);
+}
+
+#endif
+
+/****************************************************************************/
+template<typename T>
+static TBlockStats BlockStats(uint8_t const* pCur, int iPitch, uint8_t const* pPrev, int iPrevPitch, int iWidth, int iHeight)
+{
+  TBlockStats tStats {};
+
+  for(int y = 0; y < iHeight; ++y)
+  {
+    T const* pPrevRow = pPrev ? (T const*)(pPrev + y * iPrevPitch) : nullptr;
+    RowStats((T const*)(pCur + y * iPitch), pPrevRow, iWidth, tStats);
+  }
+
+  return tStats;
+}
+
+/****************************************************************************/
+AdaptiveQP::AdaptiveQP(int iLCUSize, int iNumThreads) :
+  m_iLCUSize(iLCUSize)
+{
+  if(iNumThreads <= 0)
+    iNumThreads = std::min(4, (int)std::thread::hardware_concurrency());
+
+  // the thread calling Analyze works too
+  for(int i = 1; i < iNumThreads; ++i)
+    m_Workers.push_back(std::thread(&AdaptiveQP::Work, this));
+}
+
+/****************************************************************************/
+AdaptiveQP::~AdaptiveQP()
+{
+  {
+    std::unique_lock<std::mutex> lock(m_Lock);
+    m_bExit = true;
+  }
+  m_Work.notify_all();
+
+  for(auto& worker : m_Workers)
+    worker.join();
+}
+
+/****************************************************************************/
+void AdaptiveQP::AnalyzeRow(int iRow)
+{
+  int const iY = iRow * m_iLCUSize;
+  int const iHeight = std::max(0, std::min(m_iLCUSize, m_tDim.iHeight - iY));
+  int const iPrevPitch = m_tDim.iWidth * m_iSampleSize;
+  uint8_t* pPrevRow = m_Previous.data() + iY * iPrevPitch;
+  uint8_t const* pCurRow = m_pLuma + iY * m_iPitch;
+
+  for(int iCol = 0; iCol < m_iLCUWidth; ++iCol)
+  {
+    int const iX = iCol * m_iLCUSize;
+    int const iWidth = std::min(m_iLCUSize, m_tDim.iWidth - iX);
+    auto& tLcu = m_Stats[iRow * m_iLCUWidth + iCol];
+
+    if(iWidth <= 0 || iHeight <= 0)
+    {
+      // outside of the source
+      tLcu = TLcuStats {};
+      continue;
+    }
+
+    uint8_t const* pCur = pCurRow + iX * m_iSampleSize;
+    uint8_t const* pPrev = m_bHasPrevious ? pPrevRow + iX * m_iSampleSize : nullptr;
+
+    auto const tStats = m_iSampleSize == 1 ? BlockStats<uint8_t>(pCur, m_iPitch, pPrev, iPrevPitch, iWidth, iHeight) :
+                        BlockStats<uint16_t>(pCur, m_iPitch, pPrev, iPrevPitch, iWidth, iHeight);
+
+    double const fNumSamples = iWidth * iHeight;
+    double const fMean = tStats.uSum / fNumSamples;
+    double const fVariance = std::max(0.0, tStats.uSumSq / fNumSamples - fMean * fMean);
+
+    tLcu.fActivity = (float)std::log2(1.0 + fVariance);
+    tLcu.fChange = (float)std::log2(1.0 + tStats.uSad / fNumSamples);
+  }
+
+  // the rows of an LCU row are only read by this call
+  for(int y = 0; y < iHeight; ++y)
+    memcpy(pPrevRow + y * iPrevPitch, pCurRow + y * m_iPitch, iPrevPitch);
+}
+
+/****************************************************************************/
+void AdaptiveQP::Work()
+{
+  std::unique_lock<std::mutex> lock(m_Lock);
+
+  while(true)
+  {
+    m_Work.wait(lock, [&]() { return m_bExit || m_iNextRow < m_iLCUHeight; });
+
+    if(m_bExit)
+      return;
+
+    int const iRow = m_iNextRow++;
+    lock.unlock();
+    AnalyzeRow(iRow);
+    lock.lock();
+
+    if(--m_iPendingRows == 0)
+      m_Done.notify_all();
+  }
+}
+
+/****************************************************************************/
+bool AdaptiveQP::Analyze(AL_TBuffer* pSrc, int iMinDelta, int iMaxDelta, int8_t* pDeltaQPs, int iLCUWidth, int iLCUHeight)
+{
+  auto const pMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(pSrc, AL_META_TYPE_SOURCE);
+
+  if(!pMeta || AL_IsTiled(pMeta->tFourCC) || AL_Is10bitPacked(pMeta->tFourCC) || AL_IsCompressed(pMeta->tFourCC))
+    return false;
+
+  int const iSampleSize = AL_GetBitDepth(pMeta->tFourCC) > 8 ? 2 : 1;
+  AL_TDimension const tDim = pMeta->tDim;
+
+  if(tDim.iWidth != m_tDim.iWidth || tDim.iHeight != m_tDim.iHeight || iSampleSize != m_iSampleSize)
+  {
+    m_tDim = tDim;
+    m_iSampleSize = iSampleSize;
+    m_Previous.resize(tDim.iWidth * tDim.iHeight * iSampleSize);
+    m_bHasPrevious = false;
+  }
+
+  int const iNumLCUs = iLCUWidth * iLCUHeight;
+  m_Stats.resize(iNumLCUs);
+  m_pLuma = AL_Buffer_GetData(pSrc) + pMeta->tOffsetYC.iLuma;
+  m_iPitch = pMeta->tPitches.iLuma;
+
+  {
+    std::unique_lock<std::mutex> lock(m_Lock);
+    m_iLCUWidth = iLCUWidth;
+    m_iPendingRows = iLCUHeight;
+    m_iNextRow = 0;
+    m_iLCUHeight = iLCUHeight;
+  }
+  m_Work.notify_all();
+
+  {
+    std::unique_lock<std::mutex> lock(m_Lock);
+
+    while(m_iNextRow < m_iLCUHeight)
+    {
+      int const iRow = m_iNextRow++;
+      lock.unlock();
+      AnalyzeRow(iRow);
+      lock.lock();
+      --m_iPendingRows;
+    }
+
+    m_Done.wait(lock, [&]() { return m_iPendingRows == 0; });
+  }
+
+  // the deltas are centered on the frame average so that the rate control isn't biased
+  double fActivityMean = 0.0;
+  double fChangeMean = 0.0;
+
+  for(auto const& tLcu : m_Stats)
+  {
+    fActivityMean += tLcu.fActivity;
+    fChangeMean += tLcu.fChange;
+  }
+
+  fActivityMean /= iNumLCUs;
+  fChangeMean /= iNumLCUs;
+
+  for(int iLCU = 0; iLCU < iNumLCUs; ++iLCU)
+  {
+    auto const& tLcu = m_Stats[iLCU];
+    float fDelta = fActivityStrength * (float)(tLcu.fActivity - fActivityMean);
+
+    if(m_bHasPrevious)
+      fDelta += std::max(-iMaxChangeDelta, std::min(iMaxChangeDelta, (int)std::lround(fChangeStrength * (tLcu.fChange - fChangeMean))));
+
+    pDeltaQPs[iLCU] = (int8_t)std::max(iMinDelta, std::min(iMaxDelta, (int)std::lround(fDelta)));
+  }
+
+  m_bHasPrevious = true;
+  return true;
+}
+
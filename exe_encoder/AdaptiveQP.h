@@ -0,0 +1,101 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include "lib_rtos/types.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include "lib_common/BufferAPI.h"
+#include "lib_common/SliceConsts.h"
+}
+
+/*
+ * Content adaptive quantization: one delta QP per LCU, computed from the luma
+ * of the source. Busy LCUs (high variance) get a higher QP, where the loss is
+ * masked by the texture, flat ones a lower QP. LCUs which didn't change since
+ * the previous source get a lower QP too, as they are likely to be referenced.
+ * The LCU rows are analysed in parallel on a pool of worker threads.
+ */
+class AdaptiveQP
+{
+public:
+  AdaptiveQP(int iLCUSize, int iNumThreads = 0);
+  ~AdaptiveQP();
+
+  /* Fills pDeltaQPs with one delta QP in [iMinDelta, iMaxDelta] per LCU of an
+   * iLCUWidth x iLCUHeight grid, in raster order.
+   * Returns false when the source storage (tiled, packed 10 bits) isn't supported */
+  bool Analyze(AL_TBuffer* pSrc, int iMinDelta, int iMaxDelta, int8_t* pDeltaQPs, int iLCUWidth, int iLCUHeight);
+
+private:
+  struct TLcuStats
+  {
+    float fActivity; // log2 of the luma variance
+    float fChange; // log2 of the mean absolute difference with the previous source
+  };
+
+  void Work();
+  void AnalyzeRow(int iRow);
+
+  int const m_iLCUSize;
+
+  // frame being analysed
+  uint8_t const* m_pLuma = nullptr;
+  int m_iPitch = 0;
+  int m_iSampleSize = 0;
+  AL_TDimension m_tDim {};
+  int m_iLCUWidth = 0;
+  int m_iLCUHeight = 0;
+  bool m_bHasPrevious = false;
+  std::vector<uint8_t> m_Previous; // luma of the previous source, m_tDim.iWidth samples per row
+  std::vector<TLcuStats> m_Stats;
+
+  std::mutex m_Lock;
+  std::condition_variable m_Work;
+  std::condition_variable m_Done;
+  int m_iNextRow = 0;
+  int m_iPendingRows = 0;
+  bool m_bExit = false;
+  std::vector<std::thread> m_Workers;
+};
+
@@ -206,6 +206,7 @@ static bool GetValue(const string& sLine, size_t zStartPos, int& Value, size_t&
   else IF_KEYWORD_0(RANDOM_QP)
   else IF_KEYWORD_0(BORDER_QP)
   else IF_KEYWORD_0(ROI_QP)
+  else IF_KEYWORD_0(ADAPTIVE_QP)
   else IF_KEYWORD_0(AUTO_QP)
   else IF_KEYWORD_0(ADAPTIVE_AUTO_QP)
   else IF_KEYWORD_0(RELATIVE_QP)
@@ -493,6 +494,7 @@ static bool ParseInput(string & sLine, ConfigFile& cfg)
   else if(KEYWORD("Format"))       cfg.FileInfo.FourCC = TFourCC(GetFourCC(sLine));
   else if(KEYWORD("CmdFile"))      GetString(sLine, cfg.sCmdFileName);
   else if(KEYWORD("RoiFile"))      GetString(sLine, cfg.sRoiFileName);
+  else if(KEYWORD("QpTableFile"))  GetString(sLine, cfg.sQpTableFileName);
   else if(KEYWORD("FrameRate"))    cfg.FileInfo.FrameRate  = GetValue(sLine);
   else
     return false;
@@ -653,6 +655,11 @@ static bool ParseRun(string& sLine, TCfgRunInfo&  RunInfo)
   else if(KEYWORD("MaxPicture"))      RunInfo.iMaxPict   = GetValue(sLine);
   else if(KEYWORD("FirstPicture"))    RunInfo.iFirstPict = GetValue(sLine);
   else if(KEYWORD("ScnChgLookAhead")) RunInfo.iScnChgLookAhead = GetValue(sLine);
+  else if(KEYWORD("EgressRate"))      RunInfo.iEgressRate = GetValue(sLine);
+  else if(KEYWORD("LatencyBudget"))   RunInfo.iLatencyBudget = GetValue(sLine);
+  else if(KEYWORD("NumSegments"))     RunInfo.iNumSegments = GetValue(sLine);
+  else if(KEYWORD("MemoryBudget"))    RunInfo.iMemoryBudget = GetValue(sLine);
+  else if(KEYWORD("FitCoreLoad"))     RunInfo.bFitCoreLoad = GetValue(sLine);
   else
     return false;
 
@@ -988,6 +995,7 @@ void ParseConfigFile(const string& sCfgFileName, ConfigFile& cfg, ostream& warnS
   ToNativePath(cfg.RecFileName);
   ToNativePath(cfg.sCmdFileName);
   ToNativePath(cfg.sRoiFileName);
+  ToNativePath(cfg.sQpTableFileName);
 
   GetScalingList(cfg.Settings, sScalingListFile, warnStream);
 }
@@ -68,11 +68,27 @@ typedef struct tCfgRunInfo
   unsigned int iFirstPict;
   unsigned int iScnChgLookAhead;
   string sMd5Path;
+  string sStreamMd5Path;
   int eVQDescr;
   IpCtrlMode ipCtrlMode;
   std::string logsFile = "";
   bool trackDma = false;
   bool printPictureType = false;
+  std::string sRecordDriver = "";
+  std::string sLatencyStats = "";
+  std::string sTraceFile = "";
+  bool bCompileQpTables = false;
+  int iEgressRate = 0; // kbps, 0 disables the egress rate control
+  int iLatencyBudget = 500; // ms
+  std::string sEgressLinkSim = "";
+  std::string sStatsFile = "";
+  int iPass = 0; // 1 or 2 for two pass encoding
+  std::string sPassLog = "TwoPass.log";
+  int iNumSegments = 1; // channels encoding the input concurrently
+  std::string sStreamRing = ""; // shared memory ring receiving the stream instead of the bitstream file
+  int iStreamRingSize = 16; // MB
+  int iMemoryBudget = 0; // MB, 0 disables the check of the memory plan
+  bool bFitCoreLoad = false; // lower the frame rate to the load the cores can still take
 }TCfgRunInfo;
 
 
@@ -98,6 +114,9 @@ struct ConfigFile
   // happen
   string sRoiFileName;
 
+  // \brief Name of the file holding the compiled QP tables of the sequence
+  // (see QPTableStore.h), used instead of the QP and ROI text files
+  string sQpTableFileName;
 
 
   // \brief Information relative to YUV input file (from section INPUT)
@@ -97,6 +97,21 @@ void GotoFirstPicture(TYUVFileInfo const& FI, std::ifstream& File, unsigned int
   File.seekg(iPictLen * iFirstPict);
 }
 
+/*****************************************************************************/
+int GetNumPictures(TYUVFileInfo const& FI, std::ifstream& File)
+{
+  int64_t const iPictLen = PictureSize(FI);
+
+  if(iPictLen == 0)
+    return 0;
+
+  auto const iPos = File.tellg();
+  File.seekg(0, std::ios_base::end);
+  int64_t const iFileSize = File.tellg();
+  File.seekg(iPos);
+  return (int)(iFileSize / iPictLen);
+}
+
 /*****************************************************************************/
 uint32_t GetIOLumaRowSize(TFourCC fourCC, uint32_t uWidth)
 {
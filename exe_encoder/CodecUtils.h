@@ -56,6 +56,9 @@ bool IsConversionNeeded(TFourCC const& FourCC, AL_TPicFormat const& picFmt);
 /*****************************************************************************/
 void GotoFirstPicture(TYUVFileInfo const& FI, std::ifstream& File, unsigned int iFirstPict = 0);
 
+/*****************************************************************************/
+int GetNumPictures(TYUVFileInfo const& FI, std::ifstream& File);
+
 /*****************************************************************************/
 int GotoNextPicture(TYUVFileInfo const& FI, std::ifstream& File, int iEncFrameRate, int iEncPictCount, int iFilePictCount);
 
@@ -0,0 +1,302 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "EncStats.h"
+#include "lib_app/utils.h"
+#include <algorithm>
+#include <stdexcept>
+
+extern "C"
+{
+#include "lib_common/BufferPictureMeta.h"
+#include "lib_common/BufferStreamMeta.h"
+#include "lib_rtos/lib_rtos.h"
+}
+
+using namespace std;
+
+#define STATS_VERSION 2
+#define STATS_RECORD_SIZE 32
+
+/****************************************************************************/
+static bool EndsWith(string const& s, string const& sSuffix)
+{
+  return s.size() >= sSuffix.size() && s.compare(s.size() - sSuffix.size(), sSuffix.size(), sSuffix) == 0;
+}
+
+/****************************************************************************/
+static uint8_t* Put(uint8_t* pBytes, uint32_t uValue, int iNumBytes)
+{
+  for(int i = 0; i < iNumBytes; ++i)
+    *pBytes++ = (uValue >> (8 * i)) & 0xFF;
+
+  return pBytes;
+}
+
+/****************************************************************************/
+static uint32_t Get(uint8_t const*& pBytes, int iNumBytes)
+{
+  uint32_t uValue = 0;
+
+  for(int i = 0; i < iNumBytes; ++i)
+    uValue |= (uint32_t)*pBytes++ << (8 * i);
+
+  return uValue;
+}
+
+/****************************************************************************/
+static char GetTypeName(uint8_t uType)
+{
+  switch(uType)
+  {
+  case SLICE_I: return 'I';
+  case SLICE_P: return 'P';
+  case SLICE_B: return 'B';
+  default: return '?';
+  }
+}
+
+/****************************************************************************/
+EncStats::EncStats(string const& sFileName, double fFrameRate, bool bPassLog) :
+  m_bPassLog(bPassLog), m_bCsv(!bPassLog && EndsWith(sFileName, ".csv")), m_fFrameRate(fFrameRate)
+{
+  m_File.open(sFileName, m_bCsv ? ios::out : ios::out | ios::binary);
+
+  if(!m_File.is_open())
+    throw runtime_error("Can't open statistics file: " + sFileName);
+
+  if(m_bCsv)
+    m_File << "frame,source,type,qp,idr,ref,skipped,bytes,sections,latency_us,cpb_delay_90k,in_flight,complexity\n";
+  else
+  {
+    uint8_t pHeader[12] = { 'A', 'E', 'S', 'T' };
+    Put(Put(pHeader + 4, STATS_VERSION, 4), STATS_RECORD_SIZE, 4);
+    m_File.write((char const*)pHeader, sizeof(pHeader));
+  }
+}
+
+/****************************************************************************/
+void EncStats::SourceSent(AL_TBuffer const* pSrc)
+{
+  lock_guard<mutex> lock(m_Lock);
+  m_Sent.push_back(TSent { pSrc, Rtos_GetTimeUs(), m_uNumSources++ });
+}
+
+/****************************************************************************/
+void EncStats::StreamReceived(AL_TBuffer* pStream, AL_TBuffer const* pSrc)
+{
+  auto pStreamMeta = (AL_TStreamMetaData*)AL_Buffer_GetMetaData(pStream, AL_META_TYPE_STREAM);
+  auto pPictureMeta = (AL_TPictureMetaData*)AL_Buffer_GetMetaData(pStream, AL_META_TYPE_PICTURE);
+  bool bEndOfFrame = false;
+
+  for(int i = 0; i < pStreamMeta->uNumSection; ++i)
+  {
+    m_Frame.uBytes += pStreamMeta->pSections[i].uLength;
+
+    if(pStreamMeta->pSections[i].uFlags & SECTION_END_FRAME_FLAG)
+      bEndOfFrame = true;
+  }
+
+  m_Frame.uNumSections += pStreamMeta->uNumSection;
+
+  if(pPictureMeta && pPictureMeta->bSkipped)
+    bEndOfFrame = true;
+
+  if(!bEndOfFrame)
+    return;
+
+  m_Frame.uFrame = m_uNumFrames++;
+
+  if(pPictureMeta)
+  {
+    m_Frame.uType = pPictureMeta->eType;
+    m_Frame.iQP = pPictureMeta->iQP;
+    m_Frame.uFlags = (pPictureMeta->bIsIDR ? 1 : 0) | (pPictureMeta->bIsRef ? 2 : 0) | (pPictureMeta->bSkipped ? 4 : 0);
+    m_Frame.uCpbDelay = pPictureMeta->uInitialRemovalDelay;
+    m_Frame.uCplx = pPictureMeta->uSumCplx;
+  }
+  else
+    m_Frame.uType = SLICE_MAX_ENUM;
+
+  {
+    lock_guard<mutex> lock(m_Lock);
+    auto it = find_if(m_Sent.begin(), m_Sent.end(), [&](TSent const& sent) { return sent.pSrc == pSrc; });
+
+    m_Frame.uSource = m_Frame.uFrame;
+
+    if(it != m_Sent.end())
+    {
+      m_Frame.uLatency = (uint32_t)(Rtos_GetTimeUs() - it->uTime);
+      m_Frame.uSource = it->uSource;
+      m_Sent.erase(it);
+    }
+
+    m_Frame.uInFlight = m_Sent.size();
+  }
+
+  WriteFrame(m_Frame);
+  AddToGop(m_Frame);
+  m_Frame = TFrame {};
+}
+
+/****************************************************************************/
+void EncStats::WriteFrame(TFrame const& tFrame)
+{
+  if(m_bCsv)
+  {
+    m_File << tFrame.uFrame << ',' << tFrame.uSource << ',' << GetTypeName(tFrame.uType) << ',' << tFrame.iQP << ','
+           << (tFrame.uFlags & 1) << ',' << ((tFrame.uFlags >> 1) & 1) << ',' << ((tFrame.uFlags >> 2) & 1) << ','
+           << tFrame.uBytes << ',' << tFrame.uNumSections << ',' << tFrame.uLatency << ','
+           << tFrame.uCpbDelay << ',' << tFrame.uInFlight << ',' << tFrame.uCplx << '\n';
+    return;
+  }
+
+  uint8_t pRecord[STATS_RECORD_SIZE];
+  uint8_t* pCur = pRecord;
+  pCur = Put(pCur, tFrame.uFrame, 4);
+  pCur = Put(pCur, tFrame.uSource, 4);
+  pCur = Put(pCur, tFrame.uBytes, 4);
+  pCur = Put(pCur, tFrame.uLatency, 4);
+  pCur = Put(pCur, tFrame.uCpbDelay, 4);
+  pCur = Put(pCur, tFrame.uCplx, 4);
+  pCur = Put(pCur, (uint16_t)tFrame.iQP, 2);
+  pCur = Put(pCur, tFrame.uNumSections, 2);
+  pCur = Put(pCur, tFrame.uInFlight, 2);
+  pCur = Put(pCur, tFrame.uType, 1);
+  pCur = Put(pCur, tFrame.uFlags, 1);
+  m_File.write((char const*)pRecord, sizeof(pRecord));
+}
+
+/****************************************************************************/
+void EncStats::CloseGop()
+{
+  if(!m_Gop.iNumFrames)
+    return;
+
+  m_Gop.fAvgQP = (double)m_iGopSumQP / m_Gop.iNumFrames;
+  m_Gop.fBitRate = m_Gop.uBytes * 8 * m_fFrameRate / m_Gop.iNumFrames;
+  {
+    lock_guard<mutex> lock(m_Lock);
+    m_LastGop = m_Gop;
+    m_bHasLastGop = true;
+  }
+  ++m_iNumGops;
+  m_Gop = TGop {};
+  m_iGopSumQP = 0;
+}
+
+/****************************************************************************/
+void EncStats::AddToGop(TFrame const& tFrame)
+{
+  if(tFrame.uType == SLICE_I)
+    CloseGop();
+
+  if(!m_Gop.iNumFrames)
+  {
+    m_Gop.iFirstFrame = tFrame.uFrame;
+    m_Gop.iMinQP = tFrame.iQP;
+    m_Gop.iMaxQP = tFrame.iQP;
+  }
+
+  ++m_Gop.iNumFrames;
+  m_Gop.uBytes += tFrame.uBytes;
+  m_Gop.iMinQP = min<int>(m_Gop.iMinQP, tFrame.iQP);
+  m_Gop.iMaxQP = max<int>(m_Gop.iMaxQP, tFrame.iQP);
+  m_iGopSumQP += tFrame.iQP;
+
+  m_uTotalBytes += tFrame.uBytes;
+  m_iTotalSumQP += tFrame.iQP;
+}
+
+/****************************************************************************/
+bool EncStats::GetLastGop(TGop& tGop)
+{
+  lock_guard<mutex> lock(m_Lock);
+  tGop = m_LastGop;
+  return m_bHasLastGop;
+}
+
+/****************************************************************************/
+void EncStats::Finish()
+{
+  CloseGop();
+  m_File.flush();
+
+  if(m_uNumFrames && !m_bPassLog)
+    Message(CC_DEFAULT, "\nStatistics: %u frames, %d GOPs, average QP %.2f, %.1f bytes per frame\n",
+            m_uNumFrames, m_iNumGops, (double)m_iTotalSumQP / m_uNumFrames, (double)m_uTotalBytes / m_uNumFrames);
+}
+
+/****************************************************************************/
+vector<EncStats::TFrame> EncStats::Read(string const& sFileName)
+{
+  ifstream file(sFileName, ios::binary);
+
+  if(!file.is_open())
+    throw runtime_error("Can't open statistics file: " + sFileName);
+
+  uint8_t pHeader[12];
+  uint8_t const* pCur = pHeader + 4;
+
+  if(!file.read((char*)pHeader, sizeof(pHeader)) || string((char const*)pHeader, 4) != "AEST" ||
+     Get(pCur, 4) != STATS_VERSION || Get(pCur, 4) != STATS_RECORD_SIZE)
+    throw runtime_error("Invalid statistics file: " + sFileName);
+
+  vector<TFrame> frames;
+  uint8_t pRecord[STATS_RECORD_SIZE];
+
+  while(file.read((char*)pRecord, sizeof(pRecord)))
+  {
+    TFrame tFrame;
+    pCur = pRecord;
+    tFrame.uFrame = Get(pCur, 4);
+    tFrame.uSource = Get(pCur, 4);
+    tFrame.uBytes = Get(pCur, 4);
+    tFrame.uLatency = Get(pCur, 4);
+    tFrame.uCpbDelay = Get(pCur, 4);
+    tFrame.uCplx = Get(pCur, 4);
+    tFrame.iQP = (int16_t)Get(pCur, 2);
+    tFrame.uNumSections = Get(pCur, 2);
+    tFrame.uInFlight = Get(pCur, 2);
+    tFrame.uType = Get(pCur, 1);
+    tFrame.uFlags = Get(pCur, 1);
+    frames.push_back(tFrame);
+  }
+
+  return frames;
+}
+
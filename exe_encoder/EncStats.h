@@ -0,0 +1,144 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include "lib_rtos/types.h"
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include "lib_common/BufferAPI.h"
+}
+
+/*
+ * Statistics of the encoded frames, in encoding order, to tune the rate
+ * control offline. Each frame also gives the index of its source frame, in
+ * submission order. The stream buffers need a picture metadata.
+ *
+ * A ".csv" file gets one text row per frame. Any other name, and any pass log
+ * whatever its name, gets a binary file:
+ * the 4 bytes "AEST", a u32 version and a u32 record size, then one record per
+ * frame, all little endian:
+ *   u32 frame, u32 source, u32 bytes, u32 latency (us), u32 cpb removal delay (90kHz),
+ *   u32 complexity, i16 qp, u16 sections, u16 frames in flight,
+ *   u8 slice type, u8 flags (1: idr, 2: reference, 4: skipped)
+ */
+class EncStats
+{
+public:
+  struct TFrame
+  {
+    uint32_t uFrame;
+    uint32_t uSource; // index of the source frame, in submission order
+    uint32_t uBytes;
+    uint32_t uLatency; // from the source submission to the end of the encoding, in us
+    uint32_t uCpbDelay;
+    uint32_t uCplx;
+    int16_t iQP;
+    uint16_t uNumSections;
+    uint16_t uInFlight; // frames submitted and not encoded yet
+    uint8_t uType;
+    uint8_t uFlags;
+  };
+
+  /* frames from an I frame to the next one */
+  struct TGop
+  {
+    int iFirstFrame;
+    int iNumFrames;
+    uint64_t uBytes;
+    double fAvgQP;
+    int iMinQP;
+    int iMaxQP;
+    double fBitRate; // bits per second at the nominal frame rate
+  };
+
+  /* a pass log is read back by Read: it is always binary and prints no summary */
+  EncStats(std::string const& sFileName, double fFrameRate, bool bPassLog = false);
+
+  /* thread feeding the encoder, before the source is sent */
+  void SourceSent(AL_TBuffer const* pSrc);
+  /* thread of the encoded streams */
+  void StreamReceived(AL_TBuffer* pStream, AL_TBuffer const* pSrc);
+  /* after the last frame: closes the last GOP and prints a summary */
+  void Finish();
+
+  /* last complete GOP, can be called at any time */
+  bool GetLastGop(TGop& tGop);
+
+  /* reads back a binary statistics file, throws a runtime_error when it is invalid */
+  static std::vector<TFrame> Read(std::string const& sFileName);
+
+private:
+  void WriteFrame(TFrame const& tFrame);
+  void AddToGop(TFrame const& tFrame);
+  void CloseGop();
+
+  std::ofstream m_File;
+  bool const m_bPassLog;
+  bool m_bCsv;
+  double const m_fFrameRate;
+
+  // source submission times, shared between the threads
+  std::mutex m_Lock;
+  struct TSent
+  {
+    AL_TBuffer const* pSrc;
+    uint64_t uTime;
+    uint32_t uSource;
+  };
+
+  std::vector<TSent> m_Sent;
+  uint32_t m_uNumSources = 0;
+  TGop m_LastGop {};
+  bool m_bHasLastGop = false;
+
+  // frame being received
+  TFrame m_Frame {};
+  uint32_t m_uNumFrames = 0;
+
+  TGop m_Gop {};
+  int64_t m_iGopSumQP = 0;
+  int m_iNumGops = 0;
+  uint64_t m_uTotalBytes = 0;
+  int64_t m_iTotalSumQP = 0;
+};
+
@@ -66,9 +66,22 @@ extern "C"
 {
 #include "lib_encode/SchedulerMcu.h"
 #include "lib_common/HardwareDriver.h"
+#include "lib_fpga/DriverRecord.h"
 }
 
-static unique_ptr<CIpDevice> createMcuIpDevice()
+static shared_ptr<AL_TDriver> createDriver(string sRecordDriver)
+{
+  if(sRecordDriver.empty())
+    return shared_ptr<AL_TDriver>(AL_GetHardwareDriver(), [](AL_TDriver*) {});
+
+  auto pDriver = AL_RecordDriver_Create(AL_GetHardwareDriver(), sRecordDriver.c_str());
+
+  if(!pDriver)
+    throw runtime_error("Can't record the driver messages in " + sRecordDriver);
+  return shared_ptr<AL_TDriver>(pDriver, &AL_RecordDriver_Destroy);
+}
+
+static unique_ptr<CIpDevice> createMcuIpDevice(string sRecordDriver)
 {
   auto device = make_unique<CIpDevice>();
 
@@ -77,23 +90,26 @@ static unique_ptr<CIpDevice> createMcuIpDevice()
   if(!device->m_pAllocator)
     throw runtime_error("Can't open DMA allocator");
 
-  device->m_pScheduler = AL_SchedulerMcu_Create(AL_GetHardwareDriver(), device->m_pAllocator.get());
+  device->m_pDriver = createDriver(sRecordDriver);
+  device->m_pScheduler = AL_SchedulerMcu_Create(device->m_pDriver.get(), device->m_pAllocator.get());
 
   if(!device->m_pScheduler)
     throw std::runtime_error("Failed to create MCU scheduler");
 
+  device->m_pLedger = AL_SchedulerMcu_GetResourceLedger(device->m_pScheduler);
+
   return device;
 }
 
 
-shared_ptr<CIpDevice> CreateIpDevice(bool bUseRefSoftware, int iSchedulerType, AL_TEncSettings& Settings, function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl, bool trackDma, int eVqDescr)
+shared_ptr<CIpDevice> CreateIpDevice(bool bUseRefSoftware, int iSchedulerType, AL_TEncSettings& Settings, function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl, bool trackDma, int eVqDescr, string sRecordDriver)
 {
   (void)bUseRefSoftware, (void)Settings, (void)wrapIpCtrl, (void)eVqDescr, (void)trackDma;
 
 
 
   if(iSchedulerType == SCHEDULER_TYPE_MCU)
-    return createMcuIpDevice();
+    return createMcuIpDevice(sRecordDriver);
 
   throw runtime_error("No support for this scheduling type");
 }
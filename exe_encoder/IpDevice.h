@@ -45,10 +45,12 @@ extern "C"
 {
 #include "lib_common_enc/Settings.h"
 #include "lib_encode/lib_encoder.h"
+#include "lib_common/ResourceLedger.h"
 }
 
 typedef struct AL_t_Allocator AL_TAllocator;
 typedef struct AL_t_IpCtrl AL_TIpCtrl;
+typedef struct AL_t_driver AL_TDriver;
 typedef struct AL_t_Timer AL_Timer;
 
 /*****************************************************************************/
@@ -56,8 +58,10 @@ struct CIpDevice
 {
   TScheduler* m_pScheduler = nullptr;
   std::shared_ptr<AL_TAllocator> m_pAllocator;
+  std::shared_ptr<AL_TDriver> m_pDriver;
   AL_Timer* m_pTimer;
+  AL_TResourceLedger* m_pLedger = nullptr; // load of the channels created on the device
 };
 
-std::shared_ptr<CIpDevice> CreateIpDevice(bool bUseRefSoftware, int iSchedulerType, AL_TEncSettings& Settings, std::function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl, bool trackDma = false, int iVqDescr = 0);
+std::shared_ptr<CIpDevice> CreateIpDevice(bool bUseRefSoftware, int iSchedulerType, AL_TEncSettings& Settings, std::function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl, bool trackDma = false, int iVqDescr = 0, std::string sRecordDriver = "");
 
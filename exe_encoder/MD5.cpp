@@ -38,6 +38,15 @@
 #include "MD5.h"
 #include "string.h"
 #include <assert.h>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MD5_SIMD 1
+#endif
+
+// number of MD5 hashed together by the engine
+#define MD5_LANES 4
 
 // mix functions for processBlock()
 inline uint32_t F(uint32_t X, uint32_t Y, uint32_t Z)
@@ -65,10 +74,165 @@ inline uint32_t Rot(uint32_t X, uint32_t s)
   return (X << s) | (X >> (32 - s));
 }
 
-#define MD5(d, X, Y, Z, Fn, i, C, s) d = (Rot(d + Fn(X, Y, Z) + pBlock[i] + C, s) + X)
+#define MD5(d, X, Y, Z, Fn, i, C, s) d = (Rot(d + Fn(X, Y, Z) + pBlock[i] + C, s) + X);
+
+// RFC 1321 rounds: STEP(d, X, Y, Z, Fn, i, C, s)
+#define MD5_ROUNDS(STEP) \
+  STEP(a, b, c, d, F, 0, 0xD76AA478, 7) \
+  STEP(d, a, b, c, F, 1, 0xE8C7B756, 12) \
+  STEP(c, d, a, b, F, 2, 0x242070DB, 17) \
+  STEP(b, c, d, a, F, 3, 0xC1BDCEEE, 22) \
+  STEP(a, b, c, d, F, 4, 0xF57C0FAF, 7) \
+  STEP(d, a, b, c, F, 5, 0x4787C62A, 12) \
+  STEP(c, d, a, b, F, 6, 0xA8304613, 17) \
+  STEP(b, c, d, a, F, 7, 0xFD469501, 22) \
+  STEP(a, b, c, d, F, 8, 0x698098D8, 7) \
+  STEP(d, a, b, c, F, 9, 0x8B44F7AF, 12) \
+  STEP(c, d, a, b, F, 10, 0xFFFF5BB1, 17) \
+  STEP(b, c, d, a, F, 11, 0x895CD7BE, 22) \
+  STEP(a, b, c, d, F, 12, 0x6B901122, 7) \
+  STEP(d, a, b, c, F, 13, 0xFD987193, 12) \
+  STEP(c, d, a, b, F, 14, 0xA679438E, 17) \
+  STEP(b, c, d, a, F, 15, 0x49B40821, 22) \
+  \
+  STEP(a, b, c, d, G, 1, 0xF61E2562, 5) \
+  STEP(d, a, b, c, G, 6, 0xC040B340, 9) \
+  STEP(c, d, a, b, G, 11, 0x265E5A51, 14) \
+  STEP(b, c, d, a, G, 0, 0xE9B6C7AA, 20) \
+  STEP(a, b, c, d, G, 5, 0xD62F105D, 5) \
+  STEP(d, a, b, c, G, 10, 0x02441453, 9) \
+  STEP(c, d, a, b, G, 15, 0xD8A1E681, 14) \
+  STEP(b, c, d, a, G, 4, 0xE7D3FBC8, 20) \
+  STEP(a, b, c, d, G, 9, 0x21E1CDE6, 5) \
+  STEP(d, a, b, c, G, 14, 0xC33707D6, 9) \
+  STEP(c, d, a, b, G, 3, 0xF4D50D87, 14) \
+  STEP(b, c, d, a, G, 8, 0x455A14ED, 20) \
+  STEP(a, b, c, d, G, 13, 0xA9E3E905, 5) \
+  STEP(d, a, b, c, G, 2, 0xFCEFA3F8, 9) \
+  STEP(c, d, a, b, G, 7, 0x676F02D9, 14) \
+  STEP(b, c, d, a, G, 12, 0x8D2A4C8A, 20) \
+  \
+  STEP(a, b, c, d, H, 5, 0xFFFA3942, 4) \
+  STEP(d, a, b, c, H, 8, 0x8771F681, 11) \
+  STEP(c, d, a, b, H, 11, 0x6D9D6122, 16) \
+  STEP(b, c, d, a, H, 14, 0xFDE5380C, 23) \
+  STEP(a, b, c, d, H, 1, 0xA4BEEA44, 4) \
+  STEP(d, a, b, c, H, 4, 0x4BDECFA9, 11) \
+  STEP(c, d, a, b, H, 7, 0xF6BB4B60, 16) \
+  STEP(b, c, d, a, H, 10, 0xBEBFBC70, 23) \
+  STEP(a, b, c, d, H, 13, 0x289B7EC6, 4) \
+  STEP(d, a, b, c, H, 0, 0xEAA127FA, 11) \
+  STEP(c, d, a, b, H, 3, 0xD4EF3085, 16) \
+  STEP(b, c, d, a, H, 6, 0x04881D05, 23) \
+  STEP(a, b, c, d, H, 9, 0xD9D4D039, 4) \
+  STEP(d, a, b, c, H, 12, 0xE6DB99E5, 11) \
+  STEP(c, d, a, b, H, 15, 0x1FA27CF8, 16) \
+  STEP(b, c, d, a, H, 2, 0xC4AC5665, 23) \
+  \
+  STEP(a, b, c, d, I, 0, 0xF4292244, 6) \
+  STEP(d, a, b, c, I, 7, 0x432AFF97, 10) \
+  STEP(c, d, a, b, I, 14, 0xAB9423A7, 15) \
+  STEP(b, c, d, a, I, 5, 0xFC93A039, 21) \
+  STEP(a, b, c, d, I, 12, 0x655B59C3, 6) \
+  STEP(d, a, b, c, I, 3, 0x8F0CCC92, 10) \
+  STEP(c, d, a, b, I, 10, 0xFFEFF47D, 15) \
+  STEP(b, c, d, a, I, 1, 0x85845DD1, 21) \
+  STEP(a, b, c, d, I, 8, 0x6FA87E4F, 6) \
+  STEP(d, a, b, c, I, 15, 0xFE2CE6E0, 10) \
+  STEP(c, d, a, b, I, 6, 0xA3014314, 15) \
+  STEP(b, c, d, a, I, 13, 0x4E0811A1, 21) \
+  STEP(a, b, c, d, I, 4, 0xF7537E82, 6) \
+  STEP(d, a, b, c, I, 11, 0xBD3AF235, 10) \
+  STEP(c, d, a, b, I, 2, 0x2AD7D2BB, 15) \
+  STEP(b, c, d, a, I, 9, 0xEB86D391, 21)
+
+/*************************************************************************************/
+static void UpdateHash(uint32_t* pHash, uint32_t const* pBlock)
+{
+  uint32_t a = pHash[0];
+  uint32_t b = pHash[1];
+  uint32_t c = pHash[2];
+  uint32_t d = pHash[3];
+
+  MD5_ROUNDS(MD5)
+
+  pHash[0] += a;
+  pHash[1] += b;
+  pHash[2] += c;
+  pHash[3] += d;
+}
+
+#if MD5_SIMD
+// the same mix functions on 4 lanes
+static inline __m128i F4(__m128i X, __m128i Y, __m128i Z)
+{
+  return _mm_xor_si128(Z, _mm_and_si128(X, _mm_xor_si128(Y, Z)));
+}
+
+static inline __m128i G4(__m128i X, __m128i Y, __m128i Z)
+{
+  return _mm_xor_si128(Y, _mm_and_si128(Z, _mm_xor_si128(X, Y)));
+}
+
+static inline __m128i H4(__m128i X, __m128i Y, __m128i Z)
+{
+  return _mm_xor_si128(_mm_xor_si128(X, Y), Z);
+}
+
+static inline __m128i I4(__m128i X, __m128i Y, __m128i Z)
+{
+  return _mm_xor_si128(Y, _mm_or_si128(X, _mm_xor_si128(Z, _mm_set1_epi32(-1))));
+}
+
+#define ROT4(X, s) _mm_or_si128(_mm_slli_epi32(X, s), _mm_srli_epi32(X, 32 - s))
+#define MD5X4(d, X, Y, Z, Fn, i, C, s) d = _mm_add_epi32(ROT4(_mm_add_epi32(_mm_add_epi32(d, Fn ## 4(X, Y, Z)), _mm_add_epi32(W[i], _mm_set1_epi32((int)C))), s), X);
+
+/*************************************************************************************/
+static void UpdateHashes(uint32_t* pHash[MD5_LANES], uint32_t const* pBlock[MD5_LANES])
+{
+  __m128i W[16];
+
+  for(int i = 0; i < 16; ++i)
+    W[i] = _mm_set_epi32(pBlock[3][i], pBlock[2][i], pBlock[1][i], pBlock[0][i]);
+
+  __m128i const a0 = _mm_set_epi32(pHash[3][0], pHash[2][0], pHash[1][0], pHash[0][0]);
+  __m128i const b0 = _mm_set_epi32(pHash[3][1], pHash[2][1], pHash[1][1], pHash[0][1]);
+  __m128i const c0 = _mm_set_epi32(pHash[3][2], pHash[2][2], pHash[1][2], pHash[0][2]);
+  __m128i const d0 = _mm_set_epi32(pHash[3][3], pHash[2][3], pHash[1][3], pHash[0][3]);
+
+  __m128i a = a0;
+  __m128i b = b0;
+  __m128i c = c0;
+  __m128i d = d0;
+
+  MD5_ROUNDS(MD5X4)
+
+  uint32_t pOut[4][MD5_LANES];
+  _mm_storeu_si128((__m128i*)pOut[0], _mm_add_epi32(a, a0));
+  _mm_storeu_si128((__m128i*)pOut[1], _mm_add_epi32(b, b0));
+  _mm_storeu_si128((__m128i*)pOut[2], _mm_add_epi32(c, c0));
+  _mm_storeu_si128((__m128i*)pOut[3], _mm_add_epi32(d, d0));
+
+  for(int iLane = 0; iLane < MD5_LANES; ++iLane)
+  {
+    for(int i = 0; i < 4; ++i)
+      pHash[iLane][i] = pOut[i][iLane];
+  }
+}
+
+#else
+/*************************************************************************************/
+static void UpdateHashes(uint32_t* pHash[MD5_LANES], uint32_t const* pBlock[MD5_LANES])
+{
+  for(int iLane = 0; iLane < MD5_LANES; ++iLane)
+    UpdateHash(pHash[iLane], pBlock[iLane]);
+}
+
+#endif
 
 /*************************************************************************************/
-CMD5::CMD5()
+CMD5::CMD5(CMD5Engine* pEngine) :
+  m_pEngine(pEngine)
 {
   // RFC 1321
   m_pHash32[0] = 0x67452301;
@@ -78,11 +242,27 @@ CMD5::CMD5()
 
   m_uNumBytes = 0;
   m_uBound = 0;
+
+  if(m_pEngine)
+    m_pEngine->Attach(this);
+}
+
+/*************************************************************************************/
+CMD5::~CMD5()
+{
+  if(m_pEngine)
+    m_pEngine->Detach(this);
 }
 
 /*************************************************************************************/
 void CMD5::Update(uint8_t* pBuffer, uint32_t uSize)
 {
+  if(m_pEngine)
+  {
+    m_pEngine->Submit(this, pBuffer, uSize);
+    return;
+  }
+
   assert(!(uSize & 3)); // Only support 32-bit aligned buffer size
 
   m_uNumBytes += uSize;
@@ -119,6 +299,9 @@ std::string CMD5::GetMD5()
   std::string sMD5;
   static const char* sToHex = "0123456789abcdef";
 
+  if(m_pEngine)
+    m_pEngine->Drain(this);
+
   m_pBound[m_uBound++] = 0x80; // Safe because m_pBound is never full at this step
 
   if(sizeof(m_pBound) - m_uBound < 8)
@@ -153,82 +336,223 @@ std::string CMD5::GetMD5()
 /*************************************************************************************/
 void CMD5::UpdateBlock(uint32_t* pBlock)
 {
-  uint32_t a = m_pHash32[0];
-  uint32_t b = m_pHash32[1];
-  uint32_t c = m_pHash32[2];
-  uint32_t d = m_pHash32[3];
-
-  MD5(a, b, c, d, F, 0, 0xD76AA478, 7);
-  MD5(d, a, b, c, F, 1, 0xE8C7B756, 12);
-  MD5(c, d, a, b, F, 2, 0x242070DB, 17);
-  MD5(b, c, d, a, F, 3, 0xC1BDCEEE, 22);
-  MD5(a, b, c, d, F, 4, 0xF57C0FAF, 7);
-  MD5(d, a, b, c, F, 5, 0x4787C62A, 12);
-  MD5(c, d, a, b, F, 6, 0xA8304613, 17);
-  MD5(b, c, d, a, F, 7, 0xFD469501, 22);
-  MD5(a, b, c, d, F, 8, 0x698098D8, 7);
-  MD5(d, a, b, c, F, 9, 0x8B44F7AF, 12);
-  MD5(c, d, a, b, F, 10, 0xFFFF5BB1, 17);
-  MD5(b, c, d, a, F, 11, 0x895CD7BE, 22);
-  MD5(a, b, c, d, F, 12, 0x6B901122, 7);
-  MD5(d, a, b, c, F, 13, 0xFD987193, 12);
-  MD5(c, d, a, b, F, 14, 0xA679438E, 17);
-  MD5(b, c, d, a, F, 15, 0x49B40821, 22);
-
-  MD5(a, b, c, d, G, 1, 0xF61E2562, 5);
-  MD5(d, a, b, c, G, 6, 0xC040B340, 9);
-  MD5(c, d, a, b, G, 11, 0x265E5A51, 14);
-  MD5(b, c, d, a, G, 0, 0xE9B6C7AA, 20);
-  MD5(a, b, c, d, G, 5, 0xD62F105D, 5);
-  MD5(d, a, b, c, G, 10, 0x02441453, 9);
-  MD5(c, d, a, b, G, 15, 0xD8A1E681, 14);
-  MD5(b, c, d, a, G, 4, 0xE7D3FBC8, 20);
-  MD5(a, b, c, d, G, 9, 0x21E1CDE6, 5);
-  MD5(d, a, b, c, G, 14, 0xC33707D6, 9);
-  MD5(c, d, a, b, G, 3, 0xF4D50D87, 14);
-  MD5(b, c, d, a, G, 8, 0x455A14ED, 20);
-  MD5(a, b, c, d, G, 13, 0xA9E3E905, 5);
-  MD5(d, a, b, c, G, 2, 0xFCEFA3F8, 9);
-  MD5(c, d, a, b, G, 7, 0x676F02D9, 14);
-  MD5(b, c, d, a, G, 12, 0x8D2A4C8A, 20);
-
-  MD5(a, b, c, d, H, 5, 0xFFFA3942, 4);
-  MD5(d, a, b, c, H, 8, 0x8771F681, 11);
-  MD5(c, d, a, b, H, 11, 0x6D9D6122, 16);
-  MD5(b, c, d, a, H, 14, 0xFDE5380C, 23);
-  MD5(a, b, c, d, H, 1, 0xA4BEEA44, 4);
-  MD5(d, a, b, c, H, 4, 0x4BDECFA9, 11);
-  MD5(c, d, a, b, H, 7, 0xF6BB4B60, 16);
-  MD5(b, c, d, a, H, 10, 0xBEBFBC70, 23);
-  MD5(a, b, c, d, H, 13, 0x289B7EC6, 4);
-  MD5(d, a, b, c, H, 0, 0xEAA127FA, 11);
-  MD5(c, d, a, b, H, 3, 0xD4EF3085, 16);
-  MD5(b, c, d, a, H, 6, 0x04881D05, 23);
-  MD5(a, b, c, d, H, 9, 0xD9D4D039, 4);
-  MD5(d, a, b, c, H, 12, 0xE6DB99E5, 11);
-  MD5(c, d, a, b, H, 15, 0x1FA27CF8, 16);
-  MD5(b, c, d, a, H, 2, 0xC4AC5665, 23);
-
-  MD5(a, b, c, d, I, 0, 0xF4292244, 6);
-  MD5(d, a, b, c, I, 7, 0x432AFF97, 10);
-  MD5(c, d, a, b, I, 14, 0xAB9423A7, 15);
-  MD5(b, c, d, a, I, 5, 0xFC93A039, 21);
-  MD5(a, b, c, d, I, 12, 0x655B59C3, 6);
-  MD5(d, a, b, c, I, 3, 0x8F0CCC92, 10);
-  MD5(c, d, a, b, I, 10, 0xFFEFF47D, 15);
-  MD5(b, c, d, a, I, 1, 0x85845DD1, 21);
-  MD5(a, b, c, d, I, 8, 0x6FA87E4F, 6);
-  MD5(d, a, b, c, I, 15, 0xFE2CE6E0, 10);
-  MD5(c, d, a, b, I, 6, 0xA3014314, 15);
-  MD5(b, c, d, a, I, 13, 0x4E0811A1, 21);
-  MD5(a, b, c, d, I, 4, 0xF7537E82, 6);
-  MD5(d, a, b, c, I, 11, 0xBD3AF235, 10);
-  MD5(c, d, a, b, I, 2, 0x2AD7D2BB, 15);
-  MD5(b, c, d, a, I, 9, 0xEB86D391, 21);
-
-  m_pHash32[0] += a;
-  m_pHash32[1] += b;
-  m_pHash32[2] += c;
-  m_pHash32[3] += d;
+  UpdateHash(m_pHash32, pBlock);
+}
+
+/*************************************************************************************/
+CMD5Engine::CMD5Engine(size_t zMaxQueuedBytes) :
+  m_zMaxQueuedBytes(zMaxQueuedBytes)
+{
+  m_Worker = std::thread(&CMD5Engine::Process, this);
+}
+
+/*************************************************************************************/
+CMD5Engine::~CMD5Engine()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_Lock);
+    m_bExit = true;
+  }
+  m_Work.notify_one();
+  m_Worker.join();
+}
+
+/*************************************************************************************/
+void CMD5Engine::Attach(CMD5* pMD5)
+{
+  std::lock_guard<std::mutex> lock(m_Lock);
+  m_MD5s.push_back(pMD5);
+}
+
+/*************************************************************************************/
+void CMD5Engine::Detach(CMD5* pMD5)
+{
+  Drain(pMD5);
+
+  std::lock_guard<std::mutex> lock(m_Lock);
+
+  for(auto it = m_MD5s.begin(); it != m_MD5s.end(); ++it)
+  {
+    if(*it == pMD5)
+    {
+      m_MD5s.erase(it);
+      break;
+    }
+  }
+}
+
+/*************************************************************************************/
+void CMD5Engine::Submit(CMD5* pMD5, uint8_t const* pBuffer, uint32_t uSize)
+{
+  if(!uSize)
+    return;
+
+  std::vector<uint8_t> chunk(pBuffer, pBuffer + uSize);
+
+  std::unique_lock<std::mutex> lock(m_Lock);
+  m_Done.wait(lock, [&]() {
+    return m_zQueuedBytes == 0 || m_zQueuedBytes + uSize <= m_zMaxQueuedBytes;
+  });
+  pMD5->m_Pending.push_back(std::move(chunk));
+  m_zQueuedBytes += uSize;
+  lock.unlock();
+
+  m_Work.notify_one();
+}
+
+/*************************************************************************************/
+void CMD5Engine::Drain(CMD5* pMD5)
+{
+  std::unique_lock<std::mutex> lock(m_Lock);
+  m_Done.wait(lock, [&]() {
+    return pMD5->m_Pending.empty() && !pMD5->m_bBusy;
+  });
+}
+
+namespace
+{
+/* A chunk being hashed: the end of the previous chunks of the MD5 (m_pBound) is
+ * completed with its start, then its 64 bytes blocks are hashed in place. */
+struct Lane
+{
+  Lane(CMD5* pMD5_, std::vector<uint8_t>&& chunk_) :
+    pMD5(pMD5_), chunk(std::move(chunk_)), pData(chunk.data()), uSize(chunk.size())
+  {
+  }
+
+  CMD5* pMD5;
+  std::vector<uint8_t> chunk;
+  uint8_t const* pData;
+  uint32_t uSize;
+  bool bBoundFull = false;
+};
+}
+
+/*************************************************************************************/
+void CMD5Engine::Process()
+{
+  static uint32_t const pZeroBlock[16] = {};
+
+  for(;;)
+  {
+    std::vector<Lane> lanes;
+
+    {
+      std::unique_lock<std::mutex> lock(m_Lock);
+      auto hasWork = [&]() {
+        for(auto pMD5 : m_MD5s)
+        {
+          if(!pMD5->m_Pending.empty())
+            return true;
+        }
+
+        return false;
+      };
+
+      m_Work.wait(lock, [&]() {
+        return m_bExit || hasWork();
+      });
+
+      if(!hasWork())
+        return;
+
+      // round robin, so that one busy MD5 does not delay the others
+      for(size_t i = 0; i < m_MD5s.size() && lanes.size() < MD5_LANES; ++i)
+      {
+        CMD5* pMD5 = m_MD5s[(m_uNextMD5 + i) % m_MD5s.size()];
+
+        if(pMD5->m_Pending.empty())
+          continue;
+
+        pMD5->m_bBusy = true;
+        lanes.emplace_back(pMD5, std::move(pMD5->m_Pending.front()));
+        pMD5->m_Pending.pop_front();
+      }
+
+      m_uNextMD5 = (m_uNextMD5 + 1) % m_MD5s.size();
+    }
+
+    for(auto& lane : lanes)
+    {
+      CMD5* pMD5 = lane.pMD5;
+      pMD5->m_uNumBytes += lane.uSize;
+
+      if(pMD5->m_uBound)
+      {
+        uint32_t uCopy = std::min<uint32_t>(lane.uSize, sizeof(pMD5->m_pBound) - pMD5->m_uBound);
+        memcpy(pMD5->m_pBound + pMD5->m_uBound, lane.pData, uCopy);
+        pMD5->m_uBound += uCopy;
+        lane.pData += uCopy;
+        lane.uSize -= uCopy;
+        lane.bBoundFull = pMD5->m_uBound == sizeof(pMD5->m_pBound);
+      }
+    }
+
+    for(;;)
+    {
+      uint32_t pDummyHash[4];
+      uint32_t* pHash[MD5_LANES];
+      uint32_t const* pBlock[MD5_LANES];
+      int iNumActive = 0;
+      int iLastActive = 0;
+
+      for(int iLane = 0; iLane < MD5_LANES; ++iLane)
+      {
+        pHash[iLane] = pDummyHash;
+        pBlock[iLane] = pZeroBlock;
+
+        if(iLane >= (int)lanes.size())
+          continue;
+
+        auto& lane = lanes[iLane];
+        CMD5* pMD5 = lane.pMD5;
+
+        if(lane.bBoundFull)
+        {
+          pBlock[iLane] = reinterpret_cast<uint32_t const*>(pMD5->m_pBound);
+          lane.bBoundFull = false;
+          pMD5->m_uBound = 0;
+        }
+        else if(lane.uSize >= sizeof(pMD5->m_pBound))
+        {
+          pBlock[iLane] = reinterpret_cast<uint32_t const*>(lane.pData);
+          lane.pData += sizeof(pMD5->m_pBound);
+          lane.uSize -= sizeof(pMD5->m_pBound);
+        }
+        else
+          continue;
+
+        pHash[iLane] = pMD5->m_pHash32;
+        ++iNumActive;
+        iLastActive = iLane;
+      }
+
+      if(iNumActive == 0)
+        break;
+
+      if(iNumActive == 1)
+        UpdateHash(pHash[iLastActive], pBlock[iLastActive]);
+      else
+        UpdateHashes(pHash, pBlock);
+    }
+
+    for(auto& lane : lanes)
+    {
+      CMD5* pMD5 = lane.pMD5;
+      memcpy(pMD5->m_pBound + pMD5->m_uBound, lane.pData, lane.uSize);
+      pMD5->m_uBound += lane.uSize;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_Lock);
+
+      for(auto& lane : lanes)
+      {
+        lane.pMD5->m_bBusy = false;
+        m_zQueuedBytes -= lane.chunk.size();
+      }
+    }
+    m_Done.notify_all();
+  }
 }
 
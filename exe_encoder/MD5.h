@@ -38,17 +38,28 @@
 #pragma once
 
 #include "lib_rtos/types.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
+
+class CMD5Engine;
 
 class CMD5
 {
 public:
-  CMD5();
+  /* with an engine, the data is hashed on the engine thread, Update only queues a copy of it */
+  CMD5(CMD5Engine* pEngine = nullptr);
+  ~CMD5();
 
   void Update(uint8_t* pBuffer, uint32_t uSize);
   std::string GetMD5();
 
 protected:
+  friend class CMD5Engine;
+
   void UpdateBlock(uint32_t* pBlock);
 
   union
@@ -61,5 +72,42 @@ protected:
 
   uint8_t m_pBound[64]; // 512 bits
   uint32_t m_uBound;
+
+  CMD5Engine* const m_pEngine;
+  std::deque<std::vector<uint8_t>> m_Pending; // guarded by the engine lock
+  bool m_bBusy = false; // the engine is hashing a chunk of this MD5
+};
+
+/*
+ * Multi-buffer MD5: a worker thread hashes the data submitted to several CMD5
+ * at once, one MD5 per SIMD lane. The chunks of one CMD5 are hashed in the
+ * order of the Update calls.
+ */
+class CMD5Engine
+{
+public:
+  /* Update blocks while more than zMaxQueuedBytes are waiting to be hashed */
+  CMD5Engine(size_t zMaxQueuedBytes = 256 * 1024 * 1024);
+  ~CMD5Engine();
+
+private:
+  friend class CMD5;
+
+  void Attach(CMD5* pMD5);
+  void Detach(CMD5* pMD5);
+  void Submit(CMD5* pMD5, uint8_t const* pBuffer, uint32_t uSize);
+  void Drain(CMD5* pMD5);
+
+  void Process();
+
+  std::mutex m_Lock;
+  std::condition_variable m_Work;
+  std::condition_variable m_Done;
+  std::vector<CMD5*> m_MD5s;
+  size_t m_uNextMD5 = 0;
+  size_t const m_zMaxQueuedBytes;
+  size_t m_zQueuedBytes = 0;
+  bool m_bExit = false;
+  std::thread m_Worker;
 };
 
@@ -44,6 +44,7 @@
 #include <malloc.h>
 #include <sstream>
 #include <fstream>
+#include <vector>
 
 extern "C"
 {
@@ -673,6 +674,28 @@ bool GenerateROIBuffer(AL_TRoiMngrCtx* pRoiCtx, string const& sRoiFileName, int
   return Load_QPTable_FromRoiFile(pRoiCtx, sRoiFileName, pQPs, iFrameID, iNumQPPerLCU, iNumBytesPerLCU);
 }
 
+/****************************************************************************/
+bool GenerateAdaptiveQPBuffer(AdaptiveQP* pAQ, AL_TBuffer* pSrc, int16_t iSliceQP, int16_t iMinQP, int16_t iMaxQP, int iLCUWidth, int iLCUHeight, AL_EProfile eProf, uint8_t* pQPs)
+{
+  int iNumQPPerLCU, iNumBytesPerLCU, iNumLCUs;
+  GetQPBufferParameters(iLCUWidth, iLCUHeight, eProf, iNumQPPerLCU, iNumBytesPerLCU, iNumLCUs, pQPs);
+
+  vector<int8_t> deltaQPs(iNumLCUs);
+
+  // the table is relative to the slice QP
+  if(!pAQ->Analyze(pSrc, iMinQP - iSliceQP, iMaxQP - iSliceQP, deltaQPs.data(), iLCUWidth, iLCUHeight))
+    return false;
+
+  for(int iLCU = 0; iLCU < iNumLCUs; ++iLCU)
+  {
+    int iFirst = iLCU * iNumBytesPerLCU;
+
+    for(int iQP = 0; iQP < iNumQPPerLCU; ++iQP)
+      pQPs[iFirst + iQP] = deltaQPs[iLCU] & MASK_QP;
+  }
+
+  return true;
+}
 
 /****************************************************************************/
 bool GenerateQPBuffer(AL_EQpCtrlMode eMode, int16_t iSliceQP, int16_t iMinQP, int16_t iMaxQP, int iLCUWidth, int iLCUHeight, AL_EProfile eProf, int iFrameID, uint8_t* pQPs, uint8_t* pSegs)
@@ -42,6 +42,7 @@
 #include "lib_common_enc/Settings.h"
 #include <string>
 #include "ROIMngr.h"
+#include "AdaptiveQP.h"
 
 /*************************************************************************//*!
    \brief Fill QP part of the buffer pointed to by pQP with a QP for each
@@ -77,5 +78,21 @@ bool GenerateQPBuffer(AL_EQpCtrlMode eMode, int16_t iSliceQP, int16_t iMinQP, in
 *****************************************************************************/
 bool GenerateROIBuffer(AL_TRoiMngrCtx* pRoiCtx, std::string const& sRoiFileName, int iLCUWidth, int iLCUHeight, AL_EProfile eProf, int iFrameID, uint8_t* pQPs);
 
+/*************************************************************************//*!
+   \brief Fill QP part of the buffer pointed to by pQP with a delta QP for each
+        Macroblock of the slice, computed from the content of the source picture
+   \param[in]  pAQ        Pointer to the analyser of the source pictures
+   \param[in]  pSrc       Source picture to be encoded with the QP table
+   \param[in]  iSliceQP   Slice QP value (in range [0..51])
+   \param[in]  iMinQP     Minimum allowed QP value (in range [0..50])
+   \param[in]  iMaxQP     Maximum allowed QP value (in range [1..51]).
+   \param[in]  iLCUWidth  Width in Lcu Unit of the picture
+   \param[in]  iLCUHeight Height in Lcu Unit of the picture
+   \param[in]  eProf      Profile used for the encoding
+   \param[out] pQPs       Pointer to the buffer that receives the computed QPs
+   \return true on success, false if the source can't be analysed
+*****************************************************************************/
+bool GenerateAdaptiveQPBuffer(AdaptiveQP* pAQ, AL_TBuffer* pSrc, int16_t iSliceQP, int16_t iMinQP, int16_t iMaxQP, int iLCUWidth, int iLCUHeight, AL_EProfile eProf, uint8_t* pQPs);
+
 /****************************************************************************/
 
@@ -0,0 +1,347 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "QPTableStore.h"
+#include "QPGenerator.h"
+#include "ROIMngr.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+extern "C"
+{
+#include "lib_common_enc/EncBuffers.h"
+}
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#define QP_TABLE_MAGIC 0x54505141 // "AQPT"
+#define QP_TABLE_VERSION 1
+
+// the tables start on a page boundary
+static uint32_t const uDataAlign = 4096;
+// number of tables faulted in ahead of the encoder when the file doesn't fit in RAM
+static int const iPrefetchDepth = 32;
+
+/****************************************************************************/
+static uint32_t GetTableSize(AL_TEncChanParam const& tChParam)
+{
+  AL_TDimension tDim = { tChParam.uWidth, tChParam.uHeight };
+  return AL_GetAllocSizeEP2(tDim, tChParam.uMaxCuSize) - EP2_BUF_QP_BY_MB.Offset;
+}
+
+/****************************************************************************/
+static void WriteHeader(ofstream& File, TQPTableFileHeader const& tHeader)
+{
+  uint32_t const uFields[] =
+  {
+    tHeader.uMagic, tHeader.uVersion, tHeader.uLCUWidth, tHeader.uLCUHeight,
+    tHeader.uTableSize, tHeader.uNumFrames, tHeader.uDataOffset, tHeader.uReserved
+  };
+  uint8_t pBytes[sizeof(uFields)];
+
+  for(size_t i = 0; i < sizeof(uFields) / sizeof(*uFields); ++i)
+    for(int iByte = 0; iByte < 4; ++iByte)
+      pBytes[4 * i + iByte] = (uFields[i] >> (8 * iByte)) & 0xFF;
+
+  File.write((char const*)pBytes, sizeof(pBytes));
+}
+
+/****************************************************************************/
+static TQPTableFileHeader ReadHeader(uint8_t const* pBytes)
+{
+  uint32_t uFields[sizeof(TQPTableFileHeader) / sizeof(uint32_t)];
+
+  for(size_t i = 0; i < sizeof(uFields) / sizeof(*uFields); ++i)
+    uFields[i] = pBytes[4 * i] | (pBytes[4 * i + 1] << 8) | (pBytes[4 * i + 2] << 16) | ((uint32_t)pBytes[4 * i + 3] << 24);
+
+  TQPTableFileHeader tHeader;
+  tHeader.uMagic = uFields[0];
+  tHeader.uVersion = uFields[1];
+  tHeader.uLCUWidth = uFields[2];
+  tHeader.uLCUHeight = uFields[3];
+  tHeader.uTableSize = uFields[4];
+  tHeader.uNumFrames = uFields[5];
+  tHeader.uDataOffset = uFields[6];
+  tHeader.uReserved = uFields[7];
+  return tHeader;
+}
+
+/****************************************************************************/
+void CompileQPTables(string const& sFileName, AL_TEncSettings const& settings, string const& sRoiFileName, int iNumFrames)
+{
+  auto& tChParam = settings.tChParam[0];
+
+  if((settings.eQpCtrlMode & MASK_QP_TABLE) == ADAPTIVE_QP)
+    throw runtime_error("Adaptive QP tables depend on the source and can't be compiled");
+
+  ofstream File(sFileName, ios::binary);
+
+  if(!File.is_open())
+    throw runtime_error("Can't open QP table file: " + sFileName);
+
+  TQPTableFileHeader tHeader {};
+  tHeader.uMagic = QP_TABLE_MAGIC;
+  tHeader.uVersion = QP_TABLE_VERSION;
+  tHeader.uLCUWidth = AL_GetWidthInLCU(tChParam);
+  tHeader.uLCUHeight = AL_GetHeightInLCU(tChParam);
+  tHeader.uTableSize = GetTableSize(tChParam);
+  tHeader.uNumFrames = iNumFrames;
+  tHeader.uDataOffset = uDataAlign;
+
+  WriteHeader(File, tHeader);
+  vector<char> padding(tHeader.uDataOffset - sizeof(TQPTableFileHeader));
+  File.write(padding.data(), padding.size());
+
+  // replays the text sources frame by frame, the ROI manager keeps the regions of the previous frames
+  AL_TRoiMngrCtx* pRoiCtx = AL_RoiMngr_Create(tChParam.uWidth, tChParam.uHeight, tChParam.eProfile, AL_ROI_QUALITY_LOW, AL_ROI_QUALITY_ORDER);
+  vector<uint8_t> table(tHeader.uTableSize);
+
+  for(int iFrame = 0; iFrame < iNumFrames; ++iFrame)
+  {
+    bool bRet = GenerateQPBuffer(settings.eQpCtrlMode, tChParam.tRCParam.iInitialQP, tChParam.tRCParam.iMinQP, tChParam.tRCParam.iMaxQP,
+                                 tHeader.uLCUWidth, tHeader.uLCUHeight, tChParam.eProfile, iFrame, table.data(), NULL);
+
+    if(!bRet)
+      bRet = GenerateROIBuffer(pRoiCtx, sRoiFileName, tHeader.uLCUWidth, tHeader.uLCUHeight, tChParam.eProfile, iFrame, table.data());
+
+    if(!bRet)
+    {
+      AL_RoiMngr_Destroy(pRoiCtx);
+      throw runtime_error("No QP table source for frame " + to_string(iFrame));
+    }
+
+    File.write((char const*)table.data(), table.size());
+  }
+
+  AL_RoiMngr_Destroy(pRoiCtx);
+
+  if(!File.good())
+    throw runtime_error("Can't write QP table file: " + sFileName);
+}
+
+/****************************************************************************/
+QPTableStore::QPTableStore(string const& sFileName, AL_TEncChanParam const& tChParam)
+{
+  uint8_t pHeader[sizeof(TQPTableFileHeader)];
+
+#if defined(_WIN32)
+  m_File.open(sFileName, ios::binary);
+
+  if(!m_File.is_open())
+    throw runtime_error("Can't open QP table file: " + sFileName);
+
+  m_File.seekg(0, ios::end);
+  m_uFileSize = m_File.tellg();
+  m_File.seekg(0, ios::beg);
+
+  if(m_uFileSize < sizeof(pHeader) || !m_File.read((char*)pHeader, sizeof(pHeader)))
+    throw runtime_error("Invalid QP table file: " + sFileName);
+#else
+  m_iFd = open(sFileName.c_str(), O_RDONLY);
+
+  if(m_iFd < 0)
+    throw runtime_error("Can't open QP table file: " + sFileName);
+
+  struct stat tStat;
+
+  if(fstat(m_iFd, &tStat) != 0 || (uint64_t)tStat.st_size < sizeof(pHeader))
+  {
+    close(m_iFd);
+    throw runtime_error("Invalid QP table file: " + sFileName);
+  }
+
+  m_uFileSize = tStat.st_size;
+  void* pMap = mmap(NULL, m_uFileSize, PROT_READ, MAP_SHARED, m_iFd, 0);
+
+  if(pMap == MAP_FAILED)
+  {
+    close(m_iFd);
+    throw runtime_error("Can't map QP table file: " + sFileName);
+  }
+
+  m_pMap = (uint8_t*)pMap;
+  memcpy(pHeader, m_pMap, sizeof(pHeader));
+#endif
+
+  m_tHeader = ReadHeader(pHeader);
+
+  bool bValid = m_tHeader.uMagic == QP_TABLE_MAGIC && m_tHeader.uVersion == QP_TABLE_VERSION &&
+                m_tHeader.uDataOffset + (uint64_t)m_tHeader.uTableSize * m_tHeader.uNumFrames <= m_uFileSize;
+
+  bool bMatch = m_tHeader.uLCUWidth == (uint32_t)AL_GetWidthInLCU(tChParam) &&
+                m_tHeader.uLCUHeight == (uint32_t)AL_GetHeightInLCU(tChParam) &&
+                m_tHeader.uTableSize == GetTableSize(tChParam);
+
+  if(!bValid || !bMatch)
+  {
+#if !defined(_WIN32)
+    munmap(m_pMap, m_uFileSize);
+    close(m_iFd);
+#endif
+    throw runtime_error(bValid ? "QP table file doesn't match the channel resolution: " + sFileName : "Invalid QP table file: " + sFileName);
+  }
+
+#if !defined(_WIN32)
+  uint64_t uRamSize = (uint64_t)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE);
+
+  if(m_uFileSize <= uRamSize / 2)
+    madvise(m_pMap, m_uFileSize, MADV_WILLNEED);
+  else
+  {
+    madvise(m_pMap, m_uFileSize, MADV_SEQUENTIAL);
+    m_Prefetcher = thread(&QPTableStore::Prefetch, this);
+  }
+#endif
+}
+
+/****************************************************************************/
+QPTableStore::~QPTableStore()
+{
+  {
+    lock_guard<mutex> lock(m_Lock);
+    m_bExit = true;
+  }
+  m_Work.notify_one();
+
+  if(m_Prefetcher.joinable())
+    m_Prefetcher.join();
+
+#if !defined(_WIN32)
+  munmap(m_pMap, m_uFileSize);
+  close(m_iFd);
+#endif
+}
+
+/****************************************************************************/
+uint8_t const* QPTableStore::GetTableData(int iFrameID) const
+{
+#if defined(_WIN32)
+  (void)iFrameID;
+  return nullptr;
+#else
+  return m_pMap + m_tHeader.uDataOffset + (uint64_t)iFrameID * m_tHeader.uTableSize;
+#endif
+}
+
+/****************************************************************************/
+bool QPTableStore::GetTable(int iFrameID, uint8_t* pQPs)
+{
+  if(iFrameID < 0 || GetNumFrames() <= 0)
+    return false;
+
+  iFrameID = min(iFrameID, GetNumFrames() - 1);
+
+#if defined(_WIN32)
+  m_File.seekg(m_tHeader.uDataOffset + (uint64_t)iFrameID * m_tHeader.uTableSize);
+  m_File.read((char*)pQPs, m_tHeader.uTableSize);
+  return m_File.good();
+#else
+  memcpy(pQPs, GetTableData(iFrameID), m_tHeader.uTableSize);
+
+  if(m_Prefetcher.joinable())
+  {
+    {
+      lock_guard<mutex> lock(m_Lock);
+      m_iCurFrame = iFrameID;
+    }
+    m_Work.notify_one();
+  }
+
+  return true;
+#endif
+}
+
+/****************************************************************************/
+void QPTableStore::Prefetch()
+{
+#if !defined(_WIN32)
+  uintptr_t const uPageSize = sysconf(_SC_PAGESIZE);
+  int iNextFrame = 0; // first table not faulted in yet
+  int iFirstKept = 0; // first table not dropped yet
+
+  unique_lock<mutex> lock(m_Lock);
+
+  while(!m_bExit)
+  {
+    int const iCurFrame = m_iCurFrame;
+    int const iLastFrame = min(iCurFrame + iPrefetchDepth, GetNumFrames());
+
+    if(iNextFrame >= iLastFrame && iFirstKept >= iCurFrame)
+    {
+      m_Work.wait(lock);
+      continue;
+    }
+
+    lock.unlock();
+
+    // the tables before the current one won't be requested again
+    if(iCurFrame > iFirstKept)
+    {
+      uintptr_t uStart = ((uintptr_t)GetTableData(iFirstKept) + uPageSize - 1) & ~(uPageSize - 1);
+      uintptr_t uEnd = (uintptr_t)GetTableData(iCurFrame) & ~(uPageSize - 1);
+
+      if(uEnd > uStart)
+        madvise((void*)uStart, uEnd - uStart, MADV_DONTNEED);
+      iFirstKept = iCurFrame;
+    }
+
+    // touching a byte per page faults the table in
+    for(iNextFrame = max(iNextFrame, iCurFrame); iNextFrame < iLastFrame; ++iNextFrame)
+    {
+      uint8_t const* pTable = GetTableData(iNextFrame);
+      volatile uint8_t uSink = 0;
+
+      for(uint32_t uOffset = 0; uOffset < m_tHeader.uTableSize; uOffset += uPageSize)
+        uSink += pTable[uOffset];
+
+      uSink += pTable[m_tHeader.uTableSize - 1];
+    }
+
+    lock.lock();
+  }
+#endif
+}
+
@@ -0,0 +1,121 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include "lib_rtos/types.h"
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "lib_common_enc/Settings.h"
+
+/*
+ * Compiled QP tables: the per frame QP tables of a whole sequence, stored in
+ * the layout of the QP by MB part of the encoder parameters buffer 2, so that
+ * a table can be copied as is in the QP buffer of the frame.
+ *
+ * File layout: a TQPTableFileHeader, then uNumFrames tables of uTableSize
+ * bytes starting at uDataOffset. All the fields are little endian.
+ */
+struct TQPTableFileHeader
+{
+  uint32_t uMagic; // QP_TABLE_MAGIC
+  uint32_t uVersion;
+  uint32_t uLCUWidth;
+  uint32_t uLCUHeight;
+  uint32_t uTableSize; // bytes per frame
+  uint32_t uNumFrames;
+  uint32_t uDataOffset; // offset of the first table from the start of the file
+  uint32_t uReserved;
+};
+
+/*************************************************************************//*!
+   \brief Compiles the QP tables of the iNumFrames first frames, generated from
+   the text QP files (LOAD_QP) or the ROI file as the encoder would, in a
+   binary file readable by QPTableStore. Throws a runtime_error on failure.
+   \param[in] sFileName    Name of the compiled file
+   \param[in] settings     Encoder settings (eQpCtrlMode and first channel)
+   \param[in] sRoiFileName Name of the ROI file used when the QP mode doesn't
+   generate the tables itself
+   \param[in] iNumFrames   Number of frames to compile
+*****************************************************************************/
+void CompileQPTables(std::string const& sFileName, AL_TEncSettings const& settings, std::string const& sRoiFileName, int iNumFrames);
+
+/*
+ * Reads the tables of a compiled file. The whole file is mapped in memory:
+ * when it fits in RAM, it is preloaded at once, otherwise a prefetch thread
+ * faults in the tables of the next frames ahead of the encoder and drops the
+ * ones already consumed.
+ */
+class QPTableStore
+{
+public:
+  /* throws a runtime_error when the file doesn't match the channel */
+  QPTableStore(std::string const& sFileName, AL_TEncChanParam const& tChParam);
+  ~QPTableStore();
+
+  int GetNumFrames() const { return m_tHeader.uNumFrames; }
+
+  /* Copies the table of frame iFrameID in the QP by MB part of a QP buffer.
+   * The frames after the last one of the file (e.g. when looping on the
+   * source) repeat its last table. Returns false when the file has no table */
+  bool GetTable(int iFrameID, uint8_t* pQPs);
+
+private:
+  void Prefetch();
+  uint8_t const* GetTableData(int iFrameID) const;
+
+  TQPTableFileHeader m_tHeader;
+  uint64_t m_uFileSize = 0;
+
+#if defined(_WIN32)
+  std::ifstream m_File;
+#else
+  int m_iFd = -1;
+  uint8_t* m_pMap = nullptr;
+#endif
+
+  std::mutex m_Lock;
+  std::condition_variable m_Work;
+  int m_iCurFrame = 0; // last frame requested by the encoder
+  bool m_bExit = false;
+  std::thread m_Prefetcher;
+};
+
@@ -167,6 +167,23 @@ static void UpdateTransitionVert(AL_TRoiMngrCtx* pCtx, uint8_t* pLcu1, uint8_t*
   }
 }
 
+/****************************************************************************/
+static void FillRow(uint8_t* pLCU, int iNumLCUs, int iNumQPPerLCU, int iNumBytesPerLCU, uint8_t uQP)
+{
+  // contiguous QPs: memset uses the widest stores available
+  if(iNumQPPerLCU == iNumBytesPerLCU)
+  {
+    Rtos_Memset(pLCU, uQP, iNumLCUs * iNumBytesPerLCU);
+    return;
+  }
+
+  for(int w = 0; w < iNumLCUs; ++w)
+  {
+    for(int i = 0; i < iNumQPPerLCU; ++i)
+      pLCU[w * iNumBytesPerLCU + i] = uQP;
+  }
+}
+
 /****************************************************************************/
 static uint32_t GetNodePosInBuf(AL_TRoiMngrCtx* pCtx, uint32_t uLcuX, uint32_t uLcuY, int iNumBytesPerLCU)
 {
@@ -182,12 +199,7 @@ static void ComputeROI(AL_TRoiMngrCtx* pCtx, int iNumQPPerLCU, int iNumBytesPerL
   // Fill Roi
   for(int h = 0; h < pNode->iHeight; ++h)
   {
-    for(int w = 0; w < pNode->iWidth; ++w)
-    {
-      for(int i = 0; i < iNumQPPerLCU; ++i)
-        pLCU[w * iNumBytesPerLCU + i] = pNode->iDeltaQP;
-    }
-
+    FillRow(pLCU, pNode->iWidth, iNumQPPerLCU, iNumBytesPerLCU, pNode->iDeltaQP);
     pLCU += iNumBytesPerLCU * pCtx->iLcuWidth;
   }
 
@@ -243,6 +255,160 @@ static void ComputeROI(AL_TRoiMngrCtx* pCtx, int iNumQPPerLCU, int iNumBytesPerL
   }
 }
 
+/****************************************************************************/
+static bool IsSameRoi(AL_TRoiNode const* pNode1, AL_TRoiNode const* pNode2)
+{
+  return pNode1->iPosX == pNode2->iPosX && pNode1->iPosY == pNode2->iPosY &&
+         pNode1->iWidth == pNode2->iWidth && pNode1->iHeight == pNode2->iHeight &&
+         pNode1->iDeltaQP == pNode2->iDeltaQP;
+}
+
+/****************************************************************************/
+static void GetRowRange(AL_TRoiMngrCtx* pCtx, AL_TRoiNode const* pNode, int& iFirstRow, int& iLastRow)
+{
+  // rows written by ComputeROI, and the ones read by the transitions
+  iFirstRow = pNode->iPosY > 2 ? pNode->iPosY - 2 : 0;
+  iLastRow = pNode->iPosY + pNode->iHeight + 1;
+
+  if(iLastRow >= pCtx->iLcuHeight)
+    iLastRow = pCtx->iLcuHeight - 1;
+}
+
+/****************************************************************************/
+static bool IsDirty(AL_TRoiMngrCtx* pCtx, AL_TRoiNode const* pNode)
+{
+  int iFirstRow, iLastRow;
+  GetRowRange(pCtx, pNode, iFirstRow, iLastRow);
+
+  for(int iRow = iFirstRow; iRow <= iLastRow; ++iRow)
+  {
+    if(pCtx->pDirtyRows[iRow])
+      return true;
+  }
+
+  return false;
+}
+
+/****************************************************************************/
+static bool MarkDirty(AL_TRoiMngrCtx* pCtx, AL_TRoiNode const* pNode)
+{
+  int iFirstRow, iLastRow;
+  GetRowRange(pCtx, pNode, iFirstRow, iLastRow);
+
+  bool bMarked = false;
+
+  for(int iRow = iFirstRow; iRow <= iLastRow; ++iRow)
+  {
+    bMarked |= !pCtx->pDirtyRows[iRow];
+    pCtx->pDirtyRows[iRow] = 1;
+  }
+
+  return bMarked;
+}
+
+/****************************************************************************/
+static void MarkChangedRows(AL_TRoiMngrCtx* pCtx)
+{
+  Rtos_Memset(pCtx->pDirtyRows, 0, pCtx->iLcuHeight);
+
+  // the ROIs are rasterized in order, compare them position by position
+  int iRoi = 0;
+
+  for(AL_TRoiNode* pCur = pCtx->pFirstNode; pCur; pCur = pCur->pNext, ++iRoi)
+  {
+    if(iRoi < pCtx->iNumTableRois && IsSameRoi(pCur, &pCtx->pTableRois[iRoi]))
+      continue;
+
+    MarkDirty(pCtx, pCur);
+
+    if(iRoi < pCtx->iNumTableRois)
+      MarkDirty(pCtx, &pCtx->pTableRois[iRoi]);
+  }
+
+  for(; iRoi < pCtx->iNumTableRois; ++iRoi)
+    MarkDirty(pCtx, &pCtx->pTableRois[iRoi]);
+
+  // An ROI reading or writing a dirty row has to be rasterized again, so all the rows
+  // it touches are dirty too. Once stable, the clean rows are neither read nor written
+  // by the ROIs rasterized again and keep the content of the previous table.
+  bool bMarked = true;
+
+  while(bMarked)
+  {
+    bMarked = false;
+
+    for(AL_TRoiNode* pCur = pCtx->pFirstNode; pCur; pCur = pCur->pNext)
+    {
+      if(IsDirty(pCtx, pCur))
+        bMarked |= MarkDirty(pCtx, pCur);
+    }
+
+    for(int i = 0; i < pCtx->iNumTableRois; ++i)
+    {
+      if(IsDirty(pCtx, &pCtx->pTableRois[i]))
+        bMarked |= MarkDirty(pCtx, &pCtx->pTableRois[i]);
+    }
+  }
+}
+
+/****************************************************************************/
+static void Rasterize(AL_TRoiMngrCtx* pCtx, int iNumQPPerLCU, int iNumBytesPerLCU, uint8_t* pBuf, bool bDirtyOnly)
+{
+  int iRowSize = pCtx->iLcuWidth * iNumBytesPerLCU;
+
+  // Fill background
+  for(int iRow = 0; iRow < pCtx->iLcuHeight; ++iRow)
+  {
+    if(!bDirtyOnly || pCtx->pDirtyRows[iRow])
+      FillRow(pBuf + iRow * iRowSize, pCtx->iLcuWidth, iNumQPPerLCU, iNumBytesPerLCU, GetNewDeltaQP(pCtx->eBkgQuality));
+  }
+
+  // Fill ROIs
+  for(AL_TRoiNode* pCur = pCtx->pFirstNode; pCur; pCur = pCur->pNext)
+  {
+    if(!bDirtyOnly || IsDirty(pCtx, pCur))
+      ComputeROI(pCtx, iNumQPPerLCU, iNumBytesPerLCU, pBuf, pCur);
+  }
+}
+
+/****************************************************************************/
+static bool SaveTableRois(AL_TRoiMngrCtx* pCtx)
+{
+  int iNumRois = 0;
+
+  for(AL_TRoiNode* pCur = pCtx->pFirstNode; pCur; pCur = pCur->pNext)
+    ++iNumRois;
+
+  if(iNumRois > pCtx->iMaxTableRois)
+  {
+    int iMaxRois = iNumRois > 2 * pCtx->iMaxTableRois ? iNumRois : 2 * pCtx->iMaxTableRois;
+    AL_TRoiNode* pRois = (AL_TRoiNode*)Rtos_Malloc(iMaxRois * sizeof(AL_TRoiNode));
+
+    if(!pRois)
+      return false;
+
+    Rtos_Free(pCtx->pTableRois);
+    pCtx->pTableRois = pRois;
+    pCtx->iMaxTableRois = iMaxRois;
+  }
+
+  int iRoi = 0;
+
+  for(AL_TRoiNode* pCur = pCtx->pFirstNode; pCur; pCur = pCur->pNext)
+    pCtx->pTableRois[iRoi++] = *pCur;
+
+  pCtx->iNumTableRois = iNumRois;
+  return true;
+}
+
+/****************************************************************************/
+static void FreeTable(AL_TRoiMngrCtx* pCtx)
+{
+  Rtos_Free(pCtx->pTable);
+  pCtx->pTable = NULL;
+  pCtx->iNumTableRois = 0;
+}
+
 /****************************************************************************/
 AL_TRoiMngrCtx* AL_RoiMngr_Create(int iPicWidth, int iPicHeight, AL_EProfile eProf, AL_ERoiQuality eBkgQuality, AL_ERoiOrder eOrder)
 {
@@ -265,6 +431,21 @@ AL_TRoiMngrCtx* AL_RoiMngr_Create(int iPicWidth, int iPicHeight, AL_EProfile ePr
   pCtx->iLcuHeight = RoundUp(pCtx->iPicHeight, 1 << pCtx->uLcuSize) >> pCtx->uLcuSize;
   pCtx->iNumLCUs = pCtx->iLcuWidth * pCtx->iLcuHeight;
 
+  pCtx->pTable = NULL;
+  pCtx->iTableNumQPPerLCU = 0;
+  pCtx->iTableNumBytesPerLCU = 0;
+  pCtx->eTableBkgQuality = eBkgQuality;
+  pCtx->pTableRois = NULL;
+  pCtx->iNumTableRois = 0;
+  pCtx->iMaxTableRois = 0;
+  pCtx->pDirtyRows = (uint8_t*)Rtos_Malloc(pCtx->iLcuHeight);
+
+  if(!pCtx->pDirtyRows)
+  {
+    Rtos_Free(pCtx);
+    return NULL;
+  }
+
   return pCtx;
 }
 
@@ -272,6 +453,9 @@ AL_TRoiMngrCtx* AL_RoiMngr_Create(int iPicWidth, int iPicHeight, AL_EProfile ePr
 void AL_RoiMngr_Destroy(AL_TRoiMngrCtx* pCtx)
 {
   AL_RoiMngr_Clear(pCtx);
+  FreeTable(pCtx);
+  Rtos_Free(pCtx->pTableRois);
+  Rtos_Free(pCtx->pDirtyRows);
   Rtos_Free(pCtx);
 }
 
@@ -329,22 +513,34 @@ void AL_RoiMngr_FillBuff(AL_TRoiMngrCtx* pCtx, int iNumQPPerLCU, int iNumBytesPe
 {
   assert(pBuf);
 
-  // Fill background
-  for(int iLCU = 0; iLCU < pCtx->iNumLCUs; iLCU++)
+  int iTableSize = pCtx->iNumLCUs * iNumBytesPerLCU;
+  bool bDirtyOnly = pCtx->pTable && pCtx->iTableNumQPPerLCU == iNumQPPerLCU &&
+                    pCtx->iTableNumBytesPerLCU == iNumBytesPerLCU && pCtx->eTableBkgQuality == pCtx->eBkgQuality;
+
+  if(!bDirtyOnly)
   {
-    int iFirst = iLCU * iNumBytesPerLCU;
+    FreeTable(pCtx);
+    pCtx->pTable = (uint8_t*)Rtos_Malloc(iTableSize);
 
-    for(int iQP = 0; iQP < iNumQPPerLCU; ++iQP)
-      pBuf[iFirst + iQP] = GetNewDeltaQP(pCtx->eBkgQuality);
+    if(!pCtx->pTable)
+    {
+      // no previous table to update, rasterize the whole frame
+      Rasterize(pCtx, iNumQPPerLCU, iNumBytesPerLCU, pBuf, false);
+      return;
+    }
+
+    Rtos_Memset(pCtx->pTable, 0, iTableSize);
+    pCtx->iTableNumQPPerLCU = iNumQPPerLCU;
+    pCtx->iTableNumBytesPerLCU = iNumBytesPerLCU;
+    pCtx->eTableBkgQuality = pCtx->eBkgQuality;
   }
+  else
+    MarkChangedRows(pCtx);
 
-  // Fill ROIs
-  AL_TRoiNode* pCur = pCtx->pFirstNode;
+  Rasterize(pCtx, iNumQPPerLCU, iNumBytesPerLCU, pCtx->pTable, bDirtyOnly);
+  Rtos_Memcpy(pBuf, pCtx->pTable, iTableSize);
 
-  while(pCur)
-  {
-    ComputeROI(pCtx, iNumQPPerLCU, iNumBytesPerLCU, pBuf, pCur);
-    pCur = pCur->pNext;
-  }
+  if(!SaveTableRois(pCtx))
+    FreeTable(pCtx);
 }
 
@@ -89,6 +89,17 @@ struct AL_TRoiMngrCtx
 
   AL_TRoiNode* pFirstNode;
   AL_TRoiNode* pLastNode;
+
+  // table rasterized by the previous AL_RoiMngr_FillBuff, only the rows
+  // touched by the ROIs which changed since are rasterized again
+  uint8_t* pTable;
+  int iTableNumQPPerLCU;
+  int iTableNumBytesPerLCU;
+  AL_ERoiQuality eTableBkgQuality;
+  AL_TRoiNode* pTableRois; // copy of the ROIs pTable was rasterized from
+  int iNumTableRois;
+  int iMaxTableRois;
+  uint8_t* pDirtyRows;
 };
 
 AL_TRoiMngrCtx* AL_RoiMngr_Create(int iPicWidth, int iPicHeight, AL_EProfile eProf, AL_ERoiQuality eBkgQuality, AL_ERoiOrder eOrder);
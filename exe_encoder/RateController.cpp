@@ -0,0 +1,272 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "RateController.h"
+#include "lib_app/utils.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+extern "C"
+{
+#include "lib_common/BufferStreamMeta.h"
+#include "lib_common/BufferPictureMeta.h"
+}
+
+using namespace std;
+
+// share of the estimated capacity used by the stream when the link is idle
+static double const fTargetUse = 0.9;
+// growth of the estimated capacity per frame while the link keeps up with the stream
+static double const fCapacityProbe = 1.01;
+// weight of a new capacity measure when the link is saturated
+static double const fCapacitySmoothing = 0.2;
+// smallest bitrate change sent to the encoder, relative to the current bitrate
+static double const fMinChange = 0.05;
+// the bitrate doesn't go below the maximum bitrate divided by this ratio
+static int const iMinBitRateRatio = 16;
+static int const iMaxFrameRateDivider = 4;
+
+/****************************************************************************/
+static vector<EgressLink::TStep> ParseSchedule(string const& sSchedule)
+{
+  vector<EgressLink::TStep> steps;
+  stringstream ss(sSchedule);
+  string sStep;
+
+  while(getline(ss, sStep, ','))
+  {
+    EgressLink::TStep tStep {};
+    auto zAt = sStep.find('@');
+    tStep.fCapacity = stod(sStep.substr(0, zAt)) * 1000;
+
+    if(zAt != string::npos)
+      tStep.fStart = stod(sStep.substr(zAt + 1));
+
+    if(tStep.fCapacity <= 0 || (!steps.empty() && tStep.fStart <= steps.back().fStart) || (steps.empty() && tStep.fStart != 0))
+      throw runtime_error("Invalid egress link schedule: " + sSchedule);
+
+    steps.push_back(tStep);
+  }
+
+  if(steps.empty())
+    throw runtime_error("Invalid egress link schedule: " + sSchedule);
+
+  return steps;
+}
+
+/****************************************************************************/
+/* The status of the picture comes from its picture metadata. The size sent on
+ * the link is the one of the stream sections: the picture status only gives
+ * the size of the coded slices, not the parameter sets, SEI and filler data
+ * the library writes around them. */
+static bool GetStreamSize(AL_TBuffer* pStream, double& fBits)
+{
+  auto pMeta = (AL_TStreamMetaData*)AL_Buffer_GetMetaData(pStream, AL_META_TYPE_STREAM);
+  auto pPictureMeta = (AL_TPictureMetaData*)AL_Buffer_GetMetaData(pStream, AL_META_TYPE_PICTURE);
+  bool bEndOfFrame = false;
+
+  for(int i = 0; i < pMeta->uNumSection; ++i)
+  {
+    fBits += 8.0 * pMeta->pSections[i].uLength;
+
+    if(pMeta->pSections[i].uFlags & SECTION_END_FRAME_FLAG)
+      bEndOfFrame = true;
+  }
+
+  // no section is written for a skipped picture, the frame still took its time slot
+  if(pPictureMeta && pPictureMeta->bSkipped)
+    bEndOfFrame = true;
+
+  return bEndOfFrame;
+}
+
+/****************************************************************************/
+EgressLink::EgressLink(unique_ptr<IFrameSink> pNext, string const& sSchedule, double fFrameDuration) :
+  m_pNext(move(pNext)), m_Steps(ParseSchedule(sSchedule)), m_fFrameDuration(fFrameDuration)
+{
+}
+
+/****************************************************************************/
+void EgressLink::Advance(double fDuration)
+{
+  double const fEnd = m_fTime + fDuration;
+
+  while(m_fTime < fEnd && m_fBacklog > 0)
+  {
+    auto pStep = upper_bound(m_Steps.begin(), m_Steps.end(), m_fTime, [](double fTime, TStep const& tStep) { return fTime < tStep.fStart; }) - 1;
+    double fStepEnd = (pStep + 1 == m_Steps.end()) ? fEnd : min(fEnd, (pStep + 1)->fStart);
+
+    double fBits = min(m_fBacklog, (fStepEnd - m_fTime) * pStep->fCapacity);
+    m_fBacklog -= fBits;
+    m_fSent += fBits;
+    m_fTime = fStepEnd;
+  }
+
+  m_fTime = fEnd;
+}
+
+/****************************************************************************/
+void EgressLink::ProcessFrame(AL_TBuffer* pStream)
+{
+  if(pStream != EndOfStream)
+  {
+    double fBits = 0;
+
+    if(GetStreamSize(pStream, fBits))
+    {
+      Advance(m_fFrameDuration);
+      m_bSaturated = m_fBacklog > 0;
+    }
+
+    m_fBacklog += fBits;
+  }
+
+  m_pNext->ProcessFrame(pStream);
+}
+
+/****************************************************************************/
+RateController::RateController(unique_ptr<EgressLink> pLink, int iMaxBitRate, int iLatencyBudget, uint16_t uFrameRate, uint16_t uClkRatio) :
+  m_pLink(move(pLink)),
+  m_fMaxBitRate(iMaxBitRate),
+  m_fMinBitRate(iMaxBitRate / iMinBitRateRatio),
+  m_fLatencyBudget(iLatencyBudget / 1000.0),
+  m_uFrameRate(uFrameRate),
+  m_uClkRatio(uClkRatio),
+  m_fCapacity(iMaxBitRate),
+  m_iBitRate(iMaxBitRate),
+  m_bBitRateChanged(true)
+{
+}
+
+/****************************************************************************/
+void RateController::ProcessFrame(AL_TBuffer* pStream)
+{
+  bool bEndOfFrame = pStream != EndOfStream && GetStreamSize(pStream, m_fFrameBits);
+
+  m_pLink->ProcessFrame(pStream);
+
+  if(bEndOfFrame)
+  {
+    Update();
+    m_fFrameBits = 0;
+  }
+
+  if(pStream == EndOfStream)
+  {
+    lock_guard<mutex> lock(m_Lock);
+    Message(CC_DEFAULT, "\nEgress: %d bitrate changes, max delay %.0f ms, max frame rate divider %d\n", m_iNumBitRateChanges, m_fMaxDelay * 1000, m_iMaxDivider);
+  }
+}
+
+/****************************************************************************/
+void RateController::Update()
+{
+  double const fBaseDuration = (double)m_uClkRatio / (m_uFrameRate * 1000.0);
+  lock_guard<mutex> lock(m_Lock);
+  double const fDuration = fBaseDuration * m_iDivider;
+
+  double const fSent = m_pLink->GetSent() - m_fLastSent;
+  double const fBacklog = m_pLink->GetBacklog();
+  m_fLastSent = m_pLink->GetSent();
+
+  // while bits are left in the queue, the link drained all it could
+  if(m_pLink->IsSaturated())
+    m_fCapacity += fCapacitySmoothing * (fSent / fDuration - m_fCapacity);
+  else
+    m_fCapacity = max(m_fCapacity * fCapacityProbe, fSent / fDuration);
+
+  m_fCapacity = min(max(m_fCapacity, m_fMinBitRate / iMaxFrameRateDivider), m_fMaxBitRate);
+
+  double const fDelay = fBacklog / m_fCapacity;
+  m_fMaxDelay = max(m_fMaxDelay, fDelay);
+
+  // drain the queued bits within the latency budget, the minimum bitrate keeps
+  // the same bits per frame when the frame rate is divided
+  double const fMinBitRate = m_fMinBitRate / m_iDivider;
+  double fBitRate = fTargetUse * m_fCapacity - fBacklog / m_fLatencyBudget;
+  fBitRate = min(max(fBitRate, fMinBitRate), m_fMaxBitRate);
+
+  if(fabs(fBitRate - m_iBitRate) > fMinChange * m_iBitRate)
+  {
+    m_iBitRate = (int)fBitRate;
+    m_bBitRateChanged = true;
+  }
+
+  // the frames don't fit at the minimum bitrate: send less of them
+  int iDivider = m_iDivider;
+
+  if(fDelay > m_fLatencyBudget && m_iBitRate <= fMinBitRate && iDivider < iMaxFrameRateDivider)
+    iDivider *= 2;
+  else if(fDelay < m_fLatencyBudget / 4 && m_iBitRate > 2 * fMinBitRate && iDivider > 1)
+    iDivider /= 2;
+
+  if(iDivider != m_iDivider)
+  {
+    m_iDivider = iDivider;
+    m_bDividerChanged = true;
+    m_iMaxDivider = max(m_iMaxDivider, iDivider);
+    m_pLink->SetFrameDuration(fBaseDuration * iDivider);
+  }
+}
+
+/****************************************************************************/
+bool RateController::Apply(ICommandsSender* pSender, int iFrame)
+{
+  lock_guard<mutex> lock(m_Lock);
+
+  if(m_bDividerChanged)
+  {
+    pSender->setFrameRate(m_uFrameRate, m_uClkRatio * m_iDivider);
+    m_iAppliedDivider = m_iDivider;
+    m_bDividerChanged = false;
+  }
+
+  if(iFrame % m_iAppliedDivider)
+    return false;
+
+  if(m_bBitRateChanged)
+  {
+    pSender->setBitRate(m_iBitRate);
+    ++m_iNumBitRateChanges;
+    m_bBitRateChanged = false;
+  }
+
+  return true;
+}
+
@@ -0,0 +1,138 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include "sink.h"
+#include "ICommandsSender.h"
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Model of the link the stream is sent on: the encoded frames are queued and
+ * drained at the capacity of the link. The time is the media time of the
+ * frames, one frame duration per encoded frame, so that the model doesn't
+ * depend on the encoding speed and never blocks the encoder.
+ *
+ * The backlog is simulated: the bitstream writers are synchronous and give
+ * the stream buffers back to their pool at once, so neither the writer queue
+ * depth nor the stream pool occupancy can be read from them.
+ */
+class EgressLink : public IFrameSink
+{
+public:
+  struct TStep
+  {
+    double fStart; // media time in seconds
+    double fCapacity; // bits per second
+  };
+
+  /* sSchedule: "<kbps>[,<kbps>@<seconds>]...", the capacity from each media time */
+  EgressLink(std::unique_ptr<IFrameSink> pNext, std::string const& sSchedule, double fFrameDuration);
+
+  void ProcessFrame(AL_TBuffer* pStream) override;
+
+  void SetFrameDuration(double fFrameDuration) { m_fFrameDuration = fFrameDuration; }
+
+  double GetTime() const { return m_fTime; }
+  double GetBacklog() const { return m_fBacklog; } // bits queued, not sent yet
+  double GetSent() const { return m_fSent; } // bits sent since the start
+  bool IsSaturated() const { return m_bSaturated; } // the link was busy during the whole last frame
+
+private:
+  void Advance(double fDuration);
+
+  std::unique_ptr<IFrameSink> const m_pNext;
+  std::vector<TStep> m_Steps;
+  double m_fFrameDuration;
+  double m_fTime = 0;
+  double m_fBacklog = 0;
+  double m_fSent = 0;
+  bool m_bSaturated = false;
+};
+
+/*
+ * Closed loop bitrate control on the egress side: after each encoded frame,
+ * the capacity of the link is estimated from the bits it drained, and the
+ * target bitrate is set so that the queued bits are sent within the latency
+ * budget. When the minimum bitrate still doesn't fit, the frame rate is
+ * divided and the source frames in excess are dropped.
+ *
+ * The decisions are taken on the thread of the encoded frames and applied by
+ * the thread feeding the encoder, through the ICommandsSender.
+ */
+class RateController : public IFrameSink
+{
+public:
+  RateController(std::unique_ptr<EgressLink> pLink, int iMaxBitRate, int iLatencyBudget, uint16_t uFrameRate, uint16_t uClkRatio);
+
+  /* called with the encoded streams, before they are sent on the link */
+  void ProcessFrame(AL_TBuffer* pStream) override;
+
+  /* returns false when the source frame iFrame has to be dropped, applies the pending changes otherwise */
+  bool Apply(ICommandsSender* pSender, int iFrame);
+
+private:
+  void Update();
+
+  std::unique_ptr<EgressLink> const m_pLink;
+  double const m_fMaxBitRate;
+  double const m_fMinBitRate;
+  double const m_fLatencyBudget; // seconds
+  uint16_t const m_uFrameRate;
+  uint16_t const m_uClkRatio;
+
+  // encoded frames side
+  double m_fCapacity;
+  double m_fLastSent = 0;
+  double m_fFrameBits = 0; // bits of the frame being received
+  double m_fMaxDelay = 0;
+  int m_iMaxDivider = 1;
+
+  // shared with the encoder side
+  std::mutex m_Lock;
+  int m_iBitRate;
+  int m_iDivider = 1;
+  bool m_bBitRateChanged = false;
+  bool m_bDividerChanged = false;
+  int m_iNumBitRateChanges = 0;
+
+  // encoder side
+  int m_iAppliedDivider = 1;
+};
+
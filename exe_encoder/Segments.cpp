@@ -0,0 +1,367 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+#include "Segments.h"
+#include "lib_app/utils.h" // OpenInput, OpenOutput
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <stdexcept>
+
+extern "C"
+{
+#include "lib_common/SliceConsts.h"
+}
+
+using namespace std;
+
+/****************************************************************************/
+vector<TSegment> SplitSegments(int iNumPict, int iNumSegments, AL_TEncChanParam const& tChParam, string const& sStreamFile)
+{
+  auto const& tGopParam = tChParam.tGopParam;
+  int iAlign = 1;
+
+  if(tGopParam.uFreqIDR > 0 && tGopParam.uFreqIDR < (uint32_t)iNumPict)
+    iAlign = tGopParam.uFreqIDR;
+  else if(tGopParam.uGopLength > 1)
+    iAlign = tGopParam.uGopLength;
+
+  // spreads the GOPs evenly over the segments
+  int const iNumGops = (iNumPict + iAlign - 1) / iAlign;
+  iNumSegments = max(1, min(iNumSegments, iNumGops));
+
+  vector<TSegment> segments;
+
+  for(int i = 0; i < iNumSegments; ++i)
+  {
+    int const iFirst = (int)((int64_t)iNumGops * i / iNumSegments) * iAlign;
+    int const iEnd = min(iNumPict, (int)((int64_t)iNumGops * (i + 1) / iNumSegments) * iAlign);
+
+    TSegment segment;
+    segment.iFirstPict = iFirst;
+    segment.iNumPict = iEnd - iFirst;
+    segment.sStreamFile = sStreamFile + ".seg" + to_string(i);
+    segments.push_back(segment);
+  }
+
+  return segments;
+}
+
+enum ENalKind
+{
+  NAL_OTHER,
+  NAL_VCL,
+  NAL_PARAM_SET,
+  NAL_SEI,
+  NAL_END_OF_BITSTREAM,
+};
+
+struct TNal
+{
+  size_t zStart; // first byte of the start code
+  size_t zHeader; // first byte of the nal unit header
+  size_t zEnd; // without the trailing zero bytes
+};
+
+/****************************************************************************/
+static ENalKind GetNalKind(uint8_t uHeader, bool bIsAvc)
+{
+  if(bIsAvc)
+  {
+    int const iType = uHeader & 0x1F;
+
+    if(iType >= 1 && iType <= 5)
+      return NAL_VCL;
+
+    if(iType == 7 || iType == 8 || iType == 13 || iType == 15)
+      return NAL_PARAM_SET;
+
+    if(iType == 6)
+      return NAL_SEI;
+
+    if(iType == 11)
+      return NAL_END_OF_BITSTREAM;
+
+    return NAL_OTHER;
+  }
+
+  int const iType = (uHeader >> 1) & 0x3F;
+
+  if(iType < 32)
+    return NAL_VCL;
+
+  if(iType >= 32 && iType <= 34)
+    return NAL_PARAM_SET;
+
+  if(iType == 39)
+    return NAL_SEI;
+
+  if(iType == 37)
+    return NAL_END_OF_BITSTREAM;
+
+  return NAL_OTHER;
+}
+
+/****************************************************************************/
+static vector<TNal> SplitNals(vector<uint8_t> const& stream)
+{
+  vector<TNal> nals;
+
+  for(size_t i = 0; i + 3 <= stream.size(); ++i)
+  {
+    if(stream[i] != 0 || stream[i + 1] != 0 || stream[i + 2] != 1)
+      continue;
+
+    size_t zStart = (i > 0 && stream[i - 1] == 0) ? i - 1 : i;
+
+    if(nals.empty())
+      zStart = 0;
+    else
+      nals.back().zEnd = zStart;
+
+    nals.push_back({ zStart, i + 3, stream.size() });
+    i += 2;
+  }
+
+  for(auto& nal : nals)
+  {
+    while(nal.zEnd > nal.zHeader && stream[nal.zEnd - 1] == 0)
+      --nal.zEnd;
+  }
+
+  return nals;
+}
+
+/****************************************************************************/
+static vector<uint8_t> RemoveEmulationPrevention(uint8_t const* pData, size_t zSize)
+{
+  vector<uint8_t> rbsp;
+  int iNumZeros = 0;
+
+  for(size_t i = 0; i < zSize; ++i)
+  {
+    if(iNumZeros >= 2 && pData[i] == 0x03)
+    {
+      iNumZeros = 0;
+      continue;
+    }
+
+    rbsp.push_back(pData[i]);
+    iNumZeros = pData[i] ? 0 : iNumZeros + 1;
+  }
+
+  return rbsp;
+}
+
+/****************************************************************************/
+static vector<uint8_t> AddEmulationPrevention(vector<uint8_t> const& rbsp)
+{
+  vector<uint8_t> nal;
+  int iNumZeros = 0;
+
+  for(auto const uByte : rbsp)
+  {
+    if(iNumZeros >= 2 && uByte <= 0x03)
+    {
+      nal.push_back(0x03);
+      iNumZeros = 0;
+    }
+
+    nal.push_back(uByte);
+    iNumZeros = uByte ? 0 : iNumZeros + 1;
+  }
+
+  return nal;
+}
+
+/****************************************************************************/
+static bool GetBit(uint8_t const* pData, int iSize, int& iPos, int& iBit)
+{
+  if(iPos >= iSize * 8)
+    return false;
+
+  iBit = (pData[iPos >> 3] >> (7 - (iPos & 7))) & 1;
+  ++iPos;
+  return true;
+}
+
+/****************************************************************************/
+static bool SkipUE(uint8_t const* pData, int iSize, int& iPos)
+{
+  int iNumZeros = 0;
+  int iBit;
+
+  while(true)
+  {
+    if(!GetBit(pData, iSize, iPos, iBit))
+      return false;
+
+    if(iBit)
+      break;
+    ++iNumZeros;
+  }
+
+  iPos += iNumZeros;
+  return iPos <= iSize * 8;
+}
+
+/****************************************************************************/
+static bool SetConcatenationFlag(uint8_t* pPayload, int iSize)
+{
+  int iPos = 0;
+  int iIrapCpbParamsPresent;
+
+  // bp_seq_parameter_set_id, then irap_cpb_params_present_flag: the encoder
+  // doesn't use sub picture hrd parameters, so this flag is always present
+  if(!SkipUE(pPayload, iSize, iPos) || !GetBit(pPayload, iSize, iPos, iIrapCpbParamsPresent))
+    return false;
+
+  // the delay offsets the encoder never writes would have to be skipped
+  if(iIrapCpbParamsPresent || iPos >= iSize * 8)
+    return false;
+
+  pPayload[iPos >> 3] |= 0x80 >> (iPos & 7);
+  return true;
+}
+
+/****************************************************************************/
+static bool ReadSeiValue(vector<uint8_t> const& rbsp, size_t& i, int& iValue)
+{
+  iValue = 0;
+
+  while(i < rbsp.size() && rbsp[i] == 0xFF)
+  {
+    iValue += 0xFF;
+    ++i;
+  }
+
+  if(i >= rbsp.size())
+    return false;
+
+  iValue += rbsp[i++];
+  return true;
+}
+
+/****************************************************************************/
+static bool MarkConcatenation(vector<uint8_t>& rbsp)
+{
+  size_t i = 0;
+
+  // stops on the rbsp trailing bits
+  while(i < rbsp.size() && rbsp[i] != 0x80)
+  {
+    int iType, iSize;
+
+    if(!ReadSeiValue(rbsp, i, iType) || !ReadSeiValue(rbsp, i, iSize) || i + iSize > rbsp.size())
+      return false;
+
+    if(iType == 0) // buffering_period
+      return SetConcatenationFlag(&rbsp[i], iSize);
+
+    i += iSize;
+  }
+
+  return false;
+}
+
+/****************************************************************************/
+void StitchSegments(vector<TSegment> const& segments, AL_TEncChanParam const& tChParam, string const& sStreamFile)
+{
+  bool const bIsAvc = AL_IS_AVC(tChParam.eProfile);
+  int const iNalHeaderSize = bIsAvc ? 1 : 2;
+
+  ofstream out;
+  OpenOutput(out, sStreamFile);
+
+  set<vector<uint8_t>> paramSets;
+
+  for(size_t iSeg = 0; iSeg < segments.size(); ++iSeg)
+  {
+    ifstream in;
+    OpenInput(in, segments[iSeg].sStreamFile);
+    vector<uint8_t> const stream((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+    bool const bIsJoin = iSeg > 0;
+    bool const bIsLast = iSeg + 1 == segments.size();
+    bool bIsFirstAU = true;
+
+    for(auto const& nal : SplitNals(stream))
+    {
+      if(nal.zEnd <= nal.zHeader)
+        continue;
+
+      auto const eKind = GetNalKind(stream[nal.zHeader], bIsAvc);
+
+      if(eKind == NAL_VCL)
+        bIsFirstAU = false;
+
+      if(eKind == NAL_PARAM_SET)
+      {
+        vector<uint8_t> paramSet(stream.begin() + nal.zHeader, stream.begin() + nal.zEnd);
+        bool const bIsNew = paramSets.insert(paramSet).second;
+
+        // the other segments repeat the parameter sets at their first IDR
+        if(bIsJoin && bIsFirstAU && !bIsNew)
+          continue;
+      }
+
+      if(eKind == NAL_END_OF_BITSTREAM && !bIsLast)
+        continue;
+
+      if(eKind == NAL_SEI && bIsJoin && bIsFirstAU && !bIsAvc && nal.zEnd - nal.zHeader > (size_t)iNalHeaderSize)
+      {
+        // the cpb removal time of the IDR follows the one of the previous picture
+        auto const pPayload = &stream[nal.zHeader + iNalHeaderSize];
+        auto rbsp = RemoveEmulationPrevention(pPayload, nal.zEnd - nal.zHeader - iNalHeaderSize);
+
+        if(MarkConcatenation(rbsp))
+        {
+          auto const payload = AddEmulationPrevention(rbsp);
+          out.write((char const*)&stream[nal.zStart], nal.zHeader + iNalHeaderSize - nal.zStart);
+          out.write((char const*)payload.data(), payload.size());
+          continue;
+        }
+      }
+
+      out.write((char const*)&stream[nal.zStart], nal.zEnd - nal.zStart);
+    }
+  }
+
+  if(!out)
+    throw runtime_error("Can't write the stitched bitstream in " + sStreamFile);
+}
+
@@ -0,0 +1,67 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "lib_common_enc/Settings.h"
+
+/*
+ * Segmented encoding. The input is split in segments starting on GOP
+ * boundaries which are encoded concurrently on as many channels, with the
+ * same settings. Each channel starts its segment with an IDR picture, so the
+ * segments are closed and independent: the POC restarts at the IDR picture of
+ * each join. The bitstreams of the segments are then stitched in order,
+ * keeping only the first occurrence of each parameter set.
+ */
+
+struct TSegment
+{
+  int iFirstPict; // relative to the first picture of the sequence
+  int iNumPict;
+  std::string sStreamFile;
+};
+
+/* splits iNumPict pictures in at most iNumSegments segments of whole GOPs:
+ * the segments start on a multiple of the IDR period, or of the GOP length
+ * without periodic IDR */
+std::vector<TSegment> SplitSegments(int iNumPict, int iNumSegments, AL_TEncChanParam const& tChParam, std::string const& sStreamFile);
+
+/* concatenates the bitstreams of the segments in sStreamFile */
+void StitchSegments(std::vector<TSegment> const& segments, AL_TEncChanParam const& tChParam, std::string const& sStreamFile);
+
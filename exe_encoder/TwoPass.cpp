@@ -0,0 +1,121 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "TwoPass.h"
+#include "EncStats.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+// the bits of a frame are proportional to its complexity at this power (0: constant bitrate, 1: constant QP)
+static double const fComplexityCompression = 0.6;
+// the bitrate of a window stays within these ratios of the target bitrate
+static double const fMinBitRateRatio = 0.25;
+static double const fMaxBitRateRatio = 4.0;
+
+/****************************************************************************/
+void SetFirstPassSettings(AL_TEncSettings& settings)
+{
+  for(int i = 0; i < settings.NumLayer; ++i)
+    settings.tChParam[i].tRCParam.eRCMode = AL_RC_CONST_QP;
+}
+
+/****************************************************************************/
+TwoPassSchedule::TwoPassSchedule(string const& sFirstPassLog, AL_TEncChanParam const& tChParam)
+{
+  auto const& tRCParam = tChParam.tRCParam;
+
+  if(tRCParam.eRCMode == AL_RC_CONST_QP)
+    throw runtime_error("The second pass needs a rate control mode other than CONST_QP");
+
+  auto frames = EncStats::Read(sFirstPassLog);
+
+  if(frames.empty())
+    throw runtime_error("No frame in the first pass statistics: " + sFirstPassLog);
+
+  // the statistics are in encoding order, the bitrate changes follow the source frames
+  stable_sort(frames.begin(), frames.end(), [](EncStats::TFrame const& a, EncStats::TFrame const& b) { return a.uSource < b.uSource; });
+
+  double const fFrameRate = tRCParam.uFrameRate * 1000.0 / tRCParam.uClkRatio;
+
+  // a bitrate change per GOP, or per second without periodic GOP
+  m_iWindow = tChParam.tGopParam.uGopLength > 1 ? tChParam.tGopParam.uGopLength : max(1, (int)lround(fFrameRate));
+
+  vector<double> weights(frames.size());
+  double fSumWeights = 0;
+
+  for(size_t i = 0; i < frames.size(); ++i)
+  {
+    weights[i] = pow(max<double>(frames[i].uBytes, 1), fComplexityCompression);
+    fSumWeights += weights[i];
+  }
+
+  double const fTargetBits = (double)tRCParam.uTargetBitRate * frames.size() / fFrameRate;
+  double fMaxBitRate = fMaxBitRateRatio * tRCParam.uTargetBitRate;
+
+  if(tRCParam.eRCMode != AL_RC_CBR && tRCParam.uMaxBitRate)
+    fMaxBitRate = min<double>(fMaxBitRate, tRCParam.uMaxBitRate);
+
+  for(size_t iFirst = 0; iFirst < frames.size(); iFirst += m_iWindow)
+  {
+    size_t iEnd = min(frames.size(), iFirst + m_iWindow);
+    double fWeights = 0;
+
+    for(size_t i = iFirst; i < iEnd; ++i)
+      fWeights += weights[i];
+
+    double fBitRate = fTargetBits * fWeights / fSumWeights * fFrameRate / (iEnd - iFirst);
+    fBitRate = min(max(fBitRate, fMinBitRateRatio * tRCParam.uTargetBitRate), fMaxBitRate);
+    m_BitRates.push_back((int)fBitRate);
+  }
+}
+
+/****************************************************************************/
+void TwoPassSchedule::Apply(ICommandsSender* pSender, int iFrame)
+{
+  if(iFrame % m_iWindow)
+    return;
+
+  size_t iWindow = iFrame / m_iWindow;
+
+  // the frames after the ones of the first pass keep the last bitrate
+  if(iWindow < m_BitRates.size())
+    pSender->setBitRate(m_BitRates[iWindow]);
+}
+
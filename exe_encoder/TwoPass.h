@@ -0,0 +1,73 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include "ICommandsSender.h"
+#include <string>
+#include <vector>
+
+#include "lib_common_enc/Settings.h"
+
+/*
+ * Two pass encoding. The first pass encodes at a constant QP and records the
+ * size of each frame (see EncStats): at a constant QP, the size measures the
+ * complexity of the frame. The second pass shares the bits of the target
+ * bitrate over the whole sequence according to these complexities, so that
+ * the easy scenes get less bits than the hard ones, and schedules the
+ * corresponding bitrate changes once per window of source frames. The frame
+ * sizes are matched to the source frames, so the windows stay right when the
+ * GOP reorders the frames.
+ */
+
+/* settings of the first pass */
+void SetFirstPassSettings(AL_TEncSettings& settings);
+
+class TwoPassSchedule
+{
+public:
+  /* throws a runtime_error when the first pass statistics can't be used */
+  TwoPassSchedule(std::string const& sFirstPassLog, AL_TEncChanParam const& tChParam);
+
+  /* sets the bitrate of the window starting at frame iFrame */
+  void Apply(ICommandsSender* pSender, int iFrame);
+
+private:
+  int m_iWindow; // frames per bitrate change
+  std::vector<int> m_BitRates; // one per window
+};
+
@@ -42,6 +42,7 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <list>
 #include <sstream>
@@ -50,9 +51,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "lib_app/BufPool.h"
+#include "lib_app/MemoryBudget.h"
 #include "lib_app/console.h"
 #include "lib_app/utils.h"
 
@@ -75,15 +78,20 @@ extern "C"
 #include "lib_encode/lib_encoder.h"
 #include "lib_rtos/lib_rtos.h"
 #include "lib_common_enc/IpEncFourCC.h"
+#include "lib_perfs/PipelineStats.h"
+#include "lib_perfs/Tracer.h"
 }
 
 #include "lib_conv_yuv/lib_conv_yuv.h"
 #include "sink_encoder.h"
 #include "sink_bitstream_writer.h"
+#include "sink_shm_ring.h"
 #include "sink_frame_writer.h"
 #include "sink_md5.h"
+#include "MD5.h"
 #include "sink_repeater.h"
 #include "QPGenerator.h"
+#include "Segments.h"
 
 static int g_numFrameToRepeat;
 static int g_StrideHeight = -1;
@@ -194,6 +202,7 @@ void ParseCommandLine(int argc, char** argv, ConfigFile& cfg)
 
   opt.addString("--output,-o", &cfg.BitstreamFileName, "Compressed output file");
   opt.addString("--md5", &cfg.RunInfo.sMd5Path, "Path to the output MD5 textfile");
+  opt.addString("--md5-stream", &cfg.RunInfo.sStreamMd5Path, "Path to the output MD5 textfile of the bitstream");
   opt.addString("--output-rec,-r", &cfg.RecFileName, "Output reconstructed YUV file");
   opt.addOption("--color", [&]() {
     SetEnableColor(true);
@@ -249,6 +258,22 @@ void ParseCommandLine(int argc, char** argv, ConfigFile& cfg)
 
   opt.addInt("--prefetch", &g_numFrameToRepeat, "prefetch n frames and loop between these frames for max picture count");
   opt.addFlag("--print-picture-type", &cfg.RunInfo.printPictureType, "write picture type for each frame in the file", true);
+  opt.addString("--latency-stats", &cfg.RunInfo.sLatencyStats, "A file where the per stage latencies will be dumped at exit (.csv or .json)");
+  opt.addString("--trace", &cfg.RunInfo.sTraceFile, "A file where the threads activity will be dumped at exit (Chrome trace-event json)");
+  opt.addString("--record-driver", &cfg.RunInfo.sRecordDriver, "A file where the driver messages will be recorded, to be replayed by AL_DriverReplay.exe");
+  opt.addInt("--pass", &cfg.RunInfo.iPass, "Two pass encoding: 1 records the complexity of the frames in the pass-log, 2 spreads the bitrate over the frames accordingly");
+  opt.addString("--pass-log", &cfg.RunInfo.sPassLog, "Statistics file written by the first pass and read by the second one");
+  opt.addString("--stats", &cfg.RunInfo.sStatsFile, "A file where the statistics of each encoded frame will be written (.csv, or binary otherwise)");
+  opt.addString("--qp-table-file", &cfg.sQpTableFileName, "A file holding the compiled QP tables of the sequence, used instead of the QP and ROI text files");
+  opt.addInt("--egress-rate", &cfg.RunInfo.iEgressRate, "Adapt the bitrate to send the stream at this rate (kbps) within the latency budget");
+  opt.addInt("--latency-budget", &cfg.RunInfo.iLatencyBudget, "Maximum time (ms) the encoded frames wait to be sent, with --egress-rate");
+  opt.addString("--sim-egress-link", &cfg.RunInfo.sEgressLinkSim, "Simulate a link of varying capacity with --egress-rate: <kbps>[,<kbps>@<seconds>]...");
+  opt.addInt("--segments", &cfg.RunInfo.iNumSegments, "Split the input in this number of segments starting on GOP boundaries, encoded concurrently on as many channels and stitched back in the bitstream");
+  opt.addString("--stream-ring", &cfg.RunInfo.sStreamRing, "Publish the stream in this shared memory ring instead of the bitstream file (see AL_StreamConsumer.exe)");
+  opt.addInt("--stream-ring-size", &cfg.RunInfo.iStreamRingSize, "Size of the shared memory ring in MB, a power of 2");
+  opt.addInt("--memory-budget", &cfg.RunInfo.iMemoryBudget, "Print the memory plan of the channel and refuse to encode if the channels need more than this memory (MB)");
+  opt.addFlag("--fit-core-load", &cfg.RunInfo.bFitCoreLoad, "Lower the encoding frame rate when the cores can't take the load of the channel along with the channels already running (ignored with --segments)");
+  opt.addFlag("--compile-qp-tables", &cfg.RunInfo.bCompileQpTables, "Compile the QP tables of the max-picture first frames from the QP or ROI text files in the qp-table-file and exit");
 
 
   opt.parse(argc, argv);
@@ -296,6 +321,35 @@ void ValidateConfig(ConfigFile& cfg)
   if(cfg.YUVFileName.empty())
     throw runtime_error("No YUV input was given, specify it in the [INPUT] section of your configuration file or in your commandline (use -h to get help)");
 
+  if(cfg.RunInfo.iPass < 0 || cfg.RunInfo.iPass > 2)
+    throw runtime_error("Invalid pass, use 1 or 2 for two pass encoding");
+
+  if(cfg.RunInfo.iPass != 0 && cfg.RunInfo.sPassLog.empty())
+    throw runtime_error("Two pass encoding needs a statistics file, specify it with --pass-log");
+
+  if(cfg.RunInfo.iPass != 0 && cfg.RunInfo.sPassLog == cfg.RunInfo.sStatsFile)
+    throw runtime_error("The pass log and the statistics file must be different files");
+
+  if(cfg.RunInfo.iNumSegments < 1)
+    throw runtime_error("Invalid number of segments");
+
+  // the compiled tables replace the ones generated for the frames: adaptive tables depend on the source
+  if(!cfg.sQpTableFileName.empty() && (cfg.Settings.eQpCtrlMode & MASK_QP_TABLE) == ADAPTIVE_QP)
+    throw runtime_error("The QP table file can't be used with the adaptive QP mode");
+
+  if(cfg.RunInfo.iNumSegments > 1)
+  {
+    // these follow the frames of the whole sequence, or write a single output
+    if(!cfg.RecFileName.empty() || !cfg.RunInfo.sMd5Path.empty() || !cfg.RunInfo.sStreamMd5Path.empty() ||
+       !cfg.sCmdFileName.empty() || !cfg.sRoiFileName.empty() || !cfg.sQpTableFileName.empty() ||
+       !cfg.RunInfo.sStatsFile.empty() || cfg.RunInfo.iPass != 0 || cfg.RunInfo.iEgressRate > 0 ||
+       !cfg.RunInfo.sStreamRing.empty() || g_numFrameToRepeat > 0 || cfg.RunInfo.bLoop)
+      throw runtime_error("The segmented encoding doesn't support the reconstructed output, the md5, the command, ROI and QP table files, the statistics, the two pass and egress rate controls, the stream ring, the prefetch and the loop");
+
+    if(cfg.FileInfo.FrameRate != cfg.Settings.tChParam[0].tRCParam.uFrameRate)
+      throw runtime_error("The segmented encoding needs the input and encoding frame rates to match");
+  }
+
   SetConsoleColor(CC_RED);
 
   FILE* out = stdout;
@@ -398,12 +452,21 @@ shared_ptr<AL_TBuffer> ReadSourceFrame(BufPool* pBufPool, AL_TBuffer* conversion
   shared_ptr<AL_TBuffer> sourceBuffer(pBufPool->GetBuffer(), &AL_Buffer_Unref);
   assert(sourceBuffer);
 
+  AL_PipelineStats_Start((uintptr_t)sourceBuffer.get());
+
   if(!ReadOneFrameYuv(YuvFile, hConv ? conversionBuffer : sourceBuffer.get(), cfg.RunInfo.bLoop))
+  {
+    AL_PipelineStats_Stop((uintptr_t)sourceBuffer.get());
     return nullptr;
+  }
+
+  AL_PipelineStats_Checkpoint(AL_STAGE_ENC_READ, (uintptr_t)sourceBuffer.get());
 
   if(hConv)
     hConv->ConvertSrcBuf(AL_GET_BITDEPTH(tChParam.ePicFormat), conversionBuffer, sourceBuffer.get());
 
+  AL_PipelineStats_Checkpoint(AL_STAGE_ENC_CONVERT, (uintptr_t)sourceBuffer.get());
+
   return sourceBuffer;
 }
 
@@ -599,6 +662,220 @@ static void InitSrcBufPool(AL_TAllocator* pAllocator, bool shouldConvert, unique
     pSrcConv.reset(nullptr);
 }
 
+/*****************************************************************************/
+static uint32_t GetPoolBufSize(AL_TBufPoolConfig const& poolConfig)
+{
+  if(poolConfig.pMetaData)
+    poolConfig.pMetaData->MetaDestroy(poolConfig.pMetaData);
+  return poolConfig.zBufSize;
+}
+
+/*****************************************************************************/
+static void CheckEncoderMemoryBudget(ConfigFile& cfg)
+{
+  auto& Settings = cfg.Settings;
+  AL_TMemoryPlan tPlan;
+
+  if(!AL_Encoder_GetMemoryPlan(&Settings, &tPlan))
+    throw runtime_error("Can't plan the memory of the channel");
+
+  int frameBuffersCount = 2 + Settings.tChParam[0].tGopParam.uNumB;
+
+  if(g_numFrameToRepeat > 0)
+    frameBuffersCount = max(frameBuffersCount, g_numFrameToRepeat);
+
+  auto StreamBufPoolConfig = GetStreamBufPoolConfig(Settings, cfg.FileInfo);
+  AL_MemoryPlan_Add(&tPlan, "stream", AL_MEM_APPLICATION, GetPoolBufSize(StreamBufPoolConfig), StreamBufPoolConfig.uNumBuf);
+
+  auto QpBufPoolConfig = GetQpBufPoolConfig(Settings, Settings.tChParam[0], 2 + Settings.tChParam[0].tGopParam.uNumB);
+  AL_MemoryPlan_Add(&tPlan, "qp-ext", AL_MEM_APPLICATION, GetPoolBufSize(QpBufPoolConfig), QpBufPoolConfig.uNumBuf);
+
+  TFrameInfo FrameInfo = GetFrameInfo(cfg.FileInfo, Settings.tChParam[0]);
+  auto pSrcConv = CreateSrcConverter(FrameInfo, Settings.tChParam[0].eSrcMode, Settings.tChParam[0]);
+  auto SrcBufPoolConfig = GetSrcBufPoolConfig(pSrcConv, FrameInfo, Settings.tChParam[0].eSrcMode, frameBuffersCount);
+  AL_MemoryPlan_Add(&tPlan, "src", AL_MEM_APPLICATION, GetPoolBufSize(SrcBufPoolConfig), SrcBufPoolConfig.uNumBuf);
+
+  PrintMemoryPlan(tPlan);
+  CheckMemoryBudget(tPlan.uPeakSize * cfg.RunInfo.iNumSegments, cfg.RunInfo.iMemoryBudget);
+}
+
+/*****************************************************************************/
+static void FitCoreLoad(AL_TEncChanParam& tChParam, AL_TResourceLedger* pLedger)
+{
+  auto const uFrameRate = tChParam.tRCParam.uFrameRate;
+  int iNumCore;
+
+  while(tChParam.tRCParam.uFrameRate > 1 && AL_Settings_GetChannelResources(&tChParam, &iNumCore) > AL_ResourceLedger_GetAvailableResources(pLedger, iNumCore))
+    --tChParam.tRCParam.uFrameRate;
+
+  if(tChParam.tRCParam.uFrameRate != uFrameRate)
+    Message(CC_YELLOW, "The cores can't take the load of the channel: encoding at %d fps instead of %d\n", tChParam.tRCParam.uFrameRate, uFrameRate);
+}
+
+/*****************************************************************************/
+static void ShowCoreLoad(AL_TResourceLedger* pLedger)
+{
+  AL_TResourceUtilization tUtilization;
+  AL_ResourceLedger_GetUtilization(pLedger, &tUtilization);
+
+  Message(CC_DEFAULT, "Core load (%d channels):", tUtilization.iNumChannels);
+
+  for(int iCore = 0; iCore < tUtilization.iNumCores; ++iCore)
+    Message(CC_DEFAULT, " %d%%", tUtilization.iCoreLoad[iCore] * 100 / tUtilization.iCoreResources);
+
+  Message(CC_DEFAULT, "\n");
+}
+
+/*****************************************************************************/
+static void PushStreamBuffers(AL_HEncoder hEnc, BufPool& StreamBufPool, unsigned int uNumBuf, ConfigFile const& cfg)
+{
+  for(unsigned int i = 0; i < uNumBuf; ++i)
+  {
+    AL_TBuffer* pStream = StreamBufPool.GetBuffer(AL_BUF_MODE_NONBLOCK);
+    assert(pStream);
+
+    if(cfg.RunInfo.printPictureType || !cfg.RunInfo.sStatsFile.empty() || cfg.RunInfo.iPass == 1 || !cfg.RunInfo.sStreamRing.empty() || cfg.RunInfo.iEgressRate > 0)
+    {
+      AL_TMetaData* pMeta = (AL_TMetaData*)AL_PictureMetaData_Create();
+      assert(pMeta);
+      auto const attached = AL_Buffer_AddMetaData(pStream, pMeta);
+      assert(attached);
+    }
+    auto bRet = AL_Encoder_PutStreamBuffer(hEnc, pStream);
+    assert(bRet);
+    AL_Buffer_Unref(pStream);
+  }
+}
+
+/*****************************************************************************/
+static void EncodeSegment(ConfigFile cfg, TSegment const& segment, CIpDevice* pIpDevice, mutex& channelLock)
+{
+  auto& Settings = cfg.Settings;
+  cfg.RunInfo.iFirstPict += segment.iFirstPict;
+  cfg.RunInfo.iMaxPict = segment.iNumPict;
+
+  auto hFinished = Rtos_CreateEvent(false);
+  auto scopeEvent = scopeExit([&]() {
+    Rtos_DeleteEvent(hFinished);
+  });
+
+  auto pAllocator = pIpDevice->m_pAllocator.get();
+  auto pScheduler = pIpDevice->m_pScheduler;
+
+  AL_TBufPoolConfig StreamBufPoolConfig = GetStreamBufPoolConfig(Settings, cfg.FileInfo);
+  BufPool StreamBufPool(pAllocator, StreamBufPoolConfig);
+  BufPool SrcBufPool;
+
+  int frameBuffersCount = 2 + Settings.tChParam[0].tGopParam.uNumB;
+  auto QpBufPoolConfig = GetQpBufPoolConfig(Settings, Settings.tChParam[0], frameBuffersCount);
+  BufPool QpBufPool(pAllocator, QpBufPoolConfig);
+
+  unique_ptr<EncoderSink> enc;
+  {
+    lock_guard<mutex> lock(channelLock);
+    enc.reset(new EncoderSink(cfg, pScheduler, pAllocator, QpBufPool));
+  }
+  auto scopeEnc = scopeExit([&]() {
+    lock_guard<mutex> lock(channelLock);
+    enc.reset();
+  });
+
+  enc->BitstreamOutput = createBitstreamWriter(segment.sStreamFile, cfg);
+  enc->m_done = ([&]() {
+    Rtos_SetEvent(hFinished);
+  });
+
+  shared_ptr<AL_TBuffer> SrcYuv;
+  vector<uint8_t> YuvBuffer;
+  bool shouldConvert = ConvertSrcBuffer(Settings.tChParam[0], cfg.FileInfo, YuvBuffer, SrcYuv);
+
+  PushStreamBuffers(enc->hEnc, StreamBufPool, StreamBufPoolConfig.uNumBuf, cfg);
+
+  TFrameInfo FrameInfo = GetFrameInfo(cfg.FileInfo, Settings.tChParam[0]);
+  auto const eSrcMode = Settings.tChParam[0].eSrcMode;
+  auto pSrcConv = CreateSrcConverter(FrameInfo, eSrcMode, Settings.tChParam[0]);
+
+  InitSrcBufPool(pAllocator, shouldConvert, pSrcConv, FrameInfo, eSrcMode, frameBuffersCount, SrcBufPool);
+  ifstream YuvFile;
+  PrepareInput(YuvFile, cfg.YUVFileName, cfg.FileInfo, cfg);
+
+  int iPictCount = 0;
+  int iReadCount = 0;
+  bool bRet = true;
+
+  while(bRet)
+    bRet = sendInputFileTo(YuvFile, SrcBufPool, SrcYuv.get(), cfg, pSrcConv.get(), enc.get(), iPictCount, iReadCount);
+
+  Rtos_WaitEvent(hFinished, AL_WAIT_FOREVER);
+}
+
+/*****************************************************************************/
+static void EncodeSegments(ConfigFile const& cfg, CIpDevice* pIpDevice)
+{
+  auto const& RunInfo = cfg.RunInfo;
+  auto const& tChParam = cfg.Settings.tChParam[0];
+
+  ifstream YuvFile;
+  OpenInput(YuvFile, cfg.YUVFileName);
+  int iNumPict = max(0, GetNumPictures(cfg.FileInfo, YuvFile) - (int)RunInfo.iFirstPict);
+
+  if(RunInfo.iMaxPict >= 0)
+    iNumPict = min(iNumPict, RunInfo.iMaxPict);
+
+  auto const segments = SplitSegments(iNumPict, RunInfo.iNumSegments, tChParam, cfg.BitstreamFileName);
+  Message(CC_DEFAULT, "Encoding %d pictures in %d segments\n", iNumPict, (int)segments.size());
+
+  mutex channelLock;
+  vector<exception_ptr> errors(segments.size());
+  vector<thread> workers;
+
+  for(size_t i = 0; i < segments.size(); ++i)
+  {
+    workers.push_back(thread([&, i]() {
+      try
+      {
+        EncodeSegment(cfg, segments[i], pIpDevice, channelLock);
+      }
+      catch(...)
+      {
+        errors[i] = current_exception();
+      }
+    }));
+  }
+
+  for(auto& worker : workers)
+    worker.join();
+
+  for(auto& error : errors)
+  {
+    if(error)
+      rethrow_exception(error);
+  }
+
+  StitchSegments(segments, tChParam, cfg.BitstreamFileName);
+
+  for(auto const& segment : segments)
+    remove(segment.sStreamFile.c_str());
+}
+
+/*****************************************************************************/
+static void ExportRunStats(TCfgRunInfo const& RunInfo)
+{
+  if(!RunInfo.sLatencyStats.empty() && !AL_PipelineStats_Export(RunInfo.sLatencyStats.c_str()))
+    throw runtime_error("Can't write the latency statistics in " + RunInfo.sLatencyStats);
+
+  if(!RunInfo.sTraceFile.empty())
+  {
+    AL_Tracer_Stop();
+
+    if(!AL_Tracer_Export(RunInfo.sTraceFile.c_str()))
+      throw runtime_error("Can't write the trace in " + RunInfo.sTraceFile);
+  }
+
+  if(auto err = GetEncoderLastError())
+    throw codec_error(EncoderErrorToString(err), err);
+}
+
 /*****************************************************************************/
 void SafeMain(int argc, char** argv)
 {
@@ -618,6 +895,9 @@ void SafeMain(int argc, char** argv)
   AL_Settings_SetDefaultParam(&Settings);
   SetMoreDefaults(cfg);
 
+  if(RunInfo.iPass == 1)
+    SetFirstPassSettings(Settings);
+
   if(!RecFileName.empty() || !cfg.RunInfo.sMd5Path.empty())
     Settings.tChParam[0].eOptions = (AL_EChEncOption)(Settings.tChParam[0].eOptions | AL_OPT_FORCE_REC);
 
@@ -625,15 +905,40 @@ void SafeMain(int argc, char** argv)
 
   ValidateConfig(cfg);
 
+  if(RunInfo.bCompileQpTables)
+  {
+    if(cfg.sQpTableFileName.empty() || RunInfo.iMaxPict <= 0 || RunInfo.iMaxPict == INT_MAX)
+      throw runtime_error("Compiling the QP tables needs a qp-table-file and a max-picture count");
+
+    CompileQPTables(cfg.sQpTableFileName, Settings, cfg.sRoiFileName, RunInfo.iMaxPict);
+    return;
+  }
+
+  if(!RunInfo.sLatencyStats.empty())
+    AL_PipelineStats_Enable(true);
+
+  if(!RunInfo.sTraceFile.empty() && !AL_Tracer_Start(AL_TRACER_DEFAULT_EVENTS_PER_THREAD))
+    throw runtime_error("Can't start the tracer");
+
+
+  if(RunInfo.iMemoryBudget > 0)
+    CheckEncoderMemoryBudget(cfg);
 
   function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl = GetIpCtrlWrapper(RunInfo);
 
-  auto pIpDevice = CreateIpDevice(!RunInfo.bUseBoard, RunInfo.iSchedulerType, Settings, wrapIpCtrl, RunInfo.trackDma, RunInfo.eVQDescr);
+  auto pIpDevice = CreateIpDevice(!RunInfo.bUseBoard, RunInfo.iSchedulerType, Settings, wrapIpCtrl, RunInfo.trackDma, RunInfo.eVQDescr, RunInfo.sRecordDriver);
 
   if(!pIpDevice)
     throw runtime_error("Can't create IpDevice");
 
 
+  if(RunInfo.iNumSegments > 1)
+  {
+    EncodeSegments(cfg, pIpDevice.get());
+    ExportRunStats(RunInfo);
+    return;
+  }
+
   auto hFinished = Rtos_CreateEvent(false);
   auto scopeMutex = scopeExit([&]() {
     Rtos_DeleteEvent(hFinished);
@@ -654,12 +959,65 @@ void SafeMain(int argc, char** argv)
   BufPool QpBufPool(pAllocator, QpBufPoolConfig);
 
 
+  /* instantiation has to be before the Encoder instantiation: the md5 sinks wait for it */
+  unique_ptr<CMD5Engine> md5Engine;
+
+  if(!cfg.RunInfo.sMd5Path.empty() || !cfg.RunInfo.sStreamMd5Path.empty())
+    md5Engine.reset(new CMD5Engine);
+
+  if(RunInfo.bFitCoreLoad && pIpDevice->m_pLedger)
+    FitCoreLoad(Settings.tChParam[0], pIpDevice->m_pLedger);
+
   unique_ptr<EncoderSink> enc;
   enc.reset(new EncoderSink(cfg, pScheduler, pAllocator, QpBufPool
                             ));
 
+  if(pIpDevice->m_pLedger)
+    ShowCoreLoad(pIpDevice->m_pLedger);
+
+
+  if(!RunInfo.sStreamRing.empty())
+    enc->BitstreamOutput = createShmRingWriter(RunInfo.sStreamRing, (uint64_t)RunInfo.iStreamRingSize << 20);
+  else
+    enc->BitstreamOutput = createBitstreamWriter(StreamFileName, cfg);
+
+  if(!cfg.RunInfo.sStreamMd5Path.empty())
+  {
+    auto multisink = unique_ptr<MultiSink>(new MultiSink);
+    multisink->sinks.push_back(move(enc->BitstreamOutput));
+    multisink->sinks.push_back(createStreamMd5Calculator(cfg.RunInfo.sStreamMd5Path, md5Engine.get()));
+    enc->BitstreamOutput = move(multisink);
+  }
+
+  if(RunInfo.iPass == 2)
+    enc->twoPass.reset(new TwoPassSchedule(RunInfo.sPassLog, Settings.tChParam[0]));
+
+  if(!RunInfo.sStatsFile.empty() || RunInfo.iPass == 1)
+  {
+    auto const& tRCParam = Settings.tChParam[0].tRCParam;
+    double const fFrameRate = tRCParam.uFrameRate * 1000.0 / tRCParam.uClkRatio;
+
+    if(!RunInfo.sStatsFile.empty())
+      enc->stats.reset(new EncStats(RunInfo.sStatsFile, fFrameRate));
+
+    if(RunInfo.iPass == 1)
+      enc->passLog.reset(new EncStats(RunInfo.sPassLog, fFrameRate, true));
+  }
+
+  if(RunInfo.iEgressRate > 0)
+  {
+    auto const& tRCParam = Settings.tChParam[0].tRCParam;
+
+    if(tRCParam.eRCMode == AL_RC_CONST_QP)
+      throw runtime_error("The egress rate control needs a rate control mode other than CONST_QP");
+
+    auto const sSchedule = RunInfo.sEgressLinkSim.empty() ? to_string(RunInfo.iEgressRate) : RunInfo.sEgressLinkSim;
+    unique_ptr<EgressLink> link(new EgressLink(move(enc->BitstreamOutput), sSchedule, (double)tRCParam.uClkRatio / (tRCParam.uFrameRate * 1000.0)));
+    auto rateCtrl = new RateController(move(link), RunInfo.iEgressRate * 1000, RunInfo.iLatencyBudget, tRCParam.uFrameRate, tRCParam.uClkRatio);
+    enc->BitstreamOutput.reset(rateCtrl);
+    enc->rateCtrl = rateCtrl;
+  }
 
-  enc->BitstreamOutput = createBitstreamWriter(StreamFileName, cfg);
   enc->m_done = ([&]() {
     Rtos_SetEvent(hFinished);
   });
@@ -686,27 +1044,12 @@ void SafeMain(int argc, char** argv)
   {
     auto multisink = unique_ptr<MultiSink>(new MultiSink);
     multisink->sinks.push_back(move(enc->RecOutput));
-    multisink->sinks.push_back(createMd5Calculator(cfg.RunInfo.sMd5Path, cfg, RecYuv.get()));
+    multisink->sinks.push_back(createMd5Calculator(cfg.RunInfo.sMd5Path, cfg, RecYuv.get(), md5Engine.get()));
     enc->RecOutput = move(multisink);
   }
 
 
-  for(unsigned int i = 0; i < StreamBufPoolConfig.uNumBuf; ++i)
-  {
-    AL_TBuffer* pStream = StreamBufPool.GetBuffer(AL_BUF_MODE_NONBLOCK);
-    assert(pStream);
-
-    if(cfg.RunInfo.printPictureType)
-    {
-      AL_TMetaData* pMeta = (AL_TMetaData*)AL_PictureMetaData_Create();
-      assert(pMeta);
-      auto const attached = AL_Buffer_AddMetaData(pStream, pMeta);
-      assert(attached);
-    }
-    auto bRet = AL_Encoder_PutStreamBuffer(enc->hEnc, pStream);
-    assert(bRet);
-    AL_Buffer_Unref(pStream);
-  }
+  PushStreamBuffers(enc->hEnc, StreamBufPool, StreamBufPoolConfig.uNumBuf, cfg);
 
 
   unique_ptr<RepeaterSink> prefetch;
@@ -742,8 +1085,7 @@ void SafeMain(int argc, char** argv)
 
   Rtos_WaitEvent(hFinished, AL_WAIT_FOREVER);
 
-  if(auto err = GetEncoderLastError())
-    throw codec_error(EncoderErrorToString(err), err);
+  ExportRunStats(RunInfo);
 }
 
 /******************************************************************************/
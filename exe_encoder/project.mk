@@ -7,12 +7,19 @@ EXE_ENCODER_SRCS:=\
   $(THIS_EXE_ENCODER)/container.cpp\
   $(THIS_EXE_ENCODER)/main.cpp\
   $(THIS_EXE_ENCODER)/sink_bitstream_writer.cpp\
+  $(THIS_EXE_ENCODER)/sink_shm_ring.cpp\
   $(THIS_EXE_ENCODER)/sink_frame_writer.cpp\
   $(THIS_EXE_ENCODER)/sink_md5.cpp\
   $(THIS_EXE_ENCODER)/MD5.cpp\
   $(THIS_EXE_ENCODER)/ROIMngr.cpp\
   $(THIS_EXE_ENCODER)/EncCmdMngr.cpp\
   $(THIS_EXE_ENCODER)/QPGenerator.cpp\
+  $(THIS_EXE_ENCODER)/AdaptiveQP.cpp\
+  $(THIS_EXE_ENCODER)/QPTableStore.cpp\
+  $(THIS_EXE_ENCODER)/RateController.cpp\
+  $(THIS_EXE_ENCODER)/EncStats.cpp\
+  $(THIS_EXE_ENCODER)/TwoPass.cpp\
+  $(THIS_EXE_ENCODER)/Segments.cpp\
   $(THIS_EXE_ENCODER)/CommandsSender.cpp\
   $(THIS_EXE_ENCODER)/CfgParser.cpp\
   $(LIB_CONV_SRC)\
@@ -38,9 +38,14 @@
 #pragma once
 
 #include "lib_app/timing.h"
+#include "lib_perfs/Tracer.h"
 #include "QPGenerator.h"
+#include "QPTableStore.h"
 #include "EncCmdMngr.h"
 #include "CommandsSender.h"
+#include "RateController.h"
+#include "EncStats.h"
+#include "TwoPass.h"
 
 #include "FileUtils.h"
 
@@ -60,6 +65,10 @@ public:
     bufpool(bufpool), isExternQpTable(settings.eQpCtrlMode & (MASK_QP_TABLE_EXT)), settings(settings)
   {
     pRoiCtx = AL_RoiMngr_Create(tChParam.uWidth, tChParam.uHeight, tChParam.eProfile, AL_ROI_QUALITY_LOW, AL_ROI_QUALITY_ORDER);
+
+    if((settings.eQpCtrlMode & MASK_QP_TABLE) == ADAPTIVE_QP)
+      pAdaptiveQP.reset(new AdaptiveQP(1 << tChParam.uMaxCuSize));
+
     initQpBuffers(bufpool);
   }
 
@@ -69,9 +78,9 @@ public:
   }
 
 
-  AL_TBuffer* getBuffer(int frameNum)
+  AL_TBuffer* getBuffer(int frameNum, AL_TBuffer* pSrc)
   {
-    return getBuffer(frameNum, &bufpool, settings.tChParam[0]);
+    return getBuffer(frameNum, pSrc, &bufpool, settings.tChParam[0]);
   }
 
   void releaseBuffer(AL_TBuffer* buffer)
@@ -86,6 +95,12 @@ public:
     sRoiFileName = roiFileName;
   }
 
+  void setQpTableFileName(string const& qpTableFileName)
+  {
+    if(isExternQpTable && !qpTableFileName.empty())
+      pTableStore.reset(new QPTableStore(qpTableFileName, settings.tChParam[0]));
+  }
+
 
 private:
   void initQpBuffers(BufPool& BufPool)
@@ -103,13 +118,25 @@ private:
       AL_Buffer_Unref(qpBuf);
   }
 
-  AL_TBuffer* getBuffer(int frameNum, BufPool* pBufPool, const AL_TEncChanParam& tChParam)
+  AL_TBuffer* getBuffer(int frameNum, AL_TBuffer* pSrc, BufPool* pBufPool, const AL_TEncChanParam& tChParam)
   {
     if(!isExternQpTable)
       return nullptr;
 
     AL_TBuffer* pQpBuf = pBufPool->GetBuffer();
-    bool bRet = PreprocessQP(AL_Buffer_GetData(pQpBuf), settings, tChParam, frameNum);
+
+    if(pTableStore)
+    {
+      if(pTableStore->GetTable(frameNum, AL_Buffer_GetData(pQpBuf) + EP2_BUF_QP_BY_MB.Offset))
+        return pQpBuf;
+
+      releaseBuffer(pQpBuf);
+      return nullptr;
+    }
+
+    bool bRet = pAdaptiveQP ? GenerateAdaptiveQPBuffer(pAdaptiveQP.get(), pSrc, tChParam.tRCParam.iInitialQP, tChParam.tRCParam.iMinQP, tChParam.tRCParam.iMaxQP,
+                                                       AL_GetWidthInLCU(tChParam), AL_GetHeightInLCU(tChParam), tChParam.eProfile, AL_Buffer_GetData(pQpBuf) + EP2_BUF_QP_BY_MB.Offset) :
+                PreprocessQP(AL_Buffer_GetData(pQpBuf), settings, tChParam, frameNum);
 
     if(!bRet)
       bRet = GenerateROIBuffer(pRoiCtx, sRoiFileName, AL_GetWidthInLCU(tChParam), AL_GetHeightInLCU(tChParam),
@@ -131,6 +158,8 @@ private:
 
   string sRoiFileName;
   AL_TRoiMngrCtx* pRoiCtx;
+  std::unique_ptr<AdaptiveQP> pAdaptiveQP;
+  std::unique_ptr<QPTableStore> pTableStore;
 };
 
 
@@ -191,6 +220,7 @@ struct EncoderSink : IFrameSink
     qpBuffers(qpBufPool, cfg.Settings, cfg.Settings.tChParam[0])
   {
     qpBuffers.setRoiFileName(cfg.sRoiFileName);
+    qpBuffers.setQpTableFileName(cfg.sQpTableFileName);
 
     AL_CB_EndEncoding onEndEncoding = { &EncoderSink::EndEncoding, this };
 
@@ -219,6 +249,12 @@ struct EncoderSink : IFrameSink
 
   void ProcessFrame(AL_TBuffer* Src) override
   {
+    if(Src && rateCtrl && !rateCtrl->Apply(commandsSender.get(), m_picCount + m_dropCount))
+    {
+      ++m_dropCount;
+      return;
+    }
+
     if(m_picCount == 0)
       m_StartTime = GetPerfTime();
 
@@ -231,17 +267,29 @@ struct EncoderSink : IFrameSink
 
     if(Src)
     {
+      if(twoPass)
+        twoPass->Apply(commandsSender.get(), m_picCount);
+
       EncCmd.Process(commandsSender.get(), m_picCount);
 
 
-      QpBuf = qpBuffers.getBuffer(m_picCount);
+      QpBuf = qpBuffers.getBuffer(m_picCount, Src);
     }
 
     shared_ptr<AL_TBuffer> QpBufShared(QpBuf, [&](AL_TBuffer* pBuf) { qpBuffers.releaseBuffer(pBuf); });
 
+    if(Src && stats)
+      stats->SourceSent(Src);
+
+    if(Src && passLog)
+      passLog->SourceSent(Src);
+
     if(!AL_Encoder_Process(hEnc, Src, QpBuf))
       throw runtime_error("Failed");
 
+    if(Src)
+      AL_PipelineStats_Checkpoint(AL_STAGE_ENC_PROCESS, (uintptr_t)Src);
+
     if(Src)
       m_picCount++;
   }
@@ -249,10 +297,16 @@ struct EncoderSink : IFrameSink
 
   unique_ptr<IFrameSink> RecOutput;
   unique_ptr<IFrameSink> BitstreamOutput;
+  RateController* rateCtrl = nullptr; // in the BitstreamOutput chain
+  unique_ptr<EncStats> stats;
+  int m_iLastGopShown = -1; // first frame of the last GOP summary printed
+  unique_ptr<EncStats> passLog; // first pass statistics, read by the second pass
+  unique_ptr<TwoPassSchedule> twoPass;
   AL_HEncoder hEnc;
 
 private:
   int m_picCount = 0;
+  int m_dropCount = 0;
   int m_pictureType = -1;
   uint64_t m_StartTime = 0;
   uint64_t m_EndTime = 0;
@@ -275,10 +329,39 @@ private:
   {
     auto pThis = (EncoderSink*)userParam;
 
+    /* a source given back without its stream (e.g. a skipped frame) won't reach the last stage */
+    if(isSourceReleased(pStream, pSrc))
+      AL_PipelineStats_Stop((uintptr_t)pSrc);
+
     if(isStreamReleased(pStream, pSrc) || isSourceReleased(pStream, pSrc))
       return;
 
+    AL_PipelineStats_Checkpoint(AL_STAGE_ENC_END_ENCODING, (uintptr_t)pSrc);
+
+    if(pStream && pThis->stats)
+    {
+      pThis->stats->StreamReceived(pStream, pSrc);
+      pThis->ShowLastGop();
+    }
+
+    if(pStream && pThis->passLog)
+      pThis->passLog->StreamReceived(pStream, pSrc);
+
     pThis->processOutput(pStream);
+    AL_PipelineStats_Checkpoint(AL_STAGE_ENC_STREAM_WRITTEN, (uintptr_t)pSrc);
+  }
+
+  /* one line per GOP, as soon as the next I frame closes it */
+  void ShowLastGop()
+  {
+    EncStats::TGop tGop;
+
+    if(!stats->GetLastGop(tGop) || tGop.iFirstFrame == m_iLastGopShown)
+      return;
+
+    m_iLastGopShown = tGop.iFirstFrame;
+    Message(CC_GREY, "  GOP at frame %d: %d frames, %llu bytes, QP %.2f [%d, %d], %.1f kbits/s\n",
+            tGop.iFirstFrame, tGop.iNumFrames, (unsigned long long)tGop.uBytes, tGop.fAvgQP, tGop.iMinQP, tGop.iMaxQP, tGop.fBitRate / 1000.0);
   }
 
   AL_ERR PreprocessOutput(AL_TBuffer* pStream)
@@ -292,7 +375,9 @@ private:
       m_pictureType = pMeta->eType;
       Message(CC_DEFAULT, "Picture Type %i\n", m_pictureType);
     }
+    AL_Trace_Begin("app.write_stream", 0);
     BitstreamOutput->ProcessFrame(pStream);
+    AL_Trace_End("app.write_stream");
     return AL_SUCCESS;
   }
 
@@ -314,7 +399,9 @@ private:
     while(AL_Encoder_GetRecPicture(hEnc, &RecPic))
     {
       auto buf = WrapBufferYuv(&RecPic.tBuf);
+      AL_Trace_Begin("app.write_rec", 0);
       RecOutput->ProcessFrame(buf);
+      AL_Trace_End("app.write_rec");
       AL_Buffer_Destroy(buf);
 
       AL_Encoder_ReleaseRecPicture(hEnc, &RecPic);
@@ -322,6 +409,15 @@ private:
 
     if(!pStream)
     {
+      if(stats)
+      {
+        stats->Finish();
+        ShowLastGop();
+      }
+
+      if(passLog)
+        passLog->Finish();
+
       RecOutput->ProcessFrame(EndOfStream);
       m_EndTime = GetPerfTime();
       m_done();
@@ -44,6 +44,7 @@
 extern "C"
 {
 #include "lib_common/BufferSrcMeta.h"
+#include "lib_common/BufferStreamMeta.h"
 }
 
 void RecToYuv(AL_TBuffer const* pRec, AL_TBuffer* pYuv, TFourCC tFourCC);
@@ -51,7 +52,8 @@ void RecToYuv(AL_TBuffer const* pRec, AL_TBuffer* pYuv, TFourCC tFourCC);
 class Md5Calculator : public IFrameSink
 {
 public:
-  Md5Calculator(string path, ConfigFile& cfg_, AL_TBuffer* Yuv_) :
+  Md5Calculator(string path, ConfigFile& cfg_, AL_TBuffer* Yuv_, CMD5Engine* pEngine) :
+    m_MD5(pEngine),
     Yuv(Yuv_),
     fourcc(cfg_.RecFourCC)
   {
@@ -86,8 +88,54 @@ private:
   TFourCC const fourcc;
 };
 
-unique_ptr<IFrameSink> createMd5Calculator(string path, ConfigFile& cfg_, AL_TBuffer* Yuv_)
+unique_ptr<IFrameSink> createMd5Calculator(string path, ConfigFile& cfg_, AL_TBuffer* Yuv_, CMD5Engine* pEngine)
 {
-  return unique_ptr<IFrameSink>(new Md5Calculator(path, cfg_, Yuv_));
+  return unique_ptr<IFrameSink>(new Md5Calculator(path, cfg_, Yuv_, pEngine));
+}
+
+class StreamMd5Calculator : public IFrameSink
+{
+public:
+  StreamMd5Calculator(string path, CMD5Engine* pEngine) :
+    m_MD5(pEngine)
+  {
+    OpenOutput(m_Md5File, path);
+  }
+
+  void ProcessFrame(AL_TBuffer* pStream)
+  {
+    if(pStream == EndOfStream)
+    {
+      m_Md5File << m_MD5.GetMD5();
+      return;
+    }
+
+    auto pStreamMeta = (AL_TStreamMetaData*)AL_Buffer_GetMetaData(pStream, AL_META_TYPE_STREAM);
+    uint8_t* pData = AL_Buffer_GetData(pStream);
+
+    // same bytes as WriteOneSection
+    for(int iSection = 0; iSection < pStreamMeta->uNumSection; ++iSection)
+    {
+      AL_TStreamSection* pSection = &pStreamMeta->pSections[iSection];
+      uint32_t uRemSize = pStream->zSize - pSection->uOffset;
+
+      if(uRemSize < pSection->uLength)
+      {
+        m_MD5.Update(pData + pSection->uOffset, uRemSize);
+        m_MD5.Update(pData, pSection->uLength - uRemSize);
+      }
+      else
+        m_MD5.Update(pData + pSection->uOffset, pSection->uLength);
+    }
+  }
+
+private:
+  ofstream m_Md5File;
+  CMD5 m_MD5;
+};
+
+unique_ptr<IFrameSink> createStreamMd5Calculator(string path, CMD5Engine* pEngine)
+{
+  return unique_ptr<IFrameSink>(new StreamMd5Calculator(path, pEngine));
 }
 
@@ -40,5 +40,10 @@
 #include "sink.h"
 #include "CfgParser.h"
 
-std::unique_ptr<IFrameSink> createMd5Calculator(std::string path, ConfigFile& cfg_, AL_TBuffer* Yuv_);
+class CMD5Engine;
+
+/* the MD5 are computed on the thread of pEngine, the frames are hashed in the order they are received */
+std::unique_ptr<IFrameSink> createMd5Calculator(std::string path, ConfigFile& cfg_, AL_TBuffer* Yuv_, CMD5Engine* pEngine);
+/* MD5 of the bytes written in the bitstream file (without container header) */
+std::unique_ptr<IFrameSink> createStreamMd5Calculator(std::string path, CMD5Engine* pEngine);
 
@@ -0,0 +1,117 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+#include "sink_shm_ring.h"
+#include "lib_app/ShmRing.h"
+#include "lib_app/utils.h"
+#include <cstring>
+
+extern "C"
+{
+#include "lib_common/BufferStreamMeta.h"
+#include "lib_common/BufferPictureMeta.h"
+}
+
+using namespace std;
+
+struct ShmRingWriter : IFrameSink
+{
+  ShmRingWriter(string const& sName, uint64_t uRingSize) : m_ring(ShmRing::Create(sName, uRingSize))
+  {
+    Message(CC_DEFAULT, "Publishing the stream in the shared memory ring %s\n", sName.c_str());
+  }
+
+  void ProcessFrame(AL_TBuffer* pStream)
+  {
+    if(pStream == EndOfStream)
+    {
+      m_ring->Close();
+      m_ring->WaitDrained();
+      return;
+    }
+
+    auto pStreamMeta = (AL_TStreamMetaData*)AL_Buffer_GetMetaData(pStream, AL_META_TYPE_STREAM);
+    auto pPictureMeta = (AL_TPictureMetaData*)AL_Buffer_GetMetaData(pStream, AL_META_TYPE_PICTURE);
+
+    uint32_t uDataSize = 0;
+
+    for(int i = 0; i < pStreamMeta->uNumSection; ++i)
+      uDataSize += pStreamMeta->pSections[i].uLength;
+
+    uint32_t const uTableSize = sizeof(TShmStreamEntry) + pStreamMeta->uNumSection * sizeof(TShmStreamSection);
+    uint8_t* pEntryData = m_ring->Reserve(uTableSize + uDataSize);
+
+    auto pEntry = (TShmStreamEntry*)pEntryData;
+    pEntry->uNumSections = pStreamMeta->uNumSection;
+    pEntry->uDataSize = uDataSize;
+    pEntry->iSliceType = pPictureMeta ? pPictureMeta->eType : -1;
+    pEntry->iQP = pPictureMeta ? pPictureMeta->iQP : -1;
+
+    auto pSections = (TShmStreamSection*)(pEntry + 1);
+    uint8_t* pDst = pEntryData + uTableSize;
+    uint8_t const* pData = AL_Buffer_GetData(pStream);
+    uint32_t uOffset = 0;
+
+    for(int i = 0; i < pStreamMeta->uNumSection; ++i)
+    {
+      auto const& section = pStreamMeta->pSections[i];
+      pSections[i].uOffset = uOffset;
+      pSections[i].uLength = section.uLength;
+      pSections[i].uFlags = section.uFlags;
+
+      if(section.uLength)
+      {
+        // the section can wrap at the end of the stream buffer
+        uint32_t const uRemSize = pStream->zSize - section.uOffset;
+        uint32_t const uFirstPart = min(uRemSize, section.uLength);
+        memcpy(pDst + uOffset, pData + section.uOffset, uFirstPart);
+        memcpy(pDst + uOffset + uFirstPart, pData, section.uLength - uFirstPart);
+      }
+
+      uOffset += section.uLength;
+    }
+
+    m_ring->Publish();
+  }
+
+  unique_ptr<ShmRing> m_ring;
+};
+
+unique_ptr<IFrameSink> createShmRingWriter(string const& sName, uint64_t uRingSize)
+{
+  return unique_ptr<IFrameSink>(new ShmRingWriter(sName, uRingSize));
+}
+
@@ -0,0 +1,196 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include "lib_app/CommandLineParser.h"
+#include "lib_app/ShmRing.h"
+
+extern "C"
+{
+#include "lib_common/StreamSection.h"
+}
+
+using namespace std;
+
+/* Example of a consumer of the stream the encoder publishes with
+ * --stream-ring: it reads the entries in the order of the stream, writes
+ * their data in a file and acknowledges them so that the encoder can reuse
+ * their space in the ring. */
+
+struct Config
+{
+  bool help = false;
+  string sRing;
+  string sOut;
+  int iTimeoutMs = 10000;
+};
+
+/******************************************************************************/
+static void Usage(CommandLineParser const& opt, char* ExeName)
+{
+  cerr << "Usage: " << ExeName << " -r <ring> [options]" << endl;
+  cerr << "Reads the stream published by AL_Encoder.exe --stream-ring <ring>" << endl;
+  cerr << "Options:" << endl;
+
+  for(auto& name : opt.displayOrder)
+  {
+    auto& o = opt.options.at(name);
+    cerr << "  " << o.desc << endl;
+  }
+
+  cerr << endl;
+}
+
+static Config ParseCommandLine(int argc, char* argv[])
+{
+  Config cfg;
+
+  auto opt = CommandLineParser();
+
+  opt.addFlag("--help,-h", &cfg.help, "Shows this help");
+  opt.addString("--ring,-r", &cfg.sRing, "Name of the shared memory ring");
+  opt.addString("--output,-o", &cfg.sOut, "File where the stream is written");
+  opt.addInt("--timeout", &cfg.iTimeoutMs, "Time to wait for the encoder to create the ring, in ms");
+
+  opt.parse(argc, argv);
+
+  if(cfg.help)
+  {
+    Usage(opt, argv[0]);
+    return cfg;
+  }
+
+  if(cfg.sRing.empty())
+    throw runtime_error("No ring specified (use -h to get help)");
+
+  return cfg;
+}
+
+/******************************************************************************/
+static unique_ptr<ShmRing> WaitRing(string const& sRing, int iTimeoutMs)
+{
+  auto const deadline = chrono::steady_clock::now() + chrono::milliseconds(iTimeoutMs);
+
+  while(true)
+  {
+    if(auto ring = ShmRing::Open(sRing))
+      return ring;
+
+    if(chrono::steady_clock::now() > deadline)
+      throw runtime_error("Can't open the shared memory ring " + sRing);
+
+    this_thread::sleep_for(chrono::milliseconds(10));
+  }
+}
+
+/******************************************************************************/
+static void SafeMain(int argc, char** argv)
+{
+  auto cfg = ParseCommandLine(argc, argv);
+
+  if(cfg.help)
+    return;
+
+  auto ring = WaitRing(cfg.sRing, cfg.iTimeoutMs);
+
+  ofstream out;
+
+  if(!cfg.sOut.empty())
+  {
+    out.open(cfg.sOut, ios::binary);
+
+    if(!out)
+      throw runtime_error("Can't open " + cfg.sOut);
+  }
+
+  int iNumEntries = 0;
+  int iNumFrames = 0;
+  uint64_t uNumBytes = 0;
+
+  while(!ring->IsFinished())
+  {
+    uint32_t uSize;
+    auto pEntryData = ring->Peek(uSize);
+
+    if(!pEntryData)
+    {
+      this_thread::sleep_for(chrono::microseconds(200));
+      continue;
+    }
+
+    auto pEntry = (TShmStreamEntry const*)pEntryData;
+    auto pSections = (TShmStreamSection const*)(pEntry + 1);
+    auto pData = (char const*)(pSections + pEntry->uNumSections);
+
+    for(uint32_t i = 0; i < pEntry->uNumSections; ++i)
+    {
+      if(pSections[i].uFlags & SECTION_END_FRAME_FLAG)
+        ++iNumFrames;
+    }
+
+    if(out.is_open())
+      out.write(pData, pEntry->uDataSize);
+
+    uNumBytes += pEntry->uDataSize;
+    ++iNumEntries;
+
+    ring->Acknowledge();
+  }
+
+  cout << "Received " << iNumEntries << " entries, " << iNumFrames << " frame(s), " << uNumBytes << " bytes" << endl;
+}
+
+/******************************************************************************/
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    SafeMain(argc, argv);
+    return 0;
+  }
+  catch(runtime_error const& error)
+  {
+    cerr << endl << "Exception caught: " << error.what() << endl;
+    return 1;
+  }
+}
+
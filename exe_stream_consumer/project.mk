@@ -0,0 +1,13 @@
+EXE_STREAM_CONSUMER_SRC:=\
+  exe_stream_consumer/main.cpp\
+  lib_app/ShmRing.cpp\
+
+EXE_STREAM_CONSUMER_OBJ:=$(EXE_STREAM_CONSUMER_SRC:%=$(BIN)/%.o)
+
+ifeq ($(findstring linux,$(TARGET)),linux)
+
+$(BIN)/AL_StreamConsumer.exe: $(EXE_STREAM_CONSUMER_OBJ)
+
+TARGETS+=$(BIN)/AL_StreamConsumer.exe
+
+endif
@@ -49,6 +49,7 @@
 #define AL_MCU_WAIT_FOR_START_CODE _IOWR('q', 9, struct al5_scstatus)
 #define GET_DMA_FD        _IOWR('q', 13, struct al5_dma_info)
 #define AL_MCU_DECODE_ONE_SLICE _IOWR('q', 18, struct al5_decode_msg)
+#define AL_MCU_DECODE_SLICE_BATCH _IOWR('q', 19, struct al5_decode_batch_msg)
 
 struct al5_dma_info
 {
@@ -90,6 +91,17 @@ struct al5_decode_msg
 	__u32 slice_param_v;
 };
 
+/* num_slices consecutive slice params starting at slice_param_v.
+ * Drivers without it fail with ENOTTY and the slices are sent one by one
+ * with AL_MCU_DECODE_ONE_SLICE */
+struct al5_decode_batch_msg
+{
+	struct al5_params params;
+	struct al5_params addresses;
+	__u32 slice_param_v;
+	__u32 num_slices;
+};
+
 struct al5_search_sc_msg
 {
 	struct al5_params param;
@@ -53,11 +53,18 @@ typedef struct AL_t_PictureMetaData
 {
   AL_TMetaData tMeta;
   AL_ESliceType eType; /*< slice type chosen to encode the picture */
+  int16_t iQP; /*< slice QP of the picture */
+  bool bSkipped; /*< the picture was skipped (no residual sent) */
+  bool bIsIDR; /*< the picture is an IDR picture */
+  bool bIsRef; /*< the picture is used as a reference */
+  uint32_t uInitialRemovalDelay; /*< CPB removal delay (90kHz), reflects the level of the coded picture buffer */
+  uint32_t uSumCplx; /*< complexity of the picture measured by the encoder */
 }AL_TPictureMetaData;
 
 /*************************************************************************//*!
    \brief Create a picture metadata.
-   The slice type is initialized to an invalid value (SLICE_MAX_ENUM) by default.
+   The slice type is initialized to an invalid value (SLICE_MAX_ENUM) by default,
+   the other fields to 0.
 *****************************************************************************/
 AL_TPictureMetaData* AL_PictureMetaData_Create();
 AL_TPictureMetaData* AL_PictureMetaData_Clone(AL_TPictureMetaData* pMeta);
@@ -57,6 +57,8 @@ typedef struct AL_t_SrcMetaData
   AL_TPitches tPitches; /*!< Luma & chroma pitches size */
   AL_TOffsetYC tOffsetYC; /*!< Luma & chroma offset addresses */
   TFourCC tFourCC; /*!< FOURCC identifier */
+  AL_TDimension tVisibleDim; /*!< Dimension in pixel of the displayed part of the frame (tDim when it is not cropped) */
+  AL_TOffsetYC tVisibleOffsetYC; /*!< Offset in bytes of the first displayed luma & chroma samples, from the beginning of their plane */
 }AL_TSrcMetaData;
 
 /*************************************************************************//*!
@@ -86,5 +88,17 @@ int AL_SrcMetaData_GetLumaSize(AL_TSrcMetaData* pMeta);
 *****************************************************************************/
 int AL_SrcMetaData_GetChromaSize(AL_TSrcMetaData* pMeta);
 
+/*************************************************************************//*!
+   \brief Restricts the displayed part of the picture to a cropping window.
+   The frame is left untouched: its readers skip the cropped samples using
+   tVisibleOffsetYC and tVisibleDim.
+   \param[in] pMeta A pointer the the source metadata of a raster (non tiled, non packed) picture
+   \param[in] iLeft Number of luma columns cropped on the left of the picture
+   \param[in] iRight Number of luma columns cropped on the right of the picture
+   \param[in] iTop Number of luma lines cropped on the top of the picture
+   \param[in] iBottom Number of luma lines cropped on the bottom of the picture
+*****************************************************************************/
+void AL_SrcMetaData_SetCrop(AL_TSrcMetaData* pMeta, int iLeft, int iRight, int iTop, int iBottom);
+
 /*@*/
 
@@ -57,7 +57,9 @@ enum
   /*! The decoder had to conceal some errors in the stream */
   AL_WARN_CONCEAL_DETECT = AL_DEF_WARNING(1),
   /*! Some LCU exceed the maximum allowed bits in the stream */
-  AL_WARN_LCU_OVERFLOW = AL_DEF_WARNING(2)
+  AL_WARN_LCU_OVERFLOW = AL_DEF_WARNING(2),
+  /*! The decoder input queue stayed full: the buffer wasn't pushed */
+  AL_WARN_INPUT_FULL = AL_DEF_WARNING(3)
 };
 
 enum
@@ -72,7 +74,8 @@ enum
    * This can be dma memory, mcu specific memory if available or
    * simply virtual memory shortage */
   AL_ERR_NO_MEMORY = AL_DEF_ERROR(7),
-  /*! The generated stream couldn't fit inside the allocated stream buffer */
+  /*! The generated stream couldn't fit inside the allocated stream buffer
+   * (decoder: an access unit is bigger than the circular stream buffer) */
   AL_ERR_STREAM_OVERFLOW = AL_DEF_ERROR(8),
   /*! If SliceSize mode is supported, the constraint couldn't be respected
    * as too many slices were required to respect it */
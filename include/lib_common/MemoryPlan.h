@@ -0,0 +1,103 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+/**************************************************************************//*!
+   \addtogroup Buffers
+   @{
+   \file
+ **************************************************************************/
+#pragma once
+
+#include "lib_rtos/types.h"
+
+#define AL_MEMORY_PLAN_MAX_ITEMS 32
+/* the dma allocators reserve whole pages */
+#define AL_MEMORY_PLAN_PAGE_SIZE 4096
+
+/*************************************************************************//*!
+   \brief Who allocates a planned buffer
+*****************************************************************************/
+typedef enum
+{
+  AL_MEM_LIBRARY, /*!< allocated by the library with the allocator of the channel */
+  AL_MEM_FIRMWARE, /*!< allocated by the firmware in the device memory (estimation) */
+  AL_MEM_APPLICATION, /*!< provided by the application */
+}AL_EMemoryOwner;
+
+/*************************************************************************//*!
+   \brief Buffers of the same kind needed by a channel
+*****************************************************************************/
+typedef struct
+{
+  char const* pName;
+  AL_EMemoryOwner eOwner;
+  uint32_t uSize; /*!< size of one buffer */
+  int iCount; /*!< number of buffers */
+}AL_TMemoryPlanItem;
+
+/*************************************************************************//*!
+   \brief Itemized memory footprint of a channel
+   None of the buffers of a channel is released before the channel is
+   destroyed: the peak is reached once they are all allocated. It is above
+   the total by the page rounding of the allocators.
+*****************************************************************************/
+typedef struct
+{
+  AL_TMemoryPlanItem tItems[AL_MEMORY_PLAN_MAX_ITEMS];
+  int iNumItems;
+  uint64_t uTotalSize; /*!< sum of the sizes of the buffers */
+  uint64_t uPeakSize; /*!< memory reserved when all the buffers are allocated */
+}AL_TMemoryPlan;
+
+/*************************************************************************//*!
+   \brief Empties a memory plan
+   \param[out] pPlan Pointer to the memory plan
+*****************************************************************************/
+void AL_MemoryPlan_Init(AL_TMemoryPlan* pPlan);
+
+/*************************************************************************//*!
+   \brief Adds iCount buffers of uSize bytes to a memory plan
+   \param[in,out] pPlan Pointer to the memory plan
+   \param[in] pName Name of the buffers, the string must outlive the plan
+   \param[in] eOwner Who allocates the buffers
+   \param[in] uSize Size of one buffer
+   \param[in] iCount Number of buffers
+   \return false if the plan has no room for another item
+*****************************************************************************/
+bool AL_MemoryPlan_Add(AL_TMemoryPlan* pPlan, char const* pName, AL_EMemoryOwner eOwner, uint32_t uSize, int iCount);
+
+/*@}*/
+
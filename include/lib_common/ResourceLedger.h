@@ -0,0 +1,122 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+/**************************************************************************//*!
+   \addtogroup ResourceLedger
+   @{
+   \file
+ **************************************************************************/
+#pragma once
+
+#include "lib_rtos/types.h"
+#include "lib_common/Error.h"
+
+#define AL_LEDGER_MAX_CORES 32
+#define AL_LEDGER_MAX_CHANNELS 32
+
+/*************************************************************************//*!
+   \brief Host side account of the load of the channels running on the cores
+   of a device.
+   A channel spreads its load evenly on the cores it uses. It is placed on the
+   least loaded cores, the lowest index first when they are equally loaded,
+   so that the same sequence of channels always gets the same placement. A
+   channel is admitted only when each of its cores can take its share of the
+   load: the real time of the channels already running is never given up.
+*****************************************************************************/
+typedef struct AL_t_ResourceLedger AL_TResourceLedger;
+
+/*************************************************************************//*!
+   \brief Load of the cores of a device
+*****************************************************************************/
+typedef struct
+{
+  int iNumCores;
+  int iCoreResources; /*!< resources a core can handle */
+  int iNumChannels;
+  int iCoreLoad[AL_LEDGER_MAX_CORES]; /*!< resources used on each core */
+  int iUsedResources; /*!< sum of the load of the cores */
+}AL_TResourceUtilization;
+
+/*************************************************************************//*!
+   \brief Creates the ledger of a device
+   \param[in] iNumCores Number of cores of the device
+   \param[in] iCoreResources Resources a core can handle, see GetCoreResources
+   \return the ledger, NULL on failure
+*****************************************************************************/
+AL_TResourceLedger* AL_ResourceLedger_Create(int iNumCores, int iCoreResources);
+
+/*************************************************************************//*!
+   \brief Destroys a ledger
+*****************************************************************************/
+void AL_ResourceLedger_Destroy(AL_TResourceLedger* pLedger);
+
+/*************************************************************************//*!
+   \brief Records the load of a new channel
+   \param[in] pLedger Pointer to the ledger
+   \param[in] pOwner Identifies the channel, given back to AL_ResourceLedger_Release
+   \param[in] iResources Load of the channel
+   \param[in] iNumCore Number of cores the channel uses
+   \return AL_SUCCESS if the channel fits on the device,
+   AL_ERR_CHAN_CREATION_NOT_ENOUGH_CORES if the device has less than iNumCore cores,
+   AL_ERR_CHAN_CREATION_RESOURCE_UNAVAILABLE if the cores can't take the load,
+   AL_ERR_CHAN_CREATION_NO_CHANNEL_AVAILABLE if the ledger is full
+*****************************************************************************/
+AL_ERR AL_ResourceLedger_Reserve(AL_TResourceLedger* pLedger, void const* pOwner, int iResources, int iNumCore);
+
+/*************************************************************************//*!
+   \brief Forgets the load of a channel
+   \param[in] pLedger Pointer to the ledger
+   \param[in] pOwner Channel given to AL_ResourceLedger_Reserve
+*****************************************************************************/
+void AL_ResourceLedger_Release(AL_TResourceLedger* pLedger, void const* pOwner);
+
+/*************************************************************************//*!
+   \brief Gives the biggest load a new channel using iNumCore cores can have
+   \param[in] pLedger Pointer to the ledger
+   \param[in] iNumCore Number of cores of the channel
+   \return the load AL_ResourceLedger_Reserve accepts, 0 if none
+*****************************************************************************/
+int AL_ResourceLedger_GetAvailableResources(AL_TResourceLedger* pLedger, int iNumCore);
+
+/*************************************************************************//*!
+   \brief Gives the current load of the cores
+   \param[in] pLedger Pointer to the ledger
+   \param[out] pUtilization Load of the cores
+*****************************************************************************/
+void AL_ResourceLedger_GetUtilization(AL_TResourceLedger* pLedger, AL_TResourceUtilization* pUtilization);
+
+/*@}*/
+
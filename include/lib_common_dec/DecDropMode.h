@@ -0,0 +1,56 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+/*************************************************************************//*!
+   \addtogroup Decoder_Settings
+   @{
+   \file
+*****************************************************************************/
+#pragma once
+
+/*************************************************************************//*!
+   \brief Pictures the decoder skips without decoding them (thumbnailing, fast forward)
+*****************************************************************************/
+typedef enum AL_e_DecDropMode
+{
+  AL_DROP_NONE, /*< decode all the pictures */
+  AL_DROP_NON_KEY_FRAMES, /*< decode only the IDR pictures (AVC) or the IRAP pictures (HEVC) */
+  AL_DROP_HIGH_TEMPORAL_LAYERS, /*< decode only the pictures up to the maximum temporal id. AVC has no temporal id: 0 drops the non reference pictures, higher values keep all the pictures */
+  AL_DROP_MAX_ENUM, /* sentinel */
+}AL_EDecDropMode;
+
+/*@}*/
+
@@ -95,6 +95,7 @@ typedef enum e_QPCtrlMode
   LOAD_QP = 0x04, /*!< used for test purpose */
   BORDER_QP = 0x05, /*!< used for test purpose */
   ROI_QP = 0x06,
+  ADAPTIVE_QP = 0x07, /*!< relative QP table computed from the source content by the application */
   MASK_QP_TABLE = 0x07,
 
   // additional modes
@@ -189,5 +190,14 @@ int AL_Settings_CheckValidity(AL_TEncSettings* pSettings, AL_TEncChanParam* pChP
  *****************************************************************************/
 int AL_Settings_CheckCoherency(AL_TEncSettings* pSettings, AL_TEncChanParam* pChParam, TFourCC tFourCC, FILE* pOut);
 
+/*************************************************************************//*!
+   \brief Gives the load of a channel on the encoder cores
+   \param[in] pChParam Pointer to the channel parameters
+   \param[out] pNumCore Number of cores the channel uses, chosen from its load
+   when uNumCore is NUMCORE_AUTO
+   \return the resources the channel uses, in the unit of GetCoreResources
+*****************************************************************************/
+int AL_Settings_GetChannelResources(AL_TEncChanParam const* pChParam, int* pNumCore);
+
 /*@}*/
 
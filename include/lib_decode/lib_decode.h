@@ -57,10 +57,12 @@
 #include "lib_common/BufferAPI.h"
 #include "lib_common/Error.h"
 #include "lib_common/FourCC.h"
+#include "lib_common/MemoryPlan.h"
 
 #include "lib_common_dec/DecInfo.h"
 #include "lib_common_dec/DecDpbMode.h"
 #include "lib_common_dec/DecSynchro.h"
+#include "lib_common_dec/DecDropMode.h"
 
 typedef struct AL_t_IDecChannel AL_TIDecChannel;
 
@@ -104,6 +106,28 @@ typedef struct
 *****************************************************************************/
 typedef AL_HANDLE AL_HDecoder;
 
+/*************************************************************************//*!
+   \brief Handle to a pool of threads running the input feeding of several
+   decoders, instead of one feeder thread per decoder.
+   \see AL_FeederPool_Create
+*****************************************************************************/
+typedef AL_HANDLE AL_HFeederPool;
+
+/*************************************************************************//*!
+   \brief Creates a feeder pool of iNumThreads threads. Each thread has a run
+   queue of decoders and steals the work of the others when it is idle. A
+   decoder runs one decoding unit per turn, then goes back at the end of the
+   queue so that a busy stream can't starve the others.
+   \param[in] iNumThreads Number of threads of the pool
+   \return the pool, NULL on failure
+*****************************************************************************/
+AL_HFeederPool AL_FeederPool_Create(int iNumThreads);
+
+/*************************************************************************//*!
+   \brief Destroys a feeder pool. The decoders using it must be destroyed first
+*****************************************************************************/
+void AL_FeederPool_Destroy(AL_HFeederPool hPool);
+
 /*************************************************************************//*!
    \brief Decoder Settings
    \ingroup Decoder_Settings
@@ -126,6 +150,12 @@ typedef struct
   AL_EDecUnit eDecUnit; /*!< Should subframe latency mode be used */
   AL_EDpbMode eDpbMode; /*!< Should low ref mode be used */
   AL_TStreamSettings tStream; /*!< Stream's settings. These need to be set if you want to preallocate the buffer. memset to 0 otherwise */
+  bool bDropOnStreamOverflow; /*!< Low latency policy: drop the buffered stream when it doesn't fit in the stream buffer instead of reporting AL_ERR_STREAM_OVERFLOW */
+  bool bLengthPrefixed; /*!< Each NAL of the input is preceded by its size on 4 big endian bytes (AVCC/HVCC samples of MP4/MKV files) instead of a start code */
+  AL_EDecDropMode eDropMode; /*!< Pictures skipped without being decoded */
+  uint8_t uMaxTemporalId; /*!< Highest temporal id decoded when eDropMode is AL_DROP_HIGH_TEMPORAL_LAYERS */
+  AL_HFeederPool hFeederPool; /*!< Pool running the input feeding of the decoder. NULL: the decoder has its own feeder thread */
+  bool bBatchSlices; /*!< Subframe latency: send the slices parsed together in one request. The channel falls back on one request per slice when the driver refuses it */
 
 }AL_TDecSettings;
 
@@ -171,6 +201,20 @@ void AL_Decoder_SetParam(AL_HDecoder hDec, bool bConceal, bool bUseBoard, int iF
 *****************************************************************************/
 bool AL_Decoder_PushBuffer(AL_HDecoder hDec, AL_TBuffer* pBuf, size_t uSize);
 
+/*************************************************************************//*!
+   \brief Pushes a buffer to the decoder queue, waiting at most uWait ms for
+   the decoder to free some room in it. The decoder only takes data from its
+   queue when there is space in its stream buffer, so a full queue means the
+   input is ahead of the decoding.
+   \param[in] hDec Handle to a decoder object.
+   \param[in] pBuf Pointer to the encoded bitstream buffer
+   \param[in] uSize Size in bytes of actual data in pBuf
+   \param[in] uWait Maximum wait in milliseconds (AL_NO_WAIT, AL_WAIT_FOREVER)
+   \return AL_SUCCESS when the buffer was queued, AL_WARN_INPUT_FULL when the
+   queue stayed full, the decoder error otherwise
+*****************************************************************************/
+AL_ERR AL_Decoder_TryPushBuffer(AL_HDecoder hDec, AL_TBuffer* pBuf, size_t uSize, uint32_t uWait);
+
 /*************************************************************************//*!
    \brief Flushes the decoding request stack when the stream parsing is finished.
    \param[in]  hDec Handle to a decoder object.
@@ -215,6 +259,47 @@ AL_ERR AL_Decoder_GetLastError(AL_HDecoder hDec);
 *****************************************************************************/
 bool AL_Decoder_PreallocateBuffers(AL_HDecoder hDec);
 
+/*************************************************************************//*!
+   \brief Settings of a stream found by AL_Decoder_ProbeStream
+*****************************************************************************/
+typedef struct
+{
+  AL_TStreamSettings tStreamSettings; /*!< Settings of the first sequence of the stream, usable as AL_TDecSettings::tStream */
+  AL_TCropInfo tCropInfo; /*!< Cropping window of the first sequence */
+  int iNumFrameBuffers; /*!< Number of output buffers the decoder will request in its resolution found callback */
+  int iFrameBufferSize; /*!< Size of each of these output buffers */
+}AL_TStreamProbe;
+
+/*************************************************************************//*!
+   \brief Reads the settings of a stream from its first sequence parameter set
+   without creating a decoder.
+   Only the host memory given in parameter is read: no channel, hardware
+   resource or dma memory is used. The result lets the application size its
+   buffer pools and fill the stream settings needed by AL_Decoder_PreallocateBuffers.
+   \param[in]  pSettings Settings the stream will be decoded with (codec, input
+   format, dpb mode, stack size and frame buffer storage are used)
+   \param[in]  pStream Beginning of the stream
+   \param[in]  zSize Size of the beginning of the stream in bytes
+   \param[out] pProbe Settings of the stream
+   \return AL_SUCCESS if a supported sequence parameter set was found,
+   AL_ERR_NO_MEMORY if the parsing context couldn't be allocated,
+   AL_ERROR otherwise
+*****************************************************************************/
+AL_ERR AL_Decoder_ProbeStream(AL_TDecSettings const* pSettings, uint8_t const* pStream, size_t zSize, AL_TStreamProbe* pProbe);
+
+/*************************************************************************//*!
+   \brief Lists the buffers a decoder channel allocates for a stream, without
+   creating the decoder, so that the application can check that they fit in
+   its memory before allocating anything.
+   The frame buffers the application provides in the resolution found
+   callback are part of the plan.
+   \param[in]  pSettings Settings the stream will be decoded with. All the
+   stream settings (tStream) must be set, see AL_Decoder_ProbeStream
+   \param[out] pPlan Itemized buffers and footprint of the channel
+   \return false if the settings are incomplete or invalid
+*****************************************************************************/
+bool AL_Decoder_GetMemoryPlan(AL_TDecSettings const* pSettings, AL_TMemoryPlan* pPlan);
+
 /*************************************************************************//*!
    \brief Give the minimum stride supported by the decoder for its reconstructed buffers
    \param[in] uWidth width of the reconstructed buffers in pixels
@@ -38,9 +38,17 @@
 #pragma once
 
 #include "lib_common/Allocator.h"
+#include "lib_common/ResourceLedger.h"
 
 typedef struct AL_t_driver AL_TDriver;
 typedef struct t_Scheduler TScheduler;
 
 TScheduler* AL_SchedulerMcu_Create(AL_TDriver* driver, AL_TAllocator* pDmaAllocator);
 
+/*************************************************************************//*!
+   \brief Gives the ledger of the load of the channels created with the scheduler.
+   The scheduler refuses the channels the cores can't handle along with the
+   channels already running (AL_ERR_CHAN_CREATION_RESOURCE_UNAVAILABLE).
+*****************************************************************************/
+AL_TResourceLedger* AL_SchedulerMcu_GetResourceLedger(TScheduler* pScheduler);
+
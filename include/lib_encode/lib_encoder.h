@@ -54,6 +54,7 @@
 
 #include "lib_common/BufferAPI.h"
 #include "lib_common/Error.h"
+#include "lib_common/MemoryPlan.h"
 #include "lib_common_enc/Settings.h"
 #include "lib_common_enc/EncRecBuffer.h"
 
@@ -100,6 +101,21 @@ typedef struct
 *****************************************************************************/
 AL_ERR AL_Encoder_Create(AL_HEncoder* hEnc, TScheduler* pScheduler, AL_TAllocator* pAlloc, AL_TEncSettings const* pSettings, AL_CB_EndEncoding callback);
 
+/*************************************************************************//*!
+   \brief Lists the buffers an encoder channel needs for the given settings,
+   without creating it, so that the application can reject a channel that
+   doesn't fit in its memory before allocating anything.
+   The buffers allocated by the firmware in the device memory (references,
+   motion vectors, intermediate buffers) are estimated from the worst case
+   of the settings. The source, stream and qp table buffers are provided by
+   the application and are not part of the plan.
+   \param[in] pSettings Pointer to AL_TEncSettings structure specifying the encoder
+   parameters.
+   \param[out] pPlan Itemized buffers and footprint of the channel
+   \return false if the settings don't describe a supported channel
+*****************************************************************************/
+bool AL_Encoder_GetMemoryPlan(AL_TEncSettings const* pSettings, AL_TMemoryPlan* pPlan);
+
 /*************************************************************************//*!
    \brief Releases all allocated and/or owned ressources
    \param[in] hEnc Handle to Encoder object previously created with CreateEncoder
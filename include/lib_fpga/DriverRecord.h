@@ -0,0 +1,142 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+/**************************************************************************//*!
+   \addtogroup Driver
+   @{
+   \file
+ *****************************************************************************/
+#pragma once
+
+#include "lib_rtos/types.h"
+
+typedef struct AL_t_driver AL_TDriver;
+
+/*************************************************************************//*!
+   \brief Kind of driver call stored in a recording
+*****************************************************************************/
+typedef enum
+{
+  AL_DRIVER_RECORD_OPEN,
+  AL_DRIVER_RECORD_CLOSE,
+  AL_DRIVER_RECORD_MESSAGE,
+}AL_EDriverRecordType;
+
+/*************************************************************************//*!
+   \brief One driver call. Channels are numbered in opening order.
+   Timestamps are in microseconds, relative to the start of the recording.
+   pIn holds the payload given to the driver and pOut the payload it gave
+   back, both uSize bytes long.
+*****************************************************************************/
+typedef struct
+{
+  uint32_t eType;
+  int32_t iChannel;
+  uint64_t uMessageId;
+  uint64_t uStartUs;
+  uint64_t uEndUs;
+  int32_t iStatus;
+  uint32_t uSize;
+  uint8_t* pIn;
+  uint8_t* pOut;
+}AL_TDriverRecord;
+
+/*************************************************************************//*!
+   \brief A recording loaded in memory. The records are in the order they
+   were logged: each call is logged once it returns, when it gets the
+   recording lock, so concurrent calls can be slightly out of order. Sort on
+   uStartUs or uEndUs when the exact order matters.
+*****************************************************************************/
+typedef struct
+{
+  AL_TDriverRecord* pRecords;
+  int iNumRecords;
+  int iNumChannels;
+}AL_TDriverSession;
+
+/*************************************************************************//*!
+   \brief Loads a recording made by a record driver
+   \param[in] sFileName path of the recording
+   \param[out] pSession loaded session, to be released with
+   AL_DriverSession_Deinit
+   \return false if the file can't be read or isn't a recording
+*****************************************************************************/
+bool AL_DriverSession_Load(char const* sFileName, AL_TDriverSession* pSession);
+void AL_DriverSession_Deinit(AL_TDriverSession* pSession);
+
+/*************************************************************************//*!
+   \brief Creates a driver forwarding every call to pDriver and logging it,
+   with its payloads, timestamps and returned status, in sFileName.
+   \return NULL if the recording can't be created
+*****************************************************************************/
+AL_TDriver* AL_RecordDriver_Create(AL_TDriver* pDriver, char const* sFileName);
+
+/*************************************************************************//*!
+   \brief Flushes the recording and frees the driver. The wrapped driver is
+   left untouched.
+*****************************************************************************/
+void AL_RecordDriver_Destroy(AL_TDriver* pDriver);
+
+/*************************************************************************//*!
+   \brief Replay parameters
+*****************************************************************************/
+typedef struct
+{
+  /* delay between a request and the status it triggers,
+   * -1 to reproduce the delays of the recording */
+  int iLatencyUs;
+  /* messages blocking until the device reports something,
+   * answered once their recorded cause has been replayed */
+  long unsigned int const* pWaitMessages;
+  int iNumWaitMessages;
+}AL_TReplayConfig;
+
+/*************************************************************************//*!
+   \brief Creates a driver answering from a recording instead of a device.
+   Channels are matched in opening order and each request gets the payload
+   and status that were recorded for the same request on the same channel.
+   The channels can be polled: their fd becomes readable when a wait message
+   has a status ready, like with the hardware driver.
+   \param[in] pSession recording to replay. It must outlive the driver
+   \param[in] pConfig replay parameters
+   \return NULL on failure
+*****************************************************************************/
+AL_TDriver* AL_ReplayDriver_Create(AL_TDriverSession const* pSession, AL_TReplayConfig const* pConfig);
+void AL_ReplayDriver_Destroy(AL_TDriver* pDriver);
+
+/*@}*/
+
@@ -0,0 +1,123 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+/**************************************************************************//*!
+   \addtogroup Perfs
+   @{
+   \file
+ *****************************************************************************/
+#pragma once
+
+#include "lib_rtos/types.h"
+
+/*************************************************************************//*!
+   \brief Checkpoints of the encoding and decoding pipelines. The latency of a
+   stage is the time between the previous checkpoint of the same frame and
+   this one.
+*****************************************************************************/
+typedef enum
+{
+  AL_STAGE_ENC_READ, /*!< source frame read from the input */
+  AL_STAGE_ENC_CONVERT, /*!< source frame converted to the encoder format */
+  AL_STAGE_ENC_PROCESS, /*!< AL_Encoder_Process returned */
+  AL_STAGE_ENC_END_ENCODING, /*!< EndEncoding callback received */
+  AL_STAGE_ENC_STREAM_WRITTEN, /*!< stream written to the output */
+  AL_STAGE_ENC_TOTAL, /*!< whole encoding pipeline, computed */
+  AL_STAGE_DEC_PUSH_BUFFER, /*!< time spent in AL_Decoder_PushBuffer */
+  AL_STAGE_DEC_START_CODE, /*!< start codes of the frame found, since the last push */
+  AL_STAGE_DEC_LAUNCH, /*!< frame decoding sent to the ip */
+  AL_STAGE_DEC_FRAME_READY, /*!< end of decoding reported */
+  AL_STAGE_DEC_DISPLAYED, /*!< display callback done */
+  AL_STAGE_DEC_TOTAL, /*!< whole decoding pipeline, computed */
+  AL_STAGE_MAX_ENUM,
+}AL_EPipelineStage;
+
+typedef struct
+{
+  uint32_t uCount;
+  uint64_t uMeanUs;
+  uint64_t uP50Us;
+  uint64_t uP95Us;
+  uint64_t uP99Us;
+  uint64_t uMaxUs;
+}AL_TLatencySummary;
+
+/*************************************************************************//*!
+   \brief Starts collecting statistics, clearing the previous ones.
+   The checkpoints are ignored while the collection is disabled.
+*****************************************************************************/
+void AL_PipelineStats_Enable(bool bEnable);
+bool AL_PipelineStats_IsEnabled(void);
+
+/*************************************************************************//*!
+   \brief Starts tracking a frame
+   \param[in] uKey identifies the frame across the pipeline, typically the
+   address of its buffer. 0 is reserved.
+   \param[in] uTimeUs date of the start, from Rtos_GetTimeUs
+*****************************************************************************/
+void AL_PipelineStats_StartAt(uint64_t uKey, uint64_t uTimeUs);
+void AL_PipelineStats_Start(uint64_t uKey);
+
+/*************************************************************************//*!
+   \brief Records that the frame uKey reached eStage at uTimeUs.
+   A checkpoint on a frame that isn't tracked is ignored. The last stage of a
+   pipeline stops the tracking of the frame.
+*****************************************************************************/
+void AL_PipelineStats_CheckpointAt(AL_EPipelineStage eStage, uint64_t uKey, uint64_t uTimeUs);
+void AL_PipelineStats_Checkpoint(AL_EPipelineStage eStage, uint64_t uKey);
+
+/*************************************************************************//*!
+   \brief Stops tracking the frame uKey without recording its total, when its
+   buffer leaves the pipeline before the last stage
+*****************************************************************************/
+void AL_PipelineStats_Stop(uint64_t uKey);
+
+/*************************************************************************//*!
+   \brief Percentiles are approximated within 3%
+   \return false if the stage has no sample
+*****************************************************************************/
+bool AL_PipelineStats_GetSummary(AL_EPipelineStage eStage, AL_TLatencySummary* pSummary);
+char const* AL_PipelineStats_GetStageName(AL_EPipelineStage eStage);
+
+/*************************************************************************//*!
+   \brief Writes the summary of every stage with samples in sFileName, as CSV
+   if the name ends with ".csv" and as JSON otherwise
+*****************************************************************************/
+bool AL_PipelineStats_Export(char const* sFileName);
+
+/*@}*/
+
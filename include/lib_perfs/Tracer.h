@@ -0,0 +1,112 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+/**************************************************************************//*!
+   \addtogroup Perfs
+   @{
+   \file
+ *****************************************************************************/
+#pragma once
+
+#include "lib_rtos/types.h"
+
+/*************************************************************************//*!
+   \brief Low overhead tracer, a lighter alternative to AL_Log.
+   Every thread writes its events in its own ring, without locking. An event
+   is a timestamp, a static name and an argument: the name must be a string
+   literal, it is never copied. The rings are merged in a Chrome trace-event
+   file (chrome://tracing, Perfetto) by AL_Tracer_Export.
+   When the tracer is stopped, tracing an event costs one test.
+*****************************************************************************/
+typedef enum
+{
+  AL_TRACE_BEGIN,
+  AL_TRACE_END,
+  AL_TRACE_INSTANT,
+}AL_ETracePhase;
+
+extern bool g_TracerEnabled;
+
+#define AL_TRACER_DEFAULT_EVENTS_PER_THREAD (64 * 1024)
+
+/*************************************************************************//*!
+   \brief Starts tracing, with rings of iEventsPerThread events. The oldest
+   events of a thread are overwritten when its ring is full.
+*****************************************************************************/
+bool AL_Tracer_Start(int iEventsPerThread);
+void AL_Tracer_Stop(void);
+
+/*************************************************************************//*!
+   \brief Writes the events of every thread in sFileName as Chrome trace-event
+   JSON. The traced threads should be idle while exporting.
+*****************************************************************************/
+bool AL_Tracer_Export(char const* sFileName);
+
+/*! \cond ********************************************************************/
+void AL_Tracer_Record(char const* sEvent, AL_ETracePhase ePhase, uint32_t uArg);
+void AL_Tracer_NameThread(char const* sName);
+/*! \endcond *****************************************************************/
+
+static inline void AL_Trace_Begin(char const* sEvent, uint32_t uArg)
+{
+  if(g_TracerEnabled)
+    AL_Tracer_Record(sEvent, AL_TRACE_BEGIN, uArg);
+}
+
+static inline void AL_Trace_End(char const* sEvent)
+{
+  if(g_TracerEnabled)
+    AL_Tracer_Record(sEvent, AL_TRACE_END, 0);
+}
+
+static inline void AL_Trace_Instant(char const* sEvent, uint32_t uArg)
+{
+  if(g_TracerEnabled)
+    AL_Tracer_Record(sEvent, AL_TRACE_INSTANT, uArg);
+}
+
+/*************************************************************************//*!
+   \brief Names the calling thread in the trace. sName must be a string literal
+*****************************************************************************/
+static inline void AL_Trace_NameThread(char const* sName)
+{
+  if(g_TracerEnabled)
+    AL_Tracer_NameThread(sName);
+}
+
+/*@}*/
+
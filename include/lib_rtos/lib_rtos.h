@@ -76,6 +76,8 @@ int Rtos_Memcmp(void const* pBuf1, void const* pBuf2, size_t zSize);
 /*  Clock */
 /****************************************************************************/
 AL_64U Rtos_GetTime();
+/* monotonic, for measuring durations */
+AL_64U Rtos_GetTimeUs();
 void Rtos_Sleep(uint32_t uMillisecond);
 
 /****************************************************************************/
@@ -0,0 +1,87 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+#include "lib_app/MemoryBudget.h"
+#include "lib_app/utils.h"
+
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+
+/*****************************************************************************/
+static char const* ToString(AL_EMemoryOwner eOwner)
+{
+  switch(eOwner)
+  {
+  case AL_MEM_LIBRARY: return "library";
+  case AL_MEM_FIRMWARE: return "firmware";
+  case AL_MEM_APPLICATION: return "application";
+  default: return "unknown";
+  }
+}
+
+/*****************************************************************************/
+static double ToMB(uint64_t uSize)
+{
+  return uSize / (1024.0 * 1024.0);
+}
+
+/*****************************************************************************/
+void PrintMemoryPlan(AL_TMemoryPlan const& tPlan)
+{
+  Message(CC_DEFAULT, "Memory plan of the channel:\n");
+
+  for(int i = 0; i < tPlan.iNumItems; ++i)
+  {
+    auto& tItem = tPlan.tItems[i];
+    Message(CC_DEFAULT, "  %-16s %-12s %3d x %10u bytes\n", tItem.pName, ToString(tItem.eOwner), tItem.iCount, tItem.uSize);
+  }
+
+  Message(CC_DEFAULT, "  total %.2f MB, peak %.2f MB\n", ToMB(tPlan.uTotalSize), ToMB(tPlan.uPeakSize));
+}
+
+/*****************************************************************************/
+void CheckMemoryBudget(uint64_t uPeakSize, int iBudget)
+{
+  if(uPeakSize <= ((uint64_t)iBudget << 20))
+    return;
+
+  stringstream ss;
+  ss << "The channels need " << ToMB(uPeakSize) << " MB, over the memory budget of " << iBudget << " MB";
+  throw runtime_error(ss.str());
+}
+
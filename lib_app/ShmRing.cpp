@@ -0,0 +1,337 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+#include "ShmRing.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// the data area starts on its own page
+static uint64_t const DATA_OFFSET = 4096;
+// a waiting producer gives up after this time without any sign of the consumer
+static int const iConsumerTimeoutMs = 5000;
+
+enum
+{
+  RECORD_ENTRY,
+  RECORD_PADDING, // skips the end of the data area
+};
+
+struct TRecord
+{
+  uint32_t uSize; // bytes following the record header
+  uint32_t uType;
+};
+
+/****************************************************************************/
+static uint64_t GetRecordSize(uint32_t uSize)
+{
+  return (sizeof(TRecord) + uSize + 7) & ~7ULL;
+}
+
+/****************************************************************************/
+static void Backoff(int& iNumTries)
+{
+  if(++iNumTries < 64)
+    this_thread::yield();
+  else
+    this_thread::sleep_for(chrono::microseconds(100));
+}
+
+/****************************************************************************/
+struct ShmRing::ConsumerWatch
+{
+  int iNumTries = 0;
+  uint64_t uHeartbeat;
+  chrono::steady_clock::time_point lastBeat = chrono::steady_clock::now();
+};
+
+/* called by the producer while it can't go on without the consumer */
+void ShmRing::WaitConsumer(ConsumerWatch& watch)
+{
+  auto const uHeartbeat = m_pHeader->uHeartbeat.load(memory_order_relaxed);
+  auto const now = chrono::steady_clock::now();
+
+  if(watch.iNumTries == 0 || uHeartbeat != watch.uHeartbeat)
+  {
+    watch.uHeartbeat = uHeartbeat;
+    watch.lastBeat = now;
+  }
+  else if(!m_pHeader->uAttached.load(memory_order_relaxed) && uHeartbeat != 0)
+    throw runtime_error("The consumer of the shared memory ring " + m_sName + " detached");
+  else if(now - watch.lastBeat > chrono::milliseconds(iConsumerTimeoutMs))
+    throw runtime_error("The consumer of the shared memory ring " + m_sName + (uHeartbeat ? " stopped responding" : " never attached"));
+
+  Backoff(watch.iNumTries);
+}
+
+/****************************************************************************/
+static string GetShmName(string const& sName)
+{
+  return sName.empty() || sName[0] != '/' ? "/" + sName : sName;
+}
+
+/****************************************************************************/
+ShmRing::ShmRing(string const& sName, void* pMap, uint64_t uMapSize, bool bOwner) :
+  m_pHeader((TShmRingHeader*)pMap), m_pData((uint8_t*)pMap + DATA_OFFSET), m_uMapSize(uMapSize), m_sName(sName), m_bOwner(bOwner)
+{
+}
+
+#ifdef _WIN32
+
+ShmRing::~ShmRing()
+{
+}
+
+unique_ptr<ShmRing> ShmRing::Create(string const&, uint64_t)
+{
+  throw runtime_error("The shared memory ring isn't supported on this platform");
+}
+
+unique_ptr<ShmRing> ShmRing::Open(string const&)
+{
+  throw runtime_error("The shared memory ring isn't supported on this platform");
+}
+
+#else
+
+/****************************************************************************/
+ShmRing::~ShmRing()
+{
+  if(!m_bOwner)
+    m_pHeader->uAttached.store(0, memory_order_release);
+
+  munmap(m_pHeader, m_uMapSize);
+
+  if(m_bOwner)
+    shm_unlink(m_sName.c_str());
+}
+
+/****************************************************************************/
+unique_ptr<ShmRing> ShmRing::Create(string const& sName, uint64_t uDataSize)
+{
+  if(uDataSize < 4096 || (uDataSize & (uDataSize - 1)))
+    throw runtime_error("The size of the shared memory ring must be a power of 2 of at least 4096 bytes");
+
+  auto const sShmName = GetShmName(sName);
+  int fd = shm_open(sShmName.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+
+  if(fd < 0)
+    throw runtime_error("Can't create the shared memory " + sShmName + ": " + strerror(errno));
+
+  uint64_t const uMapSize = DATA_OFFSET + uDataSize;
+  void* pMap = MAP_FAILED;
+
+  if(ftruncate(fd, uMapSize) == 0)
+    pMap = mmap(nullptr, uMapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if(pMap == MAP_FAILED)
+  {
+    shm_unlink(sShmName.c_str());
+    throw runtime_error("Can't map the shared memory " + sShmName + ": " + strerror(errno));
+  }
+
+  auto pHeader = new(pMap) TShmRingHeader;
+  pHeader->uDataSize = uDataSize;
+  pHeader->uWritePos.store(0);
+  pHeader->uReadPos.store(0);
+  pHeader->uClosed.store(0);
+  pHeader->uAttached.store(0);
+  pHeader->uHeartbeat.store(0);
+  pHeader->uVersion = SHM_RING_VERSION;
+  // the consumer checks the magic number before using the ring
+  atomic_thread_fence(memory_order_release);
+  pHeader->uMagic = SHM_RING_MAGIC;
+
+  return unique_ptr<ShmRing>(new ShmRing(sShmName, pMap, uMapSize, true));
+}
+
+/****************************************************************************/
+unique_ptr<ShmRing> ShmRing::Open(string const& sName)
+{
+  auto const sShmName = GetShmName(sName);
+  int fd = shm_open(sShmName.c_str(), O_RDWR, 0);
+
+  if(fd < 0)
+    return nullptr;
+
+  struct stat tStat;
+  void* pMap = MAP_FAILED;
+
+  if(fstat(fd, &tStat) == 0 && (uint64_t)tStat.st_size > DATA_OFFSET)
+    pMap = mmap(nullptr, tStat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if(pMap == MAP_FAILED)
+    return nullptr;
+
+  auto pHeader = (TShmRingHeader*)pMap;
+
+  if(pHeader->uMagic != SHM_RING_MAGIC)
+  {
+    munmap(pMap, tStat.st_size);
+    return nullptr;
+  }
+
+  atomic_thread_fence(memory_order_acquire);
+
+  if(pHeader->uVersion != SHM_RING_VERSION || DATA_OFFSET + pHeader->uDataSize != (uint64_t)tStat.st_size)
+  {
+    munmap(pMap, tStat.st_size);
+    throw runtime_error("Incompatible shared memory ring " + sShmName);
+  }
+
+  // the first beat tells the producer a consumer came
+  pHeader->uAttached.store(1, memory_order_release);
+  pHeader->uHeartbeat.fetch_add(1, memory_order_relaxed);
+
+  return unique_ptr<ShmRing>(new ShmRing(sShmName, pMap, tStat.st_size, false));
+}
+
+#endif
+
+/****************************************************************************/
+uint8_t* ShmRing::Reserve(uint32_t uSize)
+{
+  uint64_t const uDataSize = m_pHeader->uDataSize;
+  uint64_t const uRecordSize = GetRecordSize(uSize);
+
+  if(uRecordSize > uDataSize / 2)
+    throw runtime_error("The entry doesn't fit in the shared memory ring");
+
+  uint64_t uWritePos = m_pHeader->uWritePos.load(memory_order_relaxed);
+  uint64_t const uContiguous = uDataSize - (uWritePos & (uDataSize - 1));
+  // the entry doesn't wrap: the end of the data area is skipped
+  uint64_t const uPadding = uContiguous < uRecordSize ? uContiguous : 0;
+  ConsumerWatch watch;
+
+  while(uDataSize - (uWritePos - m_pHeader->uReadPos.load(memory_order_acquire)) < uPadding + uRecordSize)
+    WaitConsumer(watch);
+
+  if(uPadding)
+  {
+    auto pPadding = (TRecord*)(m_pData + (uWritePos & (uDataSize - 1)));
+    pPadding->uSize = uPadding - sizeof(TRecord);
+    pPadding->uType = RECORD_PADDING;
+    uWritePos += uPadding;
+    m_pHeader->uWritePos.store(uWritePos, memory_order_release);
+  }
+
+  auto pRecord = (TRecord*)(m_pData + (uWritePos & (uDataSize - 1)));
+  pRecord->uSize = uSize;
+  pRecord->uType = RECORD_ENTRY;
+  m_uPending = uRecordSize;
+
+  return (uint8_t*)(pRecord + 1);
+}
+
+/****************************************************************************/
+void ShmRing::Publish()
+{
+  auto const uWritePos = m_pHeader->uWritePos.load(memory_order_relaxed);
+  m_pHeader->uWritePos.store(uWritePos + m_uPending, memory_order_release);
+  m_uPending = 0;
+}
+
+/****************************************************************************/
+void ShmRing::Close()
+{
+  m_pHeader->uClosed.store(1, memory_order_release);
+}
+
+/****************************************************************************/
+void ShmRing::WaitDrained()
+{
+  ConsumerWatch watch;
+
+  while(m_pHeader->uReadPos.load(memory_order_acquire) != m_pHeader->uWritePos.load(memory_order_relaxed))
+    WaitConsumer(watch);
+}
+
+/****************************************************************************/
+uint8_t const* ShmRing::Peek(uint32_t& uSize)
+{
+  uint64_t const uDataSize = m_pHeader->uDataSize;
+  uint64_t uReadPos = m_pHeader->uReadPos.load(memory_order_relaxed);
+
+  m_pHeader->uHeartbeat.fetch_add(1, memory_order_relaxed);
+
+  while(uReadPos != m_pHeader->uWritePos.load(memory_order_acquire))
+  {
+    auto pRecord = (TRecord const*)(m_pData + (uReadPos & (uDataSize - 1)));
+    uint64_t const uRecordSize = GetRecordSize(pRecord->uSize);
+
+    if(pRecord->uType == RECORD_ENTRY)
+    {
+      uSize = pRecord->uSize;
+      m_uPending = uRecordSize;
+      return (uint8_t const*)(pRecord + 1);
+    }
+
+    uReadPos += uRecordSize;
+    m_pHeader->uReadPos.store(uReadPos, memory_order_release);
+  }
+
+  return nullptr;
+}
+
+/****************************************************************************/
+void ShmRing::Acknowledge()
+{
+  auto const uReadPos = m_pHeader->uReadPos.load(memory_order_relaxed);
+  m_pHeader->uReadPos.store(uReadPos + m_uPending, memory_order_release);
+  m_uPending = 0;
+}
+
+/****************************************************************************/
+bool ShmRing::IsFinished() const
+{
+  return m_pHeader->uClosed.load(memory_order_acquire) && m_pHeader->uReadPos.load(memory_order_relaxed) == m_pHeader->uWritePos.load(memory_order_acquire);
+}
+
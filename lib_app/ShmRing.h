@@ -0,0 +1,141 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+/****************************************************************************
+   -----------------------------------------------------------------------------
+ **************************************************************************//*!
+   \addtogroup lib_base
+   @{
+   \file
+ *****************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/*************************************************************************//*!
+   \brief Single producer, single consumer ring of variable size entries in a
+   POSIX shared memory object. It hands the data of a process to another one
+   without copying it through the kernel: the producer publishes an entry by
+   advancing the write position, the consumer acknowledges it by advancing the
+   read position, which gives the space of the entry back to the producer.
+   The consumer signals it is alive by bumping a heartbeat each time it polls
+   the ring: a producer waiting for space gives up when the consumer left or
+   stopped polling, instead of blocking forever.
+*****************************************************************************/
+static uint32_t const SHM_RING_MAGIC = 0x47525341; // "ASRG"
+static uint32_t const SHM_RING_VERSION = 2;
+
+struct TShmRingHeader
+{
+  uint32_t uMagic;
+  uint32_t uVersion;
+  uint64_t uDataSize; /*!< size of the data area, a power of 2 */
+  alignas(64) std::atomic<uint64_t> uWritePos; /*!< bytes published by the producer */
+  alignas(64) std::atomic<uint64_t> uReadPos; /*!< bytes acknowledged by the consumer */
+  alignas(64) std::atomic<uint32_t> uClosed; /*!< the producer won't publish anymore */
+  alignas(64) std::atomic<uint32_t> uAttached; /*!< a consumer has the ring open */
+  std::atomic<uint64_t> uHeartbeat; /*!< bumped by the consumer each time it polls the ring */
+};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "the positions are shared between processes");
+
+class ShmRing
+{
+public:
+  ~ShmRing();
+
+  /* producer side: the ring is removed when the producer destroys it */
+  static std::unique_ptr<ShmRing> Create(std::string const& sName, uint64_t uDataSize);
+  /* consumer side: returns nullptr while the producer hasn't created the ring */
+  static std::unique_ptr<ShmRing> Open(std::string const& sName);
+
+  /* returns uSize contiguous bytes, once the consumer acknowledged enough entries.
+   * The waits of the producer throw a runtime_error when the consumer detached,
+   * or didn't poll the ring (or never attached) for 5 seconds */
+  uint8_t* Reserve(uint32_t uSize);
+  /* makes the reserved entry visible to the consumer */
+  void Publish();
+  /* no entry will be published anymore */
+  void Close();
+  /* waits for the consumer to acknowledge all the published entries */
+  void WaitDrained();
+
+  /* returns the oldest entry not yet acknowledged, nullptr when there is none */
+  uint8_t const* Peek(uint32_t& uSize);
+  /* gives the space of the entry returned by Peek back to the producer */
+  void Acknowledge();
+  /* the producer closed the ring and all its entries were acknowledged */
+  bool IsFinished() const;
+
+private:
+  ShmRing(std::string const& sName, void* pMap, uint64_t uMapSize, bool bOwner);
+
+  struct ConsumerWatch;
+  void WaitConsumer(ConsumerWatch& watch);
+
+  TShmRingHeader* m_pHeader;
+  uint8_t* m_pData;
+  uint64_t m_uMapSize;
+  std::string m_sName;
+  bool m_bOwner;
+  uint64_t m_uPending = 0; // bytes of the reserved or peeked entry
+};
+
+/*************************************************************************//*!
+   \brief Entry published by the encoder for each stream buffer. It is
+   followed by uNumSections TShmStreamSection, then by the data of the
+   sections.
+*****************************************************************************/
+struct TShmStreamEntry
+{
+  uint32_t uNumSections;
+  uint32_t uDataSize; /*!< size of the data of all the sections */
+  int32_t iSliceType; /*!< AL_ESliceType of the picture, -1 when unknown */
+  int32_t iQP; /*!< slice QP of the picture, -1 when unknown */
+};
+
+struct TShmStreamSection
+{
+  uint32_t uOffset; /*!< offset of the section in the data of the entry */
+  uint32_t uLength;
+  uint32_t uFlags; /*!< see SECTION_xxxxx_FLAG */
+};
+
+/*@}*/
+
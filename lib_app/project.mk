@@ -6,6 +6,8 @@ LIB_APP_SRC+=lib_app/utils.cpp\
 	     lib_app/BufferMetaFactory.c\
 		 lib_app/AllocatorTracker.cpp\
 		 lib_app/FileIOUtils.cpp\
+		 lib_app/ShmRing.cpp\
+		 lib_app/MemoryBudget.cpp\
 
 
 ifeq ($(findstring mingw,$(TARGET)),mingw)
@@ -59,6 +59,12 @@ AL_TPictureMetaData* AL_PictureMetaData_Create()
   pMeta->tMeta.MetaDestroy = PictureMeta_Destroy;
 
   pMeta->eType = SLICE_MAX_ENUM;
+  pMeta->iQP = 0;
+  pMeta->bSkipped = false;
+  pMeta->bIsIDR = false;
+  pMeta->bIsRef = false;
+  pMeta->uInitialRemovalDelay = 0;
+  pMeta->uSumCplx = 0;
 
   return pMeta;
 }
@@ -73,6 +79,12 @@ AL_TPictureMetaData* AL_PictureMetaData_Clone(AL_TPictureMetaData* pMeta)
   if(!pPictureMeta)
     return NULL;
   pPictureMeta->eType = pMeta->eType;
+  pPictureMeta->iQP = pMeta->iQP;
+  pPictureMeta->bSkipped = pMeta->bSkipped;
+  pPictureMeta->bIsIDR = pMeta->bIsIDR;
+  pPictureMeta->bIsRef = pMeta->bIsRef;
+  pPictureMeta->uInitialRemovalDelay = pMeta->uInitialRemovalDelay;
+  pPictureMeta->uSumCplx = pMeta->uSumCplx;
   return pPictureMeta;
 }
 
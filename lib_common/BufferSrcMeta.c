@@ -66,12 +66,24 @@ AL_TSrcMetaData* AL_SrcMetaData_Create(AL_TDimension tDim, AL_TPitches tPitches,
 
   pMeta->tFourCC = tFourCC;
 
+  pMeta->tVisibleDim = tDim;
+  pMeta->tVisibleOffsetYC.iLuma = 0;
+  pMeta->tVisibleOffsetYC.iChroma = 0;
+
   return pMeta;
 }
 
 AL_TSrcMetaData* AL_SrcMetaData_Clone(AL_TSrcMetaData* pMeta)
 {
-  return AL_SrcMetaData_Create(pMeta->tDim, pMeta->tPitches, pMeta->tOffsetYC, pMeta->tFourCC);
+  AL_TSrcMetaData* pClone = AL_SrcMetaData_Create(pMeta->tDim, pMeta->tPitches, pMeta->tOffsetYC, pMeta->tFourCC);
+
+  if(!pClone)
+    return NULL;
+
+  pClone->tVisibleDim = pMeta->tVisibleDim;
+  pClone->tVisibleOffsetYC = pMeta->tVisibleOffsetYC;
+
+  return pClone;
 }
 
 int AL_SrcMetaData_GetOffsetC(AL_TSrcMetaData* pMeta)
@@ -103,3 +115,23 @@ int AL_SrcMetaData_GetChromaSize(AL_TSrcMetaData* pMeta)
   return pMeta->tPitches.iChroma * iHeightC * 2;
 }
 
+void AL_SrcMetaData_SetCrop(AL_TSrcMetaData* pMeta, int iLeft, int iRight, int iTop, int iBottom)
+{
+  assert(!AL_IsTiled(pMeta->tFourCC) && !AL_Is10bitPacked(pMeta->tFourCC));
+
+  int const iSizePix = AL_GetBitDepth(pMeta->tFourCC) > 8 ? 2 : 1;
+  int const iSizePixC = AL_IsSemiPlanar(pMeta->tFourCC) ? 2 * iSizePix : iSizePix; // interleaved Cb & Cr
+
+  pMeta->tVisibleDim.iWidth = pMeta->tDim.iWidth - iLeft - iRight;
+  pMeta->tVisibleDim.iHeight = pMeta->tDim.iHeight - iTop - iBottom;
+
+  pMeta->tVisibleOffsetYC.iLuma = iTop * pMeta->tPitches.iLuma + iLeft * iSizePix;
+  pMeta->tVisibleOffsetYC.iChroma = 0;
+
+  if(AL_GetChromaMode(pMeta->tFourCC) != CHROMA_MONO)
+  {
+    int sx, sy;
+    AL_GetSubsampling(pMeta->tFourCC, &sx, &sy);
+    pMeta->tVisibleOffsetYC.iChroma = (iTop / sy) * pMeta->tPitches.iChroma + (iLeft / sx) * iSizePixC;
+  }
+}
@@ -129,6 +129,8 @@ AL_EChromaMode AL_GetChromaMode(TFourCC tFourCC)
           || (tFourCC == FOURCC(XV10))
           )
     return CHROMA_MONO;
+  else if((tFourCC == FOURCC(I444)) || (tFourCC == FOURCC(I4AL)))
+    return CHROMA_4_4_4;
   else
     assert(0);
   return (AL_EChromaMode) - 1;
@@ -146,6 +148,7 @@ uint8_t AL_GetBitDepth(TFourCC tFourCC)
      || (tFourCC == FOURCC(T608)) || (tFourCC == FOURCC(T628))
      || (tFourCC == FOURCC(T5m8))
      || (tFourCC == FOURCC(T508)) || (tFourCC == FOURCC(T528))
+     || (tFourCC == FOURCC(I444))
      )
     return 8;
   else if((tFourCC == FOURCC(I0AL)) || (tFourCC == FOURCC(P010))
@@ -157,6 +160,7 @@ uint8_t AL_GetBitDepth(TFourCC tFourCC)
           || (tFourCC == FOURCC(T50A)) || (tFourCC == FOURCC(T52A))
           || (tFourCC == FOURCC(XV15)) || (tFourCC == FOURCC(XV20))
           || (tFourCC == FOURCC(XV10))
+          || (tFourCC == FOURCC(I4AL))
           )
     return 10;
   else
@@ -59,6 +59,9 @@ static AL_EDriverError ErrnoToDriverError(int err)
   if(err == EINVAL || err == EPERM)
     return DRIVER_ERROR_CHANNEL;
 
+  if(err == ENOTTY)
+    return DRIVER_ERROR_NOT_SUPPORTED;
+
   return DRIVER_ERROR_UNKNOWN;
 }
 
@@ -44,6 +44,7 @@ typedef enum
   DRIVER_ERROR_UNKNOWN,
   DRIVER_ERROR_NO_MEMORY,
   DRIVER_ERROR_CHANNEL,
+  DRIVER_ERROR_NOT_SUPPORTED, /* the driver doesn't know the message */
 }AL_EDriverError;
 
 typedef struct AL_t_driver AL_TDriver;
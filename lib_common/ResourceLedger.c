@@ -0,0 +1,242 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+#include "lib_common/ResourceLedger.h"
+#include "lib_common/Utils.h"
+#include "lib_rtos/lib_rtos.h"
+
+typedef struct
+{
+  void const* pOwner;
+  int iCoreResources; /* load of the channel on each of its cores */
+  uint32_t uCoreMask;
+}AL_TLedgerEntry;
+
+struct AL_t_ResourceLedger
+{
+  AL_MUTEX Mutex;
+  int iNumCores;
+  int iCoreResources;
+  int iCoreLoad[AL_LEDGER_MAX_CORES];
+  AL_TLedgerEntry tEntries[AL_LEDGER_MAX_CHANNELS];
+};
+
+/****************************************************************************/
+AL_TResourceLedger* AL_ResourceLedger_Create(int iNumCores, int iCoreResources)
+{
+  if(iNumCores < 1 || iNumCores > AL_LEDGER_MAX_CORES || iCoreResources <= 0)
+    return NULL;
+
+  AL_TResourceLedger* pLedger = (AL_TResourceLedger*)Rtos_Malloc(sizeof(*pLedger));
+
+  if(!pLedger)
+    return NULL;
+
+  Rtos_Memset(pLedger, 0, sizeof(*pLedger));
+  pLedger->Mutex = Rtos_CreateMutex();
+
+  if(!pLedger->Mutex)
+  {
+    Rtos_Free(pLedger);
+    return NULL;
+  }
+
+  pLedger->iNumCores = iNumCores;
+  pLedger->iCoreResources = iCoreResources;
+
+  return pLedger;
+}
+
+/****************************************************************************/
+void AL_ResourceLedger_Destroy(AL_TResourceLedger* pLedger)
+{
+  if(!pLedger)
+    return;
+
+  Rtos_DeleteMutex(pLedger->Mutex);
+  Rtos_Free(pLedger);
+}
+
+/****************************************************************************/
+static int divideRoundUp(int iDividend, int iDivisor)
+{
+  return (iDividend + iDivisor - 1) / iDivisor;
+}
+
+/****************************************************************************/
+/* Chooses the iNumCore least loaded cores and returns the load of the most
+ * loaded of them */
+static int chooseCores(AL_TResourceLedger* pLedger, int iNumCore, uint32_t* pCoreMask)
+{
+  uint32_t uCoreMask = 0;
+  int iMaxLoad = 0;
+
+  for(int i = 0; i < iNumCore; ++i)
+  {
+    int iBest = -1;
+
+    for(int iCore = 0; iCore < pLedger->iNumCores; ++iCore)
+    {
+      if(uCoreMask & (1u << iCore))
+        continue;
+
+      if(iBest < 0 || pLedger->iCoreLoad[iCore] < pLedger->iCoreLoad[iBest])
+        iBest = iCore;
+    }
+
+    uCoreMask |= 1u << iBest;
+    iMaxLoad = Max(iMaxLoad, pLedger->iCoreLoad[iBest]);
+  }
+
+  *pCoreMask = uCoreMask;
+  return iMaxLoad;
+}
+
+/****************************************************************************/
+static AL_TLedgerEntry* findEntry(AL_TResourceLedger* pLedger, void const* pOwner)
+{
+  for(int i = 0; i < AL_LEDGER_MAX_CHANNELS; ++i)
+  {
+    if(pLedger->tEntries[i].pOwner == pOwner)
+      return &pLedger->tEntries[i];
+  }
+
+  return NULL;
+}
+
+/****************************************************************************/
+AL_ERR AL_ResourceLedger_Reserve(AL_TResourceLedger* pLedger, void const* pOwner, int iResources, int iNumCore)
+{
+  if(!pOwner || iNumCore < 1)
+    return AL_ERR_REQUEST_MALFORMED;
+
+  if(iNumCore > pLedger->iNumCores)
+    return AL_ERR_CHAN_CREATION_NOT_ENOUGH_CORES;
+
+  AL_ERR eError = AL_SUCCESS;
+  Rtos_GetMutex(pLedger->Mutex);
+
+  AL_TLedgerEntry* pEntry = findEntry(pLedger, NULL);
+  uint32_t uCoreMask;
+  int const iCoreResources = divideRoundUp(iResources, iNumCore);
+  int const iMaxLoad = chooseCores(pLedger, iNumCore, &uCoreMask);
+
+  if(!pEntry)
+    eError = AL_ERR_CHAN_CREATION_NO_CHANNEL_AVAILABLE;
+  else if(iMaxLoad + iCoreResources > pLedger->iCoreResources)
+    eError = AL_ERR_CHAN_CREATION_RESOURCE_UNAVAILABLE;
+  else
+  {
+    pEntry->pOwner = pOwner;
+    pEntry->iCoreResources = iCoreResources;
+    pEntry->uCoreMask = uCoreMask;
+
+    for(int iCore = 0; iCore < pLedger->iNumCores; ++iCore)
+    {
+      if(uCoreMask & (1u << iCore))
+        pLedger->iCoreLoad[iCore] += iCoreResources;
+    }
+  }
+
+  Rtos_ReleaseMutex(pLedger->Mutex);
+  return eError;
+}
+
+/****************************************************************************/
+void AL_ResourceLedger_Release(AL_TResourceLedger* pLedger, void const* pOwner)
+{
+  if(!pOwner)
+    return;
+
+  Rtos_GetMutex(pLedger->Mutex);
+
+  AL_TLedgerEntry* pEntry = findEntry(pLedger, pOwner);
+
+  if(pEntry)
+  {
+    for(int iCore = 0; iCore < pLedger->iNumCores; ++iCore)
+    {
+      if(pEntry->uCoreMask & (1u << iCore))
+        pLedger->iCoreLoad[iCore] -= pEntry->iCoreResources;
+    }
+
+    Rtos_Memset(pEntry, 0, sizeof(*pEntry));
+  }
+
+  Rtos_ReleaseMutex(pLedger->Mutex);
+}
+
+/****************************************************************************/
+int AL_ResourceLedger_GetAvailableResources(AL_TResourceLedger* pLedger, int iNumCore)
+{
+  if(iNumCore < 1 || iNumCore > pLedger->iNumCores)
+    return 0;
+
+  Rtos_GetMutex(pLedger->Mutex);
+
+  uint32_t uCoreMask;
+  int const iMaxLoad = chooseCores(pLedger, iNumCore, &uCoreMask);
+  int const iAvailable = findEntry(pLedger, NULL) ? (pLedger->iCoreResources - iMaxLoad) * iNumCore : 0;
+
+  Rtos_ReleaseMutex(pLedger->Mutex);
+  return Max(iAvailable, 0);
+}
+
+/****************************************************************************/
+void AL_ResourceLedger_GetUtilization(AL_TResourceLedger* pLedger, AL_TResourceUtilization* pUtilization)
+{
+  Rtos_Memset(pUtilization, 0, sizeof(*pUtilization));
+
+  Rtos_GetMutex(pLedger->Mutex);
+
+  pUtilization->iNumCores = pLedger->iNumCores;
+  pUtilization->iCoreResources = pLedger->iCoreResources;
+
+  for(int iCore = 0; iCore < pLedger->iNumCores; ++iCore)
+  {
+    pUtilization->iCoreLoad[iCore] = pLedger->iCoreLoad[iCore];
+    pUtilization->iUsedResources += pLedger->iCoreLoad[iCore];
+  }
+
+  for(int i = 0; i < AL_LEDGER_MAX_CHANNELS; ++i)
+  {
+    if(pLedger->tEntries[i].pOwner)
+      ++pUtilization->iNumChannels;
+  }
+
+  Rtos_ReleaseMutex(pLedger->Mutex);
+}
+
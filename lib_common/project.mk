@@ -4,6 +4,7 @@ LIB_COMMON_SRC:=\
 	lib_common/BufCommon.c\
 	lib_common/AllocatorDefault.c\
 	lib_common/ChannelResources.c\
+	lib_common/ResourceLedger.c\
 	lib_common/MemDesc.c\
 	lib_common/HwScalingList.c\
 	lib_common/BufferAPI.c\
@@ -16,6 +17,7 @@ LIB_COMMON_SRC:=\
 	lib_common/StreamBuffer.c\
 	lib_common/FourCC.c\
 	lib_common/HardwareDriver.c\
+	lib_common/MemoryPlan.c\
 
 UNITTEST+=$(shell find lib_common/unittests -name "*.cpp")
 UNITTEST+=$(LIB_COMMON_SRC)
@@ -689,6 +689,21 @@ void AL_Settings_SetDefaultParam(AL_TEncSettings* pSettings)
 }
 
 
+/***************************************************************************/
+int AL_Settings_GetChannelResources(AL_TEncChanParam const* pChParam, int* pNumCore)
+{
+  uint32_t const uFrameRate = pChParam->tRCParam.uFrameRate * 1000;
+  *pNumCore = pChParam->uNumCore;
+
+  if(*pNumCore == NUMCORE_AUTO)
+  {
+    const int maximumResourcesForOneCore = GetCoreResources(ENCODER_CORE_FREQUENCY, ENCODER_CORE_FREQUENCY_MARGIN, ENCODER_CYCLES_FOR_BLK_32X32);
+    *pNumCore = ChoseCoresCount(pChParam->uWidth, pChParam->uHeight, uFrameRate, pChParam->tRCParam.uClkRatio, maximumResourcesForOneCore);
+  }
+
+  return GetResources(pChParam->uWidth, pChParam->uHeight, uFrameRate, pChParam->tRCParam.uClkRatio);
+}
+
 /***************************************************************************/
 int AL_Settings_CheckValidity(AL_TEncSettings* pSettings, AL_TEncChanParam* pChParam, FILE* pOut)
 {
@@ -1063,7 +1078,7 @@ int AL_Settings_CheckCoherency(AL_TEncSettings* pSettings, AL_TEncChanParam* pCh
   }
 
 
-  if((pSettings->eQpCtrlMode & MASK_QP_TABLE) == ROI_QP)
+  if((pSettings->eQpCtrlMode & MASK_QP_TABLE) == ROI_QP || (pSettings->eQpCtrlMode & MASK_QP_TABLE) == ADAPTIVE_QP)
     pSettings->eQpCtrlMode |= RELATIVE_QP;
 
   if(pSettings->eQpCtrlMode & (MASK_AUTO_QP | MASK_QP_TABLE))
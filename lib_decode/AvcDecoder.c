@@ -169,6 +169,20 @@ static bool isSPSCompatibleWithStreamSettings(AL_TAvcSps const* pSPS, AL_TStream
   return true;
 }
 
+/******************************************************************************/
+static AL_TStreamSettings getStreamSettings(AL_TAvcSps const* pSPS)
+{
+  AL_TStreamSettings tStreamSettings;
+  tStreamSettings.tDim.iWidth = (pSPS->pic_width_in_mbs_minus1 + 1) * 16;
+  tStreamSettings.tDim.iHeight = (pSPS->pic_height_in_map_units_minus1 + 1) * 16;
+  tStreamSettings.eChroma = (AL_EChromaMode)pSPS->chroma_format_idc;
+  tStreamSettings.iBitDepth = getMaxBitDepth(pSPS->profile_idc);
+  tStreamSettings.iLevel = pSPS->constraint_set3_flag ? 9 : pSPS->level_idc; /* We treat constraint set 3 as a level 9 */
+  tStreamSettings.iProfileIdc = pSPS->profile_idc;
+  tStreamSettings.eSequenceMode = AL_SM_PROGRESSIVE;
+  return tStreamSettings;
+}
+
 int AVC_GetMinOutputBuffersNeeded(int iDpbMaxBuf, int iStack);
 /******************************************************************************/
 static bool allocateBuffers(AL_TDecCtx* pCtx, AL_TAvcSps const* pSPS)
@@ -212,12 +226,7 @@ static bool allocateBuffers(AL_TDecCtx* pCtx, AL_TAvcSps const* pSPS)
   int iSizeYuv = AL_GetAllocSize_Frame(tSPSDim, eSPSChromaMode, iSPSMaxBitDepth, bEnableDisplayCompression, eDisplayStorageMode);
   const AL_TCropInfo tCropInfo = getCropInfo(pSPS);
 
-  pCtx->tStreamSettings.tDim = tSPSDim;
-  pCtx->tStreamSettings.eChroma = eSPSChromaMode;
-  pCtx->tStreamSettings.iBitDepth = iSPSMaxBitDepth;
-  pCtx->tStreamSettings.iLevel = pSPS->constraint_set3_flag ? 9 : pSPS->level_idc;
-  pCtx->tStreamSettings.iProfileIdc = pSPS->profile_idc;
-  pCtx->tStreamSettings.eSequenceMode = AL_SM_PROGRESSIVE;
+  pCtx->tStreamSettings = getStreamSettings(pSPS);
 
   pCtx->resolutionFoundCB.func(iMaxBuf, iSizeYuv, &pCtx->tStreamSettings, &tCropInfo, pCtx->resolutionFoundCB.userParam);
 
@@ -473,9 +482,32 @@ static bool constructRefPicList(AL_TAvcSliceHdr* pSlice, AL_TDecCtx* pCtx, TBuff
   return true;
 }
 
+/*****************************************************************************/
+static bool isDropped(AL_TDecCtx* pCtx, AL_ENut eNUT)
+{
+  switch(pCtx->eDropMode)
+  {
+  case AL_DROP_NON_KEY_FRAMES:
+    return eNUT != AL_AVC_NUT_VCL_IDR;
+  case AL_DROP_HIGH_TEMPORAL_LAYERS:
+  {
+    // non reference pictures can be removed from the stream without changing the
+    // frame_num and reference marking of the others
+    uint8_t const nal_ref_idc = (getNalHeaderByte(pCtx, 0) >> 5) & 0x03;
+    return pCtx->uMaxTemporalId == 0 && nal_ref_idc == 0;
+  }
+  default:
+    return false;
+  }
+}
+
 /*****************************************************************************/
 static void decodeSliceData(AL_TAup* pIAUP, AL_TDecCtx* pCtx, AL_ENut eNUT, bool bIsLastAUNal, int* iNumSlice)
 {
+  // the dropped pictures are skipped before their slice header updates the decoding context
+  if(isDropped(pCtx, eNUT))
+    return; // SkipNal();
+
   // Slice header deanti-emulation
   AL_TRbspParser rp;
   TCircBuffer* pBufStream = &pCtx->Stream;
@@ -538,7 +570,10 @@ static void decodeSliceData(AL_TAup* pIAUP, AL_TDecCtx* pCtx, AL_ENut eNUT, bool
     isValid = isSPSCompatibleWithStreamSettings(&pAUP->pSPS[spsid], &pCtx->tStreamSettings);
 
     if(!isValid)
+    {
       pAUP->pSPS[spsid].bConceal = true;
+      AL_ParamSetCache_Invalidate(&pCtx->tParamSetCache, AL_PARAM_SET_SPS, spsid);
+    }
   }
 
   if(isValid && !pSlice->first_mb_in_slice)
@@ -665,13 +700,19 @@ static bool isSliceData(AL_ENut nut)
   }
 }
 
-static AL_PARSE_RESULT parsePPSandUpdateConcealment(AL_TAup* aup, AL_TRbspParser* rp, AL_TDecCtx* pCtx)
+static void updatePPSConcealment(AL_TAup* aup, AL_TDecCtx* pCtx, int iPpsId)
 {
-  AL_PARSE_RESULT result = AL_AVC_ParsePPS(aup, rp);
+  if(iPpsId < 0 || iPpsId >= AL_AVC_MAX_PPS)
+    return;
 
-  if(!aup->avcAup.pPPS->bConceal)
+  if(!aup->avcAup.pPPS[iPpsId].bConceal)
     pCtx->tConceal.bHasPPS = true;
+}
 
+static AL_PARSE_RESULT parsePPSandUpdateConcealment(AL_TAup* aup, AL_TRbspParser* rp, AL_TDecCtx* pCtx, int* pPpsId)
+{
+  AL_PARSE_RESULT result = AL_AVC_ParsePPS(aup, rp, pPpsId);
+  updatePPSConcealment(aup, pCtx, *pPpsId);
   return result;
 }
 
@@ -691,6 +732,7 @@ void AL_AVC_DecodeOneNAL(AL_TAup* pAUP, AL_TDecCtx* pCtx, AL_ENut eNUT, bool bIs
   {
     AL_AVC_ParseSPS,
     parsePPSandUpdateConcealment,
+    updatePPSConcealment,
     NULL,
     AL_AVC_ParseSEI,
     decodeSliceData,
@@ -712,6 +754,26 @@ void AL_AVC_InitAUP(AL_TAvcAup* pAUP)
   pAUP->pActiveSPS = NULL;
 }
 
+/*****************************************************************************/
+bool AL_AVC_ProbeSPS(AL_TAup* pAUP, AL_TRbspParser* pRP, AL_TDecSettings const* pSettings, AL_TStreamProbe* pProbe)
+{
+  int iSpsId;
+
+  if(AL_AVC_ParseSPS(pAUP, pRP, &iSpsId) != AL_OK)
+    return false;
+
+  AL_TAvcSps const* pSPS = &pAUP->avcAup.pSPS[iSpsId];
+  AL_TStreamSettings const tStreamSettings = getStreamSettings(pSPS);
+  const int iDpbMaxBuf = AL_AVC_GetMaxDPBSize(tStreamSettings.iLevel, tStreamSettings.tDim.iWidth, tStreamSettings.tDim.iHeight, pSettings->eDpbMode);
+
+  pProbe->tStreamSettings = tStreamSettings;
+  pProbe->tCropInfo = getCropInfo(pSPS);
+  pProbe->iNumFrameBuffers = AVC_GetMinOutputBuffersNeeded(iDpbMaxBuf, pSettings->iStackSize);
+  pProbe->iFrameBufferSize = AL_GetAllocSize_Frame(tStreamSettings.tDim, tStreamSettings.eChroma, tStreamSettings.iBitDepth, pSettings->bFrameBufferCompression, pSettings->eFBStorageMode);
+
+  return true;
+}
+
 /*****************************************************************************/
 AL_ERR CreateAvcDecoder(AL_TDecoder** hDec, AL_TIDecChannel* pDecChannel, AL_TAllocator* pAllocator, AL_TDecSettings* pSettings, AL_TDecCallBacks* pCB)
 {
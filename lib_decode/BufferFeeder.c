@@ -43,11 +43,11 @@ static void notifyDecoder(AL_TBufferFeeder* this)
   AL_DecoderFeeder_Process(this->decoderFeeder);
 }
 
-static bool enqueueBuffer(AL_TBufferFeeder* this, AL_TBuffer* pBuf)
+static bool enqueueBuffer(AL_TBufferFeeder* this, AL_TBuffer* pBuf, uint32_t uWait)
 {
   AL_Buffer_Ref(pBuf);
 
-  if(!AL_Fifo_Queue(&this->fifo, pBuf, AL_WAIT_FOREVER))
+  if(!AL_Fifo_Queue(&this->fifo, pBuf, uWait))
   {
     AL_Buffer_Unref(pBuf);
     return false;
@@ -55,25 +55,30 @@ static bool enqueueBuffer(AL_TBufferFeeder* this, AL_TBuffer* pBuf)
   return true;
 }
 
-bool AL_BufferFeeder_PushBuffer(AL_TBufferFeeder* this, AL_TBuffer* pBuf, size_t uSize, bool bLastBuffer)
+AL_ERR AL_BufferFeeder_PushBuffer(AL_TBufferFeeder* this, AL_TBuffer* pBuf, size_t uSize, bool bLastBuffer, uint32_t uWait)
 {
   AL_TMetaData* pMetaCirc = (AL_TMetaData*)AL_CircMetaData_Create(0, uSize, bLastBuffer);
 
   if(!pMetaCirc)
-    return false;
+    return AL_ERR_NO_MEMORY;
 
   if(!AL_Buffer_AddMetaData(pBuf, pMetaCirc))
   {
     Rtos_Free(pMetaCirc);
-    return false;
+    return AL_ERR_NO_MEMORY;
   }
 
-  if(!enqueueBuffer(this, pBuf))
-    return false;
+  if(!enqueueBuffer(this, pBuf, uWait))
+  {
+    /* the buffer will be pushed again later */
+    AL_Buffer_RemoveMetaData(pBuf, pMetaCirc);
+    pMetaCirc->MetaDestroy(pMetaCirc);
+    return AL_WARN_INPUT_FULL;
+  }
 
   notifyDecoder(this);
 
-  return true;
+  return AL_SUCCESS;
 }
 
 /* called when the decoder has finished to decode a frame */
@@ -85,7 +90,7 @@ void AL_BufferFeeder_Signal(AL_TBufferFeeder* this)
 void AL_BufferFeeder_Flush(AL_TBufferFeeder* this)
 {
   if(this->eosBuffer)
-    AL_BufferFeeder_PushBuffer(this, this->eosBuffer, this->eosBuffer->zSize, true);
+    AL_BufferFeeder_PushBuffer(this, this->eosBuffer, this->eosBuffer->zSize, true, AL_WAIT_FOREVER);
 
   AL_DecoderFeeder_Flush(this->decoderFeeder);
 }
@@ -98,14 +103,14 @@ void AL_BufferFeeder_Reset(AL_TBufferFeeder* this)
 void AL_BufferFeeder_Destroy(AL_TBufferFeeder* this)
 {
   if(this->eosBuffer)
-    AL_BufferFeeder_PushBuffer(this, this->eosBuffer, this->eosBuffer->zSize, false);
+    AL_BufferFeeder_PushBuffer(this, this->eosBuffer, this->eosBuffer->zSize, false, AL_WAIT_FOREVER);
   AL_DecoderFeeder_Destroy(this->decoderFeeder);
   AL_Patchworker_Deinit(&this->patchworker);
   AL_Fifo_Deinit(&this->fifo);
   Rtos_Free(this);
 }
 
-AL_TBufferFeeder* AL_BufferFeeder_Create(AL_HANDLE hDec, TCircBuffer* circularBuf, int iMaxBufNum, AL_CB_Error* errorCallback)
+AL_TBufferFeeder* AL_BufferFeeder_Create(AL_HANDLE hDec, TCircBuffer* circularBuf, int iMaxBufNum, bool bDropOnOverflow, AL_TFeederPool* pPool, AL_CB_Error* errorCallback)
 {
   AL_TBufferFeeder* this = Rtos_Malloc(sizeof(*this));
 
@@ -120,7 +125,7 @@ AL_TBufferFeeder* AL_BufferFeeder_Create(AL_HANDLE hDec, TCircBuffer* circularBu
   if(!AL_Patchworker_Init(&this->patchworker, circularBuf, &this->fifo))
     goto fail_patchworker_allocation;
 
-  this->decoderFeeder = AL_DecoderFeeder_Create(&circularBuf->tMD, hDec, &this->patchworker, errorCallback);
+  this->decoderFeeder = AL_DecoderFeeder_Create(&circularBuf->tMD, hDec, &this->patchworker, bDropOnOverflow, pPool, errorCallback);
 
   if(!this->decoderFeeder)
     goto fail_decoder_feeder_creation;
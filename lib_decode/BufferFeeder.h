@@ -53,10 +53,10 @@ typedef struct al_t_BufferFeeder
   AL_TBuffer* eosBuffer;
 }AL_TBufferFeeder;
 
-AL_TBufferFeeder* AL_BufferFeeder_Create(AL_HANDLE hDec, TCircBuffer* circularBuf, int uMaxBufNum, AL_CB_Error* errorCallback);
+AL_TBufferFeeder* AL_BufferFeeder_Create(AL_HANDLE hDec, TCircBuffer* circularBuf, int uMaxBufNum, bool bDropOnOverflow, AL_TFeederPool* pPool, AL_CB_Error* errorCallback);
 void AL_BufferFeeder_Destroy(AL_TBufferFeeder* pFeeder);
-/* push a buffer in the queue. it will be fed to the decoder when possible */
-bool AL_BufferFeeder_PushBuffer(AL_TBufferFeeder* pFeeder, AL_TBuffer* pBuf, size_t uSize, bool bLastBuffer);
+/* push a buffer in the queue, waiting at most uWait ms for a free slot. it will be fed to the decoder when possible */
+AL_ERR AL_BufferFeeder_PushBuffer(AL_TBufferFeeder* pFeeder, AL_TBuffer* pBuf, size_t uSize, bool bLastBuffer, uint32_t uWait);
 /* tell the buffer queue that the decoder finished decoding a frame */
 void AL_BufferFeeder_Signal(AL_TBufferFeeder* pFeeder);
 /* After telling the feeder that EOS is coming, wait for the decoder to consume all the buffers */
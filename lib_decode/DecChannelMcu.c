@@ -37,6 +37,7 @@
 
 #include "lib_decode/I_DecChannel.h"
 #include "lib_common/IDriver.h"
+#include "lib_fpga/EventLoop.h"
 
 #if  __linux__
 
@@ -49,6 +50,7 @@
 #include "allegro_ioctl_mcu_dec.h"
 #include "lib_common/List.h"
 #include "lib_common/Error.h"
+#include "lib_perfs/Tracer.h"
 
 #define DCACHE_OFFSET 0x80000000
 
@@ -99,16 +101,21 @@ typedef struct
   AL_THREAD thread;
   bool bBeingDestroyed;
   AL_TDriver* driver;
+  AL_TEventLoop* eventLoop;
+  AL_EVENT ended; /* set once the fd has left the event loop */
 
   AL_CB_EndFrameDecoding endFrameDecodingCB;
 }Channel;
 
+struct DecChanMcuCtx;
+
 typedef struct
 {
   int fd;
   AL_CB_EndStartCode endStartCodeCB;
   bool bEnded;
   AL_TDriver* driver;
+  struct DecChanMcuCtx* decChanMcu;
 }SCMsg;
 
 typedef struct AL_t_Event
@@ -137,6 +144,10 @@ struct DecChanMcuCtx
   Channel chan;
   bool chanIsConfigured;
   AL_TDriver* driver;
+  AL_TEventLoop* eventLoop;
+  AL_WaitQueue ScDone;
+  int iNumScInFlight; /* start code searches watched by the event loop */
+  bool bBatchUnsupported;
 };
 
 int AL_EventQueue_Init(AL_EventQueue* pEventQueue)
@@ -201,14 +212,19 @@ static void setChannelMsg(struct al5_params* msg, const AL_TDecChanParam* pChPar
   Rtos_Memcpy(msg->opaque, pChParam, msg->size);
 }
 
-static bool getStatusMsg(Channel* chan, struct al5_params* msg)
+static AL_EDriverError waitStatusMsg(Channel* chan, struct al5_params* msg)
 {
-  bool bRet = AL_Driver_PostMessage(chan->driver, chan->fd, AL_MCU_WAIT_FOR_STATUS, msg) == DRIVER_SUCCESS;
+  AL_EDriverError const errdrv = AL_Driver_PostMessage(chan->driver, chan->fd, AL_MCU_WAIT_FOR_STATUS, msg);
 
-  if(!bRet && !chan->bBeingDestroyed)
+  if(errdrv != DRIVER_SUCCESS && !chan->bBeingDestroyed)
     perror("Failed to get decode status");
 
-  return bRet;
+  return errdrv;
+}
+
+static bool getStatusMsg(Channel* chan, struct al5_params* msg)
+{
+  return waitStatusMsg(chan, msg) == DRIVER_SUCCESS;
 }
 
 static bool getScStatusMsg(SCMsg* pMsg, struct al5_scstatus* StatusMsg)
@@ -220,13 +236,17 @@ static void processStatusMsg(Channel* chan, struct al5_params* msg)
 {
   AL_TDecPicStatus status;
   Rtos_Memcpy(&status, msg->opaque, msg->size);
+  AL_Trace_Begin("dec.end_frame_decoding", status.uFrmID);
   chan->endFrameDecodingCB.func(chan->endFrameDecodingCB.userParam, &status);
+  AL_Trace_End("dec.end_frame_decoding");
 }
 
 static void* NotificationThread(void* p)
 {
   Channel* chan = p;
 
+  AL_Trace_NameThread("notification");
+
   for(;;)
   {
     struct al5_params msg = { 0 };
@@ -240,6 +260,30 @@ static void* NotificationThread(void* p)
   return 0;
 }
 
+/* the fd is readable: AL_MCU_WAIT_FOR_STATUS won't block */
+static bool OnStatusReady(void* p)
+{
+  Channel* chan = p;
+  struct al5_params msg = { 0 };
+  AL_EDriverError const errdrv = waitStatusMsg(chan, &msg);
+
+  if(errdrv == DRIVER_SUCCESS)
+  {
+    processStatusMsg(chan, &msg);
+    return true;
+  }
+
+  /* once destroyed, the driver fails the wait when no status is left. Other
+   * errors don't end the channel: keep watching it */
+  return !chan->bBeingDestroyed && errdrv != DRIVER_ERROR_CHANNEL;
+}
+
+static void OnStatusEnded(void* p)
+{
+  Channel* chan = p;
+  Rtos_SetEvent(chan->ended);
+}
+
 static void setScStatus(AL_TScStatus* status, struct al5_scstatus* msg)
 {
   status->uNumSC = msg->num_sc;
@@ -251,7 +295,9 @@ static void processScStatusMsg(SCMsg* pMsg, struct al5_scstatus* StatusMsg)
   AL_TScStatus status;
 
   setScStatus(&status, StatusMsg);
+  AL_Trace_Begin("dec.end_start_code", status.uNumSC);
   pMsg->endStartCodeCB.func(pMsg->endStartCodeCB.userParam, &status);
+  AL_Trace_End("dec.end_start_code");
 }
 
 /* One reader, no race condition */
@@ -267,6 +313,8 @@ static void* ScNotificationThread(void* p)
   AL_EventQueue* pEventQueue = &pSCQueue->EventQueue;
   struct al5_scstatus StatusMsg = { 0 };
 
+  AL_Trace_NameThread("sc notification");
+
   while(true)
   {
     AL_Event* pEvent;
@@ -290,6 +338,51 @@ static void* ScNotificationThread(void* p)
   return NULL;
 }
 
+/* each start code search has its own fd, watched until its status arrives */
+static bool OnScStatusReady(void* p)
+{
+  SCMsg* pMsg = p;
+  struct al5_scstatus StatusMsg = { 0 };
+
+  if(getScStatusMsg(pMsg, &StatusMsg))
+    processScStatusMsg(pMsg, &StatusMsg);
+
+  return false;
+}
+
+static void ReleaseScMsg(void* p)
+{
+  SCMsg* pMsg = p;
+  struct DecChanMcuCtx* decChanMcu = pMsg->decChanMcu;
+
+  AL_Driver_Close(pMsg->driver, pMsg->fd);
+  Rtos_Free(pMsg);
+
+  pthread_mutex_lock(&decChanMcu->ScDone.Lock);
+  --decChanMcu->iNumScInFlight;
+  pthread_cond_broadcast(&decChanMcu->ScDone.Cond);
+  pthread_mutex_unlock(&decChanMcu->ScDone.Lock);
+}
+
+static bool isScIdle(void* p)
+{
+  struct DecChanMcuCtx* decChanMcu = p;
+  return decChanMcu->iNumScInFlight == 0;
+}
+
+static bool StartScNotificationThread(struct DecChanMcuCtx* decChanMcu)
+{
+  decChanMcu->pSCThread = Rtos_CreateThread(&ScNotificationThread, &decChanMcu->SCQueue);
+
+  if(!decChanMcu->pSCThread)
+  {
+    perror("Couldn't create thread");
+    return false;
+  }
+
+  return true;
+}
+
 /* Update some values of pChParam set by MCU */
 static void getParamUpdateByMcu(const struct al5_channel_status* msg, AL_TDecChanParam* pChParam)
 {
@@ -305,14 +398,19 @@ static bool DecChannelMcu_Init(struct DecChanMcuCtx* decChanMcu)
 {
   StartCodeEventQueue* SCQueue = &decChanMcu->SCQueue;
   decChanMcu->chanIsConfigured = false;
+  decChanMcu->pSCThread = NULL;
+  decChanMcu->iNumScInFlight = 0;
 
   AL_EventQueue_Init(&SCQueue->EventQueue);
+  AL_WaitQueue_Init(&decChanMcu->ScDone);
 
-  decChanMcu->pSCThread = Rtos_CreateThread(&ScNotificationThread, SCQueue);
+  /* the start code thread is only needed when the driver can't be polled */
+  decChanMcu->eventLoop = AL_EventLoop_GetShared();
 
-  if(!decChanMcu->pSCThread)
+  if(!decChanMcu->eventLoop && !StartScNotificationThread(decChanMcu))
   {
-    perror("Couldn't create thread");
+    AL_WaitQueue_Deinit(&decChanMcu->ScDone);
+    AL_EventQueue_Deinit(&SCQueue->EventQueue);
     return false;
   }
 
@@ -323,16 +421,26 @@ static void DecChannelMcu_DestroyChannel(Channel* chan)
 {
   chan->bBeingDestroyed = true;
 
-  if(AL_Driver_PostMessage(chan->driver, chan->fd, AL_MCU_DESTROY_CHANNEL, NULL) != DRIVER_SUCCESS)
-  {
+  bool const bDestroyed = AL_Driver_PostMessage(chan->driver, chan->fd, AL_MCU_DESTROY_CHANNEL, NULL) == DRIVER_SUCCESS;
+
+  if(!bDestroyed)
     perror("Failed to destroy channel");
-    goto exit;
-  }
 
-  Rtos_JoinThread(chan->thread);
-  Rtos_DeleteThread(chan->thread);
+  if(chan->eventLoop)
+  {
+    /* the statuses still queued in the driver are processed until it reports the end of the channel */
+    if(bDestroyed)
+      Rtos_WaitEvent(chan->ended, AL_WAIT_FOREVER);
+
+    AL_EventLoop_RemoveFd(chan->eventLoop, chan->fd);
+    Rtos_DeleteEvent(chan->ended);
+  }
+  else if(bDestroyed)
+  {
+    Rtos_JoinThread(chan->thread);
+    Rtos_DeleteThread(chan->thread);
+  }
 
-  exit:
   AL_Driver_Close(chan->driver, chan->fd);
 }
 
@@ -340,30 +448,42 @@ static void DecChannelMcu_Destroy(AL_TIDecChannel* pDecChannel)
 {
   struct DecChanMcuCtx* decChanMcu = (struct DecChanMcuCtx*)pDecChannel;
   StartCodeEventQueue* SCQueue = &decChanMcu->SCQueue;
+  AL_Event* pEvent = NULL;
 
-  AL_Event* pEvent = Rtos_Malloc(sizeof(*pEvent));
+  if(decChanMcu->pSCThread)
+  {
+    pEvent = Rtos_Malloc(sizeof(*pEvent));
 
-  if(!pEvent)
-    goto fail_event;
-  SCMsg* pMsg = Rtos_Malloc(sizeof(*pMsg));
+    if(!pEvent)
+      goto fail_event;
+    SCMsg* pMsg = Rtos_Malloc(sizeof(*pMsg));
 
-  if(!pMsg)
-    goto fail_msg;
+    if(!pMsg)
+      goto fail_msg;
 
-  pMsg->bEnded = true;
-  pMsg->driver = decChanMcu->driver;
-  pEvent->pPriv = pMsg;
-  AL_EventQueue_Push(&SCQueue->EventQueue, pEvent);
+    pMsg->bEnded = true;
+    pMsg->driver = decChanMcu->driver;
+    pEvent->pPriv = pMsg;
+    AL_EventQueue_Push(&SCQueue->EventQueue, pEvent);
+  }
 
   if(decChanMcu->chanIsConfigured)
     DecChannelMcu_DestroyChannel(&decChanMcu->chan);
 
-  if(!Rtos_JoinThread(decChanMcu->pSCThread))
-    goto fail_join;
+  /* their end callbacks use the decoder context */
+  AL_WaitEvent(&decChanMcu->ScDone, isScIdle, decChanMcu);
 
-  Rtos_DeleteThread(decChanMcu->pSCThread);
+  if(decChanMcu->pSCThread)
+  {
+    if(!Rtos_JoinThread(decChanMcu->pSCThread))
+      goto fail_join;
+
+    Rtos_DeleteThread(decChanMcu->pSCThread);
+  }
 
+  AL_WaitQueue_Deinit(&decChanMcu->ScDone);
   AL_EventQueue_Deinit(&SCQueue->EventQueue);
+  AL_EventLoop_ReleaseShared(decChanMcu->eventLoop);
 
   Rtos_Free(decChanMcu);
 
@@ -371,6 +491,7 @@ static void DecChannelMcu_Destroy(AL_TIDecChannel* pDecChannel)
 
   fail_join:
   AL_EventQueue_Deinit(&SCQueue->EventQueue);
+  return;
   fail_msg:
   Rtos_Free(pEvent);
   fail_event:
@@ -416,10 +537,24 @@ static AL_ERR DecChannelMcu_ConfigChannel(AL_TIDecChannel* pDecChannel, AL_TDecC
 
   getParamUpdateByMcu(&msg.status, pChParam);
 
-  chan->thread = Rtos_CreateThread(&NotificationThread, chan);
+  AL_CB_FdReady onStatusReady = { &OnStatusReady, &OnStatusEnded, chan };
+  chan->eventLoop = NULL;
+  chan->ended = decChanMcu->eventLoop ? Rtos_CreateEvent(false) : NULL;
 
-  if(!chan->thread)
-    goto fail_open;
+  /* fall back on a blocking thread when the driver can't be polled */
+  if(chan->ended && AL_EventLoop_AddFd(decChanMcu->eventLoop, chan->fd, onStatusReady))
+    chan->eventLoop = decChanMcu->eventLoop;
+  else
+  {
+    if(chan->ended)
+      Rtos_DeleteEvent(chan->ended);
+    chan->ended = NULL;
+
+    chan->thread = Rtos_CreateThread(&NotificationThread, chan);
+
+    if(!chan->thread)
+      goto fail_open;
+  }
 
   decChanMcu->chanIsConfigured = true;
   return AL_SUCCESS;
@@ -468,6 +603,7 @@ static void DecChannelMcu_SearchSC(AL_TIDecChannel* pDecChannel, AL_TScParam* pS
   pMsg->bEnded = false;
   pMsg->endStartCodeCB = endStartCodeCB;
   pMsg->driver = decChanMcu->driver;
+  pMsg->decChanMcu = decChanMcu;
   pMsg->fd = AL_Driver_Open(pMsg->driver, deviceFile);
 
   if(pMsg->fd < 0)
@@ -484,6 +620,29 @@ static void DecChannelMcu_SearchSC(AL_TIDecChannel* pDecChannel, AL_TScParam* pS
     goto fail_open;
   }
 
+  AL_CB_FdReady onScStatusReady = { &OnScStatusReady, &ReleaseScMsg, pMsg };
+
+  if(decChanMcu->eventLoop)
+  {
+    /* counted first: the status may come back before AddFd returns */
+    pthread_mutex_lock(&decChanMcu->ScDone.Lock);
+    ++decChanMcu->iNumScInFlight;
+    pthread_mutex_unlock(&decChanMcu->ScDone.Lock);
+
+    if(AL_EventLoop_AddFd(decChanMcu->eventLoop, pMsg->fd, onScStatusReady))
+    {
+      Rtos_Free(pEvent);
+      return;
+    }
+
+    pthread_mutex_lock(&decChanMcu->ScDone.Lock);
+    --decChanMcu->iNumScInFlight;
+    pthread_mutex_unlock(&decChanMcu->ScDone.Lock);
+  }
+
+  if(!decChanMcu->pSCThread && !StartScNotificationThread(decChanMcu))
+    goto fail_open;
+
   pEvent->pPriv = pMsg;
   AL_EventQueue_Push(pEventQueue, pEvent);
 
@@ -540,6 +699,45 @@ static void DecChannelMcu_DecodeOneSlice(AL_TIDecChannel* pDecChannel, AL_TDecPi
 }
 
 
+static void DecChannelMcu_DecodeSliceBatch(AL_TIDecChannel* pDecChannel, AL_TDecPicParam* pPictParam, AL_TDecPicBufferAddrs* pPictAddrs, TMemDesc* hSliceParam, int iNumSlices)
+{
+  struct DecChanMcuCtx* decChanMcu = (struct DecChanMcuCtx*)pDecChannel;
+  Channel* chan = &decChanMcu->chan;
+
+  if(chan == AL_INVALID_CHANNEL || chan == AL_UNINITIALIZED_CHANNEL)
+    return;
+
+  if(!decChanMcu->bBatchUnsupported)
+  {
+    struct al5_decode_batch_msg msg = { 0 };
+    setPictParam(&msg.params, pPictParam);
+    setPictBufferAddrs(&msg.addresses, pPictAddrs);
+    msg.slice_param_v = hSliceParam->uPhysicalAddr + DCACHE_OFFSET;
+    msg.num_slices = iNumSlices;
+
+    AL_EDriverError const errdrv = AL_Driver_PostMessage(decChanMcu->driver, chan->fd, AL_MCU_DECODE_SLICE_BATCH, &msg);
+
+    if(errdrv == DRIVER_SUCCESS)
+      return;
+
+    /* the driver doesn't know the batch request: send the slices one by one from now on */
+    if(errdrv == DRIVER_ERROR_NOT_SUPPORTED)
+      decChanMcu->bBatchUnsupported = true;
+    else
+      perror("Failed to decode slice batch");
+  }
+
+  /* the end of frame only comes once every slice has been sent */
+
+  for(int i = 0; i < iNumSlices; ++i)
+  {
+    TMemDesc tSliceParam = *hSliceParam;
+    tSliceParam.uPhysicalAddr += i * sizeof(AL_TDecSliceParam);
+    tSliceParam.pVirtualAddr += i * sizeof(AL_TDecSliceParam);
+    DecChannelMcu_DecodeOneSlice(pDecChannel, pPictParam, pPictAddrs, &tSliceParam);
+  }
+}
+
 static const AL_TIDecChannelVtable DecChannelMcu =
 {
   DecChannelMcu_Destroy,
@@ -547,6 +745,7 @@ static const AL_TIDecChannelVtable DecChannelMcu =
   DecChannelMcu_SearchSC,
   DecChannelMcu_DecodeOneFrame,
   DecChannelMcu_DecodeOneSlice,
+  DecChannelMcu_DecodeSliceBatch,
 };
 
 AL_TIDecChannel* AL_DecChannelMcu_Create(AL_TDriver* driver)
@@ -556,6 +755,7 @@ AL_TIDecChannel* AL_DecChannelMcu_Create(AL_TDriver* driver)
   if(!decChannel)
     return NULL;
   decChannel->vtable = &DecChannelMcu;
+  decChannel->bBatchUnsupported = false;
 
   if(!DecChannelMcu_Init(decChannel))
   {
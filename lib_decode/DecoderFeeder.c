@@ -40,6 +40,7 @@
 #include "lib_common/Error.h"
 #include "lib_common/Utils.h"
 #include "InternalError.h"
+#include "lib_perfs/Tracer.h"
 
 int AL_Decoder_GetStrOffset(AL_HANDLE hDec);
 UNIT_ERROR AL_Decoder_TryDecodeOneUnit(AL_HDecoder hDec, TCircBuffer* pBufStream);
@@ -56,16 +57,31 @@ typedef struct AL_TDecoderFeederS
   AL_EVENT incomingWorkEvent;
 
   AL_THREAD slave;
+  /* when the feeding runs on a pool instead of the slave thread */
+  AL_TFeederPool* pool;
+  AL_TPoolJob job;
   TCircBuffer decodeBuffer;
   int32_t keepGoing;
   bool stopped;
   bool endWithAccessUnit;
+  bool dropOnOverflow;
   AL_CB_Error errorCallback;
 }AL_TDecoderFeeder;
 
 /* Decoder Feeder Slave structure */
 typedef AL_TDecoderFeeder DecoderFeederSlave;
 
+/* decoding units per run on a feeder pool, before letting the other decoders run */
+#define POOL_UNITS_PER_RUN 1
+
+static void Slave_Signal(DecoderFeederSlave* slave)
+{
+  if(slave->pool)
+    AL_FeederPool_Schedule(slave->pool, &slave->job);
+  else
+    Rtos_SetEvent(slave->incomingWorkEvent);
+}
+
 static bool CircBuffer_IsFull(TCircBuffer* pBuf)
 {
   return pBuf->iAvailSize == (int32_t)pBuf->tMD.uSize;
@@ -78,7 +94,7 @@ static bool shouldKeepGoing(AL_TDecoderFeeder* slave)
   return keepGoing >= 0 || !slave->endWithAccessUnit;
 }
 
-static bool Slave_Process(DecoderFeederSlave* slave, TCircBuffer* decodeBuffer)
+static AL_ERR Slave_Process(DecoderFeederSlave* slave, TCircBuffer* decodeBuffer, int iMaxUnits)
 {
   AL_HANDLE hDec = slave->hDec;
 
@@ -89,7 +105,7 @@ static bool Slave_Process(DecoderFeederSlave* slave, TCircBuffer* decodeBuffer)
   size_t transferedBytes = AL_Patchworker_Transfer(slave->patchworker);
 
   if(transferedBytes)
-    Rtos_SetEvent(slave->incomingWorkEvent);
+    Slave_Signal(slave);
 
   decodeBuffer->iAvailSize += transferedBytes;
 
@@ -98,7 +114,9 @@ static bool Slave_Process(DecoderFeederSlave* slave, TCircBuffer* decodeBuffer)
 
   while(eErr != ERR_UNIT_NOT_FOUND && shouldKeepGoing(slave))
   {
+    AL_Trace_Begin("feeder.decode_unit", 0);
     eErr = AL_Decoder_TryDecodeOneUnit(hDec, decodeBuffer);
+    AL_Trace_End("feeder.decode_unit");
 
     if(eErr == ERR_ACCESS_UNIT_NONE)
       slave->endWithAccessUnit = true;
@@ -110,25 +128,40 @@ static bool Slave_Process(DecoderFeederSlave* slave, TCircBuffer* decodeBuffer)
       slave->stopped = false;
 
     if(eErr == ERR_UNIT_INVALID_CHANNEL)
-      return false;
+      return AL_ERROR;
+
+    // let the other decoders of the pool run, we'll be back for the next units
+    if(eErr != ERR_UNIT_NOT_FOUND && --iMaxUnits == 0)
+    {
+      Slave_Signal(slave);
+      return AL_SUCCESS;
+    }
   }
 
   if(CircBuffer_IsFull(slave->patchworker->outputCirc))
   {
+    AL_Trace_Begin("feeder.wait_frame_sent", 0);
     AL_Default_Decoder_WaitFrameSent(hDec);
+    AL_Trace_End("feeder.wait_frame_sent");
 
     uint32_t uNewOffset = AL_Decoder_GetStrOffset(hDec);
     CircBuffer_ConsumeUpToOffset(slave->patchworker->outputCirc, uNewOffset);
 
     if(CircBuffer_IsFull(slave->patchworker->outputCirc))
     {
-      // no more AU to get from a full circular buffer:
-      // empty it to avoid a stall
+      // no more AU to get from a full circular buffer: the pending unit is
+      // bigger than the buffer. Nothing will free some space, so either empty
+      // it and go on (low latency policy) or stop and report the overflow.
+      if(!slave->dropOnOverflow)
+      {
+        AL_Default_Decoder_ReleaseFrames(hDec);
+        return AL_ERR_STREAM_OVERFLOW;
+      }
       AL_Decoder_FlushInput(hDec);
     }
 
     AL_Default_Decoder_ReleaseFrames(hDec);
-    Rtos_SetEvent(slave->incomingWorkEvent);
+    Slave_Signal(slave);
   }
 
   // Leave when end of input [all the data were processed in the previous TryDecodeOneUnit]
@@ -138,34 +171,55 @@ static bool Slave_Process(DecoderFeederSlave* slave, TCircBuffer* decodeBuffer)
     slave->stopped = true;
   }
 
+  return AL_SUCCESS;
+}
+
+/* returns false when the slave is over */
+static bool Slave_Run(DecoderFeederSlave* slave, int iMaxUnits)
+{
+  if(!shouldKeepGoing(slave))
+  {
+    if(!slave->stopped)
+      AL_Decoder_InternalFlush(slave->hDec);
+    return false;
+  }
+
+  AL_Trace_Begin("feeder.process", 0);
+  AL_ERR eErr = Slave_Process(slave, &slave->decodeBuffer, iMaxUnits);
+  AL_Trace_End("feeder.process");
+
+  if(eErr != AL_SUCCESS)
+  {
+    slave->errorCallback.func(slave->errorCallback.userParam, eErr);
+    return false;
+  }
+
   return true;
 }
 
 static void Slave_EntryPoint(AL_TDecoderFeeder* slave)
 {
+  AL_Trace_NameThread("feeder");
+
   while(1)
   {
     Rtos_WaitEvent(slave->incomingWorkEvent, AL_WAIT_FOREVER);
 
-    if(!shouldKeepGoing(slave))
-    {
-      if(!slave->stopped)
-        AL_Decoder_InternalFlush(slave->hDec);
-      break;
-    }
-
-    bool bRet = Slave_Process(slave, &slave->decodeBuffer);
-
-    if(!bRet)
-    {
-      slave->errorCallback.func(slave->errorCallback.userParam);
+    if(!Slave_Run(slave, INT32_MAX))
       break; // exit thread
-    }
   }
 }
 
+static bool Slave_PoolRun(void* pParam)
+{
+  return Slave_Run((DecoderFeederSlave*)pParam, POOL_UNITS_PER_RUN);
+}
+
 static bool CreateSlave(AL_TDecoderFeeder* this)
 {
+  if(this->pool)
+    return AL_PoolJob_Init(&this->job, &Slave_PoolRun, this);
+
   this->slave = Rtos_CreateThread((void*)&Slave_EntryPoint, this);
 
   if(!this->slave)
@@ -175,6 +229,14 @@ static bool CreateSlave(AL_TDecoderFeeder* this)
 
 static void DestroySlave(AL_TDecoderFeeder* this)
 {
+  if(this->pool)
+  {
+    Rtos_AtomicDecrement(&this->keepGoing); /* Will be propagated to the slave */
+    Slave_Signal(this);
+    AL_PoolJob_Deinit(&this->job);
+    return;
+  }
+
   if(!this->slave)
     return;
 
@@ -196,13 +258,13 @@ void AL_DecoderFeeder_Destroy(AL_TDecoderFeeder* this)
 
 void AL_DecoderFeeder_Process(AL_TDecoderFeeder* this)
 {
-  Rtos_SetEvent(this->incomingWorkEvent);
+  Slave_Signal(this);
 }
 
 void AL_DecoderFeeder_Flush(AL_TDecoderFeeder* this)
 {
   AL_Patchworker_NotifyEndOfInput(this->patchworker);
-  Rtos_SetEvent(this->incomingWorkEvent);
+  Slave_Signal(this);
 }
 
 void AL_DecoderFeeder_Reset(AL_TDecoderFeeder* this)
@@ -211,7 +273,7 @@ void AL_DecoderFeeder_Reset(AL_TDecoderFeeder* this)
   CircBuffer_Init(&this->decodeBuffer);
 }
 
-AL_TDecoderFeeder* AL_DecoderFeeder_Create(TMemDesc* decodeMemoryDescriptor, AL_HANDLE hDec, AL_TPatchworker* patchworker, AL_CB_Error* errorCallback)
+AL_TDecoderFeeder* AL_DecoderFeeder_Create(TMemDesc* decodeMemoryDescriptor, AL_HANDLE hDec, AL_TPatchworker* patchworker, bool bDropOnOverflow, AL_TFeederPool* pPool, AL_CB_Error* errorCallback)
 {
   AL_TDecoderFeeder* this = Rtos_Malloc(sizeof(*this));
 
@@ -235,7 +297,10 @@ AL_TDecoderFeeder* AL_DecoderFeeder_Create(TMemDesc* decodeMemoryDescriptor, AL_
   this->keepGoing = 1;
   this->stopped = true;
   this->endWithAccessUnit = true;
+  this->dropOnOverflow = bDropOnOverflow;
   this->hDec = hDec;
+  this->slave = NULL;
+  this->pool = pPool;
 
   if(!CreateSlave(this))
     goto cleanup;
@@ -42,17 +42,20 @@
 
 #include "lib_decode/lib_decode.h"
 #include "Patchworker.h"
+#include "FeederPool.h"
 #include "lib_rtos/types.h"
 
 typedef struct
 {
-  void (* func)(void* pUserParam);
+  void (* func)(void* pUserParam, AL_ERR eError);
   void* userParam;
 }AL_CB_Error;
 
 typedef struct AL_TDecoderFeederS AL_TDecoderFeeder;
 
-AL_TDecoderFeeder* AL_DecoderFeeder_Create(TMemDesc* decodeMemoryDescriptor, AL_HANDLE hDec, AL_TPatchworker* patchworker, AL_CB_Error* errorCallback);
+/* bDropOnOverflow: empty the stream buffer when it is full of data that can't be decoded instead of stopping with AL_ERR_STREAM_OVERFLOW */
+/* pPool: run the feeding on this pool instead of a dedicated thread (can be NULL) */
+AL_TDecoderFeeder* AL_DecoderFeeder_Create(TMemDesc* decodeMemoryDescriptor, AL_HANDLE hDec, AL_TPatchworker* patchworker, bool bDropOnOverflow, AL_TFeederPool* pPool, AL_CB_Error* errorCallback);
 void AL_DecoderFeeder_Destroy(AL_TDecoderFeeder* pDecFeeder);
 /* push a buffer in the queue. it will be fed to the decoder when possible */
 void AL_DecoderFeeder_Process(AL_TDecoderFeeder* pDecFeeder);
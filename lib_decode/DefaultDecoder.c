@@ -56,6 +56,8 @@
 #include "lib_common/BufferSrcMeta.h"
 
 #include "lib_common/AvcLevelsLimit.h"
+#include "lib_perfs/PipelineStats.h"
+#include "lib_perfs/Tracer.h"
 
 #include "lib_parsing/I_PictMngr.h"
 #include "lib_decode/I_DecChannel.h"
@@ -63,6 +65,7 @@
 
 #define AVC_NAL_HDR_SIZE 4
 #define HEVC_NAL_HDR_SIZE 5
+#define NAL_LENGTH_SIZE 4 /* size of the big endian NAL size preceding each NAL of a length prefixed stream */
 
 /*****************************************************************************/
 static bool isAVC(AL_ECodec eCodec)
@@ -153,6 +156,40 @@ static int GetCircularBufferSize(bool isAvc, int iStack, AL_TStreamSettings tStr
   return RoundUp(bufferSize, bitstreamRequestSize);
 }
 
+/*****************************************************************************/
+static int GetMaxNumberOfSlices(bool isAvc)
+{
+  return isAvc ? Avc_GetMaxNumberOfSlices(122, 52, 1, 60, INT32_MAX) : 600; // TODO FIX
+}
+
+/*****************************************************************************/
+static int GetCompDataSize(bool isAvc, AL_TStreamSettings tStreamSettings)
+{
+  return isAvc ? AL_GetAllocSize_AvcCompData(tStreamSettings.tDim, tStreamSettings.eChroma) : AL_GetAllocSize_HevcCompData(tStreamSettings.tDim, tStreamSettings.eChroma);
+}
+
+/*****************************************************************************/
+static int GetMvSize(bool isAvc, AL_TStreamSettings tStreamSettings)
+{
+  return isAvc ? AL_GetAllocSize_AvcMV(tStreamSettings.tDim) : AL_GetAllocSize_HevcMV(tStreamSettings.tDim);
+}
+
+/*****************************************************************************/
+static int GetMaxDpbBuffers(bool isAvc, AL_TStreamSettings tStreamSettings, AL_EDpbMode eDpbMode)
+{
+  if(isAvc)
+    return AL_AVC_GetMaxDPBSize(tStreamSettings.iLevel, tStreamSettings.tDim.iWidth, tStreamSettings.tDim.iHeight, eDpbMode);
+  return AL_HEVC_GetMaxDPBSize(tStreamSettings.iLevel, tStreamSettings.tDim.iWidth, tStreamSettings.tDim.iHeight, eDpbMode);
+}
+
+/*****************************************************************************/
+static int GetNumMaxBuffers(bool isAvc, int iDpbMaxBuf, int iStack)
+{
+  int const iRecBuf = isAvc ? REC_BUF : 0;
+  int const iConcealBuf = CONCEAL_BUF;
+  return iDpbMaxBuf + iStack + iRecBuf + iConcealBuf;
+}
+
 /*****************************************************************************/
 static AL_TDecCtx* AL_sGetContext(AL_TDefaultDecoder* pDec)
 {
@@ -183,7 +220,10 @@ static void AL_sDecoder_CallDecode(AL_TDecCtx* pCtx, int iFrameID)
   AL_TBuffer* pDecodedFrame = AL_PictMngr_GetDisplayBufferFromID(&pCtx->PictMngr, iFrameID);
   assert(pDecodedFrame);
 
+  AL_PipelineStats_Checkpoint(AL_STAGE_DEC_FRAME_READY, (uintptr_t)pDecodedFrame);
+  AL_Trace_Begin("dec.end_decoding", iFrameID);
   pCtx->decodeCB.func(pDecodedFrame, pCtx->decodeCB.userParam);
+  AL_Trace_End("dec.end_decoding");
 }
 
 /*****************************************************************************/
@@ -199,7 +239,10 @@ static void AL_sDecoder_CallDisplay(AL_TDecCtx* pCtx)
 
     assert(AL_Buffer_GetData(pFrameToDisplay));
 
+    AL_Trace_Begin("dec.display", 0);
     pCtx->displayCB.func(pFrameToDisplay, &pInfo, pCtx->displayCB.userParam);
+    AL_Trace_End("dec.display");
+    AL_PipelineStats_Checkpoint(AL_STAGE_DEC_DISPLAYED, (uintptr_t)pFrameToDisplay);
     AL_PictMngr_SignalCallbackDisplayIsDone(&pCtx->PictMngr, pFrameToDisplay);
   }
 }
@@ -269,6 +312,7 @@ static void InitInternalBuffers(AL_TDecCtx* pCtx)
   for(int i = 0; i < MAX_STACK_SIZE; ++i)
   {
     MemDesc_Init(&pCtx->PoolSclLst[i].tMD);
+    pCtx->PoolSclStamp[i].iPpsId = -1;
     MemDesc_Init(&pCtx->PoolCompData[i].tMD);
     MemDesc_Init(&pCtx->PoolCompMap[i].tMD);
     MemDesc_Init(&pCtx->PoolSP[i].tMD);
@@ -351,6 +395,7 @@ void AL_Default_Decoder_Destroy(AL_TDecoder* pAbsDec)
   DeinitPictureManager(pCtx);
   MemDesc_Free(&pCtx->circularBuf.tMD);
   Rtos_Free(pCtx->BufNoAE.tMD.pVirtualAddr);
+  AL_ParamSetCache_Deinit(&pCtx->tParamSetCache);
   DeinitBuffers(pCtx);
 
   Rtos_DeleteSemaphore(pCtx->Sem);
@@ -631,6 +676,76 @@ static bool RefillStartCodes(AL_TDecCtx* pCtx, TCircBuffer* pBufStream)
   return pCtx->ScdStatus.uNumSC > 0;
 }
 
+/*****************************************************************************/
+static uint8_t GetNalUnitType(AL_ECodec eCodec, uint8_t uNalHdr)
+{
+  return isAVC(eCodec) ? (uNalHdr & 0x1F) : ((uNalHdr >> 1) & 0x3F);
+}
+
+/*****************************************************************************/
+static void SkipStream(TCircBuffer* pBufStream, uint32_t uNumBytes)
+{
+  pBufStream->iOffset = (pBufStream->iOffset + uNumBytes) % pBufStream->tMD.uSize;
+  pBufStream->iAvailSize -= uNumBytes;
+}
+
+/*****************************************************************************/
+static bool RefillLengthPrefixedNals(AL_TDecCtx* pCtx, TCircBuffer* pBufStream)
+{
+  uint8_t* pBuf = pBufStream->tMD.pVirtualAddr;
+  uint32_t const uSize = pBufStream->tMD.uSize;
+  AL_TNal* pTable = (AL_TNal*)pCtx->SCTable.tMD.pVirtualAddr;
+  int iNumNals = 0;
+
+  while(pBufStream->iAvailSize > NAL_LENGTH_SIZE && canStoreMoreStartCodes(pCtx))
+  {
+    uint32_t const uPos = pBufStream->iOffset;
+    uint32_t uNalSize = 0;
+
+    for(int i = 0; i < NAL_LENGTH_SIZE; ++i)
+      uNalSize = (uNalSize << 8) | pBuf[(uPos + i) % uSize];
+
+    if(uNalSize > uSize - NAL_LENGTH_SIZE)
+    {
+      // a corrupted size can't be resynchronized on: drop what was received
+      SkipStream(pBufStream, pBufStream->iAvailSize);
+      break;
+    }
+
+    if(uNalSize + NAL_LENGTH_SIZE > (uint32_t)pBufStream->iAvailSize)
+      break; // the end of the NAL isn't received yet
+
+    if(uNalSize)
+    {
+      // the NAL size is replaced by a 4 bytes start code, so that the NAL
+      // is seen as in an annex B stream by the parsing and the hardware
+      pBuf[uPos % uSize] = 0x00;
+      pBuf[(uPos + 1) % uSize] = 0x00;
+      pBuf[(uPos + 2) % uSize] = 0x00;
+      pBuf[(uPos + 3) % uSize] = 0x01;
+
+      AL_TNal* pNal = &pTable[pCtx->uNumSC++];
+      pNal->tStartCode.uPosition = (uPos + 1) % uSize;
+      pNal->tStartCode.uNUT = GetNalUnitType(pCtx->chanParam.eCodec, pBuf[(uPos + NAL_LENGTH_SIZE) % uSize]);
+      pNal->uSize = uNalSize + NAL_LENGTH_SIZE - 1; // from uPosition: 3 bytes of start code + the NAL
+      ++iNumNals;
+    }
+
+    SkipStream(pBufStream, uNalSize + NAL_LENGTH_SIZE);
+  }
+
+  return iNumNals > 0;
+}
+
+/*****************************************************************************/
+static bool RefillNals(AL_TDecCtx* pCtx, TCircBuffer* pBufStream)
+{
+  if(pCtx->bLengthPrefixed)
+    return RefillLengthPrefixedNals(pCtx, pBufStream);
+
+  return RefillStartCodes(pCtx, pBufStream);
+}
+
 /*****************************************************************************/
 static int FindNextDecodingUnit(AL_TDecCtx* pCtx, TCircBuffer* pBufStream, int* iLastVclNalInAU)
 {
@@ -645,10 +760,19 @@ static int FindNextDecodingUnit(AL_TDecCtx* pCtx, TCircBuffer* pBufStream, int*
       ResetStartCodes(pCtx);
     }
 
-    if(!RefillStartCodes(pCtx, pBufStream))
+    /* don't keep the queued slices waiting for the next start code search */
+    AL_FlushSliceDecoding(pCtx);
+
+    if(!RefillNals(pCtx, pBufStream))
       return 0;
   }
 
+  if(AL_PipelineStats_IsEnabled())
+  {
+    pCtx->uScPushUs = pCtx->uLastPushUs;
+    pCtx->uScFoundUs = Rtos_GetTimeUs();
+  }
+
   return iLastStartCodeIdx + 1;
 }
 
@@ -711,12 +835,30 @@ UNIT_ERROR AL_Default_Decoder_TryDecodeOneUnit(AL_TDecoder* pAbsDec, TCircBuffer
 }
 
 /*****************************************************************************/
-bool AL_Default_Decoder_PushBuffer(AL_TDecoder* pAbsDec, AL_TBuffer* pBuf, size_t uSize)
+AL_ERR AL_Default_Decoder_PushBuffer(AL_TDecoder* pAbsDec, AL_TBuffer* pBuf, size_t uSize, uint32_t uWait)
 {
   AL_TDefaultDecoder* pDec = (AL_TDefaultDecoder*)pAbsDec;
   AL_TDecCtx* pCtx = &pDec->ctx;
   bool bLastBuffer = false;
-  return AL_BufferFeeder_PushBuffer(pCtx->Feeder, pBuf, uSize, bLastBuffer);
+
+  /* a decoder stopped on error doesn't consume its input anymore */
+  Rtos_GetMutex(pCtx->DecMutex);
+  AL_ERR eErr = pCtx->error;
+  Rtos_ReleaseMutex(pCtx->DecMutex);
+
+  if(eErr != AL_SUCCESS && eErr != AL_WARN_CONCEAL_DETECT)
+    return eErr;
+
+  if(!AL_PipelineStats_IsEnabled())
+    return AL_BufferFeeder_PushBuffer(pCtx->Feeder, pBuf, uSize, bLastBuffer, uWait);
+
+  AL_PipelineStats_Start((uintptr_t)pBuf);
+  eErr = AL_BufferFeeder_PushBuffer(pCtx->Feeder, pBuf, uSize, bLastBuffer, uWait);
+  AL_PipelineStats_Checkpoint(AL_STAGE_DEC_PUSH_BUFFER, (uintptr_t)pBuf);
+  /* the input buffer is given back: the frames are tracked by their frame buffer from now on */
+  AL_PipelineStats_Stop((uintptr_t)pBuf);
+  pCtx->uLastPushUs = Rtos_GetTimeUs();
+  return eErr;
 }
 
 /*****************************************************************************/
@@ -757,6 +899,8 @@ void AL_Default_Decoder_FlushInput(AL_TDecoder* pAbsDec)
   pCtx->iCurOffset = 0;
   Rtos_ReleaseMutex(pCtx->DecMutex);
   AL_BufferFeeder_Reset(pCtx->Feeder);
+  // the parameter sets following a flush are parsed again
+  AL_ParamSetCache_Clear(&pCtx->tParamSetCache);
 }
 
 /*****************************************************************************/
@@ -867,20 +1011,19 @@ bool AL_Default_Decoder_PreallocateBuffers(AL_TDecoder* pAbsDec)
     return false;
   }
 
-  int const iSPSMaxSlices = isAVC(pCtx->chanParam.eCodec) ? Avc_GetMaxNumberOfSlices(122, 52, 1, 60, INT32_MAX) : 600; // TODO FIX
+  bool const bIsAvc = isAVC(pCtx->chanParam.eCodec);
+  int const iSPSMaxSlices = GetMaxNumberOfSlices(bIsAvc);
   int const iSizeWP = iSPSMaxSlices * WP_SLICE_SIZE;
   int const iSizeSP = iSPSMaxSlices * sizeof(AL_TDecSliceParam);
-  int const iSizeCompData = isAVC(pCtx->chanParam.eCodec) ? AL_GetAllocSize_AvcCompData(tStreamSettings.tDim, tStreamSettings.eChroma) : AL_GetAllocSize_HevcCompData(tStreamSettings.tDim, tStreamSettings.eChroma);
+  int const iSizeCompData = GetCompDataSize(bIsAvc, tStreamSettings);
   int const iSizeCompMap = AL_GetAllocSize_DecCompMap(tStreamSettings.tDim);
 
   if(!AL_Default_Decoder_AllocPool(pCtx, iSizeWP, iSizeSP, iSizeCompData, iSizeCompMap))
     goto fail_alloc;
 
-  int const iDpbMaxBuf = isAVC(pCtx->chanParam.eCodec) ? AL_AVC_GetMaxDPBSize(tStreamSettings.iLevel, tStreamSettings.tDim.iWidth, tStreamSettings.tDim.iHeight, pCtx->eDpbMode) : AL_HEVC_GetMaxDPBSize(tStreamSettings.iLevel, tStreamSettings.tDim.iWidth, tStreamSettings.tDim.iHeight, pCtx->eDpbMode);
-  int const iRecBuf = isAVC(pCtx->chanParam.eCodec) ? REC_BUF : 0;
-  int const iConcealBuf = CONCEAL_BUF;
-  int const iMaxBuf = iDpbMaxBuf + pCtx->iStackSize + iRecBuf + iConcealBuf;
-  int const iSizeMV = isAVC(pCtx->chanParam.eCodec) ? AL_GetAllocSize_AvcMV(tStreamSettings.tDim) : AL_GetAllocSize_HevcMV(tStreamSettings.tDim);
+  int const iDpbMaxBuf = GetMaxDpbBuffers(bIsAvc, tStreamSettings, pCtx->eDpbMode);
+  int const iMaxBuf = GetNumMaxBuffers(bIsAvc, iDpbMaxBuf, pCtx->iStackSize);
+  int const iSizeMV = GetMvSize(bIsAvc, tStreamSettings);
   int const iSizePOC = POCBUFF_PL_SIZE;
 
   if(!AL_Default_Decoder_AllocMv(pCtx, iSizeMV, iSizePOC, iMaxBuf))
@@ -910,6 +1053,53 @@ bool AL_Default_Decoder_PreallocateBuffers(AL_TDecoder* pAbsDec)
   return false;
 }
 
+/*****************************************************************************/
+bool AL_Decoder_GetMemoryPlan(AL_TDecSettings const* pSettings, AL_TMemoryPlan* pPlan)
+{
+  if(!pSettings || !pPlan)
+    return false;
+
+  if(pSettings->eCodec != AL_CODEC_AVC && pSettings->eCodec != AL_CODEC_HEVC)
+    return false;
+
+  AL_TStreamSettings const tStreamSettings = pSettings->tStream;
+
+  if(!IsAllStreamSettingsSet(tStreamSettings) || tStreamSettings.eSequenceMode == AL_SM_MAX_ENUM)
+    return false;
+
+  int const iStack = pSettings->iStackSize;
+
+  if((iStack < 1) || (iStack > MAX_STACK_SIZE))
+    return false;
+
+  bool const bIsAvc = isAVC(pSettings->eCodec);
+  int const iSPSMaxSlices = GetMaxNumberOfSlices(bIsAvc);
+  int const iMaxBuf = GetNumMaxBuffers(bIsAvc, GetMaxDpbBuffers(bIsAvc, tStreamSettings, pSettings->eDpbMode), iStack);
+
+  AL_MemoryPlan_Init(pPlan);
+
+  // allocated at the creation of the decoder
+  bool bRet = AL_MemoryPlan_Add(pPlan, "scd", AL_MEM_LIBRARY, SCD_SIZE, 1);
+  bRet = bRet && AL_MemoryPlan_Add(pPlan, "sctable", AL_MEM_LIBRARY, iStack * MAX_NAL_UNIT * sizeof(AL_TNal), 1);
+  bRet = bRet && AL_MemoryPlan_Add(pPlan, "reflist", AL_MEM_LIBRARY, REF_LIST_SIZE, iStack);
+  bRet = bRet && AL_MemoryPlan_Add(pPlan, "scllst", AL_MEM_LIBRARY, SCLST_SIZE_DEC, iStack);
+  bRet = bRet && AL_MemoryPlan_Add(pPlan, "circular stream", AL_MEM_LIBRARY, GetCircularBufferSize(bIsAvc, iStack, tStreamSettings), 1);
+
+  // allocated once the resolution is known
+  bRet = bRet && AL_MemoryPlan_Add(pPlan, "wp", AL_MEM_LIBRARY, iSPSMaxSlices * WP_SLICE_SIZE, iStack);
+  bRet = bRet && AL_MemoryPlan_Add(pPlan, "sp", AL_MEM_LIBRARY, iSPSMaxSlices * sizeof(AL_TDecSliceParam), iStack);
+  bRet = bRet && AL_MemoryPlan_Add(pPlan, "comp data", AL_MEM_LIBRARY, GetCompDataSize(bIsAvc, tStreamSettings), iStack);
+  bRet = bRet && AL_MemoryPlan_Add(pPlan, "comp map", AL_MEM_LIBRARY, AL_GetAllocSize_DecCompMap(tStreamSettings.tDim), iStack);
+  bRet = bRet && AL_MemoryPlan_Add(pPlan, "mv", AL_MEM_LIBRARY, GetMvSize(bIsAvc, tStreamSettings), iMaxBuf);
+  bRet = bRet && AL_MemoryPlan_Add(pPlan, "poc", AL_MEM_LIBRARY, POCBUFF_PL_SIZE, iMaxBuf);
+
+  // frame buffers requested by the resolution found callback
+  int const iSizeYuv = AL_GetAllocSize_Frame(tStreamSettings.tDim, tStreamSettings.eChroma, tStreamSettings.iBitDepth, pSettings->bFrameBufferCompression, pSettings->eFBStorageMode);
+  bRet = bRet && AL_MemoryPlan_Add(pPlan, "yuv", AL_MEM_APPLICATION, iSizeYuv, iMaxBuf);
+
+  return bRet;
+}
+
 /*****************************************************************************/
 static AL_TBuffer* AllocEosBufferHEVC()
 {
@@ -930,6 +1120,35 @@ static AL_TBuffer* AllocEosBufferAVC()
   return AL_Buffer_WrapData((uint8_t*)EOSNal, sizeof EOSNal, &AL_Buffer_Destroy);
 }
 
+/*****************************************************************************/
+static AL_TBuffer* AllocLengthPrefixedEosBufferHEVC()
+{
+  static const uint8_t EOSNal[] =
+  {
+    0, 0, 0, 3, 0x28, 0, 0x80, 0, 0, 0, 2, 0, 0
+  }; // simulate a new frame
+  return AL_Buffer_WrapData((uint8_t*)EOSNal, sizeof EOSNal, &AL_Buffer_Destroy);
+}
+
+/*****************************************************************************/
+static AL_TBuffer* AllocLengthPrefixedEosBufferAVC()
+{
+  static const uint8_t EOSNal[] =
+  {
+    0, 0, 0, 2, 0x01, 0x80, 0, 0, 0, 2, 0, 0
+  }; // simulate a new AU
+  return AL_Buffer_WrapData((uint8_t*)EOSNal, sizeof EOSNal, &AL_Buffer_Destroy);
+}
+
+/*****************************************************************************/
+static AL_TBuffer* AllocEosBuffer(AL_TDecCtx* pCtx)
+{
+  if(pCtx->bLengthPrefixed)
+    return isAVC(pCtx->chanParam.eCodec) ? AllocLengthPrefixedEosBufferAVC() : AllocLengthPrefixedEosBufferHEVC();
+
+  return isAVC(pCtx->chanParam.eCodec) ? AllocEosBufferAVC() : AllocEosBufferHEVC();
+}
+
 /*****************************************************************************/
 static bool CheckStreamSettings(AL_TStreamSettings tStreamSettings)
 {
@@ -975,6 +1194,9 @@ static bool CheckSettings(AL_TDecSettings* const pSettings)
   if(isSubframe(pSettings->eDecUnit) && pSettings->bParallelWPP)
     return false;
 
+  if(pSettings->eDropMode >= AL_DROP_MAX_ENUM)
+    return false;
+
   if(pSettings->eCodec == AL_CODEC_AVC)
   {
     if(!CheckAVCSettings(pSettings))
@@ -991,6 +1213,10 @@ static void AssignSettings(AL_TDecCtx* const pCtx, AL_TDecSettings const* const
   pCtx->bForceFrameRate = pSettings->bForceFrameRate;
   pCtx->eDpbMode = pSettings->eDpbMode;
   pCtx->tStreamSettings = pSettings->tStream;
+  pCtx->bLengthPrefixed = pSettings->bLengthPrefixed;
+  pCtx->eDropMode = pSettings->eDropMode;
+  pCtx->uMaxTemporalId = pSettings->uMaxTemporalId;
+  pCtx->bBatchSlices = pSettings->bBatchSlices;
 
   AL_TDecChanParam* pChan = &pCtx->chanParam;
   pChan->uMaxLatency = pSettings->iStackSize;
@@ -1031,10 +1257,18 @@ static void AssignCallBacks(AL_TDecCtx* const pCtx, AL_TDecCallBacks* pCB)
   pCtx->resolutionFoundCB = pCB->resolutionFoundCB;
 }
 
-static void errorHandler(void* pUserParam)
+static void errorHandler(void* pUserParam, AL_ERR eError)
 {
   AL_TDefaultDecoder* const pDec = (AL_TDefaultDecoder*)pUserParam;
   AL_TDecCtx* const pCtx = &pDec->ctx;
+
+  /* keep the first error, the feeder error can be a consequence of it */
+  Rtos_GetMutex(pCtx->DecMutex);
+
+  if(pCtx->error == AL_SUCCESS || pCtx->error == AL_WARN_CONCEAL_DETECT)
+    pCtx->error = eError;
+  Rtos_ReleaseMutex(pCtx->DecMutex);
+
   pCtx->decodeCB.func(NULL, pCtx->decodeCB.userParam);
 }
 
@@ -1110,6 +1344,8 @@ static void InitAUP(AL_TDecCtx* pCtx)
     AL_AVC_InitAUP(&pCtx->aup.avcAup);
   else
     AL_HEVC_InitAUP(&pCtx->aup.hevcAup);
+
+  AL_ParamSetCache_Init(&pCtx->tParamSetCache);
 }
 
 /*****************************************************************************/
@@ -1217,7 +1453,7 @@ AL_ERR AL_CreateDefaultDecoder(AL_TDecoder** hDec, AL_TIDecChannel* pDecChannel,
   if(!pCtx->BufNoAE.tMD.pVirtualAddr)
     goto cleanup;
 
-  pCtx->eosBuffer = isAVC(pCtx->chanParam.eCodec) ? AllocEosBufferAVC() : AllocEosBufferHEVC();
+  pCtx->eosBuffer = AllocEosBuffer(pCtx);
 
   if(!pCtx->eosBuffer)
     goto cleanup;
@@ -1235,7 +1471,7 @@ AL_ERR AL_CreateDefaultDecoder(AL_TDecoder** hDec, AL_TIDecChannel* pDecChannel,
   if(!MemDesc_AllocNamed(&pCtx->circularBuf.tMD, pAllocator, iBufferStreamSize, "circular stream"))
     goto cleanup;
 
-  pCtx->Feeder = AL_BufferFeeder_Create((AL_HDecoder)pDec, &pCtx->circularBuf, iInputFifoSize, &errorCallback);
+  pCtx->Feeder = AL_BufferFeeder_Create((AL_HDecoder)pDec, &pCtx->circularBuf, iInputFifoSize, pSettings->bDropOnStreamOverflow, (AL_TFeederPool*)pSettings->hFeederPool, &errorCallback);
 
   if(!pCtx->Feeder)
     goto cleanup;
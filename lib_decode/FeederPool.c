@@ -0,0 +1,311 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "FeederPool.h"
+#include "lib_perfs/Tracer.h"
+#include <assert.h>
+
+typedef struct
+{
+  AL_TFeederPool* pPool;
+  int iIndex;
+  AL_MUTEX hLock;
+  AL_TPoolJob* pHead;
+  AL_TPoolJob* pTail;
+  AL_THREAD hThread;
+}AL_TPoolWorker;
+
+struct AL_t_FeederPool
+{
+  /* one token per queued job: the worker that takes a token always finds a job */
+  AL_SEMAPHORE hPending;
+  int32_t iNextWorker;
+  bool bExit;
+  int iNumWorkers;
+  AL_TPoolWorker* pWorkers;
+};
+
+/****************************************************************************/
+bool AL_PoolJob_Init(AL_TPoolJob* pJob, bool (*pfnRun)(void* pParam), void* pParam)
+{
+  pJob->pfnRun = pfnRun;
+  pJob->pParam = pParam;
+  pJob->eState = AL_JOB_IDLE;
+  pJob->iWorker = -1;
+  pJob->pNext = NULL;
+  pJob->hLock = Rtos_CreateMutex();
+  pJob->hDone = Rtos_CreateEvent(false);
+
+  if(!pJob->hLock || !pJob->hDone)
+  {
+    Rtos_DeleteMutex(pJob->hLock);
+    Rtos_DeleteEvent(pJob->hDone);
+    return false;
+  }
+
+  return true;
+}
+
+void AL_PoolJob_Deinit(AL_TPoolJob* pJob)
+{
+  Rtos_WaitEvent(pJob->hDone, AL_WAIT_FOREVER);
+
+  /* the worker signals the end of the job with the lock held */
+  Rtos_GetMutex(pJob->hLock);
+  Rtos_ReleaseMutex(pJob->hLock);
+
+  Rtos_DeleteEvent(pJob->hDone);
+  Rtos_DeleteMutex(pJob->hLock);
+}
+
+/****************************************************************************/
+static void Enqueue(AL_TFeederPool* pPool, AL_TPoolJob* pJob)
+{
+  int iWorker = pJob->iWorker;
+
+  /* spread the new jobs, the others stay on the worker that ran them last */
+  if(iWorker < 0)
+    iWorker = (Rtos_AtomicIncrement(&pPool->iNextWorker) & 0x7FFFFFFF) % pPool->iNumWorkers;
+
+  AL_TPoolWorker* pWorker = &pPool->pWorkers[iWorker];
+
+  Rtos_GetMutex(pWorker->hLock);
+  pJob->pNext = NULL;
+
+  if(pWorker->pTail)
+    pWorker->pTail->pNext = pJob;
+  else
+    pWorker->pHead = pJob;
+  pWorker->pTail = pJob;
+  Rtos_ReleaseMutex(pWorker->hLock);
+
+  Rtos_ReleaseSemaphore(pPool->hPending);
+}
+
+static AL_TPoolJob* Dequeue(AL_TPoolWorker* pWorker)
+{
+  Rtos_GetMutex(pWorker->hLock);
+  AL_TPoolJob* pJob = pWorker->pHead;
+
+  if(pJob)
+  {
+    pWorker->pHead = pJob->pNext;
+
+    if(!pWorker->pHead)
+      pWorker->pTail = NULL;
+  }
+  Rtos_ReleaseMutex(pWorker->hLock);
+
+  return pJob;
+}
+
+/* own run queue first, then steal the oldest job of the other workers */
+static AL_TPoolJob* FindJob(AL_TPoolWorker* pWorker)
+{
+  AL_TFeederPool* pPool = pWorker->pPool;
+
+  /* the jobs are queued before their token is given: there is one for us */
+  for(int i = 0; i < pPool->iNumWorkers; ++i)
+  {
+    AL_TPoolJob* pJob = Dequeue(&pPool->pWorkers[(pWorker->iIndex + i) % pPool->iNumWorkers]);
+
+    if(pJob)
+      return pJob;
+  }
+
+  assert(0);
+  return NULL;
+}
+
+void AL_FeederPool_Schedule(AL_TFeederPool* pPool, AL_TPoolJob* pJob)
+{
+  bool bEnqueue = false;
+
+  Rtos_GetMutex(pJob->hLock);
+
+  if(pJob->eState == AL_JOB_IDLE)
+  {
+    pJob->eState = AL_JOB_QUEUED;
+    bEnqueue = true;
+  }
+  else if(pJob->eState == AL_JOB_RUNNING)
+    pJob->eState = AL_JOB_RERUN;
+  Rtos_ReleaseMutex(pJob->hLock);
+
+  if(bEnqueue)
+    Enqueue(pPool, pJob);
+}
+
+static void RunJob(AL_TPoolWorker* pWorker, AL_TPoolJob* pJob)
+{
+  Rtos_GetMutex(pJob->hLock);
+  pJob->eState = AL_JOB_RUNNING;
+  Rtos_ReleaseMutex(pJob->hLock);
+
+  bool bAlive = pJob->pfnRun(pJob->pParam);
+
+  Rtos_GetMutex(pJob->hLock);
+
+  if(!bAlive)
+  {
+    pJob->eState = AL_JOB_DONE;
+    Rtos_SetEvent(pJob->hDone);
+    Rtos_ReleaseMutex(pJob->hLock);
+    return;
+  }
+
+  /* a rescheduled job goes at the end of the queue: the other streams run first */
+  bool bRequeue = pJob->eState == AL_JOB_RERUN;
+  pJob->eState = bRequeue ? AL_JOB_QUEUED : AL_JOB_IDLE;
+  pJob->iWorker = pWorker->iIndex;
+  Rtos_ReleaseMutex(pJob->hLock);
+
+  if(bRequeue)
+    Enqueue(pWorker->pPool, pJob);
+}
+
+static void* Worker(void* p)
+{
+  AL_TPoolWorker* pWorker = p;
+  AL_TFeederPool* pPool = pWorker->pPool;
+
+  AL_Trace_NameThread("feeder pool");
+
+  for(;;)
+  {
+    Rtos_GetSemaphore(pPool->hPending, AL_WAIT_FOREVER);
+
+    if(pPool->bExit)
+      break;
+
+    AL_TPoolJob* pJob = FindJob(pWorker);
+
+    if(pJob)
+      RunJob(pWorker, pJob);
+  }
+
+  return NULL;
+}
+
+/****************************************************************************/
+static void DestroyWorkers(AL_TFeederPool* pPool, int iNumThreads)
+{
+  pPool->bExit = true;
+
+  for(int i = 0; i < iNumThreads; ++i)
+    Rtos_ReleaseSemaphore(pPool->hPending);
+
+  for(int i = 0; i < iNumThreads; ++i)
+  {
+    Rtos_JoinThread(pPool->pWorkers[i].hThread);
+    Rtos_DeleteThread(pPool->pWorkers[i].hThread);
+  }
+
+  for(int i = 0; i < pPool->iNumWorkers; ++i)
+    Rtos_DeleteMutex(pPool->pWorkers[i].hLock);
+}
+
+AL_HFeederPool AL_FeederPool_Create(int iNumThreads)
+{
+  if(iNumThreads <= 0)
+    return NULL;
+
+  AL_TFeederPool* pPool = Rtos_Malloc(sizeof(*pPool));
+
+  if(!pPool)
+    return NULL;
+
+  Rtos_Memset(pPool, 0, sizeof(*pPool));
+  pPool->iNumWorkers = iNumThreads;
+  pPool->hPending = Rtos_CreateSemaphore(0);
+  pPool->pWorkers = Rtos_Malloc(iNumThreads * sizeof(AL_TPoolWorker));
+
+  if(!pPool->hPending || !pPool->pWorkers)
+    goto fail_alloc;
+
+  Rtos_Memset(pPool->pWorkers, 0, iNumThreads * sizeof(AL_TPoolWorker));
+
+  for(int i = 0; i < iNumThreads; ++i)
+  {
+    AL_TPoolWorker* pWorker = &pPool->pWorkers[i];
+    pWorker->pPool = pPool;
+    pWorker->iIndex = i;
+    pWorker->hLock = Rtos_CreateMutex();
+
+    if(!pWorker->hLock)
+      goto fail_workers;
+  }
+
+  for(int i = 0; i < iNumThreads; ++i)
+  {
+    pPool->pWorkers[i].hThread = Rtos_CreateThread(&Worker, &pPool->pWorkers[i]);
+
+    if(!pPool->pWorkers[i].hThread)
+    {
+      DestroyWorkers(pPool, i);
+      goto fail_threads;
+    }
+  }
+
+  return pPool;
+
+  fail_workers:
+
+  for(int i = 0; i < iNumThreads; ++i)
+    Rtos_DeleteMutex(pPool->pWorkers[i].hLock);
+
+  fail_threads:
+  fail_alloc:
+  Rtos_Free(pPool->pWorkers);
+  Rtos_DeleteSemaphore(pPool->hPending);
+  Rtos_Free(pPool);
+  return NULL;
+}
+
+void AL_FeederPool_Destroy(AL_HFeederPool hPool)
+{
+  AL_TFeederPool* pPool = (AL_TFeederPool*)hPool;
+
+  if(!pPool)
+    return;
+
+  DestroyWorkers(pPool, pPool->iNumWorkers);
+  Rtos_Free(pPool->pWorkers);
+  Rtos_DeleteSemaphore(pPool->hPending);
+  Rtos_Free(pPool);
+}
+
@@ -0,0 +1,76 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include "lib_rtos/lib_rtos.h"
+#include "lib_decode/lib_decode.h"
+
+typedef struct AL_t_FeederPool AL_TFeederPool;
+
+typedef enum
+{
+  AL_JOB_IDLE, /* waits for AL_FeederPool_Schedule */
+  AL_JOB_QUEUED, /* in the run queue of a worker */
+  AL_JOB_RUNNING,
+  AL_JOB_RERUN, /* scheduled while running: goes back in a run queue after the run */
+  AL_JOB_DONE, /* never runs again */
+}AL_EPoolJobState;
+
+/*
+ * A job is the work of one decoder feeder. It is in at most one run queue, and
+ * runs on one worker at a time: the schedules received meanwhile are merged in
+ * one more run, as the wake up event of a dedicated feeder thread would do.
+ */
+typedef struct AL_t_PoolJob
+{
+  /* returns false when the job is over */
+  bool (* pfnRun)(void* pParam);
+  void* pParam;
+  AL_MUTEX hLock;
+  AL_EVENT hDone;
+  AL_EPoolJobState eState;
+  int iWorker; /* run queue of the job, -1 when it never ran */
+  struct AL_t_PoolJob* pNext;
+}AL_TPoolJob;
+
+bool AL_PoolJob_Init(AL_TPoolJob* pJob, bool (*pfnRun)(void* pParam), void* pParam);
+/* wait for the job to be over before releasing it */
+void AL_PoolJob_Deinit(AL_TPoolJob* pJob);
+
+void AL_FeederPool_Schedule(AL_TFeederPool* pPool, AL_TPoolJob* pJob);
+
@@ -261,6 +261,20 @@ static bool isSPSCompatibleWithStreamSettings(AL_THevcSps const* pSPS, AL_TStrea
   return true;
 }
 
+/*****************************************************************************/
+static AL_TStreamSettings getStreamSettings(AL_THevcSps const* pSPS)
+{
+  AL_TStreamSettings tStreamSettings;
+  tStreamSettings.tDim.iWidth = pSPS->pic_width_in_luma_samples;
+  tStreamSettings.tDim.iHeight = pSPS->pic_height_in_luma_samples;
+  tStreamSettings.eChroma = (AL_EChromaMode)pSPS->chroma_format_idc;
+  tStreamSettings.iBitDepth = getMaxBitDepth(pSPS->profile_and_level);
+  tStreamSettings.iLevel = pSPS->profile_and_level.general_level_idc / 3;
+  tStreamSettings.iProfileIdc = pSPS->profile_and_level.general_profile_idc;
+  tStreamSettings.eSequenceMode = getSequenceMode(pSPS);
+  return tStreamSettings;
+}
+
 int HEVC_GetMinOutputBuffersNeeded(int iDpbMaxBuf, int iStack);
 
 /*****************************************************************************/
@@ -302,12 +316,7 @@ static bool allocateBuffers(AL_TDecCtx* pCtx, AL_THevcSps const* pSPS)
   int iSizeYuv = AL_GetAllocSize_Frame(tSPSDim, eSPSChromaMode, iSPSMaxBitDepth, bEnableDisplayCompression, eDisplayStorageMode);
   const AL_TCropInfo tCropInfo = getCropInfo(pSPS);
 
-  pCtx->tStreamSettings.tDim = tSPSDim;
-  pCtx->tStreamSettings.eChroma = eSPSChromaMode;
-  pCtx->tStreamSettings.iBitDepth = iSPSMaxBitDepth;
-  pCtx->tStreamSettings.iLevel = iSPSLevel;
-  pCtx->tStreamSettings.iProfileIdc = pSPS->profile_and_level.general_profile_idc;
-  pCtx->tStreamSettings.eSequenceMode = getSequenceMode(pSPS);
+  pCtx->tStreamSettings = getStreamSettings(pSPS);
   assert(pCtx->tStreamSettings.eSequenceMode != AL_SM_MAX_ENUM);
 
   pCtx->resolutionFoundCB.func(iMaxBuf, iSizeYuv, &pCtx->tStreamSettings, &tCropInfo, pCtx->resolutionFoundCB.userParam);
@@ -579,17 +588,50 @@ static void finishPreviousFrame(AL_TDecCtx* pCtx)
   endFrame(pCtx, pSlice->nal_unit_type, pSlice, pPP, pSlice->pic_output_flag);
 }
 
+/*****************************************************************************/
+static bool isIRAP(AL_ENut eNUT)
+{
+  return AL_HEVC_IsCRA(eNUT) || AL_HEVC_IsBLA(eNUT) || AL_HEVC_IsIDR(eNUT) || eNUT == AL_HEVC_NUT_RSV_IRAP_VCL22 || eNUT == AL_HEVC_NUT_RSV_IRAP_VCL23;
+}
+
+/*****************************************************************************/
+static bool isDropped(AL_TDecCtx* pCtx, AL_ENut eNUT)
+{
+  switch(pCtx->eDropMode)
+  {
+  case AL_DROP_NON_KEY_FRAMES:
+    return !isIRAP(eNUT);
+  case AL_DROP_HIGH_TEMPORAL_LAYERS:
+  {
+    // a picture never references a picture of a higher temporal layer: those can
+    // only be in the RefPicSetStFoll / LtFoll lists, where missing pictures are allowed
+    int const iTemporalId = (getNalHeaderByte(pCtx, 1) & 0x07) - 1;
+    return iTemporalId > pCtx->uMaxTemporalId;
+  }
+  default:
+    return false;
+  }
+}
+
 /*****************************************************************************/
 static void decodeSliceData(AL_TAup* pIAUP, AL_TDecCtx* pCtx, AL_ENut eNUT, bool bIsLastAUNal, int* iNumSlice)
 {
+  // the dropped pictures are skipped before their slice header updates the decoding context
+  if(isDropped(pCtx, eNUT))
+    return; // SkipNal();
+
   // ignore RASL picture associated with an IRAP picture that has NoRaslOutputFlag = 1
   if(AL_HEVC_IsRASL(eNUT) && pCtx->uNoRaslOutputFlag)
     return; // SkipNal();
 
-  bool const bIsRAP = AL_HEVC_IsCRA(eNUT) || AL_HEVC_IsBLA(eNUT) || AL_HEVC_IsIDR(eNUT) || eNUT == AL_HEVC_NUT_RSV_IRAP_VCL22 || eNUT == AL_HEVC_NUT_RSV_IRAP_VCL23;// CRA, BLA IDR or RAP nal
+  bool const bIsRAP = isIRAP(eNUT); // CRA, BLA IDR or RAP nal
+
+  // when only the IRAP pictures are kept, the temporal id 0 pictures preceding a CRA
+  // are gone and its POC msb can't be derived from them: handle it as a BLA (HandleCraAsBlaFlag)
+  bool const bHandleCraAsBla = pCtx->eDropMode == AL_DROP_NON_KEY_FRAMES;
 
   if(bIsRAP)
-    pCtx->uNoRaslOutputFlag = (pCtx->bIsFirstPicture || pCtx->bLastIsEOS || AL_HEVC_IsBLA(eNUT) || AL_HEVC_IsIDR(eNUT)) ? 1 : 0;
+    pCtx->uNoRaslOutputFlag = (pCtx->bIsFirstPicture || pCtx->bLastIsEOS || AL_HEVC_IsBLA(eNUT) || AL_HEVC_IsIDR(eNUT) || bHandleCraAsBla) ? 1 : 0;
 
   TCircBuffer* pBufStream = &pCtx->Stream;
   // Slice header deanti-emulation
@@ -650,7 +692,10 @@ static void decodeSliceData(AL_TAup* pIAUP, AL_TDecCtx* pCtx, AL_ENut eNUT, bool
     isValid = isSPSCompatibleWithStreamSettings(&pAUP->pSPS[spsid], &pCtx->tStreamSettings);
 
     if(!isValid)
+    {
       pAUP->pSPS[spsid].bConceal = true;
+      AL_ParamSetCache_Invalidate(&pCtx->tParamSetCache, AL_PARAM_SET_SPS, spsid);
+    }
   }
 
   if(pSlice->first_slice_segment_in_pic_flag && *bFirstSliceInFrameIsValid)
@@ -682,7 +727,8 @@ static void decodeSliceData(AL_TAup* pIAUP, AL_TDecCtx* pCtx, AL_ENut eNUT, bool
     if(pSlice->first_slice_segment_in_pic_flag && !(*bBeginFrameIsValid))
     {
       bool bClearRef = (bIsRAP && pCtx->uNoRaslOutputFlag); // IRAP picture with NoRaslOutputFlag = 1
-      bool bNoOutputPrior = (AL_HEVC_IsCRA(eNUT) || ((AL_HEVC_IsIDR(eNUT) || AL_HEVC_IsBLA(eNUT)) && pSlice->no_output_of_prior_pics_flag));
+      // the previous key frames are still to be displayed when the CRA is only handled as a BLA
+      bool bNoOutputPrior = ((AL_HEVC_IsCRA(eNUT) && !bHandleCraAsBla) || ((AL_HEVC_IsIDR(eNUT) || AL_HEVC_IsBLA(eNUT)) && pSlice->no_output_of_prior_pics_flag));
 
       AL_HEVC_PictMngr_ClearDPB(&pCtx->PictMngr, pSlice->pSPS, bClearRef, bNoOutputPrior);
     }
@@ -811,15 +857,28 @@ static bool isSliceData(AL_ENut nut)
   }
 }
 
-static AL_PARSE_RESULT parsePPSandUpdateConcealment(AL_TAup* IAup, AL_TRbspParser* rp, AL_TDecCtx* pCtx)
+static void updatePPSConcealment(AL_TAup* IAup, AL_TDecCtx* pCtx, int iPpsId)
 {
   AL_THevcAup* aup = &IAup->hevcAup;
+
+  if(iPpsId < 0 || iPpsId >= AL_HEVC_MAX_PPS)
+    return;
+
+  if(!aup->pPPS[iPpsId].bConceal && pCtx->tConceal.iLastPPSId <= iPpsId)
+    pCtx->tConceal.iLastPPSId = iPpsId;
+}
+
+static AL_PARSE_RESULT parsePPSandUpdateConcealment(AL_TAup* IAup, AL_TRbspParser* rp, AL_TDecCtx* pCtx, int* pPpsId)
+{
   uint8_t LastPicId;
   AL_HEVC_ParsePPS(IAup, rp, &LastPicId);
 
-  if(!aup->pPPS[LastPicId].bConceal && pCtx->tConceal.iLastPPSId <= LastPicId)
-    pCtx->tConceal.iLastPPSId = LastPicId;
+  /* an out of range id was not stored: it must not be cached either */
+  if(LastPicId >= AL_HEVC_MAX_PPS)
+    return AL_UNSUPPORTED;
 
+  *pPpsId = LastPicId;
+  updatePPSConcealment(IAup, pCtx, LastPicId);
   return AL_OK;
 }
 
@@ -839,6 +898,7 @@ void AL_HEVC_DecodeOneNAL(AL_TAup* pAUP, AL_TDecCtx* pCtx, AL_ENut eNUT, bool bI
   {
     AL_HEVC_ParseSPS,
     parsePPSandUpdateConcealment,
+    updatePPSConcealment,
     ParseVPS,
     AL_HEVC_ParseSEI,
     decodeSliceData,
@@ -859,6 +919,26 @@ void AL_HEVC_InitAUP(AL_THevcAup* pAUP)
   pAUP->pActiveSPS = NULL;
 }
 
+/*****************************************************************************/
+bool AL_HEVC_ProbeSPS(AL_TAup* pAUP, AL_TRbspParser* pRP, AL_TDecSettings const* pSettings, AL_TStreamProbe* pProbe)
+{
+  int iSpsId;
+
+  if(AL_HEVC_ParseSPS(pAUP, pRP, &iSpsId) != AL_OK)
+    return false;
+
+  AL_THevcSps const* pSPS = &pAUP->hevcAup.pSPS[iSpsId];
+  AL_TStreamSettings const tStreamSettings = getStreamSettings(pSPS);
+  const int iDpbMaxBuf = AL_HEVC_GetMaxDPBSize(tStreamSettings.iLevel, tStreamSettings.tDim.iWidth, tStreamSettings.tDim.iHeight, pSettings->eDpbMode);
+
+  pProbe->tStreamSettings = tStreamSettings;
+  pProbe->tCropInfo = getCropInfo(pSPS);
+  pProbe->iNumFrameBuffers = HEVC_GetMinOutputBuffersNeeded(iDpbMaxBuf, pSettings->iStackSize);
+  pProbe->iFrameBufferSize = AL_GetAllocSize_Frame(tStreamSettings.tDim, tStreamSettings.eChroma, tStreamSettings.iBitDepth, pSettings->bFrameBufferCompression, pSettings->eFBStorageMode);
+
+  return true;
+}
+
 /*****************************************************************************/
 AL_ERR CreateHevcDecoder(AL_TDecoder** hDec, AL_TIDecChannel* pDecChannel, AL_TAllocator* pAllocator, AL_TDecSettings* pSettings, AL_TDecCallBacks* pCB)
 {
@@ -92,6 +92,7 @@ typedef struct AL_t_IDecChannelVtable
   void (* SearchSC)(AL_TIDecChannel* pDecChannel, AL_TScParam* pScParam, AL_TScBufferAddrs* pBufferAddrs, AL_CB_EndStartCode callback);
   void (* DecodeOneFrame)(AL_TIDecChannel* pDecChannel, AL_TDecPicParam* pPictParam, AL_TDecPicBufferAddrs* pPictAddrs, TMemDesc* pSliceParams);
   void (* DecodeOneSlice)(AL_TIDecChannel* pDecChannel, AL_TDecPicParam* pPictParam, AL_TDecPicBufferAddrs* pPictAddrs, TMemDesc* pSliceParams);
+  void (* DecodeSliceBatch)(AL_TIDecChannel* pDecChannel, AL_TDecPicParam* pPictParam, AL_TDecPicBufferAddrs* pPictAddrs, TMemDesc* pSliceParams, int iNumSlices);
 
 }AL_TIDecChannelVtable;
 
@@ -162,5 +163,21 @@ void AL_IDecChannel_DecodeOneSlice(AL_TIDecChannel* pThis, AL_TDecPicParam* pPic
   pThis->vtable->DecodeOneSlice(pThis, pPictParam, pPictAddrs, pSliceParams);
 }
 
+/*************************************************************************//*!
+   \brief Asks the scheduler to process several slices of the same frame
+   in one request
+   \param[in] pThis Decoder channel
+   \param[in] pPictParam  Pointer to the picture parameters structure
+   \param[in] pPictAddrs  Pointer to the picture buffers addresses
+   \param[in] pSliceParams Pointer to the first slice parameters. The other
+   slice parameters follow it in memory
+   \param[in] iNumSlices Number of slices to decode
+*****************************************************************************/
+static inline
+void AL_IDecChannel_DecodeSliceBatch(AL_TIDecChannel* pThis, AL_TDecPicParam* pPictParam, AL_TDecPicBufferAddrs* pPictAddrs, TMemDesc* pSliceParams, int iNumSlices)
+{
+  pThis->vtable->DecodeSliceBatch(pThis, pPictParam, pPictAddrs, pSliceParams, iNumSlices);
+}
+
 /*@}*/
 
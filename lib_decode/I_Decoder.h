@@ -54,7 +54,7 @@ typedef struct
 {
   void (* pfnDecoderDestroy)(AL_TDecoder* pDec);
   void (* pfnSetParam)(AL_TDecoder* pDec, bool bConceal, bool bUseBoard, int iFrmID, int iNumFrm);
-  bool (* pfnPushBuffer)(AL_TDecoder* pDec, AL_TBuffer* pBuf, size_t uSize);
+  AL_ERR (* pfnPushBuffer)(AL_TDecoder* pDec, AL_TBuffer* pBuf, size_t uSize, uint32_t uWait);
   void (* pfnFlush)(AL_TDecoder* pDec);
   void (* pfnPutDisplayPicture)(AL_TDecoder* pDec, AL_TBuffer* pDisplay);
   int (* pfnGetMaxBD)(AL_TDecoder* pDec);
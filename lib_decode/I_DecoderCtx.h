@@ -54,6 +54,7 @@
 #include "lib_decode/I_DecChannel.h"
 #include "lib_decode/lib_decode.h"
 #include "BufferFeeder.h"
+#include "ParamSetCache.h"
 
 typedef enum AL_e_ChanState
 {
@@ -62,6 +63,16 @@ typedef enum AL_e_ChanState
   CHAN_INVALID,
 }AL_EChanState;
 
+/*************************************************************************//*!
+   \brief Identifies the parameter sets a hardware scaling list was generated from
+*****************************************************************************/
+typedef struct
+{
+  int iPpsId; /* -1 when the buffer content is unknown */
+  uint32_t uSpsGen;
+  uint32_t uPpsGen;
+}AL_TSclLstStamp;
+
 /*************************************************************************//*!
    \brief Decoder Context structure
 *****************************************************************************/
@@ -96,6 +107,7 @@ typedef struct t_Dec_Ctx
 
   // decoder pool buffer
   TBuffer PoolSclLst[MAX_STACK_SIZE];      // Scaling List pool buffer
+  AL_TSclLstStamp PoolSclStamp[MAX_STACK_SIZE]; // parameter sets the scaling list pool buffers were written from
   TBuffer PoolCompData[MAX_STACK_SIZE];    // compressed MVDs + header + residuals pool buffer
   TBuffer PoolCompMap[MAX_STACK_SIZE];     // Compression map : LCU size + LCU offset pool buffer
   TBuffer PoolWP[MAX_STACK_SIZE];          // Weighted Pred Tables pool buffer
@@ -116,6 +128,10 @@ typedef struct t_Dec_Ctx
   bool bConceal;
   int iStackSize;
   bool bForceFrameRate;
+  bool bLengthPrefixed; // NALs are preceded by their size instead of a start code
+  AL_EDecDropMode eDropMode;
+  uint8_t uMaxTemporalId;
+  bool bBatchSlices; // the pending slices are sent in one request (see AL_FlushSliceDecoding)
 
   // Trace stuff
   int iTraceFirstFrame;
@@ -147,6 +163,16 @@ typedef struct t_Dec_Ctx
   TBufferMV MV;            // Motion Vector buffer
   AL_TRecBuffers pRecs;    // Reconstructed buffers
 
+  // slices waiting to be sent in one request (subframe latency)
+  uint16_t uFirstPendingSlice;
+  uint16_t uNumPendingSlices;
+  uint16_t uPendingToggle;
+
+  // pipeline checkpoints of the frame being decoded (see lib_perfs/PipelineStats.h)
+  uint64_t uLastPushUs;
+  uint64_t uScPushUs;
+  uint64_t uScFoundUs;
+
   // decoder counters
   uint16_t uToggle;
   int iNumFrmBlk1;
@@ -155,6 +181,7 @@ typedef struct t_Dec_Ctx
   // reference frames and dpb manager
   AL_TPictMngrCtx PictMngr;
   AL_TAup aup;
+  AL_TParamSetCache tParamSetCache; // NALs of the parameter sets stored in aup
   union
   {
     AL_TAvcSliceHdr AvcSliceHdr[2]; // Slice header
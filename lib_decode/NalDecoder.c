@@ -54,20 +54,43 @@ void AL_DecodeOneNal(AL_NonVclNuts nuts, AL_NalParser parser, AL_TAup* pAUP, AL_
 
   if(nut == nuts.sps)
   {
-    AL_TRbspParser rp = getParserOnNonVclNal(pCtx);
-    parser.parseSps(pAUP, &rp);
+    AL_TParamSetKey tKey;
+
+    if(!AL_ParamSetCache_Find(&pCtx->tParamSetCache, AL_PARAM_SET_SPS, &pCtx->Stream, &tKey))
+    {
+      AL_TRbspParser rp = getParserOnNonVclNal(pCtx);
+      int iSpsId = -1;
+      parser.parseSps(pAUP, &rp, &iSpsId);
+      AL_ParamSetCache_Store(&pCtx->tParamSetCache, AL_PARAM_SET_SPS, iSpsId, &pCtx->Stream, &tKey);
+    }
   }
 
   if(nut == nuts.pps)
   {
-    AL_TRbspParser rp = getParserOnNonVclNal(pCtx);
-    parser.parsePps(pAUP, &rp, pCtx);
+    AL_TParamSetKey tKey;
+
+    if(AL_ParamSetCache_Find(&pCtx->tParamSetCache, AL_PARAM_SET_PPS, &pCtx->Stream, &tKey))
+      parser.updatePps(pAUP, pCtx, tKey.iId);
+    else
+    {
+      AL_TRbspParser rp = getParserOnNonVclNal(pCtx);
+      int iPpsId = -1;
+      parser.parsePps(pAUP, &rp, pCtx, &iPpsId);
+      AL_ParamSetCache_Store(&pCtx->tParamSetCache, AL_PARAM_SET_PPS, iPpsId, &pCtx->Stream, &tKey);
+    }
   }
 
   if(nut == nuts.vps && parser.parseVps)
   {
-    AL_TRbspParser rp = getParserOnNonVclNal(pCtx);
-    parser.parseVps(pAUP, &rp);
+    AL_TParamSetKey tKey;
+
+    if(!AL_ParamSetCache_Find(&pCtx->tParamSetCache, AL_PARAM_SET_VPS, &pCtx->Stream, &tKey))
+    {
+      AL_TRbspParser rp = getParserOnNonVclNal(pCtx);
+      int iVpsId = -1;
+      parser.parseVps(pAUP, &rp, &iVpsId);
+      AL_ParamSetCache_Store(&pCtx->tParamSetCache, AL_PARAM_SET_VPS, iVpsId, &pCtx->Stream, &tKey);
+    }
   }
 
   if(nut == nuts.eos)
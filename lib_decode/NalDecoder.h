@@ -49,9 +49,12 @@ typedef struct
 
 typedef struct
 {
-  AL_PARSE_RESULT (* parseSps)(AL_TAup*, AL_TRbspParser*);
-  AL_PARSE_RESULT (* parsePps)(AL_TAup*, AL_TRbspParser*, AL_TDecCtx*);
-  void (* parseVps)(AL_TAup*, AL_TRbspParser*);
+  /* the parameter set parsers give the id of the table entry they wrote, if any */
+  AL_PARSE_RESULT (* parseSps)(AL_TAup*, AL_TRbspParser*, int*);
+  AL_PARSE_RESULT (* parsePps)(AL_TAup*, AL_TRbspParser*, AL_TDecCtx*, int*);
+  /* what parsePps does to the decoding context, for a PPS found in the cache */
+  void (* updatePps)(AL_TAup*, AL_TDecCtx*, int);
+  void (* parseVps)(AL_TAup*, AL_TRbspParser*, int*);
   bool (* parseSei)(AL_TAup*, AL_TRbspParser*);
   void (* decodeSliceData)(AL_TAup*, AL_TDecCtx*, AL_ENut, bool, int*);
   bool (* isSliceData)(AL_ENut nut);
@@ -207,6 +207,14 @@ bool SkipNal()
   return false;
 }
 
+/*****************************************************************************/
+uint8_t getNalHeaderByte(AL_TDecCtx const* pCtx, int iByte)
+{
+  TCircBuffer const* pBufStream = &pCtx->Stream;
+  uint32_t const uStartCodeSize = 3;
+  return pBufStream->tMD.pVirtualAddr[(pBufStream->iOffset + uStartCodeSize + iByte) % pBufStream->tMD.uSize];
+}
+
 /*****************************************************************************/
 AL_TRbspParser getParserOnNonVclNal(AL_TDecCtx* pCtx)
 {
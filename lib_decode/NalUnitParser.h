@@ -53,6 +53,8 @@
 #include "lib_parsing/AvcParser.h"
 #include "lib_parsing/HevcParser.h"
 
+#include "lib_decode/lib_decode.h"
+
 typedef struct t_Dec_Ctx AL_TDecCtx;
 
 void UpdateContextAtEndOfFrame(AL_TDecCtx* pCtx);
@@ -60,5 +62,8 @@ void UpdateContextAtEndOfFrame(AL_TDecCtx* pCtx);
 void AL_AVC_DecodeOneNAL(AL_TAup* pAUP, AL_TDecCtx* pCtx, AL_ENut eNUT, bool bIsLastAUNal, int* iNumSlice);
 void AL_HEVC_DecodeOneNAL(AL_TAup* pAUP, AL_TDecCtx* pCtx, AL_ENut eNUT, bool bIsLastAUNal, int* iNumSlice);
 
+bool AL_AVC_ProbeSPS(AL_TAup* pAUP, AL_TRbspParser* pRP, AL_TDecSettings const* pSettings, AL_TStreamProbe* pProbe);
+bool AL_HEVC_ProbeSPS(AL_TAup* pAUP, AL_TRbspParser* pRP, AL_TDecSettings const* pSettings, AL_TStreamProbe* pProbe);
+
 /*@}*/
 
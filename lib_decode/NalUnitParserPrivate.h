@@ -42,3 +42,6 @@ bool SkipNal();
 
 AL_TRbspParser getParserOnNonVclNal(AL_TDecCtx* pCtx);
 
+/* byte of the header of the current NAL, following its start code */
+uint8_t getNalHeaderByte(AL_TDecCtx const* pCtx, int iByte);
+
@@ -0,0 +1,191 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "ParamSetCache.h"
+#include "lib_common/Utils.h"
+
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+
+/*****************************************************************************/
+void AL_ParamSetCache_Init(AL_TParamSetCache* pCache)
+{
+  Rtos_Memset(pCache, 0, sizeof(*pCache));
+}
+
+/*****************************************************************************/
+void AL_ParamSetCache_Deinit(AL_TParamSetCache* pCache)
+{
+  for(int iKind = 0; iKind < AL_PARAM_SET_MAX_ENUM; ++iKind)
+  {
+    for(int iId = 0; iId < AL_PARAM_SET_CACHE_MAX_ID; ++iId)
+      Rtos_Free(pCache->tEntries[iKind][iId].pNal);
+  }
+
+  AL_ParamSetCache_Init(pCache);
+}
+
+/*****************************************************************************/
+void AL_ParamSetCache_Clear(AL_TParamSetCache* pCache)
+{
+  for(int iKind = 0; iKind < AL_PARAM_SET_MAX_ENUM; ++iKind)
+  {
+    for(int iId = 0; iId < AL_PARAM_SET_CACHE_MAX_ID; ++iId)
+      pCache->tEntries[iKind][iId].uSize = 0;
+
+    ++pCache->uGen[iKind];
+  }
+}
+
+/*****************************************************************************/
+/* the NAL may wrap around the end of the circular buffer */
+static void GetSegments(TCircBuffer const* pStream, uint8_t const** pSeg, uint32_t* uSegSize)
+{
+  uint32_t uBufSize = pStream->tMD.uSize;
+  uint32_t uOffset = (uint32_t)pStream->iOffset % uBufSize;
+  uint32_t uSize = (uint32_t)pStream->iAvailSize;
+
+  pSeg[0] = pStream->tMD.pVirtualAddr + uOffset;
+  uSegSize[0] = UnsignedMin(uSize, uBufSize - uOffset);
+  pSeg[1] = pStream->tMD.pVirtualAddr;
+  uSegSize[1] = uSize - uSegSize[0];
+}
+
+/*****************************************************************************/
+static uint64_t HashNal(uint8_t const** pSeg, uint32_t const* uSegSize)
+{
+  uint64_t uHash = FNV_OFFSET_BASIS;
+
+  for(int iSeg = 0; iSeg < 2; ++iSeg)
+  {
+    for(uint32_t i = 0; i < uSegSize[iSeg]; ++i)
+    {
+      uHash ^= pSeg[iSeg][i];
+      uHash *= FNV_PRIME;
+    }
+  }
+
+  return uHash;
+}
+
+/*****************************************************************************/
+static uint32_t GetParentGen(AL_TParamSetCache const* pCache, AL_EParamSetKind eKind)
+{
+  return eKind == AL_PARAM_SET_VPS ? 0 : pCache->uGen[eKind - 1];
+}
+
+/*****************************************************************************/
+bool AL_ParamSetCache_Find(AL_TParamSetCache* pCache, AL_EParamSetKind eKind, TCircBuffer const* pStream, AL_TParamSetKey* pKey)
+{
+  pKey->uHash = 0;
+  pKey->uSize = 0;
+  pKey->iId = -1;
+
+  if(pStream->iAvailSize <= 0 || pStream->iAvailSize > AL_PARAM_SET_CACHE_MAX_NAL_SIZE)
+    return false;
+
+  uint8_t const* pSeg[2];
+  uint32_t uSegSize[2];
+  GetSegments(pStream, pSeg, uSegSize);
+
+  pKey->uHash = HashNal(pSeg, uSegSize);
+  pKey->uSize = pStream->iAvailSize;
+
+  uint32_t uParentGen = GetParentGen(pCache, eKind);
+
+  for(int iId = 0; iId < AL_PARAM_SET_CACHE_MAX_ID; ++iId)
+  {
+    AL_TParamSetCacheEntry const* pEntry = &pCache->tEntries[eKind][iId];
+
+    if(pEntry->uSize != pKey->uSize || pEntry->uHash != pKey->uHash || pEntry->uParentGen != uParentGen)
+      continue;
+
+    if(Rtos_Memcmp(pEntry->pNal, pSeg[0], uSegSize[0]) == 0 &&
+       Rtos_Memcmp(pEntry->pNal + uSegSize[0], pSeg[1], uSegSize[1]) == 0)
+    {
+      pKey->iId = iId;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/*****************************************************************************/
+void AL_ParamSetCache_Store(AL_TParamSetCache* pCache, AL_EParamSetKind eKind, int iId, TCircBuffer const* pStream, AL_TParamSetKey const* pKey)
+{
+  if(iId < 0 || iId >= AL_PARAM_SET_CACHE_MAX_ID)
+    return;
+
+  AL_ParamSetCache_Invalidate(pCache, eKind, iId);
+
+  if(pKey->uSize == 0)
+    return;
+
+  AL_TParamSetCacheEntry* pEntry = &pCache->tEntries[eKind][iId];
+
+  if(pEntry->uCapacity < pKey->uSize)
+  {
+    Rtos_Free(pEntry->pNal);
+    pEntry->pNal = (uint8_t*)Rtos_Malloc(pKey->uSize);
+    pEntry->uCapacity = pEntry->pNal ? pKey->uSize : 0;
+
+    if(!pEntry->pNal)
+      return;
+  }
+
+  uint8_t const* pSeg[2];
+  uint32_t uSegSize[2];
+  GetSegments(pStream, pSeg, uSegSize);
+
+  Rtos_Memcpy(pEntry->pNal, pSeg[0], uSegSize[0]);
+  Rtos_Memcpy(pEntry->pNal + uSegSize[0], pSeg[1], uSegSize[1]);
+  pEntry->uHash = pKey->uHash;
+  pEntry->uSize = pKey->uSize;
+  pEntry->uParentGen = GetParentGen(pCache, eKind);
+}
+
+/*****************************************************************************/
+void AL_ParamSetCache_Invalidate(AL_TParamSetCache* pCache, AL_EParamSetKind eKind, int iId)
+{
+  if(iId < 0 || iId >= AL_PARAM_SET_CACHE_MAX_ID)
+    return;
+
+  pCache->tEntries[eKind][iId].uSize = 0;
+  ++pCache->uGen[eKind];
+}
+
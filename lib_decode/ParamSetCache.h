@@ -0,0 +1,134 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+/****************************************************************************
+   -----------------------------------------------------------------------------
+ **************************************************************************//*!
+   \addtogroup lib_decode_hls
+   @{
+   \file
+ *****************************************************************************/
+
+#pragma once
+
+#include "lib_rtos/lib_rtos.h"
+#include "lib_common/BufCommonInternal.h"
+
+#define AL_PARAM_SET_CACHE_MAX_ID 256
+/* parameter set NALs bigger than this are parsed each time */
+#define AL_PARAM_SET_CACHE_MAX_NAL_SIZE 1024
+
+typedef enum
+{
+  AL_PARAM_SET_VPS,
+  AL_PARAM_SET_SPS,
+  AL_PARAM_SET_PPS,
+  AL_PARAM_SET_MAX_ENUM,
+}AL_EParamSetKind;
+
+/*************************************************************************//*!
+   \brief Raw bytes of the NAL which produced a stored parameter set
+*****************************************************************************/
+typedef struct
+{
+  uint64_t uHash;
+  uint32_t uSize; /* 0 when no parameter set of this id is known */
+  uint32_t uParentGen; /* generation of the parent kind at parse time */
+  uint8_t* pNal;
+  uint32_t uCapacity;
+}AL_TParamSetCacheEntry;
+
+/*************************************************************************//*!
+   \brief Remembers the NAL bytes of the parameter sets stored in the access
+   unit tables, so a repeated parameter set is recognized without being parsed.
+   A PPS is parsed against its SPS (and a SPS against its VPS): the entries of
+   a kind are only reused while no parameter set of the parent kind changed.
+*****************************************************************************/
+typedef struct
+{
+  AL_TParamSetCacheEntry tEntries[AL_PARAM_SET_MAX_ENUM][AL_PARAM_SET_CACHE_MAX_ID];
+  uint32_t uGen[AL_PARAM_SET_MAX_ENUM]; /* bumped each time a stored parameter set of the kind changes */
+}AL_TParamSetCache;
+
+/*************************************************************************//*!
+   \brief Raw NAL of the parameter set being decoded
+*****************************************************************************/
+typedef struct
+{
+  uint64_t uHash;
+  uint32_t uSize;
+  int iId; /* id of the stored parameter set parsed from the same bytes, when found */
+}AL_TParamSetKey;
+
+void AL_ParamSetCache_Init(AL_TParamSetCache* pCache);
+void AL_ParamSetCache_Deinit(AL_TParamSetCache* pCache);
+
+/*************************************************************************//*!
+   \brief Forgets every stored NAL. The next parameter sets are parsed again.
+*****************************************************************************/
+void AL_ParamSetCache_Clear(AL_TParamSetCache* pCache);
+
+/*************************************************************************//*!
+   \brief Looks for the parameter set NAL located in the stream buffer
+   \param[in]  pCache  Pointer to the parameter set cache
+   \param[in]  eKind   Kind of the parameter set
+   \param[in]  pStream Stream buffer, the NAL spans iAvailSize bytes from iOffset
+   \param[out] pKey    Receives the key of the NAL, to be given to AL_ParamSetCache_Store,
+   and the id of the matching parameter set on success
+   \return true if the parameter set stored for some id was parsed from the
+   same bytes and parsing the NAL again would not change it
+*****************************************************************************/
+bool AL_ParamSetCache_Find(AL_TParamSetCache* pCache, AL_EParamSetKind eKind, TCircBuffer const* pStream, AL_TParamSetKey* pKey);
+
+/*************************************************************************//*!
+   \brief Records the NAL which has just been parsed into the parameter set iId
+   \param[in] pCache  Pointer to the parameter set cache
+   \param[in] eKind   Kind of the parameter set
+   \param[in] iId     Id of the parameter set written by the parser, -1 if the
+   parser did not write any
+   \param[in] pStream Stream buffer holding the NAL
+   \param[in] pKey    Key filled by AL_ParamSetCache_Find
+*****************************************************************************/
+void AL_ParamSetCache_Store(AL_TParamSetCache* pCache, AL_EParamSetKind eKind, int iId, TCircBuffer const* pStream, AL_TParamSetKey const* pKey);
+
+/*************************************************************************//*!
+   \brief Forgets the NAL of a parameter set which was modified outside of its parsing
+*****************************************************************************/
+void AL_ParamSetCache_Invalidate(AL_TParamSetCache* pCache, AL_EParamSetKind eKind, int iId);
+
+/*@}*/
+
@@ -56,6 +56,7 @@
 #include "lib_parsing/Hevc_PictMngr.h"
 
 #include "lib_decode/I_DecChannel.h"
+#include "lib_perfs/PipelineStats.h"
 #include "I_DecoderCtx.h"
 #include "FrameParam.h"
 
@@ -134,9 +135,9 @@ static void AL_sSaveNalStreamBlk1(AL_TDecCtx* pCtx)
 }
 
 /*****************************************************************************/
-static AL_TDecPicBufferAddrs AL_SetBufferAddrs(AL_TDecCtx* pCtx)
+static AL_TDecPicBufferAddrs AL_SetBufferAddrs(AL_TDecCtx* pCtx, uint16_t uToggle)
 {
-  AL_TDecPicBuffers* pPictBuffers = &pCtx->PoolPB[pCtx->uToggle];
+  AL_TDecPicBuffers* pPictBuffers = &pCtx->PoolPB[uToggle];
   AL_TDecPicBufferAddrs BufAddrs;
 
   BufAddrs.pCompData = pPictBuffers->tCompData.tMD.uPhysicalAddr;
@@ -172,33 +173,87 @@ static void UpdateStreamOffset(AL_TDecCtx* pCtx)
 }
 
 /*****************************************************************************/
-void AL_LaunchSliceDecoding(AL_TDecCtx* pCtx, bool bIsLastAUNal)
+static TMemDesc AL_sGetSliceParam(AL_TDecCtx* pCtx, uint16_t uToggle, uint16_t uSliceID)
+{
+  AL_TDecSliceParam* pSP_v = &(((AL_TDecSliceParam*)pCtx->PoolSP[uToggle].tMD.pVirtualAddr)[uSliceID]);
+  AL_PADDR pSP_p = (AL_PADDR)(uintptr_t)&(((AL_TDecSliceParam*)(uintptr_t)pCtx->PoolSP[uToggle].tMD.uPhysicalAddr)[uSliceID]);
+  TMemDesc tSP;
+  tSP.pVirtualAddr = (AL_VADDR)pSP_v;
+  tSP.uPhysicalAddr = pSP_p;
+  return tSP;
+}
+
+/*****************************************************************************/
+void AL_FlushSliceDecoding(AL_TDecCtx* pCtx)
+{
+  if(!pCtx->uNumPendingSlices)
+    return;
+
+  uint16_t uToggle = pCtx->uPendingToggle;
+  AL_TDecPicBufferAddrs BufAddrs = AL_SetBufferAddrs(pCtx, uToggle);
+  TMemDesc tFirstSP = AL_sGetSliceParam(pCtx, uToggle, pCtx->uFirstPendingSlice);
+
+  if(pCtx->uNumPendingSlices == 1)
+    AL_IDecChannel_DecodeOneSlice(pCtx->pDecChannel, &pCtx->PoolPP[uToggle], &BufAddrs, &tFirstSP);
+  else
+    AL_IDecChannel_DecodeSliceBatch(pCtx->pDecChannel, &pCtx->PoolPP[uToggle], &BufAddrs, &tFirstSP, pCtx->uNumPendingSlices);
+
+  pCtx->uNumPendingSlices = 0;
+}
+
+/*****************************************************************************/
+static void AL_sQueueSlice(AL_TDecCtx* pCtx, uint16_t uSliceID)
+{
+  bool bFollowsPending = (pCtx->uPendingToggle == pCtx->uToggle) && (pCtx->uFirstPendingSlice + pCtx->uNumPendingSlices == uSliceID);
+
+  if(pCtx->uNumPendingSlices && !bFollowsPending)
+    AL_FlushSliceDecoding(pCtx);
+
+  if(!pCtx->uNumPendingSlices)
+  {
+    pCtx->uFirstPendingSlice = uSliceID;
+    pCtx->uPendingToggle = pCtx->uToggle;
+  }
+
+  ++pCtx->uNumPendingSlices;
+
+  if(!pCtx->bBatchSlices)
+    AL_FlushSliceDecoding(pCtx);
+}
+
+/*****************************************************************************/
+static void AL_sCheckpointLaunch(AL_TDecCtx* pCtx)
 {
-  AL_TDecPicBufferAddrs BufAddrs = AL_SetBufferAddrs(pCtx);
+  if(!AL_PipelineStats_IsEnabled())
+    return;
+
+  /* the frame buffer is the key of the frame until it is displayed */
+  uint64_t uKey = (uintptr_t)AL_PictMngr_GetDisplayBufferFromID(&pCtx->PictMngr, pCtx->PoolPP[pCtx->uToggle].FrmID);
+  AL_PipelineStats_StartAt(uKey, pCtx->uScPushUs ? pCtx->uScPushUs : pCtx->uScFoundUs);
+  AL_PipelineStats_CheckpointAt(AL_STAGE_DEC_START_CODE, uKey, pCtx->uScFoundUs);
+  AL_PipelineStats_Checkpoint(AL_STAGE_DEC_LAUNCH, uKey);
+}
 
+/*****************************************************************************/
+void AL_LaunchSliceDecoding(AL_TDecCtx* pCtx, bool bIsLastAUNal)
+{
   uint16_t uSliceID = pCtx->PictMngr.uNumSlice - 1;
 
 
   UpdateStreamOffset(pCtx);
 
+  if(uSliceID == 0)
+    AL_sCheckpointLaunch(pCtx);
+
+  /* With bBatchSlices, the slices are only queued here. They are sent together when the
+   * access unit is complete or before waiting for more start codes (see AL_FlushSliceDecoding) */
   if(uSliceID)
-  {
-    AL_TDecSliceParam* pPrevSP_v = &(((AL_TDecSliceParam*)pCtx->PoolSP[pCtx->uToggle].tMD.pVirtualAddr)[uSliceID - 1]);
-    AL_PADDR pPrevSP_p = (AL_PADDR)(uintptr_t)&(((AL_TDecSliceParam*)(uintptr_t)pCtx->PoolSP[pCtx->uToggle].tMD.uPhysicalAddr)[uSliceID - 1]);
-    TMemDesc pPrevSP;
-    pPrevSP.pVirtualAddr = (AL_VADDR)pPrevSP_v;
-    pPrevSP.uPhysicalAddr = pPrevSP_p;
-    AL_IDecChannel_DecodeOneSlice(pCtx->pDecChannel, &pCtx->PoolPP[pCtx->uToggle], &BufAddrs, &pPrevSP);
-  }
+    AL_sQueueSlice(pCtx, uSliceID - 1);
 
   if(bIsLastAUNal)
   {
-    AL_TDecSliceParam* pSP_v = &(((AL_TDecSliceParam*)pCtx->PoolSP[pCtx->uToggle].tMD.pVirtualAddr)[uSliceID]);
-    AL_PADDR pSP_p = (AL_PADDR)(uintptr_t)&(((AL_TDecSliceParam*)(uintptr_t)pCtx->PoolSP[pCtx->uToggle].tMD.uPhysicalAddr)[uSliceID]);
-    TMemDesc pSP;
-    pSP.pVirtualAddr = (AL_VADDR)pSP_v;
-    pSP.uPhysicalAddr = pSP_p;
-    AL_IDecChannel_DecodeOneSlice(pCtx->pDecChannel, &pCtx->PoolPP[pCtx->uToggle], &BufAddrs, &pSP);
+    AL_sQueueSlice(pCtx, uSliceID);
+    AL_FlushSliceDecoding(pCtx);
 
     pCtx->uCurTileID = 0;
 
@@ -212,11 +267,12 @@ void AL_LaunchSliceDecoding(AL_TDecCtx* pCtx, bool bIsLastAUNal)
 /*****************************************************************************/
 void AL_LaunchFrameDecoding(AL_TDecCtx* pCtx)
 {
-  AL_TDecPicBufferAddrs BufAddrs = AL_SetBufferAddrs(pCtx);
+  AL_TDecPicBufferAddrs BufAddrs = AL_SetBufferAddrs(pCtx, pCtx->uToggle);
 
 
   UpdateStreamOffset(pCtx);
 
+  AL_sCheckpointLaunch(pCtx);
   AL_IDecChannel_DecodeOneFrame(pCtx->pDecChannel, &pCtx->PoolPP[pCtx->uToggle], &BufAddrs, &pCtx->PoolSP[pCtx->uToggle].tMD);
 
   pCtx->uCurTileID = 0;
@@ -324,6 +380,31 @@ void AL_TerminatePreviousCommand(AL_TDecCtx* pCtx, AL_TDecPicParam* pPP, AL_TDec
   }
 }
 
+/*****************************************************************************/
+/* The scaling list buffer of the current toggle still holds the list generated
+ * from the same, unchanged, parameter sets: it does not need to be written again */
+static bool isSclLstUpToDate(AL_TDecCtx* pCtx, int iPpsId, bool bIsValid)
+{
+  AL_TSclLstStamp* pStamp = &pCtx->PoolSclStamp[pCtx->uToggle];
+  AL_TParamSetCache const* pCache = &pCtx->tParamSetCache;
+
+  if(!bIsValid)
+  {
+    pStamp->iPpsId = -1;
+    return false;
+  }
+
+  if(pStamp->iPpsId == iPpsId &&
+     pStamp->uSpsGen == pCache->uGen[AL_PARAM_SET_SPS] &&
+     pStamp->uPpsGen == pCache->uGen[AL_PARAM_SET_PPS])
+    return true;
+
+  pStamp->iPpsId = iPpsId;
+  pStamp->uSpsGen = pCache->uGen[AL_PARAM_SET_SPS];
+  pStamp->uPpsGen = pCache->uGen[AL_PARAM_SET_PPS];
+  return false;
+}
+
 /*****************************************************************************/
 void AL_AVC_PrepareCommand(AL_TDecCtx* pCtx, AL_TScl* pSCL, AL_TDecPicParam* pPP, AL_TDecPicBuffers* pBufs, AL_TDecSliceParam* pSP, AL_TAvcSliceHdr* pSlice, bool bIsLastVclNalInAU, bool bIsValid)
 {
@@ -345,7 +426,7 @@ void AL_AVC_PrepareCommand(AL_TDecCtx* pCtx, AL_TScl* pSCL, AL_TDecPicParam* pPP
     if(pSP->FirstLcuSliceSegment && pSP->eSliceType == SLICE_I)
       pSP->ColocPicID = pPrevSP->ColocPicID;
 
-    if(!pSlice->first_mb_in_slice)
+    if(!pSlice->first_mb_in_slice && !isSclLstUpToDate(pCtx, pSlice->pic_parameter_set_id, bIsValid))
       AL_AVC_WriteDecHwScalingList((AL_TScl const*)pSCL, pBufs->tScl.tMD.pVirtualAddr);
     AL_AVC_PictMngr_GetBuffers(&pCtx->PictMngr, pPP, pSP, pSlice, &pCtx->ListRef, &pBufs->tListVirtRef, &pBufs->tListRef, &pCtx->POC, &pCtx->MV, &pBufs->tWP, &pCtx->pRecs);
 
@@ -383,7 +464,7 @@ void AL_HEVC_PrepareCommand(AL_TDecCtx* pCtx, AL_TScl* pSCL, AL_TDecPicParam* pP
     if(pSP->FirstLcuSliceSegment && pSP->eSliceType == SLICE_I)
       pSP->ColocPicID = pPrevSP->ColocPicID;
 
-    if(pSlice->first_slice_segment_in_pic_flag)
+    if(pSlice->first_slice_segment_in_pic_flag && !isSclLstUpToDate(pCtx, pSlice->slice_pic_parameter_set_id, bIsValid))
       AL_HEVC_WriteDecHwScalingList((const AL_TScl*)pSCL, pBufs->tScl.tMD.pVirtualAddr);
     AL_HEVC_PictMngr_GetBuffers(&pCtx->PictMngr, pPP, pSP, pSlice, &pCtx->ListRef, &pBufs->tListVirtRef, &pBufs->tListRef, &pCtx->POC, &pCtx->MV, &pBufs->tWP, &pCtx->pRecs);
 
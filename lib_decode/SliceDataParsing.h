@@ -64,6 +64,13 @@ void AL_LaunchFrameDecoding(AL_TDecCtx* pCtx);
 *****************************************************************************/
 void AL_LaunchSliceDecoding(AL_TDecCtx* pCtx, bool bIsLastAUNal);
 
+/*************************************************************************//*!
+   \brief The AL_FlushSliceDecoding function sends the slices queued by
+   AL_LaunchSliceDecoding to the Hardware IP in one request
+   \param[in]  pCtx              Pointer to a decoder context object
+*****************************************************************************/
+void AL_FlushSliceDecoding(AL_TDecCtx* pCtx);
+
 /*************************************************************************//*!
    \brief The AL_InitFrameBuffers function intializes the frame buffers needed to process the current frame decoding
    \param[in]  pCtx              Pointer to a decoder context object
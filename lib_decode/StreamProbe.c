@@ -0,0 +1,198 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+/****************************************************************************
+   -----------------------------------------------------------------------------
+ **************************************************************************//*!
+   \addtogroup lib_decode_hls
+   @{
+   \file
+ *****************************************************************************/
+
+#include "lib_rtos/lib_rtos.h"
+#include "lib_common/Utils.h"
+#include "lib_common_dec/DecBuffers.h"
+#include "lib_common_dec/RbspParser.h"
+
+#include "NalUnitParser.h"
+
+#define NAL_LENGTH_SIZE 4
+#define START_CODE_SIZE 3
+#define MAX_PROBED_NAL_SIZE (NON_VCL_NAL_SIZE - 2 * START_CODE_SIZE)
+
+static uint8_t const StartCode[START_CODE_SIZE] =
+{
+  0x00, 0x00, 0x01
+};
+
+/*****************************************************************************/
+static bool isStartCode(uint8_t const* pStream, size_t zSize, size_t zOffset)
+{
+  return (zOffset + START_CODE_SIZE <= zSize) && !pStream[zOffset] && !pStream[zOffset + 1] && (pStream[zOffset + 2] == 0x01);
+}
+
+/*****************************************************************************/
+static bool nextAnnexBNal(uint8_t const* pStream, size_t zSize, size_t* pOffset, uint8_t const** ppNal, size_t* pNalSize)
+{
+  size_t zBegin = *pOffset;
+
+  while(zBegin + START_CODE_SIZE <= zSize && !isStartCode(pStream, zSize, zBegin))
+    ++zBegin;
+
+  if(zBegin + START_CODE_SIZE > zSize)
+    return false;
+
+  zBegin += START_CODE_SIZE;
+
+  size_t zEnd = zBegin;
+
+  while(zEnd < zSize && !isStartCode(pStream, zSize, zEnd))
+    ++zEnd;
+
+  *ppNal = &pStream[zBegin];
+  *pNalSize = zEnd - zBegin;
+  *pOffset = zEnd;
+  return true;
+}
+
+/*****************************************************************************/
+static bool nextLengthPrefixedNal(uint8_t const* pStream, size_t zSize, size_t* pOffset, uint8_t const** ppNal, size_t* pNalSize)
+{
+  size_t const zBegin = *pOffset + NAL_LENGTH_SIZE;
+
+  if(zBegin > zSize)
+    return false;
+
+  uint8_t const* pLength = &pStream[*pOffset];
+  size_t const zNalSize = ((uint32_t)pLength[0] << 24) | ((uint32_t)pLength[1] << 16) | ((uint32_t)pLength[2] << 8) | pLength[3];
+
+  if(zNalSize > zSize - zBegin)
+    return false;
+
+  *ppNal = &pStream[zBegin];
+  *pNalSize = zNalSize;
+  *pOffset = zBegin + zNalSize;
+  return true;
+}
+
+/*****************************************************************************/
+static bool isSPS(AL_ECodec eCodec, uint8_t const* pNal, size_t zNalSize)
+{
+  if(zNalSize < 2)
+    return false;
+
+  if(eCodec == AL_CODEC_AVC)
+    return (pNal[0] & 0x1F) == AL_AVC_NUT_SPS;
+
+  return ((pNal[0] >> 1) & 0x3F) == AL_HEVC_NUT_SPS;
+}
+
+/*****************************************************************************/
+static bool probeSPS(AL_TDecSettings const* pSettings, AL_TAup* pAUP, uint8_t* pNalBuf, uint8_t* pBufNoAE, uint8_t const* pNal, size_t zNalSize, AL_TStreamProbe* pProbe)
+{
+  uint32_t const uNalSize = (uint32_t)(zNalSize < MAX_PROBED_NAL_SIZE ? zNalSize : MAX_PROBED_NAL_SIZE);
+
+  // frame the nal with start codes: the rbsp parser stops on the second one
+  Rtos_Memcpy(pNalBuf, StartCode, START_CODE_SIZE);
+  Rtos_Memcpy(pNalBuf + START_CODE_SIZE, pNal, uNalSize);
+  Rtos_Memcpy(pNalBuf + START_CODE_SIZE + uNalSize, StartCode, START_CODE_SIZE);
+  Rtos_Memset(pBufNoAE, 0, NON_VCL_NAL_SIZE + ANTI_EMUL_GRANULARITY);
+
+  TCircBuffer tNalStream;
+  Rtos_Memset(&tNalStream, 0, sizeof(tNalStream));
+  tNalStream.tMD.pVirtualAddr = pNalBuf;
+  tNalStream.tMD.uSize = uNalSize + 2 * START_CODE_SIZE;
+  tNalStream.iAvailSize = tNalStream.tMD.uSize;
+
+  AL_TRbspParser rp;
+  InitRbspParser(&tNalStream, pBufNoAE, true, &rp);
+
+  if(pSettings->eCodec == AL_CODEC_AVC)
+    return AL_AVC_ProbeSPS(pAUP, &rp, pSettings, pProbe);
+
+  return AL_HEVC_ProbeSPS(pAUP, &rp, pSettings, pProbe);
+}
+
+/*****************************************************************************/
+AL_ERR AL_Decoder_ProbeStream(AL_TDecSettings const* pSettings, uint8_t const* pStream, size_t zSize, AL_TStreamProbe* pProbe)
+{
+  if(!pSettings || !pStream || !pProbe)
+    return AL_ERROR;
+
+  if(pSettings->eCodec != AL_CODEC_AVC && pSettings->eCodec != AL_CODEC_HEVC)
+    return AL_ERROR;
+
+  AL_ERR eError = AL_ERR_NO_MEMORY;
+  AL_TAup* pAUP = (AL_TAup*)Rtos_Malloc(sizeof(AL_TAup));
+  uint8_t* pNalBuf = (uint8_t*)Rtos_Malloc(NON_VCL_NAL_SIZE);
+  uint8_t* pBufNoAE = (uint8_t*)Rtos_Malloc(NON_VCL_NAL_SIZE + ANTI_EMUL_GRANULARITY);
+
+  if(!pAUP || !pNalBuf || !pBufNoAE)
+    goto cleanup;
+
+  if(pSettings->eCodec == AL_CODEC_AVC)
+    AL_AVC_InitAUP(&pAUP->avcAup);
+  else
+    AL_HEVC_InitAUP(&pAUP->hevcAup);
+
+  eError = AL_ERROR;
+
+  size_t zOffset = 0;
+  uint8_t const* pNal;
+  size_t zNalSize;
+
+  while(pSettings->bLengthPrefixed ? nextLengthPrefixedNal(pStream, zSize, &zOffset, &pNal, &zNalSize) : nextAnnexBNal(pStream, zSize, &zOffset, &pNal, &zNalSize))
+  {
+    if(!isSPS(pSettings->eCodec, pNal, zNalSize))
+      continue;
+
+    if(probeSPS(pSettings, pAUP, pNalBuf, pBufNoAE, pNal, zNalSize, pProbe))
+    {
+      eError = AL_SUCCESS;
+      break;
+    }
+  }
+
+  cleanup:
+  Rtos_Free(pBufNoAE);
+  Rtos_Free(pNalBuf);
+  Rtos_Free(pAUP);
+  return eError;
+}
+
+/*@}*/
+
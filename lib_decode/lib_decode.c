@@ -96,7 +96,14 @@ UNIT_ERROR AL_Decoder_TryDecodeOneUnit(AL_HDecoder hDec, TCircBuffer* pBufStream
 bool AL_Decoder_PushBuffer(AL_HDecoder hDec, AL_TBuffer* pBuf, size_t uSize)
 {
   AL_TDecoder* pDec = (AL_TDecoder*)hDec;
-  return pDec->vtable->pfnPushBuffer(pDec, pBuf, uSize);
+  return pDec->vtable->pfnPushBuffer(pDec, pBuf, uSize, AL_WAIT_FOREVER) == AL_SUCCESS;
+}
+
+/*****************************************************************************/
+AL_ERR AL_Decoder_TryPushBuffer(AL_HDecoder hDec, AL_TBuffer* pBuf, size_t uSize, uint32_t uWait)
+{
+  AL_TDecoder* pDec = (AL_TDecoder*)hDec;
+  return pDec->vtable->pfnPushBuffer(pDec, pBuf, uSize, uWait);
 }
 
 /*****************************************************************************/
@@ -8,15 +8,18 @@ endif
 LIB_DECODE_SRC+=\
 		lib_decode/NalUnitParser.c\
 		lib_decode/NalDecoder.c\
+		lib_decode/ParamSetCache.c\
 		lib_decode/HevcDecoder.c\
 		lib_decode/AvcDecoder.c\
 		lib_decode/FrameParam.c\
 		lib_decode/SliceDataParsing.c\
 		lib_decode/DefaultDecoder.c\
+		lib_decode/StreamProbe.c\
 		lib_decode/lib_decode.c\
 		lib_decode/BufferFeeder.c\
 		lib_decode/Patchworker.c\
 		lib_decode/DecoderFeeder.c\
+		lib_decode/FeederPool.c\
 		lib_decode/DecChannelMcu.c\
 
 LIB_DECODER_SRC:=\
@@ -798,7 +798,15 @@ static void EndEncoding(void* pUserParam, AL_TEncPicStatus* pPicStatus, AL_64U s
   AL_TPictureMetaData* pPictureMeta = (AL_TPictureMetaData*)AL_Buffer_GetMetaData(pStream, AL_META_TYPE_PICTURE);
 
   if(pPictureMeta)
+  {
     pPictureMeta->eType = pPicStatus->eType;
+    pPictureMeta->iQP = pPicStatus->iQP;
+    pPictureMeta->bSkipped = pPicStatus->bSkip;
+    pPictureMeta->bIsIDR = pPicStatus->bIsIDR;
+    pPictureMeta->bIsRef = pPicStatus->bIsRef;
+    pPictureMeta->uInitialRemovalDelay = pPicStatus->uInitialRemovalDelay;
+    pPictureMeta->uSumCplx = pPicStatus->uSumCplx;
+  }
 
   int iPoolID = pPicStatus->UserParam;
   AL_TFrameInfo* pFI = &pCtx->Pool[iPoolID];
@@ -42,7 +42,12 @@
 
 #include "lib_rtos/lib_rtos.h"
 #include "lib_fpga/DmaAlloc.h"
+#include "lib_fpga/EventLoop.h"
 #include "lib_common/Error.h"
+#include "lib_common/ResourceLedger.h"
+#include "lib_common/ChannelResources.h"
+#include "lib_common_enc/Settings.h"
+#include "lib_perfs/Tracer.h"
 
 #include <unistd.h> // for close
 
@@ -51,6 +56,8 @@ typedef struct al_t_SchedulerMcu
   const TSchedulerVtable* vtable;
   AL_TAllocator* allocator;
   AL_TDriver* driver;
+  AL_TEventLoop* eventLoop;
+  AL_TResourceLedger* ledger;
 }AL_TSchedulerMcu;
 
 typedef struct
@@ -61,6 +68,8 @@ typedef struct
   int fd;
   AL_THREAD thread;
   int32_t shouldContinue;
+  AL_TEventLoop* eventLoop;
+  AL_EVENT ended; /* set once the fd has left the event loop */
 }Channel;
 
 #if __linux__
@@ -80,6 +89,8 @@ static void setCallbacks(Channel* chan, AL_TISchedulerCallBacks* pCBs);
 static bool getStatusMsg(Channel* chan, struct al5_params* msg);
 static void processStatusMsg(Channel* chan, struct al5_params* msg);
 static void* WaitForStatus(void* p);
+static bool OnStatusReady(void* p);
+static void OnStatusEnded(void* p);
 
 static AL_ERR createChannel(AL_HANDLE* hChannel, TScheduler* pScheduler, AL_TEncChanParam* pChParam, TMemDesc* pEP1, AL_TISchedulerCallBacks* pCBs)
 {
@@ -96,6 +107,15 @@ static AL_ERR createChannel(AL_HANDLE* hChannel, TScheduler* pScheduler, AL_TEnc
 
   Rtos_Memset(chan, 0, sizeof(*chan));
 
+  int iNumCore;
+  int const iResources = AL_Settings_GetChannelResources(pChParam, &iNumCore);
+  errorCode = AL_ResourceLedger_Reserve(schedulerMcu->ledger, chan, iResources, iNumCore);
+
+  if(errorCode != AL_SUCCESS)
+    goto ledger_fail;
+
+  errorCode = AL_ERROR;
+
   chan->driver = schedulerMcu->driver;
   chan->fd = AL_Driver_Open(chan->driver, deviceFile);
 
@@ -130,10 +150,25 @@ static AL_ERR createChannel(AL_HANDLE* hChannel, TScheduler* pScheduler, AL_TEnc
 
   chan->shouldContinue = 1;
 
-  chan->thread = Rtos_CreateThread(&WaitForStatus, chan);
+  AL_CB_FdReady onStatusReady = { &OnStatusReady, &OnStatusEnded, chan };
 
-  if(!chan->thread)
-    goto fail;
+  if(schedulerMcu->eventLoop)
+    chan->ended = Rtos_CreateEvent(false);
+
+  /* fall back on a blocking thread when the driver can't be polled */
+  if(chan->ended && AL_EventLoop_AddFd(schedulerMcu->eventLoop, chan->fd, onStatusReady))
+    chan->eventLoop = schedulerMcu->eventLoop;
+  else
+  {
+    if(chan->ended)
+      Rtos_DeleteEvent(chan->ended);
+    chan->ended = NULL;
+
+    chan->thread = Rtos_CreateThread(&WaitForStatus, chan);
+
+    if(!chan->thread)
+      goto fail;
+  }
 
   SetChannelInfo(&chan->info, pChParam);
 
@@ -143,6 +178,8 @@ static AL_ERR createChannel(AL_HANDLE* hChannel, TScheduler* pScheduler, AL_TEnc
   fail:
   AL_Driver_Close(schedulerMcu->driver, chan->fd);
   driver_open_fail:
+  AL_ResourceLedger_Release(schedulerMcu->ledger, chan);
+  ledger_fail:
   Rtos_Free(chan);
   channel_creation_fail:
   *hChannel = AL_INVALID_CHANNEL;
@@ -182,13 +219,27 @@ static bool destroyChannel(TScheduler* pScheduler, AL_HANDLE hChannel)
 
   Rtos_AtomicDecrement(&chan->shouldContinue);
 
-  AL_Driver_PostMessage(schedulerMcu->driver, chan->fd, AL_MCU_DESTROY_CHANNEL, NULL);
+  bool const bDestroyed = AL_Driver_PostMessage(schedulerMcu->driver, chan->fd, AL_MCU_DESTROY_CHANNEL, NULL) == DRIVER_SUCCESS;
 
-  if(!Rtos_JoinThread(chan->thread))
-    return false;
-  Rtos_DeleteThread(chan->thread);
+  if(chan->eventLoop)
+  {
+    /* the statuses still queued in the driver are processed until it reports the end of the channel */
+    if(bDestroyed)
+      Rtos_WaitEvent(chan->ended, AL_WAIT_FOREVER);
+
+    AL_EventLoop_RemoveFd(chan->eventLoop, chan->fd);
+    Rtos_DeleteEvent(chan->ended);
+  }
+
+  if(chan->thread)
+  {
+    if(!Rtos_JoinThread(chan->thread))
+      return false;
+    Rtos_DeleteThread(chan->thread);
+  }
 
   AL_Driver_Close(schedulerMcu->driver, chan->fd);
+  AL_ResourceLedger_Release(schedulerMcu->ledger, chan);
 
   Rtos_Free(chan);
 
@@ -252,9 +303,14 @@ static void setCallbacks(Channel* chan, AL_TISchedulerCallBacks* pCBs)
   chan->CBs.pfnEndEncodingCallBack = pCBs->pfnEndEncodingCallBack;
 }
 
+static AL_EDriverError waitStatusMsg(Channel* chan, struct al5_params* msg)
+{
+  return AL_Driver_PostMessage(chan->driver, chan->fd, AL_MCU_WAIT_FOR_STATUS, msg);
+}
+
 static bool getStatusMsg(Channel* chan, struct al5_params* msg)
 {
-  return AL_Driver_PostMessage(chan->driver, chan->fd, AL_MCU_WAIT_FOR_STATUS, msg) == DRIVER_SUCCESS;
+  return waitStatusMsg(chan, msg) == DRIVER_SUCCESS;
 }
 
 static void processStatusMsg(Channel* chan, struct al5_params* msg)
@@ -272,7 +328,9 @@ static void processStatusMsg(Channel* chan, struct al5_params* msg)
     pStatus = &status;
   }
 
+  AL_Trace_Begin("enc.end_encoding", pStatus ? pStatus->uSize : 0);
   chan->CBs.pfnEndEncodingCallBack(chan->CBs.pEndEncodingCBParam, pStatus, streamBufferPtr);
+  AL_Trace_End("enc.end_encoding");
 }
 
 static void* WaitForStatus(void* p)
@@ -280,6 +338,8 @@ static void* WaitForStatus(void* p)
   Channel* chan = p;
   struct al5_params msg = { 0 };
 
+  AL_Trace_NameThread("notification");
+
   while(true)
   {
     if(Rtos_AtomicDecrement(&chan->shouldContinue) < 0)
@@ -293,9 +353,36 @@ static void* WaitForStatus(void* p)
   return 0;
 }
 
+/* the fd is readable: a status is pending and AL_MCU_WAIT_FOR_STATUS won't block */
+static bool OnStatusReady(void* p)
+{
+  Channel* chan = p;
+  struct al5_params msg = { 0 };
+  AL_EDriverError const errdrv = waitStatusMsg(chan, &msg);
+
+  if(errdrv == DRIVER_SUCCESS)
+  {
+    processStatusMsg(chan, &msg);
+    return true;
+  }
+
+  /* once destroyed, the driver fails the wait when no status is left. Other
+   * errors don't end the channel: keep watching it */
+  return chan->shouldContinue > 0 && errdrv != DRIVER_ERROR_CHANNEL;
+}
+
+static void OnStatusEnded(void* p)
+{
+  Channel* chan = p;
+  Rtos_SetEvent(chan->ended);
+}
+
 static void destroy(TScheduler* pScheduler)
 {
-  Rtos_Free((AL_TSchedulerMcu*)pScheduler);
+  AL_TSchedulerMcu* schedulerMcu = (AL_TSchedulerMcu*)pScheduler;
+  AL_EventLoop_ReleaseShared(schedulerMcu->eventLoop);
+  AL_ResourceLedger_Destroy(schedulerMcu->ledger);
+  Rtos_Free(schedulerMcu);
 }
 
 static __u32 getFd(AL_TBuffer* b)
@@ -341,9 +428,23 @@ TScheduler* AL_SchedulerMcu_Create(AL_TDriver* driver, AL_TAllocator* pDmaAlloca
   scheduler->vtable = &McuSchedulerVtable;
   scheduler->driver = driver;
   scheduler->allocator = pDmaAllocator;
+  scheduler->ledger = AL_ResourceLedger_Create(AL_ENC_NUM_CORES, GetCoreResources(ENCODER_CORE_FREQUENCY, ENCODER_CORE_FREQUENCY_MARGIN, ENCODER_CYCLES_FOR_BLK_32X32));
+
+  if(!scheduler->ledger)
+  {
+    Rtos_Free(scheduler);
+    return NULL;
+  }
+
+  scheduler->eventLoop = AL_EventLoop_GetShared();
   return (TScheduler*)scheduler;
 }
 
+AL_TResourceLedger* AL_SchedulerMcu_GetResourceLedger(TScheduler* pScheduler)
+{
+  return ((AL_TSchedulerMcu*)pScheduler)->ledger;
+}
+
 #else
 
 TScheduler* AL_SchedulerMcu_Create(AL_TDriver* driver, AL_TAllocator* pDmaAllocator)
@@ -353,5 +454,11 @@ TScheduler* AL_SchedulerMcu_Create(AL_TDriver* driver, AL_TAllocator* pDmaAlloca
   return NULL;
 }
 
+AL_TResourceLedger* AL_SchedulerMcu_GetResourceLedger(TScheduler* pScheduler)
+{
+  (void)pScheduler;
+  return NULL;
+}
+
 #endif
 
@@ -41,6 +41,7 @@
 #include "lib_encode/Com_Encoder.h"
 #include "lib_encode/lib_encoder.h"
 #include "IP_EncoderCtx.h"
+#include "lib_common_enc/EncBuffersInternal.h"
 
 void AL_CreateHevcEncoder(HighLevelEncoder* pCtx);
 void AL_CreateAvcEncoder(HighLevelEncoder* pCtx);
@@ -99,6 +100,52 @@ AL_ERR AL_Encoder_Create(AL_HEncoder* hEnc, TScheduler* pScheduler, AL_TAllocato
   return errorCode;
 }
 
+/****************************************************************************/
+static int GetNumFirmwareReferences(AL_TEncChanParam const* pChParam)
+{
+  if((pChParam->tGopParam.eMode & AL_GOP_MODE_PYRAMIDAL) || pChParam->tGopParam.bEnableLT)
+    return ENC_MAX_REF_CUSTOM;
+  return ENC_MAX_REF_DEFAULT;
+}
+
+/****************************************************************************/
+bool AL_Encoder_GetMemoryPlan(AL_TEncSettings const* pSettings, AL_TMemoryPlan* pPlan)
+{
+  if(!pSettings || !pPlan)
+    return false;
+
+  AL_TEncChanParam const* pChParam = &pSettings->tChParam[0];
+
+  if(!AL_IS_AVC(pChParam->eProfile) && !AL_IS_HEVC(pChParam->eProfile))
+    return false;
+
+  if(pChParam->uWidth == 0 || pChParam->uHeight == 0)
+    return false;
+
+  AL_TDimension const tDim = { pChParam->uWidth, pChParam->uHeight };
+  AL_ECodec const eCodec = AL_IS_AVC(pChParam->eProfile) ? AL_CODEC_AVC : AL_CODEC_HEVC;
+  uint8_t const uBitDepth = AL_GET_BITDEPTH(pChParam->ePicFormat);
+  AL_EChromaMode const eChromaMode = AL_GET_CHROMA_MODE(pChParam->ePicFormat);
+  uint8_t const uNumCore = pChParam->uNumCore ? pChParam->uNumCore : AL_ENC_NUM_CORES;
+  int const iNumSlices = pChParam->uNumSlices ? pChParam->uNumSlices : 1;
+  int const iNumRef = GetNumFirmwareReferences(pChParam);
+
+  AL_MemoryPlan_Init(pPlan);
+
+  bool bRet = AL_MemoryPlan_Add(pPlan, "ep1", AL_MEM_LIBRARY, AL_GetAllocSizeEP1(), 1);
+
+  // the firmware sizes its pools for the worst case of the channel
+  bRet = bRet && AL_MemoryPlan_Add(pPlan, "reference", AL_MEM_FIRMWARE, AL_GetAllocSize_EncReference(tDim, uBitDepth, eChromaMode, pChParam->eOptions), iNumRef);
+  bRet = bRet && AL_MemoryPlan_Add(pPlan, "mv", AL_MEM_FIRMWARE, AL_GetAllocSize_MV(tDim, pChParam->uMaxCuSize, eCodec), iNumRef);
+  bRet = bRet && AL_MemoryPlan_Add(pPlan, "comp data", AL_MEM_FIRMWARE, AL_GetAllocSize_CompData(tDim, pChParam->uMaxCuSize, uBitDepth, eChromaMode, false), ENC_MAX_SRC);
+  bRet = bRet && AL_MemoryPlan_Add(pPlan, "comp map", AL_MEM_FIRMWARE, AL_GetAllocSize_EncCompMap(tDim, pChParam->uMaxCuSize, uNumCore, false), ENC_MAX_SRC);
+  bRet = bRet && AL_MemoryPlan_Add(pPlan, "wpp", AL_MEM_FIRMWARE, AL_GetAllocSize_WPP(AL_GetHeightInLCU(*pChParam), iNumSlices, uNumCore), ENC_MAX_SRC);
+  bRet = bRet && AL_MemoryPlan_Add(pPlan, "slice size", AL_MEM_FIRMWARE, AL_GetAllocSize_SliceSize(pChParam->uWidth, pChParam->uHeight, iNumSlices, pChParam->uMaxCuSize), ENC_MAX_SRC);
+  bRet = bRet && AL_MemoryPlan_Add(pPlan, "ep3", AL_MEM_FIRMWARE, AL_GetAllocSizeEP3(), ENC_MAX_SRC);
+
+  return bRet;
+}
+
 /****************************************************************************/
 void AL_Encoder_Destroy(AL_HEncoder hEnc)
 {
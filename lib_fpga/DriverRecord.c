@@ -0,0 +1,418 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <linux/ioctl.h>
+
+#include "lib_rtos/lib_rtos.h"
+#include "lib_common/IDriver.h"
+#include "lib_fpga/DriverRecord.h"
+
+#define RECORD_MAGIC 0x52444c41 /* "ALDR" */
+#define RECORD_VERSION 1
+#define MAX_FDS 128
+/* copies of the sent payloads are preallocated so that logging a message
+ * doesn't add a heap allocation to the measured path. A copy is held while
+ * the message is in the wrapped driver, blocking wait messages included */
+#define MAX_PENDING_MESSAGES 32
+#define MAX_PAYLOAD_SIZE (_IOC_SIZEMASK + 1)
+
+/* on-disk layout of a record, followed by the in and out payloads */
+typedef struct
+{
+  uint32_t eType;
+  int32_t iChannel;
+  uint64_t uMessageId;
+  uint64_t uStartUs;
+  uint64_t uEndUs;
+  int32_t iStatus;
+  uint32_t uSize;
+}AL_TRecordHeader;
+
+typedef struct
+{
+  int fd;
+  int iChannel;
+}AL_TRecordedFd;
+
+typedef struct
+{
+  AL_TDriver base;
+  AL_TDriver* pDriver;
+  FILE* pFile;
+  AL_MUTEX hLock;
+  uint64_t uOriginUs;
+  int iNumChannels;
+  AL_TRecordedFd fds[MAX_FDS];
+  uint8_t* pPayloads;
+  uint8_t* pFreePayloads[MAX_PENDING_MESSAGES];
+  int iNumFreePayloads;
+}AL_TRecordDriver;
+
+static uint64_t GetTimeUs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/****************************************************************************/
+static int FindChannel(AL_TRecordDriver* pThis, int fd)
+{
+  for(int i = 0; i < MAX_FDS; ++i)
+  {
+    if(pThis->fds[i].fd == fd)
+      return pThis->fds[i].iChannel;
+  }
+
+  return -1;
+}
+
+static void WriteRecord(AL_TRecordDriver* pThis, AL_TDriverRecord const* pRecord)
+{
+  AL_TRecordHeader tHeader =
+  {
+    pRecord->eType, pRecord->iChannel, pRecord->uMessageId,
+    pRecord->uStartUs, pRecord->uEndUs, pRecord->iStatus, pRecord->uSize
+  };
+
+  fwrite(&tHeader, sizeof(tHeader), 1, pThis->pFile);
+
+  if(pRecord->uSize)
+  {
+    fwrite(pRecord->pIn, 1, pRecord->uSize, pThis->pFile);
+    fwrite(pRecord->pOut, 1, pRecord->uSize, pThis->pFile);
+  }
+}
+
+static int Open(AL_TDriver* driver, const char* device)
+{
+  AL_TRecordDriver* pThis = (AL_TRecordDriver*)driver;
+  AL_TDriverRecord tRecord = { 0 };
+
+  tRecord.eType = AL_DRIVER_RECORD_OPEN;
+  tRecord.uStartUs = GetTimeUs() - pThis->uOriginUs;
+  int fd = AL_Driver_Open(pThis->pDriver, device);
+  tRecord.uEndUs = GetTimeUs() - pThis->uOriginUs;
+  tRecord.iStatus = fd < 0 ? -1 : 0;
+  tRecord.iChannel = -1;
+
+  Rtos_GetMutex(pThis->hLock);
+
+  if(fd >= 0)
+  {
+    for(int i = 0; i < MAX_FDS; ++i)
+    {
+      if(pThis->fds[i].fd < 0)
+      {
+        pThis->fds[i].fd = fd;
+        pThis->fds[i].iChannel = pThis->iNumChannels;
+        tRecord.iChannel = pThis->iNumChannels++;
+        break;
+      }
+    }
+  }
+
+  WriteRecord(pThis, &tRecord);
+  Rtos_ReleaseMutex(pThis->hLock);
+
+  return fd;
+}
+
+static void Close(AL_TDriver* driver, int fd)
+{
+  AL_TRecordDriver* pThis = (AL_TRecordDriver*)driver;
+  AL_TDriverRecord tRecord = { 0 };
+
+  tRecord.eType = AL_DRIVER_RECORD_CLOSE;
+  tRecord.uStartUs = GetTimeUs() - pThis->uOriginUs;
+  AL_Driver_Close(pThis->pDriver, fd);
+  tRecord.uEndUs = GetTimeUs() - pThis->uOriginUs;
+
+  Rtos_GetMutex(pThis->hLock);
+
+  for(int i = 0; i < MAX_FDS; ++i)
+  {
+    if(pThis->fds[i].fd == fd)
+    {
+      tRecord.iChannel = pThis->fds[i].iChannel;
+      pThis->fds[i].fd = -1;
+      WriteRecord(pThis, &tRecord);
+      break;
+    }
+  }
+
+  Rtos_ReleaseMutex(pThis->hLock);
+}
+
+/****************************************************************************/
+static uint8_t* TakePayload(AL_TRecordDriver* pThis, uint32_t uSize)
+{
+  uint8_t* pPayload = NULL;
+
+  Rtos_GetMutex(pThis->hLock);
+
+  if(pThis->iNumFreePayloads)
+    pPayload = pThis->pFreePayloads[--pThis->iNumFreePayloads];
+  Rtos_ReleaseMutex(pThis->hLock);
+
+  /* more messages in flight than expected: don't lose the record */
+  if(!pPayload)
+    pPayload = Rtos_Malloc(uSize);
+
+  return pPayload;
+}
+
+/* called with the lock held */
+static void GiveBackPayload(AL_TRecordDriver* pThis, uint8_t* pPayload)
+{
+  bool const bPreallocated = pPayload >= pThis->pPayloads && pPayload < pThis->pPayloads + MAX_PENDING_MESSAGES * MAX_PAYLOAD_SIZE;
+
+  if(bPreallocated)
+    pThis->pFreePayloads[pThis->iNumFreePayloads++] = pPayload;
+  else
+    Rtos_Free(pPayload);
+}
+
+static AL_EDriverError PostMessage(AL_TDriver* driver, int fd, long unsigned int messageId, void* data)
+{
+  AL_TRecordDriver* pThis = (AL_TRecordDriver*)driver;
+  AL_TDriverRecord tRecord = { 0 };
+  uint8_t* pIn = NULL;
+
+  tRecord.eType = AL_DRIVER_RECORD_MESSAGE;
+  tRecord.uMessageId = messageId;
+  tRecord.uSize = data ? _IOC_SIZE(messageId) : 0;
+
+  /* the driver updates the payload in place, keep what was sent */
+  if(tRecord.uSize)
+  {
+    pIn = TakePayload(pThis, tRecord.uSize);
+
+    if(pIn)
+      Rtos_Memcpy(pIn, data, tRecord.uSize);
+  }
+
+  tRecord.uStartUs = GetTimeUs() - pThis->uOriginUs;
+  AL_EDriverError eRet = AL_Driver_PostMessage(pThis->pDriver, fd, messageId, data);
+  tRecord.uEndUs = GetTimeUs() - pThis->uOriginUs;
+  tRecord.iStatus = eRet;
+
+  if(tRecord.uSize && !pIn)
+    return eRet;
+
+  tRecord.pIn = pIn;
+  tRecord.pOut = data;
+
+  Rtos_GetMutex(pThis->hLock);
+  tRecord.iChannel = FindChannel(pThis, fd);
+  WriteRecord(pThis, &tRecord);
+
+  if(pIn)
+    GiveBackPayload(pThis, pIn);
+  Rtos_ReleaseMutex(pThis->hLock);
+
+  return eRet;
+}
+
+static const AL_DriverVtable RecordDriverVtable =
+{
+  &Open,
+  &Close,
+  &PostMessage,
+};
+
+AL_TDriver* AL_RecordDriver_Create(AL_TDriver* pDriver, char const* sFileName)
+{
+  AL_TRecordDriver* pThis = Rtos_Malloc(sizeof(*pThis));
+
+  if(!pThis)
+    return NULL;
+
+  pThis->pFile = fopen(sFileName, "wb");
+
+  if(!pThis->pFile)
+    goto fail_file;
+
+  pThis->hLock = Rtos_CreateMutex();
+
+  if(!pThis->hLock)
+    goto fail_lock;
+
+  pThis->pPayloads = Rtos_Malloc(MAX_PENDING_MESSAGES * MAX_PAYLOAD_SIZE);
+
+  if(!pThis->pPayloads)
+    goto fail_payloads;
+
+  for(int i = 0; i < MAX_PENDING_MESSAGES; ++i)
+    pThis->pFreePayloads[i] = pThis->pPayloads + i * MAX_PAYLOAD_SIZE;
+
+  pThis->iNumFreePayloads = MAX_PENDING_MESSAGES;
+
+  uint32_t const uFileHeader[2] = { RECORD_MAGIC, RECORD_VERSION };
+  fwrite(uFileHeader, sizeof(uFileHeader), 1, pThis->pFile);
+
+  pThis->base.vtable = &RecordDriverVtable;
+  pThis->pDriver = pDriver;
+  pThis->uOriginUs = GetTimeUs();
+  pThis->iNumChannels = 0;
+
+  for(int i = 0; i < MAX_FDS; ++i)
+    pThis->fds[i].fd = -1;
+
+  return (AL_TDriver*)pThis;
+
+  fail_payloads:
+  Rtos_DeleteMutex(pThis->hLock);
+  fail_lock:
+  fclose(pThis->pFile);
+  fail_file:
+  Rtos_Free(pThis);
+  return NULL;
+}
+
+void AL_RecordDriver_Destroy(AL_TDriver* pDriver)
+{
+  AL_TRecordDriver* pThis = (AL_TRecordDriver*)pDriver;
+
+  fclose(pThis->pFile);
+  Rtos_DeleteMutex(pThis->hLock);
+  Rtos_Free(pThis->pPayloads);
+  Rtos_Free(pThis);
+}
+
+/****************************************************************************/
+static bool ReadRecord(FILE* pFile, AL_TDriverRecord* pRecord)
+{
+  AL_TRecordHeader tHeader;
+
+  if(fread(&tHeader, sizeof(tHeader), 1, pFile) != 1)
+    return false;
+
+  pRecord->eType = tHeader.eType;
+  pRecord->iChannel = tHeader.iChannel;
+  pRecord->uMessageId = tHeader.uMessageId;
+  pRecord->uStartUs = tHeader.uStartUs;
+  pRecord->uEndUs = tHeader.uEndUs;
+  pRecord->iStatus = tHeader.iStatus;
+  pRecord->uSize = tHeader.uSize;
+  pRecord->pIn = NULL;
+  pRecord->pOut = NULL;
+
+  if(!pRecord->uSize)
+    return true;
+
+  pRecord->pIn = Rtos_Malloc(pRecord->uSize);
+  pRecord->pOut = Rtos_Malloc(pRecord->uSize);
+
+  if(pRecord->pIn && pRecord->pOut
+     && fread(pRecord->pIn, 1, pRecord->uSize, pFile) == pRecord->uSize
+     && fread(pRecord->pOut, 1, pRecord->uSize, pFile) == pRecord->uSize)
+    return true;
+
+  Rtos_Free(pRecord->pIn);
+  Rtos_Free(pRecord->pOut);
+  return false;
+}
+
+bool AL_DriverSession_Load(char const* sFileName, AL_TDriverSession* pSession)
+{
+  FILE* pFile = fopen(sFileName, "rb");
+  uint32_t uFileHeader[2];
+  int iMaxRecords = 0;
+
+  pSession->pRecords = NULL;
+  pSession->iNumRecords = 0;
+  pSession->iNumChannels = 0;
+
+  if(!pFile)
+    return false;
+
+  if(fread(uFileHeader, sizeof(uFileHeader), 1, pFile) != 1 || uFileHeader[0] != RECORD_MAGIC || uFileHeader[1] != RECORD_VERSION)
+  {
+    fclose(pFile);
+    return false;
+  }
+
+  while(true)
+  {
+    if(pSession->iNumRecords == iMaxRecords)
+    {
+      iMaxRecords = iMaxRecords ? 2 * iMaxRecords : 1024;
+      AL_TDriverRecord* pRecords = Rtos_Malloc(iMaxRecords * sizeof(*pRecords));
+
+      if(!pRecords)
+        break;
+
+      if(pSession->pRecords)
+        Rtos_Memcpy(pRecords, pSession->pRecords, pSession->iNumRecords * sizeof(*pRecords));
+      Rtos_Free(pSession->pRecords);
+      pSession->pRecords = pRecords;
+    }
+
+    AL_TDriverRecord* pRecord = &pSession->pRecords[pSession->iNumRecords];
+
+    if(!ReadRecord(pFile, pRecord))
+      break;
+
+    ++pSession->iNumRecords;
+
+    if(pRecord->iChannel >= pSession->iNumChannels)
+      pSession->iNumChannels = pRecord->iChannel + 1;
+  }
+
+  /* a recording interrupted in the middle of a record is still usable */
+  fclose(pFile);
+  return true;
+}
+
+void AL_DriverSession_Deinit(AL_TDriverSession* pSession)
+{
+  for(int i = 0; i < pSession->iNumRecords; ++i)
+  {
+    Rtos_Free(pSession->pRecords[i].pIn);
+    Rtos_Free(pSession->pRecords[i].pOut);
+  }
+
+  Rtos_Free(pSession->pRecords);
+  pSession->pRecords = NULL;
+  pSession->iNumRecords = 0;
+  pSession->iNumChannels = 0;
+}
+
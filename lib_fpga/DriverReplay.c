@@ -0,0 +1,505 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <linux/ioctl.h>
+
+#include "lib_rtos/lib_rtos.h"
+#include "lib_common/IDriver.h"
+#include "lib_fpga/DriverRecord.h"
+#include "PipeDriver.h"
+
+#define MAX_MESSAGE_IDS 32
+
+/* next request of a message id to be consumed */
+typedef struct
+{
+  long unsigned int uMessageId;
+  int iNext;
+}AL_TReplayCursor;
+
+typedef struct
+{
+  int fd;
+  bool bClosed;
+  bool bHungUp;
+
+  /* requests, in issuing order. The arrays are indexed by request number */
+  int* pPosts;
+  int* pNextSameId;
+  bool* pConsumed;
+  uint64_t* pPostTimeUs;
+  int iNumPosts;
+  int iNumConsumed; /* the requests before this one have all been consumed */
+  AL_TReplayCursor cursors[MAX_MESSAGE_IDS];
+  int iNumCursors;
+
+  /* statuses, in completion order */
+  int* pWaits;
+  int* pWaitCause;
+  uint64_t* pWaitDelayUs;
+  int iNumWaits;
+  int iNumPushed;
+}AL_TReplayChannel;
+
+typedef struct
+{
+  AL_TDriver base;
+  AL_TDriver* pPipeDriver;
+  AL_TDriverSession const* pSession;
+  AL_TReplayConfig tConfig;
+  AL_TReplayChannel* pChannels;
+  int iNumOpened;
+
+  pthread_mutex_t Lock;
+  pthread_cond_t Changed;
+  pthread_t Timer;
+  bool bStop;
+}AL_TReplayDriver;
+
+static uint64_t GetTimeUs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static bool IsWaitMessage(AL_TReplayDriver* pThis, long unsigned int messageId)
+{
+  for(int i = 0; i < pThis->tConfig.iNumWaitMessages; ++i)
+  {
+    if(pThis->tConfig.pWaitMessages[i] == messageId)
+      return true;
+  }
+
+  return false;
+}
+
+static AL_TReplayCursor* FindCursor(AL_TReplayChannel* pChan, long unsigned int messageId)
+{
+  for(int i = 0; i < pChan->iNumCursors; ++i)
+  {
+    if(pChan->cursors[i].uMessageId == messageId)
+      return &pChan->cursors[i];
+  }
+
+  return NULL;
+}
+
+static AL_TReplayChannel* FindChannel(AL_TReplayDriver* pThis, int fd)
+{
+  for(int i = 0; i < pThis->iNumOpened; ++i)
+  {
+    if(!pThis->pChannels[i].bClosed && pThis->pChannels[i].fd == fd)
+      return &pThis->pChannels[i];
+  }
+
+  return NULL;
+}
+
+/****************************************************************************/
+/* must be called with the lock held. Pushes the statuses whose cause has been
+ * replayed and whose delay is over, returns the date of the next one. */
+static uint64_t PushReadyStatuses(AL_TReplayDriver* pThis, uint64_t uNowUs)
+{
+  uint64_t uNextUs = UINT64_MAX;
+
+  for(int i = 0; i < pThis->iNumOpened; ++i)
+  {
+    AL_TReplayChannel* pChan = &pThis->pChannels[i];
+
+    if(pChan->bClosed || pChan->bHungUp)
+      continue;
+
+    while(pChan->iNumPushed < pChan->iNumWaits)
+    {
+      int iWait = pChan->iNumPushed;
+      int iCause = pChan->pWaitCause[iWait];
+
+      if(iCause > pChan->iNumConsumed)
+        break;
+
+      uint64_t uDueUs = pChan->pWaitDelayUs[iWait];
+
+      if(iCause > 0)
+        uDueUs += pChan->pPostTimeUs[iCause - 1];
+
+      if(uDueUs > uNowUs)
+      {
+        if(uDueUs < uNextUs)
+          uNextUs = uDueUs;
+        break;
+      }
+
+      AL_TDriverRecord const* pRecord = &pThis->pSession->pRecords[pChan->pWaits[iWait]];
+      AL_PipeDriver_PushStatus(pThis->pPipeDriver, pChan->fd, pRecord->pOut, pRecord->uSize);
+      ++pChan->iNumPushed;
+    }
+
+    /* nothing left to report: wake up the waiters as a destroyed channel does */
+    if(pChan->iNumPushed == pChan->iNumWaits && pChan->iNumConsumed == pChan->iNumPosts)
+    {
+      AL_PipeDriver_HangUp(pThis->pPipeDriver, pChan->fd);
+      pChan->bHungUp = true;
+    }
+  }
+
+  return uNextUs;
+}
+
+static void* TimerThread(void* p)
+{
+  AL_TReplayDriver* pThis = p;
+
+  pthread_mutex_lock(&pThis->Lock);
+
+  while(!pThis->bStop)
+  {
+    uint64_t uNextUs = PushReadyStatuses(pThis, GetTimeUs());
+
+    if(uNextUs == UINT64_MAX)
+    {
+      pthread_cond_wait(&pThis->Changed, &pThis->Lock);
+      continue;
+    }
+
+    struct timespec ts;
+    ts.tv_sec = uNextUs / 1000000;
+    ts.tv_nsec = (uNextUs % 1000000) * 1000;
+    pthread_cond_timedwait(&pThis->Changed, &pThis->Lock, &ts);
+  }
+
+  pthread_mutex_unlock(&pThis->Lock);
+
+  return NULL;
+}
+
+/****************************************************************************/
+static int Open(AL_TDriver* driver, const char* device)
+{
+  AL_TReplayDriver* pThis = (AL_TReplayDriver*)driver;
+  int fd = -1;
+
+  pthread_mutex_lock(&pThis->Lock);
+
+  if(pThis->iNumOpened < pThis->pSession->iNumChannels)
+  {
+    fd = AL_Driver_Open(pThis->pPipeDriver, device);
+
+    if(fd >= 0)
+    {
+      pThis->pChannels[pThis->iNumOpened++].fd = fd;
+      pthread_cond_signal(&pThis->Changed);
+    }
+  }
+
+  pthread_mutex_unlock(&pThis->Lock);
+
+  return fd;
+}
+
+static void Close(AL_TDriver* driver, int fd)
+{
+  AL_TReplayDriver* pThis = (AL_TReplayDriver*)driver;
+
+  pthread_mutex_lock(&pThis->Lock);
+  AL_TReplayChannel* pChan = FindChannel(pThis, fd);
+
+  if(pChan)
+  {
+    AL_Driver_Close(pThis->pPipeDriver, fd);
+    pChan->bClosed = true;
+  }
+  pthread_mutex_unlock(&pThis->Lock);
+}
+
+static AL_EDriverError PostMessage(AL_TDriver* driver, int fd, long unsigned int messageId, void* data)
+{
+  AL_TReplayDriver* pThis = (AL_TReplayDriver*)driver;
+
+  /* blocks like the device until the timer thread has pushed a status */
+  if(IsWaitMessage(pThis, messageId))
+    return AL_PipeDriver_PopStatus(pThis->pPipeDriver, fd, data, _IOC_SIZE(messageId));
+
+  AL_EDriverError eRet = DRIVER_ERROR_CHANNEL;
+
+  pthread_mutex_lock(&pThis->Lock);
+  AL_TReplayChannel* pChan = FindChannel(pThis, fd);
+
+  if(!pChan)
+    goto unlock;
+
+  AL_TReplayCursor* pCursor = FindCursor(pChan, messageId);
+
+  if(!pCursor || pCursor->iNext < 0)
+    goto unlock;
+
+  int const iPost = pCursor->iNext;
+  AL_TDriverRecord const* pRecord = &pThis->pSession->pRecords[pChan->pPosts[iPost]];
+
+  if(data && pRecord->uSize)
+    Rtos_Memcpy(data, pRecord->pOut, pRecord->uSize);
+
+  pCursor->iNext = pChan->pNextSameId[iPost];
+  pChan->pConsumed[iPost] = true;
+  pChan->pPostTimeUs[iPost] = GetTimeUs();
+
+  while(pChan->iNumConsumed < pChan->iNumPosts && pChan->pConsumed[pChan->iNumConsumed])
+    ++pChan->iNumConsumed;
+
+  pthread_cond_signal(&pThis->Changed);
+  eRet = pRecord->iStatus;
+
+  unlock:
+  pthread_mutex_unlock(&pThis->Lock);
+
+  return eRet;
+}
+
+static const AL_DriverVtable ReplayDriverVtable =
+{
+  &Open,
+  &Close,
+  &PostMessage,
+};
+
+/****************************************************************************/
+static void DeinitChannel(AL_TReplayChannel* pChan)
+{
+  Rtos_Free(pChan->pPosts);
+  Rtos_Free(pChan->pNextSameId);
+  Rtos_Free(pChan->pConsumed);
+  Rtos_Free(pChan->pPostTimeUs);
+  Rtos_Free(pChan->pWaits);
+  Rtos_Free(pChan->pWaitCause);
+  Rtos_Free(pChan->pWaitDelayUs);
+}
+
+static bool InitChannel(AL_TReplayDriver* pThis, AL_TReplayChannel* pChan, int iChannel)
+{
+  AL_TDriverSession const* pSession = pThis->pSession;
+  int iNumPosts = 0;
+  int iNumWaits = 0;
+  uint64_t uOpenUs = 0;
+
+  for(int i = 0; i < pSession->iNumRecords; ++i)
+  {
+    AL_TDriverRecord const* pRecord = &pSession->pRecords[i];
+
+    if(pRecord->iChannel != iChannel)
+      continue;
+
+    if(pRecord->eType == AL_DRIVER_RECORD_OPEN)
+      uOpenUs = pRecord->uEndUs;
+
+    if(pRecord->eType != AL_DRIVER_RECORD_MESSAGE)
+      continue;
+
+    if(!IsWaitMessage(pThis, pRecord->uMessageId))
+      ++iNumPosts;
+    /* the failing waits are the ones woken up by the channel destruction */
+    else if(pRecord->iStatus == DRIVER_SUCCESS)
+      ++iNumWaits;
+  }
+
+  Rtos_Memset(pChan, 0, sizeof(*pChan));
+  pChan->fd = -1;
+  pChan->pPosts = Rtos_Malloc((iNumPosts + 1) * sizeof(int));
+  pChan->pNextSameId = Rtos_Malloc((iNumPosts + 1) * sizeof(int));
+  pChan->pConsumed = Rtos_Malloc((iNumPosts + 1) * sizeof(bool));
+  pChan->pPostTimeUs = Rtos_Malloc((iNumPosts + 1) * sizeof(uint64_t));
+  pChan->pWaits = Rtos_Malloc((iNumWaits + 1) * sizeof(int));
+  pChan->pWaitCause = Rtos_Malloc((iNumWaits + 1) * sizeof(int));
+  pChan->pWaitDelayUs = Rtos_Malloc((iNumWaits + 1) * sizeof(uint64_t));
+
+  if(!pChan->pPosts || !pChan->pNextSameId || !pChan->pConsumed || !pChan->pPostTimeUs || !pChan->pWaits || !pChan->pWaitCause || !pChan->pWaitDelayUs)
+    return false;
+
+  /* the requests are stored in completion order, replay them in issuing order */
+  for(int i = 0; i < pSession->iNumRecords; ++i)
+  {
+    AL_TDriverRecord const* pRecord = &pSession->pRecords[i];
+
+    if(pRecord->iChannel != iChannel || pRecord->eType != AL_DRIVER_RECORD_MESSAGE)
+      continue;
+
+    if(IsWaitMessage(pThis, pRecord->uMessageId))
+    {
+      if(pRecord->iStatus == DRIVER_SUCCESS)
+        pChan->pWaits[pChan->iNumWaits++] = i;
+      continue;
+    }
+
+    int iPos = pChan->iNumPosts++;
+
+    while(iPos > 0 && pSession->pRecords[pChan->pPosts[iPos - 1]].uStartUs > pRecord->uStartUs)
+    {
+      pChan->pPosts[iPos] = pChan->pPosts[iPos - 1];
+      --iPos;
+    }
+
+    pChan->pPosts[iPos] = i;
+    pChan->pConsumed[pChan->iNumPosts - 1] = false;
+  }
+
+  /* chain the requests of each message id, the first one is the cursor */
+  for(int i = pChan->iNumPosts - 1; i >= 0; --i)
+  {
+    long unsigned int const messageId = pSession->pRecords[pChan->pPosts[i]].uMessageId;
+    AL_TReplayCursor* pCursor = FindCursor(pChan, messageId);
+
+    if(!pCursor)
+    {
+      if(pChan->iNumCursors == MAX_MESSAGE_IDS)
+        return false;
+
+      pCursor = &pChan->cursors[pChan->iNumCursors++];
+      pCursor->uMessageId = messageId;
+      pCursor->iNext = -1;
+    }
+
+    pChan->pNextSameId[i] = pCursor->iNext;
+    pCursor->iNext = i;
+  }
+
+  /* a status is caused by the last request issued before it was read */
+  for(int w = 0; w < pChan->iNumWaits; ++w)
+  {
+    AL_TDriverRecord const* pWait = &pSession->pRecords[pChan->pWaits[w]];
+    uint64_t uCauseUs = uOpenUs;
+    int iCause = 0;
+
+    while(iCause < pChan->iNumPosts && pSession->pRecords[pChan->pPosts[iCause]].uStartUs <= pWait->uEndUs)
+      ++iCause;
+
+    if(iCause > 0)
+      uCauseUs = pSession->pRecords[pChan->pPosts[iCause - 1]].uEndUs;
+
+    pChan->pWaitCause[w] = iCause;
+
+    if(pThis->tConfig.iLatencyUs >= 0)
+      pChan->pWaitDelayUs[w] = pThis->tConfig.iLatencyUs;
+    else
+      pChan->pWaitDelayUs[w] = pWait->uEndUs > uCauseUs ? pWait->uEndUs - uCauseUs : 0;
+  }
+
+  return true;
+}
+
+AL_TDriver* AL_ReplayDriver_Create(AL_TDriverSession const* pSession, AL_TReplayConfig const* pConfig)
+{
+  AL_TReplayDriver* pThis = Rtos_Malloc(sizeof(*pThis));
+
+  if(!pThis)
+    return NULL;
+
+  Rtos_Memset(pThis, 0, sizeof(*pThis));
+  pThis->base.vtable = &ReplayDriverVtable;
+  pThis->pSession = pSession;
+  pThis->tConfig = *pConfig;
+
+  pThis->pChannels = Rtos_Malloc((pSession->iNumChannels + 1) * sizeof(AL_TReplayChannel));
+
+  if(!pThis->pChannels)
+    goto fail_channels;
+
+  int iChannel = 0;
+
+  for(; iChannel < pSession->iNumChannels; ++iChannel)
+  {
+    if(!InitChannel(pThis, &pThis->pChannels[iChannel], iChannel))
+    {
+      DeinitChannel(&pThis->pChannels[iChannel]);
+      goto fail_init;
+    }
+  }
+
+  pThis->pPipeDriver = AL_PipeDriver_Create(NULL, NULL);
+
+  if(!pThis->pPipeDriver)
+    goto fail_init;
+
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&pThis->Changed, &attr);
+  pthread_condattr_destroy(&attr);
+  pthread_mutex_init(&pThis->Lock, NULL);
+
+  if(pthread_create(&pThis->Timer, NULL, &TimerThread, pThis) != 0)
+    goto fail_thread;
+
+  return (AL_TDriver*)pThis;
+
+  fail_thread:
+  pthread_mutex_destroy(&pThis->Lock);
+  pthread_cond_destroy(&pThis->Changed);
+  AL_PipeDriver_Destroy(pThis->pPipeDriver);
+  fail_init:
+
+  while(iChannel-- > 0)
+    DeinitChannel(&pThis->pChannels[iChannel]);
+
+  Rtos_Free(pThis->pChannels);
+  fail_channels:
+  Rtos_Free(pThis);
+  return NULL;
+}
+
+void AL_ReplayDriver_Destroy(AL_TDriver* pDriver)
+{
+  AL_TReplayDriver* pThis = (AL_TReplayDriver*)pDriver;
+
+  pthread_mutex_lock(&pThis->Lock);
+  pThis->bStop = true;
+  pthread_cond_signal(&pThis->Changed);
+  pthread_mutex_unlock(&pThis->Lock);
+  pthread_join(pThis->Timer, NULL);
+
+  AL_PipeDriver_Destroy(pThis->pPipeDriver);
+
+  for(int i = 0; i < pThis->pSession->iNumChannels; ++i)
+    DeinitChannel(&pThis->pChannels[i]);
+
+  Rtos_Free(pThis->pChannels);
+  pthread_mutex_destroy(&pThis->Lock);
+  pthread_cond_destroy(&pThis->Changed);
+  Rtos_Free(pThis);
+}
+
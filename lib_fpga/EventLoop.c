@@ -0,0 +1,357 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <assert.h>
+
+#include "lib_rtos/lib_rtos.h"
+#include "EventLoop.h"
+#include "lib_perfs/Tracer.h"
+
+#define WAKE_UP_KEY UINT64_MAX
+
+typedef struct
+{
+  int fd;
+  AL_CB_FdReady callback;
+  uint32_t uGeneration;
+  bool bUsed;
+  bool bBusy;
+  bool bRemoving;
+}AL_TEventSource;
+
+struct AL_t_EventLoop
+{
+  int epollFd;
+  int wakeUpFd;
+  int iNumWorkers;
+  AL_THREAD workers[AL_EVENT_LOOP_NUM_WORKERS];
+  AL_TEventSource sources[AL_EVENT_LOOP_MAX_SOURCES];
+  pthread_mutex_t Lock;
+  pthread_cond_t Idle;
+};
+
+static uint64_t MakeKey(AL_TEventLoop* pLoop, AL_TEventSource* pSrc)
+{
+  uint64_t uSlot = (uint64_t)(pSrc - pLoop->sources);
+  return ((uint64_t)pSrc->uGeneration << 32) | uSlot;
+}
+
+static bool Arm(AL_TEventLoop* pLoop, AL_TEventSource* pSrc, int op)
+{
+  struct epoll_event ev = { 0 };
+  ev.events = EPOLLIN | EPOLLONESHOT;
+  ev.data.u64 = MakeKey(pLoop, pSrc);
+  return epoll_ctl(pLoop->epollFd, op, pSrc->fd, &ev) == 0;
+}
+
+/* Lock must be held */
+static void ReleaseSource(AL_TEventLoop* pLoop, AL_TEventSource* pSrc)
+{
+  epoll_ctl(pLoop->epollFd, EPOLL_CTL_DEL, pSrc->fd, NULL);
+  pSrc->bUsed = false;
+  pSrc->bRemoving = false;
+  ++pSrc->uGeneration;
+}
+
+static AL_TEventSource* Acquire(AL_TEventLoop* pLoop, uint64_t uKey)
+{
+  AL_TEventSource* pSrc = &pLoop->sources[uKey & 0xFFFFFFFF];
+  bool bValid;
+
+  pthread_mutex_lock(&pLoop->Lock);
+  bValid = pSrc->bUsed && !pSrc->bRemoving && (pSrc->uGeneration == (uint32_t)(uKey >> 32));
+
+  if(bValid)
+    pSrc->bBusy = true;
+  pthread_mutex_unlock(&pLoop->Lock);
+
+  return bValid ? pSrc : NULL;
+}
+
+static void* Worker(void* p)
+{
+  AL_TEventLoop* pLoop = p;
+
+  AL_Trace_NameThread("event loop");
+
+  for(;;)
+  {
+    struct epoll_event ev;
+    int iRet = epoll_wait(pLoop->epollFd, &ev, 1, -1);
+
+    if(iRet < 0 && errno == EINTR)
+      continue;
+
+    if(iRet < 0)
+      break;
+
+    if(iRet == 0)
+      continue;
+
+    /* the wake up fd is level triggered so that every worker sees it */
+    if(ev.data.u64 == WAKE_UP_KEY)
+      break;
+
+    AL_TEventSource* pSrc = Acquire(pLoop, ev.data.u64);
+
+    if(!pSrc)
+      continue;
+
+    bool bKeep = pSrc->callback.func(pSrc->callback.userParam);
+
+    pthread_mutex_lock(&pLoop->Lock);
+
+    if(bKeep && !pSrc->bRemoving)
+      bKeep = Arm(pLoop, pSrc, EPOLL_CTL_MOD);
+
+    if(!bKeep || pSrc->bRemoving)
+    {
+      AL_CB_FdReady callback = pSrc->callback;
+      ReleaseSource(pLoop, pSrc);
+
+      /* the slot stays busy until the release callback is done */
+      if(callback.release)
+      {
+        pthread_mutex_unlock(&pLoop->Lock);
+        callback.release(callback.userParam);
+        pthread_mutex_lock(&pLoop->Lock);
+      }
+    }
+
+    pSrc->bBusy = false;
+    pthread_cond_broadcast(&pLoop->Idle);
+    pthread_mutex_unlock(&pLoop->Lock);
+  }
+
+  return NULL;
+}
+
+AL_TEventLoop* AL_EventLoop_Create(int iNumWorkers)
+{
+  if(iNumWorkers <= 0 || iNumWorkers > AL_EVENT_LOOP_NUM_WORKERS)
+    iNumWorkers = AL_EVENT_LOOP_NUM_WORKERS;
+
+  AL_TEventLoop* pLoop = Rtos_Malloc(sizeof(*pLoop));
+
+  if(!pLoop)
+    return NULL;
+
+  Rtos_Memset(pLoop, 0, sizeof(*pLoop));
+
+  pLoop->epollFd = epoll_create1(EPOLL_CLOEXEC);
+
+  if(pLoop->epollFd < 0)
+    goto fail_epoll;
+
+  pLoop->wakeUpFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+  if(pLoop->wakeUpFd < 0)
+    goto fail_wake_up;
+
+  struct epoll_event ev = { 0 };
+  ev.events = EPOLLIN;
+  ev.data.u64 = WAKE_UP_KEY;
+
+  if(epoll_ctl(pLoop->epollFd, EPOLL_CTL_ADD, pLoop->wakeUpFd, &ev) != 0)
+    goto fail_add;
+
+  pthread_mutex_init(&pLoop->Lock, NULL);
+  pthread_cond_init(&pLoop->Idle, NULL);
+
+  for(pLoop->iNumWorkers = 0; pLoop->iNumWorkers < iNumWorkers; ++pLoop->iNumWorkers)
+  {
+    pLoop->workers[pLoop->iNumWorkers] = Rtos_CreateThread(&Worker, pLoop);
+
+    if(!pLoop->workers[pLoop->iNumWorkers])
+      break;
+  }
+
+  if(pLoop->iNumWorkers == 0)
+  {
+    AL_EventLoop_Destroy(pLoop);
+    return NULL;
+  }
+
+  return pLoop;
+
+  fail_add:
+  close(pLoop->wakeUpFd);
+  fail_wake_up:
+  close(pLoop->epollFd);
+  fail_epoll:
+  Rtos_Free(pLoop);
+  return NULL;
+}
+
+void AL_EventLoop_Destroy(AL_TEventLoop* pLoop)
+{
+  uint64_t uOne = 1;
+
+  if(write(pLoop->wakeUpFd, &uOne, sizeof(uOne)) != sizeof(uOne))
+    assert(0);
+
+  for(int i = 0; i < pLoop->iNumWorkers; ++i)
+  {
+    Rtos_JoinThread(pLoop->workers[i]);
+    Rtos_DeleteThread(pLoop->workers[i]);
+  }
+
+  pthread_cond_destroy(&pLoop->Idle);
+  pthread_mutex_destroy(&pLoop->Lock);
+  close(pLoop->wakeUpFd);
+  close(pLoop->epollFd);
+  Rtos_Free(pLoop);
+}
+
+bool AL_EventLoop_AddFd(AL_TEventLoop* pLoop, int fd, AL_CB_FdReady callback)
+{
+  AL_TEventSource* pSrc = NULL;
+  bool bRet = false;
+
+  pthread_mutex_lock(&pLoop->Lock);
+
+  for(int i = 0; i < AL_EVENT_LOOP_MAX_SOURCES; ++i)
+  {
+    if(!pLoop->sources[i].bUsed && !pLoop->sources[i].bBusy)
+    {
+      pSrc = &pLoop->sources[i];
+      break;
+    }
+  }
+
+  if(pSrc)
+  {
+    pSrc->fd = fd;
+    pSrc->callback = callback;
+    pSrc->bRemoving = false;
+    /* drivers without poll support are refused here (EPERM) */
+    bRet = Arm(pLoop, pSrc, EPOLL_CTL_ADD);
+    pSrc->bUsed = bRet;
+  }
+
+  pthread_mutex_unlock(&pLoop->Lock);
+
+  return bRet;
+}
+
+void AL_EventLoop_RemoveFd(AL_TEventLoop* pLoop, int fd)
+{
+  AL_TEventSource* pSrc = NULL;
+  AL_CB_FdReady callback;
+
+  pthread_mutex_lock(&pLoop->Lock);
+
+  for(int i = 0; i < AL_EVENT_LOOP_MAX_SOURCES; ++i)
+  {
+    if(pLoop->sources[i].bUsed && !pLoop->sources[i].bRemoving && pLoop->sources[i].fd == fd)
+    {
+      pSrc = &pLoop->sources[i];
+      break;
+    }
+  }
+
+  if(!pSrc)
+  {
+    pthread_mutex_unlock(&pLoop->Lock);
+    return;
+  }
+
+  callback = pSrc->callback;
+  pSrc->bRemoving = true;
+
+  /* the worker running the callback releases the source when it is done */
+  if(!pSrc->bBusy)
+    ReleaseSource(pLoop, pSrc);
+  else
+  {
+    while(pSrc->bBusy)
+      pthread_cond_wait(&pLoop->Idle, &pLoop->Lock);
+
+    /* already called by the worker */
+    callback.release = NULL;
+  }
+
+  pthread_mutex_unlock(&pLoop->Lock);
+
+  if(callback.release)
+    callback.release(callback.userParam);
+}
+
+/****************************************************************************/
+static pthread_mutex_t g_SharedLock = PTHREAD_MUTEX_INITIALIZER;
+static AL_TEventLoop* g_pSharedLoop;
+static int g_iSharedRefCount;
+
+AL_TEventLoop* AL_EventLoop_GetShared(void)
+{
+  AL_TEventLoop* pLoop;
+
+  pthread_mutex_lock(&g_SharedLock);
+
+  if(!g_pSharedLoop)
+    g_pSharedLoop = AL_EventLoop_Create(AL_EVENT_LOOP_NUM_WORKERS);
+
+  if(g_pSharedLoop)
+    ++g_iSharedRefCount;
+
+  pLoop = g_pSharedLoop;
+  pthread_mutex_unlock(&g_SharedLock);
+
+  return pLoop;
+}
+
+void AL_EventLoop_ReleaseShared(AL_TEventLoop* pLoop)
+{
+  if(!pLoop)
+    return;
+
+  pthread_mutex_lock(&g_SharedLock);
+  assert(pLoop == g_pSharedLoop);
+
+  if(--g_iSharedRefCount == 0)
+  {
+    AL_EventLoop_Destroy(g_pSharedLoop);
+    g_pSharedLoop = NULL;
+  }
+  pthread_mutex_unlock(&g_SharedLock);
+}
+
@@ -0,0 +1,107 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+/**************************************************************************//*!
+   \addtogroup lib_fpga
+   @{
+   \file
+ *****************************************************************************/
+
+#pragma once
+
+#include "lib_rtos/types.h"
+
+/*************************************************************************//*!
+   \brief Completion dispatcher shared by all the channels of a process.
+   A small fixed set of workers waits on every registered file descriptor
+   and calls the associated callback when it becomes readable. A given fd is
+   never dispatched to two workers at the same time, so the callbacks of a
+   channel stay ordered.
+*****************************************************************************/
+typedef struct AL_t_EventLoop AL_TEventLoop;
+
+#define AL_EVENT_LOOP_NUM_WORKERS 4
+#define AL_EVENT_LOOP_MAX_SOURCES 128
+
+typedef struct
+{
+  /* returns false to stop watching the fd */
+  bool (* func)(void* pUserParam);
+  /* optional, called once the fd has left the loop */
+  void (* release)(void* pUserParam);
+  void* userParam;
+}AL_CB_FdReady;
+
+/*************************************************************************//*!
+   \brief Creates an event loop
+   \param[in] iNumWorkers Number of dispatching threads
+   \return Pointer on the event loop, NULL on failure
+*****************************************************************************/
+AL_TEventLoop* AL_EventLoop_Create(int iNumWorkers);
+
+/*************************************************************************//*!
+   \brief Stops the workers and frees the event loop. All the fds must have
+   been removed beforehand.
+*****************************************************************************/
+void AL_EventLoop_Destroy(AL_TEventLoop* pLoop);
+
+/*************************************************************************//*!
+   \brief Gets a reference on the process wide event loop, creating it with
+   AL_EVENT_LOOP_NUM_WORKERS workers on first use.
+*****************************************************************************/
+AL_TEventLoop* AL_EventLoop_GetShared(void);
+
+/*************************************************************************//*!
+   \brief Releases a reference taken with AL_EventLoop_GetShared
+*****************************************************************************/
+void AL_EventLoop_ReleaseShared(AL_TEventLoop* pLoop);
+
+/*************************************************************************//*!
+   \brief Starts watching fd
+   \return false if the fd can't be polled (the caller should then fall back
+   on a blocking thread) or if the loop is full
+*****************************************************************************/
+bool AL_EventLoop_AddFd(AL_TEventLoop* pLoop, int fd, AL_CB_FdReady callback);
+
+/*************************************************************************//*!
+   \brief Stops watching fd. Waits for an in-flight callback on this fd to
+   return. Must not be called from the callback of the same fd: return false
+   from the callback instead.
+*****************************************************************************/
+void AL_EventLoop_RemoveFd(AL_TEventLoop* pLoop, int fd);
+
+/*@}*/
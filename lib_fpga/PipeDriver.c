@@ -0,0 +1,283 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <unistd.h>
+#include <errno.h>
+
+#include "lib_rtos/lib_rtos.h"
+#include "lib_common_dec/DecSliceParam.h"
+#include "allegro_ioctl_mcu_dec.h"
+#include "PipeDriver.h"
+
+#define MAX_PIPES 128
+
+typedef struct
+{
+  int readFd;
+  int writeFd;
+}AL_TPipe;
+
+typedef struct
+{
+  AL_TDriver base;
+  AL_PFN_PipeDriverHandler pfnHandler;
+  void* pUserParam;
+  AL_MUTEX hLock;
+  AL_TPipe pipes[MAX_PIPES];
+}AL_TPipeDriver;
+
+static AL_TPipe* FindPipe(AL_TPipeDriver* pThis, int fd)
+{
+  for(int i = 0; i < MAX_PIPES; ++i)
+  {
+    if(pThis->pipes[i].readFd == fd)
+      return &pThis->pipes[i];
+  }
+
+  return NULL;
+}
+
+static int Open(AL_TDriver* driver, const char* device)
+{
+  (void)device;
+  AL_TPipeDriver* pThis = (AL_TPipeDriver*)driver;
+  int fds[2];
+  int iRet = -1;
+
+  Rtos_GetMutex(pThis->hLock);
+  AL_TPipe* pPipe = FindPipe(pThis, -1);
+
+  if(pPipe && pipe(fds) == 0)
+  {
+    pPipe->readFd = fds[0];
+    pPipe->writeFd = fds[1];
+    iRet = fds[0];
+  }
+  Rtos_ReleaseMutex(pThis->hLock);
+
+  return iRet;
+}
+
+static void Close(AL_TDriver* driver, int fd)
+{
+  AL_TPipeDriver* pThis = (AL_TPipeDriver*)driver;
+
+  Rtos_GetMutex(pThis->hLock);
+  AL_TPipe* pPipe = FindPipe(pThis, fd);
+
+  if(pPipe)
+  {
+    if(pPipe->writeFd >= 0)
+      close(pPipe->writeFd);
+    close(pPipe->readFd);
+    pPipe->readFd = -1;
+    pPipe->writeFd = -1;
+  }
+  Rtos_ReleaseMutex(pThis->hLock);
+}
+
+/* the device runs the slices of a batch like as many single slice requests */
+static AL_EDriverError PostSliceBatch(AL_TPipeDriver* pThis, int fd, struct al5_decode_batch_msg const* pBatch)
+{
+  for(uint32_t i = 0; i < pBatch->num_slices; ++i)
+  {
+    struct al5_decode_msg msg;
+    msg.params = pBatch->params;
+    msg.addresses = pBatch->addresses;
+    msg.slice_param_v = pBatch->slice_param_v + i * sizeof(AL_TDecSliceParam);
+
+    AL_EDriverError errdrv = pThis->pfnHandler(pThis->pUserParam, (AL_TDriver*)pThis, fd, AL_MCU_DECODE_ONE_SLICE, &msg);
+
+    if(errdrv != DRIVER_SUCCESS)
+      return errdrv;
+  }
+
+  return DRIVER_SUCCESS;
+}
+
+static AL_EDriverError PostMessage(AL_TDriver* driver, int fd, long unsigned int messageId, void* data)
+{
+  AL_TPipeDriver* pThis = (AL_TPipeDriver*)driver;
+
+  if(!pThis->pfnHandler)
+    return DRIVER_SUCCESS;
+
+  if(messageId == AL_MCU_DECODE_SLICE_BATCH)
+    return PostSliceBatch(pThis, fd, data);
+
+  return pThis->pfnHandler(pThis->pUserParam, driver, fd, messageId, data);
+}
+
+static const AL_DriverVtable PipeDriverVtable =
+{
+  &Open,
+  &Close,
+  &PostMessage,
+};
+
+AL_TDriver* AL_PipeDriver_Create(AL_PFN_PipeDriverHandler pfnHandler, void* pUserParam)
+{
+  AL_TPipeDriver* pThis = Rtos_Malloc(sizeof(*pThis));
+
+  if(!pThis)
+    return NULL;
+
+  pThis->hLock = Rtos_CreateMutex();
+
+  if(!pThis->hLock)
+  {
+    Rtos_Free(pThis);
+    return NULL;
+  }
+
+  pThis->base.vtable = &PipeDriverVtable;
+  pThis->pfnHandler = pfnHandler;
+  pThis->pUserParam = pUserParam;
+
+  for(int i = 0; i < MAX_PIPES; ++i)
+  {
+    pThis->pipes[i].readFd = -1;
+    pThis->pipes[i].writeFd = -1;
+  }
+
+  return (AL_TDriver*)pThis;
+}
+
+void AL_PipeDriver_Destroy(AL_TDriver* pDriver)
+{
+  AL_TPipeDriver* pThis = (AL_TPipeDriver*)pDriver;
+
+  for(int i = 0; i < MAX_PIPES; ++i)
+  {
+    if(pThis->pipes[i].readFd >= 0)
+      Close(pDriver, pThis->pipes[i].readFd);
+  }
+
+  Rtos_DeleteMutex(pThis->hLock);
+  Rtos_Free(pThis);
+}
+
+static bool WriteAll(int fd, void const* pData, size_t zSize)
+{
+  char const* pBuf = pData;
+
+  while(zSize > 0)
+  {
+    ssize_t iRet = write(fd, pBuf, zSize);
+
+    if(iRet < 0 && errno == EINTR)
+      continue;
+
+    if(iRet <= 0)
+      return false;
+
+    pBuf += iRet;
+    zSize -= iRet;
+  }
+
+  return true;
+}
+
+static bool ReadAll(int fd, void* pData, size_t zSize)
+{
+  char* pBuf = pData;
+
+  while(zSize > 0)
+  {
+    ssize_t iRet = read(fd, pBuf, zSize);
+
+    if(iRet < 0 && errno == EINTR)
+      continue;
+
+    if(iRet <= 0)
+      return false;
+
+    pBuf += iRet;
+    zSize -= iRet;
+  }
+
+  return true;
+}
+
+bool AL_PipeDriver_PushStatus(AL_TDriver* pDriver, int fd, void const* pData, uint32_t uSize)
+{
+  AL_TPipeDriver* pThis = (AL_TPipeDriver*)pDriver;
+  bool bRet = false;
+
+  /* a record is written in one go so that concurrent producers don't interleave */
+  Rtos_GetMutex(pThis->hLock);
+  AL_TPipe* pPipe = FindPipe(pThis, fd);
+
+  if(pPipe && pPipe->writeFd >= 0)
+    bRet = WriteAll(pPipe->writeFd, &uSize, sizeof(uSize)) && WriteAll(pPipe->writeFd, pData, uSize);
+  Rtos_ReleaseMutex(pThis->hLock);
+
+  return bRet;
+}
+
+AL_EDriverError AL_PipeDriver_PopStatus(AL_TDriver* pDriver, int fd, void* pData, uint32_t uMaxSize)
+{
+  (void)pDriver;
+  uint32_t uSize;
+
+  if(!ReadAll(fd, &uSize, sizeof(uSize)))
+    return DRIVER_ERROR_CHANNEL;
+
+  if(uSize > uMaxSize)
+    return DRIVER_ERROR_UNKNOWN;
+
+  if(!ReadAll(fd, pData, uSize))
+    return DRIVER_ERROR_CHANNEL;
+
+  return DRIVER_SUCCESS;
+}
+
+void AL_PipeDriver_HangUp(AL_TDriver* pDriver, int fd)
+{
+  AL_TPipeDriver* pThis = (AL_TPipeDriver*)pDriver;
+
+  Rtos_GetMutex(pThis->hLock);
+  AL_TPipe* pPipe = FindPipe(pThis, fd);
+
+  if(pPipe && pPipe->writeFd >= 0)
+  {
+    close(pPipe->writeFd);
+    pPipe->writeFd = -1;
+  }
+  Rtos_ReleaseMutex(pThis->hLock);
+}
+
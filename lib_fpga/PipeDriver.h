@@ -0,0 +1,79 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+/**************************************************************************//*!
+   \addtogroup lib_fpga
+   @{
+   \file
+ *****************************************************************************/
+
+#pragma once
+
+#include "lib_common/IDriver.h"
+
+/*************************************************************************//*!
+   \brief Software stand-in for the allegro device driver.
+   Each Open() creates a pipe and returns its read end, so a channel opened on
+   this driver can be polled like a device node. Messages are forwarded to
+   the user handler, a slice batch as one AL_MCU_DECODE_ONE_SLICE message
+   per slice. Completions are simulated with AL_PipeDriver_PushStatus
+   and the handler hands them back with AL_PipeDriver_PopStatus when it
+   receives a wait message.
+*****************************************************************************/
+typedef AL_EDriverError (* AL_PFN_PipeDriverHandler)(void* pUserParam, AL_TDriver* pDriver, int fd, long unsigned int messageId, void* data);
+
+AL_TDriver* AL_PipeDriver_Create(AL_PFN_PipeDriverHandler pfnHandler, void* pUserParam);
+void AL_PipeDriver_Destroy(AL_TDriver* pDriver);
+
+/*************************************************************************//*!
+   \brief Queues a status on fd. fd becomes readable.
+*****************************************************************************/
+bool AL_PipeDriver_PushStatus(AL_TDriver* pDriver, int fd, void const* pData, uint32_t uSize);
+
+/*************************************************************************//*!
+   \brief Blocks until a status is available on fd and copies it in pData.
+   \return DRIVER_ERROR_CHANNEL once the channel has been hung up
+*****************************************************************************/
+AL_EDriverError AL_PipeDriver_PopStatus(AL_TDriver* pDriver, int fd, void* pData, uint32_t uMaxSize);
+
+/*************************************************************************//*!
+   \brief Wakes up the waiters of fd with an error, as the driver does when a
+   channel is destroyed.
+*****************************************************************************/
+void AL_PipeDriver_HangUp(AL_TDriver* pDriver, int fd);
+
+/*@}*/
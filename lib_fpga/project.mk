@@ -9,6 +9,10 @@ endif
 ifeq ($(findstring linux,$(TARGET)),linux)
 	LIB_FPGA_SRC+=lib_fpga/DmaAllocLinux.c
 	LIB_FPGA_SRC+=lib_fpga/DevicePool.c
+	LIB_FPGA_SRC+=lib_fpga/EventLoop.c
+	LIB_FPGA_SRC+=lib_fpga/PipeDriver.c
+	LIB_FPGA_SRC+=lib_fpga/DriverRecord.c
+	LIB_FPGA_SRC+=lib_fpga/DriverReplay.c
 	LDFLAGS+=-lpthread
 endif
 
@@ -49,7 +49,7 @@ static void initPps(AL_TAvcPps* pPPS)
   pPPS->bConceal = true;
 }
 
-AL_PARSE_RESULT AL_AVC_ParsePPS(AL_TAup* pIAup, AL_TRbspParser* pRP)
+AL_PARSE_RESULT AL_AVC_ParsePPS(AL_TAup* pIAup, AL_TRbspParser* pRP, int* pPpsId)
 {
   uint16_t pps_id, QpBdOffset;
   AL_TAvcPps tempPPS;
@@ -261,6 +261,7 @@ AL_PARSE_RESULT AL_AVC_ParsePPS(AL_TAup* pIAup, AL_TRbspParser* pRP)
   COMPLY(tempPPS.num_slice_groups_minus1 == 0); // baseline profile only
 
   pIAup->avcAup.pPPS[pps_id] = tempPPS;
+  *pPpsId = pps_id;
   return AL_OK;
 }
 
@@ -303,7 +304,7 @@ static bool isProfileSupported(uint8_t profile_idc)
   return true;
 }
 
-AL_PARSE_RESULT AL_AVC_ParseSPS(AL_TAup* pIAup, AL_TRbspParser* pRP)
+AL_PARSE_RESULT AL_AVC_ParseSPS(AL_TAup* pIAup, AL_TRbspParser* pRP, int* pSpsId)
 {
   AL_TAvcSps tempSPS;
 
@@ -474,6 +475,7 @@ AL_PARSE_RESULT AL_AVC_ParseSPS(AL_TAup* pIAup, AL_TRbspParser* pRP)
   tempSPS.bConceal = false;
 
   pIAup->avcAup.pSPS[sps_id] = tempSPS;
+  *pSpsId = sps_id;
   return AL_OK;
 }
 
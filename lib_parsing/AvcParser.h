@@ -47,7 +47,7 @@
 
 void AL_AVC_InitAUP(AL_TAvcAup* pAUP);
 
-AL_PARSE_RESULT AL_AVC_ParsePPS(AL_TAup* pIAup, AL_TRbspParser* pRP);
-AL_PARSE_RESULT AL_AVC_ParseSPS(AL_TAup* pIAup, AL_TRbspParser* pRP);
+AL_PARSE_RESULT AL_AVC_ParsePPS(AL_TAup* pIAup, AL_TRbspParser* pRP, int* pPpsId);
+AL_PARSE_RESULT AL_AVC_ParseSPS(AL_TAup* pIAup, AL_TRbspParser* pRP, int* pSpsId);
 bool AL_AVC_ParseSEI(AL_TAup* pIAup, AL_TRbspParser* pRP);
 
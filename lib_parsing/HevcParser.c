@@ -82,16 +82,17 @@ void AL_HEVC_ParsePPS(AL_TAup* pIAup, AL_TRbspParser* pRP, uint8_t* pPpsId)
   u(pRP, 16); // Skip NUT + temporal_id
 
   pps_id = ue(pRP);
+  *pPpsId = pps_id;
+
+  if(pps_id >= AL_HEVC_MAX_PPS)
+    return;
+
   pPPS = &aup->pPPS[pps_id];
 
-  *pPpsId = pps_id;
   // default values
   initPps(pPPS);
   pPPS->bConceal = true;
 
-  if(pps_id >= AL_HEVC_MAX_PPS)
-    return;
-
   pPPS->pps_pic_parameter_set_id = pps_id;
   pPPS->pps_seq_parameter_set_id = ue(pRP);
 
@@ -421,7 +422,7 @@ static void initSps(AL_THevcSps* pSPS)
 }
 
 /*****************************************************************************/
-AL_PARSE_RESULT AL_HEVC_ParseSPS(AL_TAup* pIAup, AL_TRbspParser* pRP)
+AL_PARSE_RESULT AL_HEVC_ParseSPS(AL_TAup* pIAup, AL_TRbspParser* pRP, int* pSpsId)
 {
   AL_THevcSps tempSPS;
 
@@ -443,6 +444,7 @@ AL_PARSE_RESULT AL_HEVC_ParseSPS(AL_TAup* pIAup, AL_TRbspParser* pRP)
   int sps_id = ue(pRP);
 
   pIAup->hevcAup.pSPS[sps_id].bConceal = true;
+  *pSpsId = sps_id;
 
   COMPLY(sps_id < AL_HEVC_MAX_SPS);
 
@@ -715,7 +717,7 @@ void AL_HEVC_short_term_ref_pic_set(AL_THevcSps* pSPS, uint8_t RefIdx, AL_TRbspP
 }
 
 /*****************************************************************************/
-void ParseVPS(AL_TAup* pIAup, AL_TRbspParser* pRP)
+void ParseVPS(AL_TAup* pIAup, AL_TRbspParser* pRP, int* pVpsId)
 {
   AL_THevcVps* pVPS;
 
@@ -728,6 +730,7 @@ void ParseVPS(AL_TAup* pIAup, AL_TRbspParser* pRP)
   int vps_id = u(pRP, 4);
   pVPS = &pIAup->hevcAup.pVPS[vps_id];
   pVPS->vps_video_parameter_set_id = vps_id;
+  *pVpsId = vps_id;
 
   pVPS->vps_base_layer_internal_flag = u(pRP, 1);
   pVPS->vps_base_layer_available_flag = u(pRP, 1);
@@ -47,8 +47,8 @@
 void AL_HEVC_InitAUP(AL_THevcAup* pAUP);
 
 void AL_HEVC_ParsePPS(AL_TAup* pIAup, AL_TRbspParser* pRP, uint8_t* pPpsId);
-AL_PARSE_RESULT AL_HEVC_ParseSPS(AL_TAup* pIAup, AL_TRbspParser* pRP);
-void ParseVPS(AL_TAup* pIAup, AL_TRbspParser* pRP);
+AL_PARSE_RESULT AL_HEVC_ParseSPS(AL_TAup* pIAup, AL_TRbspParser* pRP, int* pSpsId);
+void ParseVPS(AL_TAup* pIAup, AL_TRbspParser* pRP, int* pVpsId);
 bool AL_HEVC_ParseSEI(AL_TAup* pIAup, AL_TRbspParser* pRP);
 
 /*************************************************************************//*!
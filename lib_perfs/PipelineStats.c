@@ -0,0 +1,345 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lib_rtos/lib_rtos.h"
+#include "lib_perfs/PipelineStats.h"
+
+/* log-linear buckets: exact below 2^SUB_BITS us, then 2^SUB_BITS buckets per
+ * power of two, which bounds the relative error to 1 / 2^SUB_BITS */
+#define SUB_BITS 5
+#define SUB_COUNT (1 << SUB_BITS)
+#define MAX_MSB 35
+#define NUM_BUCKETS (SUB_COUNT + (MAX_MSB - SUB_BITS + 1) * SUB_COUNT)
+
+/* frames followed at the same time */
+#define NUM_SLOTS 256
+
+typedef struct
+{
+  int32_t iBuckets[NUM_BUCKETS];
+  int32_t iCount;
+  uint64_t uSumUs;
+  uint64_t uMaxUs;
+}AL_THistogram;
+
+typedef struct
+{
+  uint64_t uKey;
+  uint64_t uStartUs;
+  uint64_t uLastUs;
+}AL_TFrameSlot;
+
+/* the checkpoints of a frame come from several threads: the slots and the
+ * histograms are only accessed with hLock held */
+static struct
+{
+  bool bEnabled;
+  AL_MUTEX hLock;
+  AL_THistogram histograms[AL_STAGE_MAX_ENUM];
+  AL_TFrameSlot slots[NUM_SLOTS];
+}g_Stats;
+
+static char const* const StageNames[AL_STAGE_MAX_ENUM] =
+{
+  "enc.read",
+  "enc.convert",
+  "enc.process",
+  "enc.end_encoding",
+  "enc.stream_written",
+  "enc.total",
+  "dec.push_buffer",
+  "dec.start_code",
+  "dec.launch",
+  "dec.frame_ready",
+  "dec.displayed",
+  "dec.total",
+};
+
+/****************************************************************************/
+static int GetMsb(uint64_t uValue)
+{
+#if defined __GNUC__
+  return 63 - __builtin_clzll(uValue);
+#else
+  int iMsb = 0;
+
+  while(uValue >>= 1)
+    ++iMsb;
+
+  return iMsb;
+#endif
+}
+
+static int GetBucket(uint64_t uValueUs)
+{
+  if(uValueUs < SUB_COUNT)
+    return (int)uValueUs;
+
+  int iMsb = GetMsb(uValueUs);
+
+  if(iMsb > MAX_MSB)
+    return NUM_BUCKETS - 1;
+
+  int iSub = (int)(uValueUs >> (iMsb - SUB_BITS)) - SUB_COUNT;
+  return SUB_COUNT + (iMsb - SUB_BITS) * SUB_COUNT + iSub;
+}
+
+/* middle of the bucket */
+static uint64_t GetBucketValue(int iBucket)
+{
+  if(iBucket < SUB_COUNT)
+    return iBucket;
+
+  int iShift = (iBucket - SUB_COUNT) / SUB_COUNT;
+  uint64_t uBase = (uint64_t)(SUB_COUNT + (iBucket - SUB_COUNT) % SUB_COUNT) << iShift;
+  return uBase + ((1ULL << iShift) >> 1);
+}
+
+static void Record(AL_EPipelineStage eStage, uint64_t uLatencyUs)
+{
+  AL_THistogram* pHisto = &g_Stats.histograms[eStage];
+
+  ++pHisto->iBuckets[GetBucket(uLatencyUs)];
+  ++pHisto->iCount;
+  pHisto->uSumUs += uLatencyUs;
+
+  if(uLatencyUs > pHisto->uMaxUs)
+    pHisto->uMaxUs = uLatencyUs;
+}
+
+static AL_TFrameSlot* GetSlot(uint64_t uKey)
+{
+  return &g_Stats.slots[(uKey * 0x9E3779B97F4A7C15ULL) >> 56];
+}
+
+static bool IsLastStage(AL_EPipelineStage eStage)
+{
+  return eStage == AL_STAGE_ENC_STREAM_WRITTEN || eStage == AL_STAGE_DEC_DISPLAYED;
+}
+
+/****************************************************************************/
+void AL_PipelineStats_Enable(bool bEnable)
+{
+  g_Stats.bEnabled = false;
+
+  if(!g_Stats.hLock)
+    g_Stats.hLock = Rtos_CreateMutex();
+
+  if(!g_Stats.hLock)
+    return;
+
+  Rtos_GetMutex(g_Stats.hLock);
+  Rtos_Memset(g_Stats.histograms, 0, sizeof(g_Stats.histograms));
+  Rtos_Memset(g_Stats.slots, 0, sizeof(g_Stats.slots));
+  Rtos_ReleaseMutex(g_Stats.hLock);
+
+  g_Stats.bEnabled = bEnable;
+}
+
+bool AL_PipelineStats_IsEnabled(void)
+{
+  return g_Stats.bEnabled;
+}
+
+void AL_PipelineStats_StartAt(uint64_t uKey, uint64_t uTimeUs)
+{
+  if(!g_Stats.bEnabled)
+    return;
+
+  /* a frame still in the slot is evicted, its next checkpoints are lost */
+  Rtos_GetMutex(g_Stats.hLock);
+  AL_TFrameSlot* pSlot = GetSlot(uKey);
+  pSlot->uStartUs = uTimeUs;
+  pSlot->uLastUs = uTimeUs;
+  pSlot->uKey = uKey;
+  Rtos_ReleaseMutex(g_Stats.hLock);
+}
+
+void AL_PipelineStats_Start(uint64_t uKey)
+{
+  if(g_Stats.bEnabled)
+    AL_PipelineStats_StartAt(uKey, Rtos_GetTimeUs());
+}
+
+void AL_PipelineStats_CheckpointAt(AL_EPipelineStage eStage, uint64_t uKey, uint64_t uTimeUs)
+{
+  if(!g_Stats.bEnabled)
+    return;
+
+  Rtos_GetMutex(g_Stats.hLock);
+  AL_TFrameSlot* pSlot = GetSlot(uKey);
+
+  if(pSlot->uKey != uKey)
+    goto unlock;
+
+  uint64_t const uLastUs = pSlot->uLastUs;
+  pSlot->uLastUs = uTimeUs;
+
+  if(uTimeUs >= uLastUs)
+    Record(eStage, uTimeUs - uLastUs);
+
+  if(IsLastStage(eStage))
+  {
+    if(uTimeUs >= pSlot->uStartUs)
+      Record(eStage + 1, uTimeUs - pSlot->uStartUs);
+    pSlot->uKey = 0;
+  }
+
+  unlock:
+  Rtos_ReleaseMutex(g_Stats.hLock);
+}
+
+void AL_PipelineStats_Checkpoint(AL_EPipelineStage eStage, uint64_t uKey)
+{
+  if(g_Stats.bEnabled)
+    AL_PipelineStats_CheckpointAt(eStage, uKey, Rtos_GetTimeUs());
+}
+
+void AL_PipelineStats_Stop(uint64_t uKey)
+{
+  if(!g_Stats.bEnabled)
+    return;
+
+  Rtos_GetMutex(g_Stats.hLock);
+  AL_TFrameSlot* pSlot = GetSlot(uKey);
+
+  if(pSlot->uKey == uKey)
+    pSlot->uKey = 0;
+  Rtos_ReleaseMutex(g_Stats.hLock);
+}
+
+/****************************************************************************/
+static uint64_t Min64(uint64_t a, uint64_t b)
+{
+  return a < b ? a : b;
+}
+
+static uint64_t GetPercentile(AL_THistogram const* pHisto, int iCount, int iPercent)
+{
+  int64_t const iRank = ((int64_t)iCount * iPercent + 99) / 100;
+  int64_t iSeen = 0;
+
+  for(int i = 0; i < NUM_BUCKETS; ++i)
+  {
+    iSeen += pHisto->iBuckets[i];
+
+    if(iSeen >= iRank)
+      return GetBucketValue(i);
+  }
+
+  return pHisto->uMaxUs;
+}
+
+bool AL_PipelineStats_GetSummary(AL_EPipelineStage eStage, AL_TLatencySummary* pSummary)
+{
+  AL_THistogram const* pHisto = &g_Stats.histograms[eStage];
+
+  Rtos_Memset(pSummary, 0, sizeof(*pSummary));
+
+  if(!g_Stats.hLock)
+    return false;
+
+  Rtos_GetMutex(g_Stats.hLock);
+  int const iCount = pHisto->iCount;
+
+  if(iCount > 0)
+  {
+    pSummary->uCount = iCount;
+    pSummary->uMeanUs = pHisto->uSumUs / iCount;
+    pSummary->uMaxUs = pHisto->uMaxUs;
+    pSummary->uP50Us = Min64(GetPercentile(pHisto, iCount, 50), pSummary->uMaxUs);
+    pSummary->uP95Us = Min64(GetPercentile(pHisto, iCount, 95), pSummary->uMaxUs);
+    pSummary->uP99Us = Min64(GetPercentile(pHisto, iCount, 99), pSummary->uMaxUs);
+  }
+  Rtos_ReleaseMutex(g_Stats.hLock);
+
+  return iCount > 0;
+}
+
+char const* AL_PipelineStats_GetStageName(AL_EPipelineStage eStage)
+{
+  return StageNames[eStage];
+}
+
+static bool IsCsv(char const* sFileName)
+{
+  size_t const zLen = strlen(sFileName);
+  return zLen >= 4 && strcmp(sFileName + zLen - 4, ".csv") == 0;
+}
+
+bool AL_PipelineStats_Export(char const* sFileName)
+{
+  FILE* pFile = fopen(sFileName, "w");
+
+  if(!pFile)
+    return false;
+
+  bool const bCsv = IsCsv(sFileName);
+  bool bFirst = true;
+
+  if(bCsv)
+    fprintf(pFile, "stage,count,mean_us,p50_us,p95_us,p99_us,max_us\n");
+  else
+    fprintf(pFile, "{\n  \"unit\": \"us\",\n  \"stages\": [");
+
+  for(int i = 0; i < AL_STAGE_MAX_ENUM; ++i)
+  {
+    AL_TLatencySummary s;
+
+    if(!AL_PipelineStats_GetSummary(i, &s))
+      continue;
+
+    unsigned long long const values[] = { s.uMeanUs, s.uP50Us, s.uP95Us, s.uP99Us, s.uMaxUs };
+
+    if(bCsv)
+      fprintf(pFile, "%s,%u,%llu,%llu,%llu,%llu,%llu\n", StageNames[i], s.uCount, values[0], values[1], values[2], values[3], values[4]);
+    else
+      fprintf(pFile, "%s\n    { \"name\": \"%s\", \"count\": %u, \"mean\": %llu, \"p50\": %llu, \"p95\": %llu, \"p99\": %llu, \"max\": %llu }",
+              bFirst ? "" : ",", StageNames[i], s.uCount, values[0], values[1], values[2], values[3], values[4]);
+    bFirst = false;
+  }
+
+  if(!bCsv)
+    fprintf(pFile, "\n  ]\n}\n");
+
+  fclose(pFile);
+  return true;
+}
+
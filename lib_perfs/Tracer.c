@@ -0,0 +1,270 @@
+/******************************************************************************
+*
+* Copyright (C) 2017 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <stdio.h>
+
+#include "lib_rtos/lib_rtos.h"
+#include "lib_perfs/Tracer.h"
+
+#if defined _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+#define MAX_RINGS 256
+
+typedef struct
+{
+  uint64_t uTicks;
+  char const* sName;
+  uint32_t uArg;
+  uint32_t ePhase;
+}AL_TTraceEvent;
+
+typedef struct
+{
+  AL_TTraceEvent* pEvents;
+  uint32_t uMask;
+  uint32_t uWrite;
+  int iThreadId;
+  char const* sThreadName;
+}AL_TTraceRing;
+
+bool g_TracerEnabled = false;
+
+static struct
+{
+  AL_MUTEX hLock;
+  AL_TTraceRing* pRings[MAX_RINGS];
+  int iNumRings;
+  uint32_t uRingSize;
+  uint64_t uStartTicks;
+  uint64_t uStartUs;
+}g_Tracer;
+
+static THREAD_LOCAL AL_TTraceRing* t_pRing;
+
+/****************************************************************************/
+static uint64_t GetTicks(void)
+{
+#if defined __GNUC__ && (defined __x86_64__ || defined __i386__)
+  return __builtin_ia32_rdtsc();
+#else
+  return Rtos_GetTimeUs();
+#endif
+}
+
+static AL_TTraceRing* CreateRing(void)
+{
+  AL_TTraceRing* pRing = NULL;
+
+  Rtos_GetMutex(g_Tracer.hLock);
+
+  /* the rings outlive their thread so that its events can still be exported */
+  if(g_Tracer.iNumRings < MAX_RINGS)
+    pRing = Rtos_Malloc(sizeof(*pRing));
+
+  if(pRing)
+  {
+    pRing->pEvents = Rtos_Malloc(g_Tracer.uRingSize * sizeof(AL_TTraceEvent));
+
+    if(!pRing->pEvents)
+    {
+      Rtos_Free(pRing);
+      pRing = NULL;
+    }
+  }
+
+  if(pRing)
+  {
+    pRing->uMask = g_Tracer.uRingSize - 1;
+    pRing->uWrite = 0;
+    pRing->iThreadId = g_Tracer.iNumRings + 1;
+    pRing->sThreadName = NULL;
+    g_Tracer.pRings[g_Tracer.iNumRings++] = pRing;
+  }
+
+  Rtos_ReleaseMutex(g_Tracer.hLock);
+
+  return pRing;
+}
+
+static AL_TTraceRing* GetRing(void)
+{
+  if(!t_pRing)
+    t_pRing = CreateRing();
+  return t_pRing;
+}
+
+/****************************************************************************/
+void AL_Tracer_Record(char const* sEvent, AL_ETracePhase ePhase, uint32_t uArg)
+{
+  AL_TTraceRing* pRing = GetRing();
+
+  if(!pRing)
+    return;
+
+  AL_TTraceEvent* pEvent = &pRing->pEvents[pRing->uWrite & pRing->uMask];
+  pEvent->uTicks = GetTicks();
+  pEvent->sName = sEvent;
+  pEvent->uArg = uArg;
+  pEvent->ePhase = ePhase;
+  ++pRing->uWrite;
+}
+
+void AL_Tracer_NameThread(char const* sName)
+{
+  AL_TTraceRing* pRing = GetRing();
+
+  if(pRing)
+    pRing->sThreadName = sName;
+}
+
+/****************************************************************************/
+static uint32_t RoundUpPow2(int iValue)
+{
+  uint32_t uSize = 1;
+
+  while((int)uSize < iValue)
+    uSize <<= 1;
+
+  return uSize;
+}
+
+bool AL_Tracer_Start(int iEventsPerThread)
+{
+  if(!g_Tracer.hLock)
+    g_Tracer.hLock = Rtos_CreateMutex();
+
+  if(!g_Tracer.hLock || iEventsPerThread <= 0)
+    return false;
+
+  Rtos_GetMutex(g_Tracer.hLock);
+
+  /* the existing rings keep their size: only the new threads use the new one */
+  g_Tracer.uRingSize = RoundUpPow2(iEventsPerThread);
+
+  for(int i = 0; i < g_Tracer.iNumRings; ++i)
+    g_Tracer.pRings[i]->uWrite = 0;
+
+  g_Tracer.uStartTicks = GetTicks();
+  g_Tracer.uStartUs = Rtos_GetTimeUs();
+  Rtos_ReleaseMutex(g_Tracer.hLock);
+
+  g_TracerEnabled = true;
+  return true;
+}
+
+void AL_Tracer_Stop(void)
+{
+  g_TracerEnabled = false;
+}
+
+static char PhaseToChar(uint32_t ePhase)
+{
+  switch(ePhase)
+  {
+  case AL_TRACE_BEGIN: return 'B';
+  case AL_TRACE_END: return 'E';
+  default: return 'i';
+  }
+}
+
+bool AL_Tracer_Export(char const* sFileName)
+{
+  if(!g_Tracer.hLock)
+    return false;
+
+  FILE* pFile = fopen(sFileName, "w");
+
+  if(!pFile)
+    return false;
+
+  /* calibrate the ticks on the microsecond clock */
+  uint64_t const uTicks = GetTicks() - g_Tracer.uStartTicks;
+  uint64_t const uElapsedUs = Rtos_GetTimeUs() - g_Tracer.uStartUs;
+  double const fUsPerTick = uTicks ? (double)uElapsedUs / uTicks : 1.0;
+  char const* sSeparator = "";
+
+  fprintf(pFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+  Rtos_GetMutex(g_Tracer.hLock);
+
+  for(int r = 0; r < g_Tracer.iNumRings; ++r)
+  {
+    AL_TTraceRing const* pRing = g_Tracer.pRings[r];
+
+    if(pRing->sThreadName)
+    {
+      fprintf(pFile, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", sSeparator, pRing->iThreadId, pRing->sThreadName);
+      sSeparator = ",";
+    }
+
+    uint32_t const uSize = pRing->uMask + 1;
+    uint32_t const uEnd = pRing->uWrite;
+    uint32_t const uBegin = uEnd > uSize ? uEnd - uSize : 0;
+
+    for(uint32_t i = uBegin; i != uEnd; ++i)
+    {
+      AL_TTraceEvent const* pEvent = &pRing->pEvents[i & pRing->uMask];
+
+      /* events from a previous session */
+      if(pEvent->uTicks < g_Tracer.uStartTicks)
+        continue;
+
+      double const fTs = (pEvent->uTicks - g_Tracer.uStartTicks) * fUsPerTick;
+      fprintf(pFile, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d", sSeparator, pEvent->sName, PhaseToChar(pEvent->ePhase), fTs, pRing->iThreadId);
+
+      if(pEvent->ePhase == AL_TRACE_INSTANT)
+        fprintf(pFile, ",\"s\":\"t\"");
+
+      if(pEvent->ePhase != AL_TRACE_END)
+        fprintf(pFile, ",\"args\":{\"arg\":%u}", pEvent->uArg);
+
+      fprintf(pFile, "}");
+      sSeparator = ",";
+    }
+  }
+
+  Rtos_ReleaseMutex(g_Tracer.hLock);
+
+  fprintf(pFile, "\n]}\n");
+  fclose(pFile);
+  return true;
+}
+
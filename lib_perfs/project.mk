@@ -0,0 +1,5 @@
+LIB_PERFS_SRC:=\
+	lib_perfs/PipelineStats.c\
+	lib_perfs/Tracer.c\
+
+UNITTEST+=$(LIB_PERFS_SRC)
@@ -132,6 +132,16 @@ AL_64U Rtos_GetTime()
   return (uCount * 1000) / uFreq;
 }
 
+/****************************************************************************/
+AL_64U Rtos_GetTimeUs()
+{
+  AL_64U uCount, uFreq;
+  QueryPerformanceCounter((LARGE_INTEGER*)&uCount);
+  QueryPerformanceFrequency((LARGE_INTEGER*)&uFreq);
+
+  return (uCount / uFreq) * 1000000 + ((uCount % uFreq) * 1000000) / uFreq;
+}
+
 /****************************************************************************/
 void Rtos_Sleep(uint32_t uMillisecond)
 {
@@ -267,6 +277,7 @@ int Rtos_DriverIoctl(void* drv, unsigned long int req, void* data)
 #elif defined __linux__
 
 #include <sys/time.h>
+#include <time.h>
 #include <errno.h>
 #include <unistd.h>
 
@@ -289,6 +300,15 @@ AL_64U Rtos_GetTime()
   return ((AL_64U)Tv.tv_sec) * 1000 + (Tv.tv_usec / 1000);
 }
 
+/****************************************************************************/
+AL_64U Rtos_GetTimeUs()
+{
+  struct timespec Ts;
+  clock_gettime(CLOCK_MONOTONIC, &Ts);
+
+  return ((AL_64U)Ts.tv_sec) * 1000000 + (Ts.tv_nsec / 1000);
+}
+
 /****************************************************************************/
 void Rtos_Sleep(uint32_t uMillisecond)
 {